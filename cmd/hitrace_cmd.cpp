@@ -93,6 +93,9 @@ enum RunningState {
     SET_TRACE_LEVEL = 33,    // --trace_level level
     GET_TRACE_LEVEL = 34,    // --trace_level
     CONFIG_BOOT_TRACE = 35,  // --boot_trace
+
+    /* Convert a raw trace file */
+    DECOMPRESS_TRACE_FILE = 36, // --decompress file
 };
 }
 
@@ -113,6 +116,7 @@ static bool HandleCloseSnapshot();
 static bool SetTraceLevel();
 static bool GetTraceLevel();
 static bool HandleBootTraceConfig();
+static bool HandleDecompressTraceFile();
 static bool HandleOptBootTrace(const RunningState& setValue);
 static bool HandleOptRepeat(const RunningState& setValue);
 
@@ -127,6 +131,7 @@ static bool HandleOptTotalsize(const RunningState& setValue);
 static bool HandleOptTracelevel(const RunningState& setValue);
 static bool HandleOptBootFilePrefix(const RunningState& setValue);
 static bool HandleOptBootIncrement(const RunningState& setValue);
+static bool HandleOptDecompress(const RunningState& setValue);
 static bool IsBootTraceActiveFlagOn();
 static void ClearBootTraceActiveFlagIfNeeded(bool isActive);
 static bool SetRunningState(const RunningState& setValue);
@@ -143,6 +148,7 @@ struct TraceArgs {
     int64_t totalSize = 0;
     bool overwrite = true;
     std::string output;
+    std::string input; // --decompress source file
 
     int duration = 0;
     bool isCompress = false;
@@ -206,6 +212,7 @@ const std::map<RunningState, std::string> STATE_INFO = {
     { SET_TRACE_LEVEL, "SET_TRACE_LEVEL"},
     { GET_TRACE_LEVEL, "GET_TRACE_LEVEL"},
     { CONFIG_BOOT_TRACE, "CONFIG_BOOT_TRACE"},
+    { DECOMPRESS_TRACE_FILE, "DECOMPRESS_TRACE_FILE"},
 };
 
 constexpr struct option LONG_OPTIONS[] = {
@@ -234,6 +241,7 @@ constexpr struct option LONG_OPTIONS[] = {
     { "repeat",              required_argument, nullptr, 0 },
     { "file_prefix",         required_argument, nullptr, 0 },
     { "increment",           no_argument,       nullptr, 0 },
+    { "decompress",          required_argument, nullptr, 0 },
     { nullptr,               0,                 nullptr, 0 },
 };
 
@@ -251,7 +259,8 @@ const std::unordered_map<RunningState, TaskFunc> TASK_TABLE = {
     {SNAPSHOT_STOP, HandleCloseSnapshot},
     {SET_TRACE_LEVEL, SetTraceLevel},
     {GET_TRACE_LEVEL, GetTraceLevel},
-    {CONFIG_BOOT_TRACE, HandleBootTraceConfig}
+    {CONFIG_BOOT_TRACE, HandleBootTraceConfig},
+    {DECOMPRESS_TRACE_FILE, HandleDecompressTraceFile}
 };
 
 const std::unordered_map<std::string, CommandFunc> COMMAND_TABLE = {
@@ -279,7 +288,8 @@ const std::unordered_map<std::string, CommandFunc> COMMAND_TABLE = {
     {"boot_trace", HandleOptBootTrace},
     {"repeat", HandleOptRepeat},
     {"file_prefix", HandleOptBootFilePrefix},
-    {"increment", HandleOptBootIncrement}
+    {"increment", HandleOptBootIncrement},
+    {"decompress", HandleOptDecompress}
 };
 
 std::unordered_map<std::string, RunningState> OPT_MAP = {
@@ -307,7 +317,8 @@ std::unordered_map<std::string, RunningState> OPT_MAP = {
     {"boot_trace", CONFIG_BOOT_TRACE},
     {"repeat", CONFIG_BOOT_TRACE},
     {"file_prefix", CONFIG_BOOT_TRACE},
-    {"increment", CONFIG_BOOT_TRACE}
+    {"increment", CONFIG_BOOT_TRACE},
+    {"decompress", DECOMPRESS_TRACE_FILE}
 };
 
 const std::set<std::string> CLOCK_TYPE = {
@@ -577,6 +588,8 @@ static void ShowHelp(const std::string& cmd)
            "                         D or Debug, I or Info, C or Critical, M or Commercial.\n"
            "  --get_level            Query the system parameter \"persist.hitrace.level.threshold\",\n"
            "                         which can control the level threshold of tracing.\n"
+           "  --decompress file      Convert a raw trace file with compressed cpu raw sections to the plain\n"
+           "                         format, the converted file is written to the path given by \"-o filename\".\n"
     );
     if (ShouldShowBootTraceHelp()) {
         ShowBootTraceHelp();
@@ -633,6 +646,21 @@ static bool GetTraceLevel()
     }
 }
 
+static bool HandleDecompressTraceFile()
+{
+    g_traceSysEventParams.opt = "Decompress";
+    if (g_traceArgs.output.empty()) {
+        ConsoleLog("error: the output file is not specified. eg: \"--decompress file -o filename\".");
+        return false;
+    }
+    if (!DecompressTraceFile(g_traceArgs.input, g_traceArgs.output)) {
+        ConsoleLog("error: decompress " + g_traceArgs.input + " failed.");
+        return false;
+    }
+    ConsoleLog("decompress done, output: " + g_traceArgs.output);
+    return true;
+}
+
 template <typename T>
 inline bool StrToNum(const std::string& sString, T &tX)
 {
@@ -1473,6 +1501,20 @@ static bool HandleOptOutput(const RunningState& setValue)
     return isTrue;
 }
 
+static bool HandleOptDecompress(const RunningState& setValue)
+{
+    if (!SetRunningState(setValue)) {
+        return false;
+    }
+    struct stat buf;
+    if (optarg == nullptr || stat(optarg, &buf) != 0 || !S_ISREG(buf.st_mode)) {
+        ConsoleLog("error: the trace file to decompress is illegal. eg: \"--decompress file -o filename\".");
+        return false;
+    }
+    g_traceArgs.input = optarg;
+    return true;
+}
+
 static bool HandleOptBootFilePrefix(const RunningState& setValue)
 {
     if (setValue != CONFIG_BOOT_TRACE) {
@@ -34,6 +34,20 @@ constexpr int DEFAULT_FILE_SIZE = 100 * 1024;
 static const char* const TRACE_TAG_ENABLE_FLAGS = "debug.hitrace.tags.enableflags";
 static const char* const TRACE_KEY_APP_PID = "debug.hitrace.app_pid";
 static const char* const TRACE_LEVEL_THRESHOLD = "persist.hitrace.level.threshold";
+// 选择trace落盘引擎，"splice" 表示使用splice，"io_uring" 表示使用io_uring，其余值使用默认的read/write
+static const char* const TRACE_DUMP_ENGINE = "persist.hitrace.dump.engine";
+// 选择cache trace的缓存方式，"memory" 表示缓存在内存中、仅在取trace时落盘，其余值按切片持续落盘
+static const char* const TRACE_CACHE_MODE = "persist.hitrace.cache.mode";
+// record/cache trace文件中cpu raw数据的zlib压缩等级（1~9），0或未设置表示不压缩
+static const char* const TRACE_COMPRESS_LEVEL = "persist.hitrace.record.compress_level";
+// 为true时，trace文件的cmdlines/tgids只记录cpu raw数据中出现过的任务
+static const char* const TRACE_SEEN_PIDS_ONLY = "persist.hitrace.dump.seen_pids_only";
+// 为true时，设置了过滤进程的trace在转储cpu raw数据时丢弃其他任务的事件
+static const char* const TRACE_FILTER_EVENT_PIDS = "persist.hitrace.dump.filter_event_pids";
+// 为true时，record/cache trace切片的events format、header page、printk formats只在同目录的sidecar文件中保存一份
+static const char* const TRACE_METADATA_SIDECAR = "persist.hitrace.dump.metadata_sidecar";
+// 为true时，trace文件附带kallsyms段，只记录cpu raw数据中出现过的内核地址对应的符号
+static const char* const TRACE_DUMP_KALLSYMS = "persist.hitrace.dump.kallsyms";
 // 标记 boot-trace 是否正在进行的临时参数（非 persist）
 static const char* const TRACE_BOOT_ACTIVE_FLAG = "debug.hitrace.boot_trace.active";
 
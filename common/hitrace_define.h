@@ -17,12 +17,19 @@
 #define HITRACE_DEFINE_H
 
 #include <inttypes.h>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace OHOS {
 namespace HiviewDFX {
 namespace Hitrace {
+class TraceDumpBufferPool;
+class TraceProcessTable;
+class TraceSeenPids;
+class TracePagePids;
+class TraceSeenAddrs;
+
 constexpr int TRACE_FILE_LEN = 128;
 
 enum TraceMode : uint8_t {
@@ -40,6 +47,13 @@ enum TraceDumpType : uint8_t {
     TRACE_ASYNC_WRITE = 4,
 };
 
+enum TraceDumpEngine : uint8_t {
+    ENGINE_DEFAULT = 0, // read/write loop
+    ENGINE_SPLICE = 1, // splice, the read/write loop takes over where it is unsupported
+    ENGINE_IO_URING = 2, // io_uring, falls back to ENGINE_DEFAULT when it is unavailable
+    ENGINE_FLIGHT_RECORDER = 3, // pages kept in memory by the flight recorder of cache trace, not trace_pipe_raw
+};
+
 enum TraceErrorCode : uint8_t {
     SUCCESS = 0,
     TRACE_NOT_SUPPORTED = 1,
@@ -70,6 +84,17 @@ struct TraceDumpRequest {
     uint64_t traceEndTime = std::numeric_limits<uint64_t>::max();
     uint64_t taskId = 0;
     uint64_t cacheSliceDuration = 0;
+    TraceDumpEngine engine = TraceDumpEngine::ENGINE_DEFAULT;
+    int compressLevel = 0; // compress the cpu raw sections of record and cache files if it is not 0
+    std::shared_ptr<TraceDumpBufferPool> bufferPool = nullptr; // set by the dump strategy for one session
+    std::shared_ptr<TraceProcessTable> processTable = nullptr; // set by the dump strategy, scanned once per file
+    bool seenPidsOnly = false; // cmdlines and tgids only list the tasks of the dumped cpu raw pages
+    std::shared_ptr<TraceSeenPids> seenPids = nullptr; // set by the dump strategy if seenPidsOnly is set
+    bool filterEventPids = false; // drop the events of the tasks out of the trace filter pids from cpu raw pages
+    std::shared_ptr<TracePagePids> eventPids = nullptr; // set by the dump strategy if filterEventPids is set
+    bool metadataSidecar = false; // keep the static sections of record and cache slices in a shared sidecar file
+    bool withKallsyms = false; // write the kernel symbols of the addresses in the dumped cpu raw pages
+    std::shared_ptr<TraceSeenAddrs> seenAddrs = nullptr; // set by the dump strategy if withKallsyms is set
 };
 
 struct TraceRetInfo {
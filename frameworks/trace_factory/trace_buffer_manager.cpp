@@ -18,6 +18,7 @@
 #include <cinttypes>
 #include <memory>
 #include <mutex>
+#include <sys/mman.h>
 
 #include "hilog/log.h"
 #include "securec.h"
@@ -36,6 +37,39 @@ namespace {
 #endif
 } // namespace
 
+BufferBlockMemory::BufferBlockMemory(size_t size) : size_(size)
+{
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+        HILOG_ERROR(LOG_CORE, "BufferBlockMemory : mmap %{public}zu bytes failed, errno(%{public}d)", size, errno);
+        return;
+    }
+    addr_ = static_cast<uint8_t*>(addr);
+}
+
+BufferBlockMemory::~BufferBlockMemory()
+{
+    if (addr_ != nullptr) {
+        munmap(addr_, size_);
+    }
+}
+
+void BufferBlockMemory::MarkIdle()
+{
+    if (addr_ == nullptr) {
+        return;
+    }
+#ifdef MADV_FREE
+    if (madvise(addr_, size_, MADV_FREE) == 0) {
+        return;
+    }
+#endif
+    // the kernel does not support MADV_FREE, the pages are dropped at once and refaulted on reuse.
+    if (madvise(addr_, size_, MADV_DONTNEED) != 0) {
+        HILOG_WARN(LOG_CORE, "BufferBlockMemory : madvise failed, errno(%{public}d)", errno);
+    }
+}
+
 size_t BufferBlock::FreeBytes() const
 {
     return data.size() - usedBytes;
@@ -55,11 +89,144 @@ bool BufferBlock::Append(const uint8_t* src, size_t size)
     return true;
 }
 
+uint8_t* BufferBlock::Tail() const
+{
+    if (data.data() == nullptr) {
+        return nullptr;
+    }
+    return data.data() + usedBytes;
+}
+
+bool BufferBlock::Commit(size_t size)
+{
+    if (FreeBytes() < size) {
+        HILOG_ERROR(LOG_CORE, "Commit : cannot commit more data");
+        return false;
+    }
+    usedBytes += size;
+    return true;
+}
+
+BufferBlockPool::BufferBlockPool(size_t blockSz, size_t maxIdleSz, int64_t idleTimeoutS)
+    : blockSz_(blockSz), maxIdleCnt_(blockSz != 0 ? maxIdleSz / blockSz : 0), idleTimeout_(idleTimeoutS) {}
+
+BufferBlockPtr BufferBlockPool::Acquire(const int cpu)
+{
+    std::unique_ptr<BufferBlock> block = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex_);
+        TrimIdleBlocksLocked(false);
+        // the most recently released block is the one most likely to still have its pages resident.
+        if (!idleBlocks_.empty()) {
+            block = std::move(idleBlocks_.back().block);
+            idleBlocks_.pop_back();
+        }
+    }
+    if (block == nullptr) {
+        block = std::make_unique<BufferBlock>(cpu, blockSz_);
+        if (block->data.data() == nullptr) {
+            return nullptr;
+        }
+    }
+    block->cpu = cpu;
+    block->usedBytes = 0;
+    std::weak_ptr<BufferBlockPool> pool = weak_from_this();
+    return BufferBlockPtr(block.release(), [pool](BufferBlock* released) { Recycle(pool, released); });
+}
+
+void BufferBlockPool::Recycle(std::weak_ptr<BufferBlockPool> pool, BufferBlock* block)
+{
+    std::unique_ptr<BufferBlock> released(block);
+    if (auto alive = pool.lock(); alive != nullptr) {
+        alive->PutIdleBlock(std::move(released));
+    }
+}
+
+void BufferBlockPool::PutIdleBlock(std::unique_ptr<BufferBlock> block)
+{
+    block->usedBytes = 0;
+    block->data.MarkIdle();
+    std::lock_guard<std::mutex> lock(poolMutex_);
+    idleBlocks_.push_back({std::move(block), std::chrono::steady_clock::now()});
+    TrimIdleBlocksLocked(false);
+}
+
+void BufferBlockPool::TrimIdleBlocks(const bool trimAll)
+{
+    std::lock_guard<std::mutex> lock(poolMutex_);
+    TrimIdleBlocksLocked(trimAll);
+}
+
+void BufferBlockPool::TrimIdleBlocksLocked(const bool trimAll)
+{
+    auto now = std::chrono::steady_clock::now();
+    // idle blocks are kept in release order, the oldest one is always at the front.
+    while (!idleBlocks_.empty()) {
+        if (!trimAll && idleBlocks_.size() <= maxIdleCnt_ && now - idleBlocks_.front().idleSince < idleTimeout_) {
+            break;
+        }
+        idleBlocks_.pop_front();
+    }
+}
+
+size_t BufferBlockPool::GetIdleBlockCount()
+{
+    std::lock_guard<std::mutex> lock(poolMutex_);
+    return idleBlocks_.size();
+}
+
+TraceDumpBufferPool::TraceDumpBufferPool(size_t bufferSz, size_t maxBufferCnt)
+    : bufferSz_(bufferSz), maxBufferCnt_(maxBufferCnt) {}
+
+std::shared_ptr<BufferBlockMemory> TraceDumpBufferPool::Acquire()
+{
+    std::unique_ptr<BufferBlockMemory> buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex_);
+        if (!idleBuffers_.empty()) {
+            buffer = std::move(idleBuffers_.back());
+            idleBuffers_.pop_back();
+        } else if (mappedBufferCnt_ < maxBufferCnt_) {
+            mappedBufferCnt_++;
+        } else {
+            HILOG_ERROR(LOG_CORE, "Acquire : all the %{public}zu dump buffers are lent", maxBufferCnt_);
+            return nullptr;
+        }
+    }
+    if (buffer == nullptr) {
+        buffer = std::make_unique<BufferBlockMemory>(bufferSz_);
+        if (buffer->size() == 0) {
+            std::lock_guard<std::mutex> lock(poolMutex_);
+            mappedBufferCnt_--;
+            return nullptr;
+        }
+    }
+    std::weak_ptr<TraceDumpBufferPool> pool = weak_from_this();
+    return std::shared_ptr<BufferBlockMemory>(buffer.release(),
+        [pool](BufferBlockMemory* released) { Recycle(pool, released); });
+}
+
+void TraceDumpBufferPool::Recycle(std::weak_ptr<TraceDumpBufferPool> pool, BufferBlockMemory* buffer)
+{
+    std::unique_ptr<BufferBlockMemory> released(buffer);
+    if (auto alive = pool.lock(); alive != nullptr) {
+        std::lock_guard<std::mutex> lock(alive->poolMutex_);
+        alive->idleBuffers_.push_back(std::move(released));
+    }
+}
+
+size_t TraceDumpBufferPool::GetMappedBufferCount()
+{
+    std::lock_guard<std::mutex> lock(poolMutex_);
+    return mappedBufferCnt_;
+}
+
 TraceBufferManager::TraceBufferManager()
 {
     maxTotalSz_ = DEFAULT_MAX_TOTAL_SZ;
     blockSz_ = DEFAULT_BLOCK_SZ;
     curTotalSz_.store(0, std::memory_order_relaxed);
+    blockPool_ = std::make_shared<BufferBlockPool>(blockSz_, DEFAULT_MAX_IDLE_SZ, DEFAULT_BLOCK_IDLE_TIMEOUT_S);
 }
 
 TraceBufferManager::~TraceBufferManager() {}
@@ -93,10 +260,15 @@ BufferBlockPtr TraceBufferManager::AllocateBlock(const uint64_t taskId, const in
         HILOG_ERROR(LOG_CORE, "AllocateBlock : taskid(%{public}" PRIu64 ") cannot allocate more blocks", taskId);
         return nullptr;
     }
-    auto buffer = std::make_shared<BufferBlock>(cpu, blockSz_);
     if (!TryAllocateMemorySpace(taskId)) {
         return nullptr;
     }
+    auto buffer = blockPool_->Acquire(cpu);
+    if (buffer == nullptr) {
+        HILOG_ERROR(LOG_CORE, "AllocateBlock : taskid(%{public}" PRIu64 ") failed to map a block", taskId);
+        curTotalSz_.fetch_sub(blockSz_, std::memory_order_relaxed);
+        return nullptr;
+    }
     {
         std::unique_lock<std::shared_mutex> globalWriteLock(globalMutex_);
         taskBuffers_[taskId].push_back(buffer);
@@ -147,6 +319,16 @@ size_t TraceBufferManager::GetBlockSize() const
 {
     return blockSz_;
 }
+
+size_t TraceBufferManager::GetIdleBlockCount()
+{
+    return blockPool_->GetIdleBlockCount();
+}
+
+void TraceBufferManager::TrimIdleBlocks()
+{
+    blockPool_->TrimIdleBlocks(true);
+}
 } // namespace Hitrace
 } // namespace HiviewDFX
 } // namespace OHOS
\ No newline at end of file
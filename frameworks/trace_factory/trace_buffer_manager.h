@@ -17,9 +17,12 @@
 #define TRACE_BUFFER_MANAGER_H
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <vector>
 
@@ -28,6 +31,26 @@
 namespace OHOS {
 namespace HiviewDFX {
 namespace Hitrace {
+/**
+ * @brief BufferBlockMemory is an anonymous mapping which holds the data of a BufferBlock.
+ * @note The mapping is never zero-filled by user space, only the bytes which have been read are meaningful.
+ */
+class BufferBlockMemory {
+public:
+    explicit BufferBlockMemory(size_t size);
+    ~BufferBlockMemory();
+    BufferBlockMemory(const BufferBlockMemory&) = delete;
+    BufferBlockMemory& operator=(const BufferBlockMemory&) = delete;
+    uint8_t* data() const { return addr_; }
+    size_t size() const { return addr_ != nullptr ? size_ : 0; }
+    // let the kernel reclaim the pages lazily while the block is idle in the pool.
+    void MarkIdle();
+
+private:
+    uint8_t* addr_ = nullptr;
+    size_t size_ = 0;
+};
+
 /**
  * @brief BufferBlock is a block of memory that can be used to store trace data.
  * @note The current trace collection service already ensures that memory reading and writing are serial,
@@ -37,7 +60,7 @@ struct BufferBlock {
     // cpu index
     int cpu;
     // data buffer
-    std::vector<uint8_t> data;
+    BufferBlockMemory data;
     // used bytes
     size_t usedBytes = 0;
     // constructor
@@ -46,6 +69,10 @@ struct BufferBlock {
     size_t FreeBytes() const;
     // append data
     bool Append(const uint8_t* src, size_t size);
+    // start of the free bytes, data can be read into it directly and then committed
+    uint8_t* Tail() const;
+    // commit the data which has been placed at the tail
+    bool Commit(size_t size);
 };
 
 using BufferBlockPtr = std::shared_ptr<BufferBlock>;
@@ -53,6 +80,59 @@ using BufferList = std::list<BufferBlockPtr>;
 
 constexpr size_t DEFAULT_BLOCK_SZ = 10 * 1024 * 1024; // 10 MB
 constexpr size_t DEFAULT_MAX_TOTAL_SZ = 300 * 1024 * 1024; // 300 MB
+constexpr size_t DEFAULT_MAX_IDLE_SZ = 100 * 1024 * 1024; // 100 MB
+constexpr int64_t DEFAULT_BLOCK_IDLE_TIMEOUT_S = 60; // 60 : unmap the blocks which have been idle for 60 seconds
+
+/**
+ * @brief BufferBlockPool recycles the blocks released by finished tasks.
+ * @note A block returns to the pool when the last reference to it is dropped, so a task which still holds its
+ *       buffer list after ReleaseTaskBlocks keeps the memory valid.
+ */
+class BufferBlockPool : public std::enable_shared_from_this<BufferBlockPool> {
+public:
+    BufferBlockPool(size_t blockSz, size_t maxIdleSz, int64_t idleTimeoutS);
+    BufferBlockPtr Acquire(const int cpu);
+    void TrimIdleBlocks(const bool trimAll = false);
+    size_t GetIdleBlockCount();
+
+private:
+    struct IdleBlock {
+        std::unique_ptr<BufferBlock> block;
+        std::chrono::steady_clock::time_point idleSince;
+    };
+    static void Recycle(std::weak_ptr<BufferBlockPool> pool, BufferBlock* block);
+    void PutIdleBlock(std::unique_ptr<BufferBlock> block);
+    void TrimIdleBlocksLocked(const bool trimAll);
+
+    size_t blockSz_;
+    size_t maxIdleCnt_;
+    std::chrono::seconds idleTimeout_;
+    std::mutex poolMutex_;
+    std::list<IdleBlock> idleBlocks_;
+};
+
+/**
+ * @brief TraceDumpBufferPool lends the staging buffers of the content writers of one dump session.
+ * @note The buffers are mapped on demand, at most maxBufferCnt of them, and unmapped with the last reference to the
+ *       pool, so the memory is only held while the session is active.
+ */
+class TraceDumpBufferPool : public std::enable_shared_from_this<TraceDumpBufferPool> {
+public:
+    TraceDumpBufferPool(size_t bufferSz, size_t maxBufferCnt);
+    // nullptr if all the buffers are lent, a buffer returns to the pool when its last reference is dropped.
+    std::shared_ptr<BufferBlockMemory> Acquire();
+    size_t GetBufferSize() const { return bufferSz_; }
+    size_t GetMappedBufferCount();
+
+private:
+    static void Recycle(std::weak_ptr<TraceDumpBufferPool> pool, BufferBlockMemory* buffer);
+
+    size_t bufferSz_;
+    size_t maxBufferCnt_;
+    size_t mappedBufferCnt_ = 0;
+    std::mutex poolMutex_;
+    std::vector<std::unique_ptr<BufferBlockMemory>> idleBuffers_;
+};
 
 class TraceBufferManager : public Singleton<TraceBufferManager> {
     DECLARE_SINGLETON(TraceBufferManager);
@@ -63,6 +143,8 @@ public:
     size_t GetTaskTotalUsedBytes(const uint64_t taskId);
     size_t GetCurrentTotalSize();
     size_t GetBlockSize() const;
+    size_t GetIdleBlockCount();
+    void TrimIdleBlocks();
 
 private:
     bool TryAllocateMemorySpace(uint64_t taskId);
@@ -72,6 +154,8 @@ private:
     size_t blockSz_;
     std::atomic_size_t curTotalSz_;
     mutable std::shared_mutex globalMutex_;
+    // declared before taskBuffers_, the blocks still owned by tasks are recycled into a living pool on destruction.
+    std::shared_ptr<BufferBlockPool> blockPool_;
     std::map<uint64_t, BufferList> taskBuffers_;
 };
 } // namespace Hitrace
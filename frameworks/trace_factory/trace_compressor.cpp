@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace_compressor.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "common_define.h"
+#include "hilog/log.h"
+#include "smart_fd.h"
+#include "trace_content.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+#ifdef LOG_DOMAIN
+#undef LOG_DOMAIN
+#define LOG_DOMAIN 0xD002D33
+#endif
+#ifdef LOG_TAG
+#undef LOG_TAG
+#define LOG_TAG "HitraceCompressor"
+#endif
+
+namespace {
+constexpr size_t MAX_CHUNK_SIZE = PAGE_INDEX_STRIDE * PAGE_SIZE;
+constexpr size_t COPY_BUFFER_SIZE = 64 * 1024;
+
+bool ReadFull(const int fd, void* buffer, const size_t size)
+{
+    return TEMP_FAILURE_RETRY(read(fd, buffer, size)) == static_cast<ssize_t>(size);
+}
+
+bool WriteFull(const int fd, const void* buffer, const size_t size)
+{
+    return TEMP_FAILURE_RETRY(write(fd, buffer, size)) == static_cast<ssize_t>(size);
+}
+
+bool CopySectionBody(const int srcFd, const int dstFd, uint32_t length)
+{
+    std::vector<uint8_t> buffer(std::min(static_cast<size_t>(length), COPY_BUFFER_SIZE));
+    while (length > 0) {
+        size_t chunk = std::min(static_cast<size_t>(length), buffer.size());
+        if (!ReadFull(srcFd, buffer.data(), chunk) || !WriteFull(dstFd, buffer.data(), chunk)) {
+            return false;
+        }
+        length -= static_cast<uint32_t>(chunk);
+    }
+    return true;
+}
+
+// write the pages of a compressed section as a plain cpu raw section, its length is backfilled at the end.
+bool DecompressSection(const int srcFd, const int dstFd, const uint32_t length)
+{
+    TraceCompressedRawHeader rawHeader;
+    if (length < sizeof(rawHeader) || !ReadFull(srcFd, &rawHeader, sizeof(rawHeader)) ||
+        rawHeader.algorithm != TRACE_COMPRESS_ZLIB) {
+        HILOG_ERROR(LOG_CORE, "DecompressSection: invalid compressed section header.");
+        return false;
+    }
+    off_t headerOffset = lseek(dstFd, 0, SEEK_CUR);
+    TraceFileContentHeader plainHeader;
+    plainHeader.type = static_cast<uint8_t>(CONTENT_TYPE_CPU_RAW + rawHeader.cpu);
+    if (headerOffset == -1 || !WriteFull(dstFd, &plainHeader, sizeof(plainHeader))) {
+        return false;
+    }
+    uint32_t readLen = sizeof(rawHeader);
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> raw;
+    while (readLen + sizeof(TraceCompressedChunkHeader) <= length) {
+        TraceCompressedChunkHeader chunkHeader;
+        if (!ReadFull(srcFd, &chunkHeader, sizeof(chunkHeader)) || chunkHeader.uncompressedSize > MAX_CHUNK_SIZE ||
+            chunkHeader.compressedSize > chunkHeader.uncompressedSize ||
+            readLen + sizeof(chunkHeader) + chunkHeader.compressedSize > length) {
+            HILOG_ERROR(LOG_CORE, "DecompressSection: invalid chunk header.");
+            return false;
+        }
+        data.resize(chunkHeader.compressedSize);
+        if (!ReadFull(srcFd, data.data(), data.size())) {
+            return false;
+        }
+        readLen += sizeof(chunkHeader) + chunkHeader.compressedSize;
+        if (chunkHeader.compressedSize == chunkHeader.uncompressedSize) {
+            raw.swap(data);
+        } else {
+            raw.resize(chunkHeader.uncompressedSize);
+            if (!TraceChunkCompressor::Decompress(data.data(), data.size(), raw)) {
+                return false;
+            }
+        }
+        if (!WriteFull(dstFd, raw.data(), raw.size())) {
+            return false;
+        }
+        plainHeader.length += static_cast<uint32_t>(raw.size());
+    }
+    return TEMP_FAILURE_RETRY(pwrite(dstFd, &plainHeader, sizeof(plainHeader), headerOffset)) ==
+        static_cast<ssize_t>(sizeof(plainHeader)) && lseek(srcFd, length - readLen, SEEK_CUR) != -1;
+}
+} // namespace
+
+TraceChunkCompressor::TraceChunkCompressor(const int level, const int workerCount)
+    : level_(std::clamp(level, TRACE_COMPRESS_LEVEL_MIN, TRACE_COMPRESS_LEVEL_MAX))
+{
+    for (int i = 0; i < std::max(workerCount, 1); i++) {
+        workers_.emplace_back(&TraceChunkCompressor::WorkLoop, this);
+    }
+}
+
+TraceChunkCompressor::~TraceChunkCompressor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    jobCond_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void TraceChunkCompressor::Submit(const std::shared_ptr<TraceRawChunk>& chunk)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(chunk);
+    }
+    jobCond_.notify_one();
+}
+
+void TraceChunkCompressor::Wait(const std::shared_ptr<TraceRawChunk>& chunk)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    doneCond_.wait(lock, [&chunk] { return chunk->done; });
+}
+
+void TraceChunkCompressor::WorkLoop()
+{
+    while (true) {
+        std::shared_ptr<TraceRawChunk> chunk;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            jobCond_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+            if (jobs_.empty()) {
+                return;
+            }
+            chunk = jobs_.front();
+            jobs_.pop_front();
+        }
+        if (!Compress(level_, chunk->raw, chunk->compressed) || chunk->compressed.size() >= chunk->raw.size()) {
+            chunk->compressed.clear();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            chunk->done = true;
+        }
+        doneCond_.notify_all();
+    }
+}
+
+bool TraceChunkCompressor::Compress(const int level, const std::vector<uint8_t>& raw, std::vector<uint8_t>& compressed)
+{
+    uLongf compressedSize = compressBound(static_cast<uLong>(raw.size()));
+    compressed.resize(compressedSize);
+    int ret = compress2(compressed.data(), &compressedSize, raw.data(), static_cast<uLong>(raw.size()), level);
+    if (ret != Z_OK) {
+        HILOG_WARN(LOG_CORE, "TraceChunkCompressor: compress failed, ret(%{public}d).", ret);
+        return false;
+    }
+    compressed.resize(compressedSize);
+    return true;
+}
+
+bool TraceChunkCompressor::Decompress(const uint8_t* data, const size_t size, std::vector<uint8_t>& raw)
+{
+    uLongf rawSize = static_cast<uLongf>(raw.size());
+    int ret = uncompress(raw.data(), &rawSize, data, static_cast<uLong>(size));
+    if (ret != Z_OK || rawSize != raw.size()) {
+        HILOG_ERROR(LOG_CORE, "TraceChunkCompressor: uncompress failed, ret(%{public}d).", ret);
+        return false;
+    }
+    return true;
+}
+
+bool DecompressTraceFile(const std::string& srcFile, const std::string& dstFile)
+{
+    SmartFd srcFd(open(srcFile.c_str(), O_RDONLY));
+    TraceFileHeader fileHeader;
+    if (!srcFd || !ReadFull(srcFd.GetFd(), &fileHeader, sizeof(fileHeader)) ||
+        fileHeader.magicNumber != MAGIC_NUMBER) {
+        HILOG_ERROR(LOG_CORE, "DecompressTraceFile: %{public}s is not a raw trace file.", srcFile.c_str());
+        return false;
+    }
+    SmartFd dstFd(open(dstFile.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644)); // 0644 : -rw-r--r--
+    fileHeader.versionNumber = VERSION_NUMBER;
+    if (!dstFd || !WriteFull(dstFd.GetFd(), &fileHeader, sizeof(fileHeader))) {
+        HILOG_ERROR(LOG_CORE, "DecompressTraceFile: write %{public}s failed, errno(%{public}d).", dstFile.c_str(),
+            errno);
+        return false;
+    }
+    TraceFileContentHeader contentHeader;
+    bool ret = true;
+    while (ret && ReadFull(srcFd.GetFd(), &contentHeader, sizeof(contentHeader)) &&
+        contentHeader.type != CONTENT_TYPE_DEFAULT) {
+        if (contentHeader.type == CONTENT_TYPE_CPU_RAW_COMPRESSED) {
+            ret = DecompressSection(srcFd.GetFd(), dstFd.GetFd(), contentHeader.length);
+        } else if (contentHeader.type == CONTENT_TYPE_PAGE_INDEX || contentHeader.type == CONTENT_TYPE_SECTION_TABLE) {
+            ret = lseek(srcFd.GetFd(), contentHeader.length, SEEK_CUR) != -1;
+        } else {
+            ret = WriteFull(dstFd.GetFd(), &contentHeader, sizeof(contentHeader)) &&
+                CopySectionBody(srcFd.GetFd(), dstFd.GetFd(), contentHeader.length);
+        }
+    }
+    ret = ret && AppendSectionTable(dstFd.GetFd());
+    if (!ret) {
+        HILOG_ERROR(LOG_CORE, "DecompressTraceFile: convert %{public}s failed.", srcFile.c_str());
+        unlink(dstFile.c_str());
+    }
+    return ret;
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRACE_COMPRESSOR_H
+#define TRACE_COMPRESSOR_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+constexpr int TRACE_COMPRESS_LEVEL_MIN = 1;
+constexpr int TRACE_COMPRESS_LEVEL_MAX = 9;
+
+struct TraceRawChunk {
+    std::vector<uint8_t> raw;
+    std::vector<uint8_t> compressed; // empty if the pages do not shrink, they are stored as they are then
+    uint32_t pageCount = 0;
+    uint64_t firstTimestamp = 0;
+    uint64_t lastTimestamp = 0;
+    bool done = false;
+};
+
+/**
+ * @brief TraceChunkCompressor compresses the chunks of raw pages with zlib in its worker threads, the chunks are
+ *        handed out in the order they were submitted by waiting on them one by one.
+ */
+class TraceChunkCompressor {
+public:
+    TraceChunkCompressor(const int level, const int workerCount);
+    ~TraceChunkCompressor();
+
+    void Submit(const std::shared_ptr<TraceRawChunk>& chunk);
+    void Wait(const std::shared_ptr<TraceRawChunk>& chunk);
+
+    static bool Compress(const int level, const std::vector<uint8_t>& raw, std::vector<uint8_t>& compressed);
+    static bool Decompress(const uint8_t* data, const size_t size, std::vector<uint8_t>& raw);
+
+private:
+    void WorkLoop();
+
+    int level_ = TRACE_COMPRESS_LEVEL_MIN;
+    std::mutex mutex_;
+    std::condition_variable jobCond_;
+    std::condition_variable doneCond_;
+    std::deque<std::shared_ptr<TraceRawChunk>> jobs_;
+    std::vector<std::thread> workers_;
+    bool stop_ = false;
+};
+
+/**
+ * @brief convert a trace file with compressed cpu raw sections to the plain format of VERSION_NUMBER, the page
+ *        index is dropped since the offsets of the pages change, the section table is built again.
+ */
+bool DecompressTraceFile(const std::string& srcFile, const std::string& dstFile);
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
+#endif // TRACE_COMPRESSOR_H
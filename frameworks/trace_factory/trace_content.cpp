@@ -15,12 +15,14 @@
 
 #include "trace_content.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
-#include <dirent.h>
 #include <fcntl.h>
-#include <fstream>
+#include <functional>
 #include <hilog/log.h>
+#include <set>
 #include <string>
 #include <unistd.h>
 
@@ -29,6 +31,8 @@
 #include "hitrace_option_util.h"
 #include "securec.h"
 #include "trace_file_utils.h"
+#include "trace_flight_recorder.h"
+#include "trace_io_uring.h"
 #include "trace_json_parser.h"
 #include "trace_context.h"
 
@@ -45,20 +49,34 @@ namespace Hitrace {
 #endif
 namespace {
 constexpr int KB_PER_MB = 1024;
-constexpr int JUDGE_FILE_EXIST = 10;  // Check whether the trace file exists every 10 times.
-constexpr int BUFFER_SIZE = 256 * PAGE_SIZE; // 1M
-constexpr uint8_t HM_FILE_RAW_TRACE = 1;
+constexpr int BUFFER_SIZE = static_cast<int>(CONTENT_BUFFER_SIZE);
 constexpr char BOOT_TRACE_INLINE_EVENT_FMT_ENV[] = "HITRACE_BOOT_INLINE_EVENT_FMT";
+constexpr size_t PAGE_HEADER_PEEK_SIZE = sizeof(uint64_t) * 2; // page timestamp + page commit size
+constexpr uint16_t URING_SLOT_COUNT = 64; // 64 * 4K registered buffers
+constexpr uint16_t URING_READ_DEPTH = 32; // max linked reads of one batch, two batches may be in flight
+constexpr int32_t URING_READ_PENDING = std::numeric_limits<int32_t>::min();
+constexpr unsigned URING_ENTRIES = URING_SLOT_COUNT * 2;
+constexpr uint64_t URING_OP_READ = 1;
+constexpr uint64_t URING_OP_WRITE = 2;
+constexpr int URING_OP_SHIFT = 32;
+constexpr int COMPRESS_MAX_WORKERS = 4;
+constexpr size_t COMPRESS_CHUNK_SIZE = PAGE_INDEX_STRIDE * PAGE_SIZE;
+constexpr size_t COMPRESS_MAX_PENDING_CHUNKS = 2 * BUFFER_SIZE / COMPRESS_CHUNK_SIZE; // 2 : two read buffers
 
 /**
  * @note async trace dump mode is performed in parallel with other modes,
- *       the following variables are required to be thread isolated.
+ *       the following variable is required to be thread isolated.
  */
-thread_local int g_writeFileLimit = 0;
 thread_local int g_outputFileSize = 0;
-thread_local uint8_t g_buffer[BUFFER_SIZE] = { 0 };
 
-static void PreWriteAllTraceEventsFormat(const int fd)
+/**
+ * @note splice support only depends on the kernel and the output file system, once it has been found
+ *       unsupported, all the following dumps go back to the read/write loop directly.
+ */
+std::atomic<bool> g_spliceUnsupported { false };
+
+// the formats of all the tags, they are dumped when no trace has been opened by this process.
+static std::vector<std::string> GetAllTraceEventsFormat()
 {
     const TraceJsonParser& traceJsonParser = TraceJsonParser::Instance();
     const std::map<std::string, TraceTag>& allTags = traceJsonParser.GetAllTagInfos();
@@ -68,12 +86,7 @@ static void PreWriteAllTraceEventsFormat(const int fd)
             traceFormats.emplace_back(fmt);
         }
     }
-    for (auto& traceFmt : traceFormats) {
-        std::string srcPath = GetTraceRootPath() + traceFmt;
-        if (access(srcPath.c_str(), R_OK) != -1) {
-            WriteEventFile(srcPath, fd);
-        }
-    }
+    return traceFormats;
 }
 
 static bool IsBootTraceInlineEventFmtEnabled()
@@ -97,6 +110,39 @@ static int IsCurrentTracePageValid(const uint64_t pageTraceTime, const uint64_t
     return 1; // hit.
 }
 
+static bool IsSpliceUnsupportedError(const int err)
+{
+    return err == EINVAL || err == ENOSYS || err == EOPNOTSUPP || err == EBADF || err == EXDEV;
+}
+
+static bool CreateSplicePipe(SmartFd& pipeRead, SmartFd& pipeWrite, const int pipeSize)
+{
+    int pipeFds[2] = { -1, -1 };
+    if (pipe2(pipeFds, O_CLOEXEC) != 0) {
+        HILOG_WARN(LOG_CORE, "CreateSplicePipe: pipe2 failed, errno(%{public}d)", errno);
+        return false;
+    }
+    pipeRead = SmartFd(pipeFds[0]);
+    pipeWrite = SmartFd(pipeFds[1]);
+    if (pipeSize > 0 && fcntl(pipeWrite.GetFd(), F_SETPIPE_SZ, pipeSize) < 0) {
+        HILOG_DEBUG(LOG_CORE, "CreateSplicePipe: set pipe size(%{public}d) failed, errno(%{public}d)",
+            pipeSize, errno);
+    }
+    return true;
+}
+
+/**
+ * @brief drain the bytes left in the pipe, the caller decides whether they are kept.
+ */
+static ssize_t DrainSplicePipe(const int pipeReadFd, const int bytes, uint8_t* buffer, const int bufferSize)
+{
+    ssize_t readBytes = TEMP_FAILURE_RETRY(read(pipeReadFd, buffer, std::min(bytes, bufferSize)));
+    if (readBytes < 0) {
+        HILOG_ERROR(LOG_CORE, "DrainSplicePipe: read failed, errno(%{public}d)", errno);
+    }
+    return readBytes;
+}
+
 static void UpdateFirstLastPageTimeStamp(const uint64_t pageTraceTime, bool& printFirstPageTime,
     uint64_t& firstPageTimeStamp, uint64_t& lastPageTimeStamp)
 {
@@ -107,12 +153,114 @@ static void UpdateFirstLastPageTimeStamp(const uint64_t pageTraceTime, bool& pri
         firstPageTimeStamp = std::min(firstPageTimeStamp, pageTraceTime);
     }
 }
+
+// the leading decimal of a saved_cmdlines or saved_tgids line, -1 if there is none.
+static int ParseLeadingPid(const char* line)
+{
+    if (*line < '0' || *line > '9') {
+        return -1;
+    }
+    return static_cast<int>(strtol(line, nullptr, 10)); // 10 : decimal
+}
+
+// a saved_tgids line is "<tid> <tgid>".
+static bool ParseTgidLine(const char* line, int& tid, int& tgid)
+{
+    tid = ParseLeadingPid(line);
+    const char* separator = strchr(line, ' ');
+    if (tid < 0 || separator == nullptr) {
+        return false;
+    }
+    tgid = ParseLeadingPid(separator + 1);
+    return tgid >= 0;
+}
+}
+
+bool TraceSectionWriter::Begin(TraceFileContentHeader& contentHeader, const uint8_t contentType)
+{
+    contentHeader.type = contentType;
+    headerOffset_ = lseek(fd_, 0, SEEK_CUR);
+    if (headerOffset_ == -1) {
+        HILOG_ERROR(LOG_CORE, "TraceSectionWriter: lseek to current position failed, errno(%{public}d)", errno);
+        return false;
+    }
+    ssize_t writeRet = TEMP_FAILURE_RETRY(write(fd_, reinterpret_cast<char *>(&contentHeader),
+        sizeof(contentHeader)));
+    if (writeRet != static_cast<ssize_t>(sizeof(contentHeader))) {
+        HILOG_ERROR(LOG_CORE, "TraceSectionWriter: failed to write content header, errno(%{public}d)", errno);
+        headerOffset_ = -1;
+        return false;
+    }
+    return true;
+}
+
+bool TraceSectionWriter::Commit(const TraceFileContentHeader& contentHeader)
+{
+    if (headerOffset_ == -1) {
+        HILOG_WARN(LOG_CORE, "TraceSectionWriter: commit a section which has not begun.");
+        return false;
+    }
+    ssize_t writeRet = TEMP_FAILURE_RETRY(pwrite(fd_, reinterpret_cast<const char *>(&contentHeader),
+        sizeof(contentHeader), headerOffset_));
+    if (writeRet != static_cast<ssize_t>(sizeof(contentHeader))) {
+        HILOG_WARN(LOG_CORE, "TraceSectionWriter: backfill content header failed, errno(%{public}d)", errno);
+        return false;
+    }
+    return true;
+}
+
+void TraceSectionWriter::Discard()
+{
+    if (headerOffset_ == -1) {
+        return;
+    }
+    if (ftruncate(fd_, headerOffset_) == -1) {
+        HILOG_ERROR(LOG_CORE, "TraceSectionWriter: ftruncate failed, errno(%{public}d)", errno);
+    }
+    if (lseek(fd_, headerOffset_, SEEK_SET) == -1) {
+        HILOG_ERROR(LOG_CORE, "TraceSectionWriter: lseek to header position failed, errno(%{public}d)", errno);
+    }
+    headerOffset_ = -1;
+}
+
+off_t TraceSectionWriter::GetDataOffset() const
+{
+    if (headerOffset_ == -1) {
+        return -1;
+    }
+    return headerOffset_ + static_cast<off_t>(sizeof(TraceFileContentHeader));
 }
 
 ITraceContent::ITraceContent(const int fd,
                              const std::string& traceFilePath,
                              const bool ishm)
-    : traceFileFd_(fd), traceFilePath_(traceFilePath), isHm_(ishm) {}
+    : traceFileFd_(fd), traceFilePath_(traceFilePath), isHm_(ishm), sectionWriter_(fd) {}
+
+ITraceContent::BufferLease::BufferLease(ITraceContent& content) : content_(content)
+{
+    if (content_.buffer_ != nullptr) {
+        return;
+    }
+    if (content_.bufferPool_ == nullptr) {
+        content_.bufferPool_ = std::make_shared<TraceDumpBufferPool>(CONTENT_BUFFER_SIZE, CONTENT_BUFFER_MAX_COUNT);
+    }
+    auto bufferMemory = content_.bufferPool_->Acquire();
+    if (bufferMemory == nullptr || bufferMemory->size() < CONTENT_BUFFER_SIZE) {
+        HILOG_ERROR(LOG_CORE, "BufferLease: no staging buffer for %{public}s.", content_.traceFilePath_.c_str());
+        return;
+    }
+    content_.bufferMemory_ = bufferMemory;
+    content_.buffer_ = bufferMemory->data();
+    isOwner_ = true;
+}
+
+ITraceContent::BufferLease::~BufferLease()
+{
+    if (isOwner_) {
+        content_.buffer_ = nullptr;
+        content_.bufferMemory_ = nullptr;
+    }
+}
 
 bool ITraceContent::WriteTraceData(const uint8_t contentType)
 {
@@ -120,37 +268,47 @@ bool ITraceContent::WriteTraceData(const uint8_t contentType)
         HILOG_ERROR(LOG_CORE, "WriteTraceData: trace file (%{public}s) not found.", traceFilePath_.c_str());
         return false;
     }
-    TraceFileContentHeader contentHeader;
-    contentHeader.type = contentType;
-    auto dataHeaderStart = lseek(traceFileFd_, 0, SEEK_CUR);
-    if (lseek(traceFileFd_, sizeof(TraceFileContentHeader), SEEK_CUR) == -1) {
-        HILOG_WARN(LOG_CORE, "lseek to dataContentStart position failed, errno(%{public}d)", errno);
+    BufferLease bufferLease(*this);
+    if (!bufferLease.IsValid()) {
         return false;
     }
-    auto writeLength = WriteTraceDataContent();
-    if (lseek(traceFileFd_, dataHeaderStart, SEEK_SET) == -1) {
-        HILOG_WARN(LOG_CORE, "lseek to dataHeaderStart position failed, errno(%{public}d)", errno);
+    TraceFileContentHeader contentHeader;
+    if (!sectionWriter_.Begin(contentHeader, contentType)) {
         return false;
     }
+    auto writeLength = WriteTraceDataContent();
     if (writeLength < 0) {
-        if (ftruncate(traceFileFd_, dataHeaderStart) == -1) {
-            HILOG_ERROR(LOG_CORE, "failed ftruncate errno(%{public}d)", errno);
-        }
+        sectionWriter_.Discard();
         return false;
     }
     contentHeader.length = static_cast<uint32_t>(writeLength);
-    ssize_t writeRet = TEMP_FAILURE_RETRY(write(traceFileFd_,
-        reinterpret_cast<char *>(&contentHeader), sizeof(contentHeader)));
-    if (writeRet != static_cast<ssize_t>(sizeof(contentHeader))) {
-        HILOG_WARN(LOG_CORE, "write header failed, err(%{public}d)", errno);
+    if (!sectionWriter_.Commit(contentHeader)) {
+        return false;
+    }
+    HILOG_INFO(LOG_CORE, "WriteTraceData end, type: %{public}d, byte: %{public}zd.", contentType, writeLength);
+    g_outputFileSize += static_cast<int>(contentHeader.length + sizeof(TraceFileContentHeader));
+    return true;
+}
+
+bool ITraceContent::WriteCachedData(const std::string& content, const uint8_t contentType)
+{
+    if (!IsFileExist()) {
+        HILOG_ERROR(LOG_CORE, "WriteCachedData: trace file (%{public}s) not found.", traceFilePath_.c_str());
+        return false;
+    }
+    TraceFileContentHeader contentHeader;
+    contentHeader.length = static_cast<uint32_t>(content.size());
+    if (!sectionWriter_.Begin(contentHeader, contentType)) {
         return false;
     }
-    if (lseek(traceFileFd_, writeLength, SEEK_CUR) == -1) {
-        HILOG_WARN(LOG_CORE, "lseek to dataContentEnd position failed, errno(%{public}d)", errno);
+    ssize_t writeRet = TEMP_FAILURE_RETRY(write(traceFileFd_, content.data(), content.size()));
+    if (writeRet != static_cast<ssize_t>(content.size())) {
+        HILOG_ERROR(LOG_CORE, "WriteCachedData: write failed, type: %{public}d, errno(%{public}d).", contentType,
+            errno);
+        sectionWriter_.Discard();
         return false;
     }
-    HILOG_INFO(LOG_CORE, "WriteTraceData end, type: %{public}d, byte: %{public}zd. g_writeFileLimit: %{public}d",
-        contentType, writeLength, g_writeFileLimit);
+    HILOG_INFO(LOG_CORE, "WriteCachedData end, type: %{public}d, byte: %{public}zu.", contentType, content.size());
     g_outputFileSize += static_cast<int>(contentHeader.length + sizeof(TraceFileContentHeader));
     return true;
 }
@@ -169,14 +327,14 @@ ssize_t ITraceContent::WriteTraceDataContent()
         bool endFlag = false;
         /* Write 1M at a time */
         while (bytes <= (BUFFER_SIZE - static_cast<int>(PAGE_SIZE)) && !endFlag) {
-            ssize_t readBytes = TEMP_FAILURE_RETRY(read(traceSourceFd_.GetFd(), g_buffer + bytes, PAGE_SIZE));
+            ssize_t readBytes = TEMP_FAILURE_RETRY(read(traceSourceFd_.GetFd(), buffer_ + bytes, PAGE_SIZE));
             if (readBytes <= 0) {
                 endFlag = true;
                 HILOG_DEBUG(LOG_CORE, "WriteTraceData: read raw trace done, size(%{public}zd), err(%{public}s).",
                     readBytes, strerror(errno));
                 break;
             }
-            if (!CheckPage(g_buffer + bytes)) {
+            if (!CheckPage(buffer_ + bytes)) {
                 pageChkFailedTime++;
             }
             bytes += static_cast<int>(readBytes);
@@ -185,7 +343,7 @@ ssize_t ITraceContent::WriteTraceDataContent()
                 break;
             }
         }
-        DoWriteTraceData(g_buffer, bytes, writeLen);
+        DoWriteTraceData(buffer_, bytes, writeLen);
         shouldContinue = !endFlag;
     }
     return writeLen;
@@ -211,10 +369,7 @@ void ITraceContent::DoWriteTraceData(const uint8_t* buffer, const int bytes, ssi
 
 bool ITraceContent::DoWriteTraceContentHeader(TraceFileContentHeader& contentHeader, const uint8_t contentType)
 {
-    contentHeader.type = contentType;
-    ssize_t writeRet = TEMP_FAILURE_RETRY(write(traceFileFd_, reinterpret_cast<char *>(&contentHeader),
-        sizeof(contentHeader)));
-    if (writeRet != static_cast<ssize_t>(sizeof(contentHeader))) {
+    if (!sectionWriter_.Begin(contentHeader, contentType)) {
         HILOG_ERROR(LOG_CORE, "DoWriteTraceContentHeader: failed to write content header, errno(%{public}d)", errno);
         return false;
     }
@@ -224,46 +379,18 @@ bool ITraceContent::DoWriteTraceContentHeader(TraceFileContentHeader& contentHea
 void ITraceContent::UpdateTraceContentHeader(struct TraceFileContentHeader& contentHeader, const uint32_t writeLen)
 {
     contentHeader.length = writeLen;
-    uint32_t offset = contentHeader.length + sizeof(contentHeader);
-    off_t pos = lseek(traceFileFd_, 0, SEEK_CUR);
-    if (pos == -1) {
-        HILOG_WARN(LOG_CORE, "UpdateTraceContentHeader: lseek failed, errno(%{public}d)", errno);
+    if (!sectionWriter_.Commit(contentHeader)) {
+        HILOG_WARN(LOG_CORE, "UpdateTraceContentHeader: write header failed.");
         return;
     }
-
-    off_t seekRet = lseek(traceFileFd_, pos - offset, SEEK_SET);
-    if (seekRet == -1) {
-        HILOG_WARN(LOG_CORE, "UpdateTraceContentHeader: lseek to header position failed, errno(%{public}d)", errno);
-        return;
-    }
-
-    ssize_t writeRet = TEMP_FAILURE_RETRY(write(traceFileFd_,
-        reinterpret_cast<char *>(&contentHeader), sizeof(contentHeader)));
-    if (writeRet != static_cast<ssize_t>(sizeof(contentHeader))) {
-        HILOG_WARN(LOG_CORE, "UpdateTraceContentHeader: write header failed, err(%{public}d)", errno);
-        return;
-    }
-
-    seekRet = lseek(traceFileFd_, pos, SEEK_SET);
-    if (seekRet == -1) {
-        HILOG_WARN(LOG_CORE, "UpdateTraceContentHeader: lseek to original position failed, errno(%{public}d)", errno);
-        return;
-    }
-
-    g_outputFileSize += static_cast<int>(offset);
+    g_outputFileSize += static_cast<int>(contentHeader.length + sizeof(contentHeader));
 }
 
 bool ITraceContent::IsFileExist()
 {
-    // 每10次数据段写入，检查一次文件是否存在
-    g_writeFileLimit++;
-    if (g_writeFileLimit > JUDGE_FILE_EXIST) {
-        g_writeFileLimit = 0;
-        if (access(traceFilePath_.c_str(), F_OK) != 0) {
-            HILOG_WARN(LOG_CORE, "IsFileExist access file:%{public}s failed, errno: %{public}d.",
-                traceFilePath_.c_str(), errno);
-            return false;
-        }
+    if (IsFileUnlinked(traceFileFd_)) {
+        HILOG_WARN(LOG_CORE, "IsFileExist: trace file:%{public}s has been removed.", traceFilePath_.c_str());
+        return false;
     }
     return true;
 }
@@ -274,7 +401,7 @@ bool ITraceContent::CheckPage(uint8_t* page)
         return true;
     }
     const int pageThreshold = PAGE_SIZE / 2; // pageThreshold = 2kB
-    PageHeader *pageHeader = reinterpret_cast<PageHeader*>(&page);
+    PageHeader *pageHeader = reinterpret_cast<PageHeader*>(page);
     if (pageHeader->size < static_cast<uint64_t>(pageThreshold)) {
         return false;
     }
@@ -293,67 +420,37 @@ void ITraceContent::ResetCurrentFileSize()
 
 void ITraceContent::WriteProcessLists(ssize_t& writeLen)
 {
-    DIR* procDir = opendir("/proc");
-    if (procDir == nullptr) {
-        HILOG_ERROR(LOG_CORE, "WriteProcessLists: open /proc failed, errno: %{public}d.", errno);
+    BufferLease bufferLease(*this);
+    if (!bufferLease.IsValid()) {
         return;
     }
-
     int bytes = 0;
-    struct dirent* entry;
-    while ((entry = readdir(procDir)) != nullptr) {
-        if (entry->d_type != DT_DIR || std::string(entry->d_name) == "." || std::string(entry->d_name) == "..") {
-            continue;
-        }
-        std::string dirName(entry->d_name);
-        if (!std::all_of(dirName.begin(), dirName.end(), ::isdigit)) {
-            continue;
-        }
-
-        std::string processName = ReadProcessName(dirName);
-        if (processName.empty()) {
-            continue;
-        }
-
-        std::string result = dirName + " " + processName + "\n";
-        if (!AppendToBuffer(result, bytes, writeLen)) {
-            continue;
-        }
+    for (const auto& process : GetProcessTable()->GetProcesses()) {
+        AppendToBuffer(std::to_string(process.pid) + " " + process.name + "\n", bytes, writeLen);
     }
-
     if (bytes > 0) {
-        DoWriteTraceData(g_buffer, bytes, writeLen);
+        DoWriteTraceData(buffer_, bytes, writeLen);
     }
-    closedir(procDir);
 }
 
-std::string ITraceContent::ReadProcessName(const std::string& pid)
+std::shared_ptr<TraceProcessTable> ITraceContent::GetProcessTable()
 {
-    std::string statusPath = CanonicalizeSpecPath(std::string("/proc/" + pid + "/status").c_str());
-    std::ifstream statusFile(statusPath);
-    if (!statusFile.is_open()) {
-        return "";
-    }
-
-    std::string line;
-    while (std::getline(statusFile, line)) {
-        if (line.find("Name:") != std::string::npos) {
-            return line.substr(line.find(":") + 1);
-        }
+    if (processTable_ == nullptr) {
+        processTable_ = std::make_shared<TraceProcessTable>();
     }
-    return "";
+    return processTable_;
 }
 
 bool ITraceContent::AppendToBuffer(const std::string& data, int& bytes, ssize_t& writeLen)
 {
-    if (memcpy_s(g_buffer + bytes, BUFFER_SIZE - bytes, data.c_str(), data.length()) != EOK) {
-        HILOG_ERROR(LOG_CORE, "WriteProcessLists: failed to memcpy result to g_buffer.");
+    if (memcpy_s(buffer_ + bytes, BUFFER_SIZE - bytes, data.c_str(), data.length()) != EOK) {
+        HILOG_ERROR(LOG_CORE, "WriteProcessLists: failed to memcpy result to buffer.");
         return false;
     }
 
     bytes += static_cast<int>(data.length());
     if (bytes > BUFFER_SIZE - static_cast<int>(PAGE_SIZE)) {
-        DoWriteTraceData(g_buffer, bytes, writeLen);
+        DoWriteTraceData(buffer_, bytes, writeLen);
         bytes = 0;
     }
     return true;
@@ -372,6 +469,7 @@ bool ITraceFileHdrContent::InitTraceFileHdr(TraceFileHeader& fileHdr)
         HILOG_ERROR(LOG_CORE, "InitTraceFileHdr error: cpu_number is %{public}d.", cpuNums);
         return false;
     }
+    fileHdr.versionNumber = versionNumber_;
     auto archWordInfo = fileHdr.reserved;
     fileHdr.reserved |= (static_cast<uint64_t>(cpuNums) << 1);
     HILOG_INFO(LOG_CORE, "InitTraceFileHdr: reserved with arch word info %{public}d, cpu number info %{public}d.",
@@ -413,10 +511,7 @@ bool TraceFileHdrHM::WriteTraceContent()
 bool TraceBaseInfoContent::WriteTraceContent()
 {
     struct TraceFileContentHeader contentHeader;
-    contentHeader.type = CONTENT_TYPE_BASE_INFO;
-    ssize_t writeRet = TEMP_FAILURE_RETRY(write(traceFileFd_,
-        reinterpret_cast<char *>(&contentHeader), sizeof(contentHeader)));
-    if (writeRet != static_cast<ssize_t>(sizeof(contentHeader))) {
+    if (!DoWriteTraceContentHeader(contentHeader, CONTENT_TYPE_BASE_INFO)) {
         HILOG_WARN(LOG_CORE, "Write BaseInfo contentHeader failed, errno: %{public}d.", errno);
         return false;
     }
@@ -475,25 +570,21 @@ TraceEventFmtContent::TraceEventFmtContent(const int fd,
         HILOG_INFO(LOG_CORE, "TraceEventFmtContent: inline mode enabled, skip saved_events_format file.");
         return;
     }
+    eventFormats_ = TraceMetadataCache::GetInstance().GetPreparedEventFormats();
+    if (eventFormats_ != nullptr) {
+        return;
+    }
     const std::string savedEventsFormatPath = std::string(TRACE_FILE_DEFAULT_DIR) +
         std::string(TRACE_SAVED_EVENTS_FORMAT);
-    bool hasPreWrotten = true;
     if (access(savedEventsFormatPath.c_str(), F_OK) != -1) {
         traceSourceFd_ = SmartFd(open(savedEventsFormatPath.c_str(), O_RDONLY | O_NONBLOCK));
-    } else {
-        traceSourceFd_ = SmartFd(open(savedEventsFormatPath.c_str(),
-            O_CREAT | O_RDWR | O_TRUNC | O_NONBLOCK, 0644)); // 0644:-rw-r--r--
-        hasPreWrotten = false;
-    }
-    if (!traceSourceFd_) {
-        HILOG_ERROR(LOG_CORE, "TraceEventFmtContent: open %{public}s failed.", savedEventsFormatPath.c_str());
-    }
-    if (!hasPreWrotten && traceSourceFd_) {
-        PreWriteAllTraceEventsFormat(traceSourceFd_.GetFd());
-        if (lseek(traceSourceFd_.GetFd(), 0, SEEK_SET) == -1) {
-            HILOG_ERROR(LOG_CORE, "TraceEventFmtContent: lseek to start pos failed, errno(%{public}d)", errno);
+        if (!traceSourceFd_) {
+            HILOG_ERROR(LOG_CORE, "TraceEventFmtContent: open %{public}s failed.", savedEventsFormatPath.c_str());
         }
+        return;
     }
+    eventFormats_ = TraceMetadataCache::GetInstance().GetEventFormats(GetAllTraceEventsFormat());
+    eventFormats_->Save(savedEventsFormatPath);
 }
 
 bool TraceEventFmtContent::WriteTraceContent()
@@ -501,49 +592,16 @@ bool TraceEventFmtContent::WriteTraceContent()
     if (inlineEventFmt_) {
         return WriteTraceContentInline();
     }
+    if (eventFormats_ != nullptr) {
+        return WriteCachedData(eventFormats_->GetContent(), CONTENT_TYPE_EVENTS_FORMAT);
+    }
     return WriteTraceData(CONTENT_TYPE_EVENTS_FORMAT);
 }
 
 bool TraceEventFmtContent::WriteTraceContentInline()
 {
-    if (!IsFileExist()) {
-        HILOG_ERROR(LOG_CORE, "WriteTraceContentInline: trace file (%{public}s) not found.", traceFilePath_.c_str());
-        return false;
-    }
-    TraceFileContentHeader contentHeader;
-    if (!DoWriteTraceContentHeader(contentHeader, CONTENT_TYPE_EVENTS_FORMAT)) {
-        return false;
-    }
-    const TraceJsonParser& traceJsonParser = TraceJsonParser::Instance();
-    const std::map<std::string, TraceTag>& allTags = traceJsonParser.GetAllTagInfos();
-    std::vector<std::string> traceFormats = traceJsonParser.GetBaseFmtPath();
-    for (auto& tag : allTags) {
-        for (auto& fmt : tag.second.formatPath) {
-            traceFormats.emplace_back(fmt);
-        }
-    }
-    ssize_t writeLen = 0;
-    for (auto& traceFmt : traceFormats) {
-        std::string srcPath = GetTraceRootPath() + traceFmt;
-        if (access(srcPath.c_str(), R_OK) == -1) {
-            continue;
-        }
-        off_t before = lseek(traceFileFd_, 0, SEEK_CUR);
-        if (before == -1) {
-            HILOG_ERROR(LOG_CORE, "WriteTraceContentInline: lseek before write failed, errno(%{public}d)", errno);
-            return false;
-        }
-        WriteEventFile(srcPath, traceFileFd_);
-        off_t after = lseek(traceFileFd_, 0, SEEK_CUR);
-        if (after == -1 || after < before) {
-            HILOG_ERROR(LOG_CORE, "WriteTraceContentInline: lseek after write failed, errno(%{public}d)", errno);
-            return false;
-        }
-        writeLen += static_cast<ssize_t>(after - before);
-    }
-    UpdateTraceContentHeader(contentHeader, static_cast<uint32_t>(writeLen));
-    HILOG_INFO(LOG_CORE, "WriteTraceContentInline: event format bytes %{public}zd", writeLen);
-    return true;
+    eventFormats_ = TraceMetadataCache::GetInstance().GetEventFormats(GetAllTraceEventsFormat());
+    return WriteCachedData(eventFormats_->GetContent(), CONTENT_TYPE_EVENTS_FORMAT);
 }
 
 TraceCmdLinesContent::TraceCmdLinesContent(const int fd,
@@ -569,6 +627,9 @@ bool TraceCmdLinesContent::WriteTraceContent()
 
 ssize_t TraceCmdLinesContent::WriteTraceDataContent()
 {
+    if (seenPids_ != nullptr && !seenPids_->IsEmpty()) {
+        return WriteSeenCmdLines();
+    }
     auto filterContext = TraceContextManager::GetInstance().GetTraceFilterContext();
     if (filterContext == nullptr) {
         auto size = ITraceContent::WriteTraceDataContent();
@@ -579,24 +640,81 @@ ssize_t TraceCmdLinesContent::WriteTraceDataContent()
     ssize_t writeLen = 0;
     filterContext->TraverseSavedCmdLine([&](const std::string& savedCmdLine) {
         if (bytes + savedCmdLine.length() > BUFFER_SIZE) {
-            DoWriteTraceData(g_buffer, bytes,  writeLen);
+            DoWriteTraceData(buffer_, bytes,  writeLen);
             bytes = 0;
         }
         for (size_t i = 0; i < savedCmdLine.length(); i++) {
-            g_buffer[bytes++] = savedCmdLine[i];
+            buffer_[bytes++] = savedCmdLine[i];
         }
     });
-    filterContext->TraverseFilterPid([this, &bytes, &writeLen](const std::string& pid) {
-        std::string pidStr = pid + " " + ReadProcessName(pid) + "\n";
+    auto processTable = GetProcessTable();
+    filterContext->TraverseFilterPid([this, &processTable, &bytes, &writeLen](const int pid) {
+        std::string pidStr = std::to_string(pid);
+        pidStr += " " + processTable->GetProcessName(pidStr) + "\n";
         if (bytes + pidStr.length() > BUFFER_SIZE) {
-            DoWriteTraceData(g_buffer, bytes,  writeLen);
+            DoWriteTraceData(buffer_, bytes,  writeLen);
             bytes = 0;
         }
         for (size_t i = 0; i < pidStr.length(); i++) {
-            g_buffer[bytes++] = pidStr[i];
+            buffer_[bytes++] = pidStr[i];
         }
     });
-    DoWriteTraceData(g_buffer, bytes,  writeLen);
+    DoWriteTraceData(buffer_, bytes,  writeLen);
+    return writeLen;
+}
+
+ssize_t TraceCmdLinesContent::WriteSeenCmdLines()
+{
+    // the processes of the seen threads are listed as well, the threads are grouped by their names.
+    auto filterContext = TraceContextManager::GetInstance().GetTraceFilterContext();
+    if (filterContext != nullptr) {
+        filterContext->TraverseTGidsContent([this](const std::pair<int, int>& tgid) {
+            if (seenPids_->Contains(tgid.first)) {
+                seenPids_->Add(tgid.second);
+            }
+        });
+    } else {
+        TraverseFileLineByLine(GetTraceRootPath() + "saved_tgids", [this](const char* line, size_t lineNum) {
+            int tid = 0;
+            int tgid = 0;
+            if (ParseTgidLine(line, tid, tgid) && seenPids_->Contains(tid)) {
+                seenPids_->Add(tgid);
+            }
+            return true;
+        });
+    }
+    TracePidSet unnamedPids = *seenPids_;
+    int bytes = 0;
+    ssize_t writeLen = 0;
+    auto appendSavedCmdLine = [this, &unnamedPids, &bytes, &writeLen](const std::string& savedCmdLine) {
+        int pid = ParseLeadingPid(savedCmdLine.c_str());
+        if (!seenPids_->Contains(pid)) {
+            return;
+        }
+        AppendToBuffer(savedCmdLine.back() == '\n' ? savedCmdLine : savedCmdLine + "\n", bytes, writeLen);
+        unnamedPids.Remove(pid);
+    };
+    if (filterContext != nullptr) {
+        filterContext->TraverseSavedCmdLine(appendSavedCmdLine);
+    } else {
+        TraverseFileLineByLine(GetTraceRootPath() + "saved_cmdlines",
+            [&appendSavedCmdLine](const char* line, size_t lineNum) {
+                appendSavedCmdLine(line);
+                return true;
+            });
+    }
+    // /proc is only read for the tasks which are missing from saved_cmdlines.
+    auto processTable = GetProcessTable();
+    unnamedPids.ForEach([this, &processTable, &bytes, &writeLen](const int pid) {
+        std::string pidStr = std::to_string(pid);
+        std::string name = processTable->GetProcessName(pidStr);
+        if (!name.empty()) {
+            AppendToBuffer(pidStr + " " + name + "\n", bytes, writeLen);
+        }
+    });
+    if (bytes > 0) {
+        DoWriteTraceData(buffer_, bytes, writeLen);
+    }
     return writeLen;
 }
 
@@ -622,32 +740,141 @@ bool TraceTgidsContent::WriteTraceContent()
 
 ssize_t TraceTgidsContent::WriteTraceDataContent()
 {
+    if (seenPids_ != nullptr && !seenPids_->IsEmpty()) {
+        return WriteSeenTgids();
+    }
     auto filterContext = TraceContextManager::GetInstance().GetTraceFilterContext();
     if (filterContext == nullptr) {
         return ITraceContent::WriteTraceDataContent();
     }
     int bytes = 0;
     ssize_t writeLen = 0;
-    filterContext->TraverseTGidsContent([&](const std::pair<std::string, std::string>& tgid) {
-        std::string result = tgid.first + " " + tgid.second + "\n";
+    filterContext->TraverseTGidsContent([&](const std::pair<int, int>& tgid) {
+        std::string result = std::to_string(tgid.first) + " " + std::to_string(tgid.second) + "\n";
         if (bytes + result.length() > BUFFER_SIZE) {
-            DoWriteTraceData(g_buffer, bytes,  writeLen);
+            DoWriteTraceData(buffer_, bytes,  writeLen);
             bytes = 0;
         }
         for (size_t i = 0; i < result.length(); i++) {
-            g_buffer[bytes++] = result[i];
+            buffer_[bytes++] = result[i];
         }
     });
-    DoWriteTraceData(g_buffer, bytes,  writeLen);
+    DoWriteTraceData(buffer_, bytes,  writeLen);
+    return writeLen;
+}
+
+ssize_t TraceTgidsContent::WriteSeenTgids()
+{
+    int bytes = 0;
+    ssize_t writeLen = 0;
+    auto filterContext = TraceContextManager::GetInstance().GetTraceFilterContext();
+    if (filterContext != nullptr) {
+        filterContext->TraverseTGidsContent([this, &bytes, &writeLen](const std::pair<int, int>& tgid) {
+            if (seenPids_->Contains(tgid.first)) {
+                AppendToBuffer(std::to_string(tgid.first) + " " + std::to_string(tgid.second) + "\n", bytes, writeLen);
+            }
+        });
+    } else {
+        TraverseFileLineByLine(GetTraceRootPath() + "saved_tgids",
+            [this, &bytes, &writeLen](const char* line, size_t lineNum) {
+                int tid = 0;
+                int tgid = 0;
+                if (ParseTgidLine(line, tid, tgid) && seenPids_->Contains(tid)) {
+                    AppendToBuffer(std::to_string(tid) + " " + std::to_string(tgid) + "\n", bytes, writeLen);
+                }
+                return true;
+            });
+    }
+    if (bytes > 0) {
+        DoWriteTraceData(buffer_, bytes, writeLen);
+    }
     return writeLen;
 }
 
+bool TraceSectionTableContent::WriteTraceContent()
+{
+    // the sections are read back through the fd which wrote them, the path may have been renamed or unlinked.
+    off_t tableOffset = lseek(traceFileFd_, 0, SEEK_CUR);
+    std::vector<TraceSectionTableEntry> entries;
+    if (tableOffset == -1 || !BuildSectionTable(traceFileFd_, static_cast<uint64_t>(tableOffset), entries)) {
+        HILOG_WARN(LOG_CORE, "TraceSectionTableContent: scan %{public}s failed, errno(%{public}d).",
+            traceFilePath_.c_str(), errno);
+        return false;
+    }
+    struct TraceFileContentHeader tableHeader;
+    if (!DoWriteTraceContentHeader(tableHeader, CONTENT_TYPE_SECTION_TABLE)) {
+        return false;
+    }
+    TraceSectionTableTrailer trailer;
+    trailer.tableOffset = static_cast<uint64_t>(tableOffset);
+    trailer.entryCount = static_cast<uint32_t>(entries.size());
+    ssize_t writeLen = 0;
+    DoWriteTraceData(reinterpret_cast<const uint8_t*>(entries.data()),
+        static_cast<int>(entries.size() * sizeof(TraceSectionTableEntry)), writeLen);
+    DoWriteTraceData(reinterpret_cast<const uint8_t*>(&trailer), static_cast<int>(sizeof(trailer)), writeLen);
+    UpdateTraceContentHeader(tableHeader, static_cast<uint32_t>(writeLen));
+    HILOG_INFO(LOG_CORE, "TraceSectionTableContent: %{public}zu sections.", entries.size());
+    return true;
+}
+
+bool TraceKallsymsContent::WriteTraceContent()
+{
+    if (seenAddrs_ == nullptr || seenAddrs_->GetAddrs().empty()) {
+        return true;
+    }
+    // the table is only loaded once an address is seen, and then shared by the files of the session.
+    auto kallsyms = TraceMetadataCache::GetInstance().GetKallsyms();
+    if (kallsyms == nullptr || kallsyms->IsEmpty()) {
+        HILOG_WARN(LOG_CORE, "TraceKallsymsContent: no kernel symbol to resolve the addresses.");
+        return false;
+    }
+    std::set<size_t> symbolIndexes;
+    size_t index = 0;
+    for (const auto addr : seenAddrs_->GetAddrs()) {
+        if (kallsyms->Find(addr, index)) {
+            symbolIndexes.insert(index);
+        }
+    }
+    std::string content;
+    for (const auto symbolIndex : symbolIndexes) {
+        content += kallsyms->GetLine(symbolIndex);
+    }
+    HILOG_INFO(LOG_CORE, "TraceKallsymsContent: %{public}zu addresses, %{public}zu symbols.",
+        seenAddrs_->GetAddrs().size(), symbolIndexes.size());
+    return content.empty() || WriteCachedData(content, CONTENT_TYPE_KALLSYMS);
+}
+
+TraceMetadataRefContent::TraceMetadataRefContent(const int fd, const std::string& traceFilePath, const bool ishm)
+    : ITraceContent(fd, traceFilePath, ishm)
+{
+    if (ishm || IsBootTraceInlineEventFmtEnabled()) {
+        return;
+    }
+    auto sidecar = TraceMetadataSidecar::GetPrepared();
+    if (sidecar != nullptr && sidecar->Save(traceFilePath_.substr(0, traceFilePath_.rfind('/') + 1))) {
+        sidecar_ = sidecar;
+    }
+}
+
+bool TraceMetadataRefContent::WriteTraceContent()
+{
+    if (sidecar_ == nullptr) {
+        return false;
+    }
+    const TraceMetadataRef& ref = sidecar_->GetRef();
+    return WriteCachedData(std::string(reinterpret_cast<const char*>(&ref), sizeof(ref)), CONTENT_TYPE_METADATA_REF);
+}
+
 bool ITraceCpuRawContent::WriteTracePipeRawData(const std::string& srcPath, const int cpuIdx)
 {
     if (!IsFileExist()) {
         HILOG_ERROR(LOG_CORE, "WriteTracePipeRawData: trace file (%{public}s) not found.", traceFilePath_.c_str());
         return false;
     }
+    BufferLease bufferLease(*this);
+    if (!bufferLease.IsValid()) {
+        return false;
+    }
     std::string path = CanonicalizeSpecPath(srcPath.c_str());
     auto rawTraceFd = SmartFd(open(path.c_str(), O_RDONLY | O_NONBLOCK));
     if (!rawTraceFd) {
@@ -663,23 +890,55 @@ bool ITraceCpuRawContent::WriteTracePipeRawData(const std::string& srcPath, cons
     int pageChkFailedTime = 0;
     bool printFirstPageTime = false; // update first page time in every WriteTracePipeRawData calling.
     bool endFlag = false;
+    // the pages which are spliced never reach user space, where the seen pids and addresses are collected and the
+    // events of the other tasks are dropped.
+    if (!isHm_ && request_.engine == TraceDumpEngine::ENGINE_SPLICE &&
+        !g_spliceUnsupported.load(std::memory_order_relaxed) && request_.seenPids == nullptr &&
+        request_.seenAddrs == nullptr && request_.eventPids == nullptr) {
+        // the read loop picks up whatever splice leaves behind, such as the partially filled reader page.
+        endFlag = SpliceTracePipeRawLoop(rawTraceFd.GetFd(), readLen, writeLen, pageChkFailedTime,
+            printFirstPageTime);
+    }
+    std::unique_ptr<TracePagePidFilter> pidFilter = nullptr;
+    if (request_.eventPids != nullptr) {
+        pidFilter = std::make_unique<TracePagePidFilter>(request_.eventPids,
+            [this, &writeLen](const uint8_t* pages, const size_t size) {
+                CollectSeenPages(pages, size);
+                DoWriteTraceData(pages, static_cast<int>(size), writeLen);
+            });
+    }
     while (!endFlag) {
         int bytes = 0;
         ReadTracePipeRawLoop(rawTraceFd.GetFd(), bytes, endFlag, pageChkFailedTime, printFirstPageTime);
         readLen += bytes;
-        DoWriteTraceData(g_buffer, bytes, writeLen);
+        if (pidFilter != nullptr) {
+            pidFilter->FilterPages(buffer_, static_cast<size_t>(bytes));
+        } else {
+            CollectSeenPages(buffer_, static_cast<size_t>(bytes));
+            DoWriteTraceData(buffer_, bytes, writeLen);
+        }
         if (IsWriteFileOverflow(g_outputFileSize, writeLen,
             request_.fileSize != 0 ? request_.fileSize : DEFAULT_FILE_SIZE * KB_PER_MB)) {
             isOverFlow_ = true;
             break;
         }
     }
+    if (pidFilter != nullptr) {
+        pidFilter->Flush();
+        HILOG_INFO(LOG_CORE, "WriteTracePipeRawData: cpu%{public}d kept %{public}" PRIu64 " of %{public}" PRIu64
+            " bytes, %{public}" PRIu64 " events dropped in %{public}" PRIu64 "us.", cpuIdx,
+            pidFilter->GetOutputBytes(), pidFilter->GetInputBytes(), pidFilter->GetDroppedEvents(),
+            pidFilter->GetCostUs());
+    }
+    off_t dataOffset = sectionWriter_.GetDataOffset();
     UpdateTraceContentHeader(rawtraceHdr, static_cast<uint32_t>(writeLen));
+    IndexCpuRawSection(cpuIdx, dataOffset, static_cast<uint32_t>(writeLen));
     if (readLen > 0) {
-        dumpStatus_ = writeLen > 0 ? TraceErrorCode::SUCCESS : TraceErrorCode::WRITE_TRACE_INFO_ERROR;
+        // all the events of the cpu may be dropped by the pid filter.
+        bool isWritten = writeLen > 0 || (pidFilter != nullptr && pidFilter->GetOutputBytes() == 0);
+        dumpStatus_ = isWritten ? TraceErrorCode::SUCCESS : TraceErrorCode::WRITE_TRACE_INFO_ERROR;
     }
-    HILOG_INFO(LOG_CORE, "WriteTracePipeRawData end, path: %{public}s, byte: %{public}zd. g_writeFileLimit: %{public}d",
-        srcPath.c_str(), writeLen, g_writeFileLimit);
+    HILOG_INFO(LOG_CORE, "WriteTracePipeRawData end, path: %{public}s, byte: %{public}zd.", srcPath.c_str(), writeLen);
     return true;
 }
 
@@ -687,7 +946,7 @@ void ITraceCpuRawContent::ReadTracePipeRawLoop(const int srcFd,
     int& bytes, bool& endFlag, int& pageChkFailedTime, bool& printFirstPageTime)
 {
     while (bytes <= (BUFFER_SIZE - static_cast<int>(PAGE_SIZE))) {
-        ssize_t readBytes = TEMP_FAILURE_RETRY(read(srcFd, g_buffer + bytes, PAGE_SIZE));
+        ssize_t readBytes = TEMP_FAILURE_RETRY(read(srcFd, buffer_ + bytes, PAGE_SIZE));
         if (readBytes <= 0) {
             endFlag = true;
             HILOG_DEBUG(LOG_CORE, "ReadTracePipeRawLoop: read raw trace done, size(%{public}zd), err(%{public}s).",
@@ -696,22 +955,24 @@ void ITraceCpuRawContent::ReadTracePipeRawLoop(const int srcFd,
             break;
         }
         uint64_t pageTraceTime = 0;
-        if (memcpy_s(&pageTraceTime, sizeof(pageTraceTime), g_buffer + bytes, sizeof(uint64_t)) != EOK) {
-            HILOG_ERROR(LOG_CORE, "ReadTracePipeRawLoop: failed to memcpy g_buffer to pageTraceTime.");
+        if (memcpy_s(&pageTraceTime, sizeof(pageTraceTime), buffer_ + bytes, sizeof(uint64_t)) != EOK) {
+            HILOG_ERROR(LOG_CORE, "ReadTracePipeRawLoop: failed to memcpy buffer to pageTraceTime.");
             break;
         }
         // only capture target duration trace data
         int pageValid = IsCurrentTracePageValid(pageTraceTime, request_.traceStartTime, request_.traceEndTime);
         if (pageValid < 0) {
             endFlag = true;
-            bytes += (printFirstPageTime ? readBytes : 0);
+            if (printFirstPageTime) {
+                bytes += readBytes;
+            }
             dumpStatus_ = TraceErrorCode::OUT_OF_TIME;
             break;
         } else if (pageValid == 0) {
             continue;
         }
         UpdateFirstLastPageTimeStamp(pageTraceTime, printFirstPageTime, firstPageTimeStamp_, lastPageTimeStamp_);
-        if (!CheckPage(g_buffer + bytes)) {
+        if (!CheckPage(buffer_ + bytes)) {
             pageChkFailedTime++;
         }
         bytes += readBytes;
@@ -722,33 +983,222 @@ void ITraceCpuRawContent::ReadTracePipeRawLoop(const int srcFd,
     }
 }
 
-bool ITraceCpuRawContent::IsWriteFileOverflow(const int outputFileSize, const ssize_t writeLen,
-                                              const int fileSizeThreshold)
+bool ITraceCpuRawContent::SpliceTracePipeRawLoop(const int srcFd, ssize_t& readLen, ssize_t& writeLen,
+    int& pageChkFailedTime, bool& printFirstPageTime)
 {
-    // only check file size threshold in CMD/CACHE mode if need.
-    if ((request_.type != TraceDumpType::TRACE_RECORDING && request_.type != TraceDumpType::TRACE_CACHE) ||
-        !request_.limitFileSz) {
+    SmartFd pageRead;
+    SmartFd pageWrite;
+    SmartFd peekRead;
+    SmartFd peekWrite;
+    SmartFd batchRead;
+    SmartFd batchWrite;
+    if (!CreateSplicePipe(pageRead, pageWrite, 0) || !CreateSplicePipe(peekRead, peekWrite, 0) ||
+        !CreateSplicePipe(batchRead, batchWrite, BUFFER_SIZE)) {
         return false;
     }
-    if (outputFileSize + writeLen + static_cast<int>(sizeof(TraceFileContentHeader)) >= fileSizeThreshold) {
-        HILOG_ERROR(LOG_CORE, "Failed to write, current round write file size exceeds the file size limit(%{public}d).",
-            fileSizeThreshold);
-        return true;
-    }
-    if (writeLen > INT_MAX - BUFFER_SIZE) {
-        HILOG_ERROR(LOG_CORE, "Failed to write, write file length is nearly overflow.");
-        return true;
-    }
-    return false;
-}
-
-bool ITraceCpuRawContent::IsOverFlow()
-{
-    return isOverFlow_;
-}
-
-bool TraceCpuRawLinux::WriteTraceContent()
-{
+    int batchSize = fcntl(batchWrite.GetFd(), F_GETPIPE_SZ);
+    batchSize = std::min(batchSize > 0 ? batchSize : static_cast<int>(PAGE_SIZE), BUFFER_SIZE);
+    const int fileSizeThreshold = request_.fileSize != 0 ? request_.fileSize : DEFAULT_FILE_SIZE * KB_PER_MB;
+    int batchBytes = 0;
+    while (true) {
+        ssize_t pageBytes = TEMP_FAILURE_RETRY(splice(srcFd, nullptr, pageWrite.GetFd(), nullptr, PAGE_SIZE,
+            SPLICE_F_MOVE | SPLICE_F_NONBLOCK));
+        if (pageBytes <= 0) {
+            if (pageBytes < 0 && IsSpliceUnsupportedError(errno)) {
+                HILOG_WARN(LOG_CORE, "SpliceTracePipeRawLoop: splice is unsupported, errno(%{public}d)", errno);
+                g_spliceUnsupported.store(true, std::memory_order_relaxed);
+            }
+            break;
+        }
+        uint8_t pageHeader[PAGE_HEADER_PEEK_SIZE] = {};
+        if (TEMP_FAILURE_RETRY(tee(pageRead.GetFd(), peekWrite.GetFd(), sizeof(pageHeader), SPLICE_F_NONBLOCK)) !=
+            static_cast<ssize_t>(sizeof(pageHeader)) ||
+            TEMP_FAILURE_RETRY(read(peekRead.GetFd(), pageHeader, sizeof(pageHeader))) !=
+            static_cast<ssize_t>(sizeof(pageHeader))) {
+            HILOG_ERROR(LOG_CORE, "SpliceTracePipeRawLoop: peek page header failed, errno(%{public}d)", errno);
+            FlushSplicePipe(batchRead.GetFd(), batchBytes, writeLen);
+            return true;
+        }
+        uint64_t pageTraceTime = 0;
+        if (memcpy_s(&pageTraceTime, sizeof(pageTraceTime), pageHeader, sizeof(uint64_t)) != EOK) {
+            HILOG_ERROR(LOG_CORE, "SpliceTracePipeRawLoop: failed to memcpy pageHeader to pageTraceTime.");
+            FlushSplicePipe(batchRead.GetFd(), batchBytes, writeLen);
+            return true;
+        }
+        // only capture target duration trace data
+        int pageValid = IsCurrentTracePageValid(pageTraceTime, request_.traceStartTime, request_.traceEndTime);
+        if (pageValid == 0 || (pageValid < 0 && !printFirstPageTime)) {
+            DrainSplicePipe(pageRead.GetFd(), static_cast<int>(pageBytes), buffer_, BUFFER_SIZE);
+            if (pageValid == 0) {
+                continue;
+            }
+        }
+        bool endFlag = false;
+        if (pageValid < 0) {
+            endFlag = true;
+            dumpStatus_ = TraceErrorCode::OUT_OF_TIME;
+        } else {
+            UpdateFirstLastPageTimeStamp(pageTraceTime, printFirstPageTime, firstPageTimeStamp_, lastPageTimeStamp_);
+            if (!CheckPage(pageHeader)) {
+                pageChkFailedTime++;
+            }
+            endFlag = pageChkFailedTime >= 2; // 2 : check failed times threshold
+        }
+        if (printFirstPageTime) {
+            ssize_t movedBytes = -1;
+            if (batchBytes + pageBytes <= batchSize || FlushSplicePipe(batchRead.GetFd(), batchBytes, writeLen)) {
+                movedBytes = TEMP_FAILURE_RETRY(splice(pageRead.GetFd(), nullptr, batchWrite.GetFd(), nullptr,
+                    pageBytes, SPLICE_F_MOVE | SPLICE_F_NONBLOCK));
+            }
+            if (movedBytes > 0) {
+                batchBytes += static_cast<int>(movedBytes);
+                readLen += movedBytes;
+            }
+            if (movedBytes != pageBytes) {
+                // the page has been consumed from trace_pipe_raw, keep it through user space.
+                FlushSplicePipe(batchRead.GetFd(), batchBytes, writeLen);
+                ssize_t leftBytes = pageBytes - std::max(movedBytes, static_cast<ssize_t>(0));
+                ssize_t readBytes = DrainSplicePipe(pageRead.GetFd(), static_cast<int>(leftBytes), buffer_,
+                    BUFFER_SIZE);
+                if (readBytes > 0) {
+                    DoWriteTraceData(buffer_, static_cast<int>(readBytes), writeLen);
+                    readLen += readBytes;
+                }
+                return endFlag;
+            }
+        }
+        if (endFlag) {
+            FlushSplicePipe(batchRead.GetFd(), batchBytes, writeLen);
+            return true;
+        }
+        if (batchBytes >= batchSize) {
+            if (!FlushSplicePipe(batchRead.GetFd(), batchBytes, writeLen)) {
+                return false;
+            }
+            if (IsWriteFileOverflow(g_outputFileSize, writeLen, fileSizeThreshold)) {
+                isOverFlow_ = true;
+                return true;
+            }
+        }
+    }
+    if (!FlushSplicePipe(batchRead.GetFd(), batchBytes, writeLen)) {
+        return false;
+    }
+    if (IsWriteFileOverflow(g_outputFileSize, writeLen, fileSizeThreshold)) {
+        isOverFlow_ = true;
+        return true;
+    }
+    return false;
+}
+
+bool ITraceCpuRawContent::FlushSplicePipe(const int pipeReadFd, int& batchBytes, ssize_t& writeLen)
+{
+    while (batchBytes > 0) {
+        ssize_t outBytes = TEMP_FAILURE_RETRY(splice(pipeReadFd, nullptr, traceFileFd_, nullptr,
+            static_cast<size_t>(batchBytes), SPLICE_F_MOVE));
+        if (outBytes > 0) {
+            batchBytes -= static_cast<int>(outBytes);
+            writeLen += outBytes;
+            continue;
+        }
+        HILOG_WARN(LOG_CORE, "FlushSplicePipe: splice to trace file failed, errno(%{public}d)", errno);
+        if (outBytes < 0 && IsSpliceUnsupportedError(errno)) {
+            g_spliceUnsupported.store(true, std::memory_order_relaxed);
+        }
+        // the pages have already been consumed from trace_pipe_raw, move them through user space instead.
+        while (batchBytes > 0) {
+            ssize_t readBytes = DrainSplicePipe(pipeReadFd, batchBytes, buffer_, BUFFER_SIZE);
+            if (readBytes <= 0) {
+                break;
+            }
+            DoWriteTraceData(buffer_, static_cast<int>(readBytes), writeLen);
+            batchBytes -= static_cast<int>(readBytes);
+        }
+        batchBytes = 0;
+        return false;
+    }
+    return true;
+}
+
+void ITraceCpuRawContent::CollectSeenPages(const uint8_t* pages, const size_t size)
+{
+    if (request_.seenPids == nullptr && request_.seenAddrs == nullptr) {
+        return;
+    }
+    for (size_t offset = 0; offset < size; offset += PAGE_SIZE) {
+        size_t pageSize = std::min(static_cast<size_t>(PAGE_SIZE), size - offset);
+        if (request_.seenPids != nullptr) {
+            request_.seenPids->CollectPage(pages + offset, pageSize);
+        }
+        if (request_.seenAddrs != nullptr) {
+            request_.seenAddrs->CollectPage(pages + offset, pageSize);
+        }
+    }
+}
+
+bool ITraceCpuRawContent::IsWriteFileOverflow(const int outputFileSize, const ssize_t writeLen,
+                                              const int fileSizeThreshold)
+{
+    // only check file size threshold in CMD/CACHE mode if need.
+    if ((request_.type != TraceDumpType::TRACE_RECORDING && request_.type != TraceDumpType::TRACE_CACHE) ||
+        !request_.limitFileSz) {
+        return false;
+    }
+    if (outputFileSize + writeLen + static_cast<int>(sizeof(TraceFileContentHeader)) >= fileSizeThreshold) {
+        HILOG_ERROR(LOG_CORE, "Failed to write, current round write file size exceeds the file size limit(%{public}d).",
+            fileSizeThreshold);
+        return true;
+    }
+    if (writeLen > INT_MAX - BUFFER_SIZE) {
+        HILOG_ERROR(LOG_CORE, "Failed to write, write file length is nearly overflow.");
+        return true;
+    }
+    return false;
+}
+
+bool ITraceCpuRawContent::IsOverFlow()
+{
+    return isOverFlow_;
+}
+
+void ITraceCpuRawContent::IndexCpuRawSection(const int cpuIdx, const off_t dataOffset, const uint32_t length)
+{
+    if ((request_.type != TraceDumpType::TRACE_RECORDING && request_.type != TraceDumpType::TRACE_CACHE) ||
+        dataOffset < 0 || length == 0) {
+        return;
+    }
+    if (!pageIndexFd_) {
+        pageIndexFd_ = SmartFd(open(traceFilePath_.c_str(), O_RDONLY));
+        if (!pageIndexFd_) {
+            HILOG_WARN(LOG_CORE, "IndexCpuRawSection: open %{public}s failed, errno(%{public}d).",
+                traceFilePath_.c_str(), errno);
+            return;
+        }
+    }
+    (void)pageIndex_.AddSection(pageIndexFd_.GetFd(), static_cast<uint32_t>(cpuIdx),
+        static_cast<uint64_t>(dataOffset), length);
+}
+
+bool ITraceCpuRawContent::WritePageIndexContent()
+{
+    const auto& entries = pageIndex_.GetEntries();
+    if (entries.empty()) {
+        return true;
+    }
+    struct TraceFileContentHeader indexHeader;
+    if (!DoWriteTraceContentHeader(indexHeader, CONTENT_TYPE_PAGE_INDEX)) {
+        return false;
+    }
+    ssize_t writeLen = 0;
+    DoWriteTraceData(reinterpret_cast<const uint8_t*>(entries.data()),
+        static_cast<int>(entries.size() * sizeof(TracePageIndexEntry)), writeLen);
+    UpdateTraceContentHeader(indexHeader, static_cast<uint32_t>(writeLen));
+    HILOG_INFO(LOG_CORE, "WritePageIndexContent: %{public}zu entries.", entries.size());
+    return true;
+}
+
+bool TraceCpuRawLinux::WriteTraceContent()
+{
     int cpuNums = GetCpuProcessors();
     for (int cpuIdx = 0; cpuIdx < cpuNums; cpuIdx++) {
         std::string srcPath = GetTraceRootPath() + "per_cpu/cpu" + std::to_string(cpuIdx) + "/trace_pipe_raw";
@@ -763,6 +1213,316 @@ bool TraceCpuRawLinux::WriteTraceContent()
     return true;
 }
 
+TraceCpuRawUringLinux::TraceCpuRawUringLinux(const int fd, const std::string& traceFilePath,
+    const TraceDumpRequest& request) : TraceCpuRawLinux(fd, traceFilePath, request) {}
+
+TraceCpuRawUringLinux::~TraceCpuRawUringLinux() = default;
+
+bool TraceCpuRawUringLinux::InitUring()
+{
+    if (uringInited_) {
+        return ring_ != nullptr;
+    }
+    uringInited_ = true;
+    auto ring = std::make_unique<TraceIoUring>(URING_ENTRIES);
+    if (!ring->IsValid()) {
+        return false;
+    }
+    bufferPool_.resize(static_cast<size_t>(URING_SLOT_COUNT) * PAGE_SIZE);
+    std::vector<struct iovec> iovecs(URING_SLOT_COUNT);
+    for (uint16_t slot = 0; slot < URING_SLOT_COUNT; slot++) {
+        iovecs[slot].iov_base = bufferPool_.data() + static_cast<size_t>(slot) * PAGE_SIZE;
+        iovecs[slot].iov_len = PAGE_SIZE;
+    }
+    if (!ring->RegisterBuffers(iovecs.data(), URING_SLOT_COUNT)) {
+        bufferPool_.clear();
+        bufferPool_.shrink_to_fit();
+        return false;
+    }
+    readResults_.assign(URING_SLOT_COUNT, 0);
+    writeOffsets_.assign(URING_SLOT_COUNT, 0);
+    writeSizes_.assign(URING_SLOT_COUNT, 0);
+    ring_ = std::move(ring);
+    return true;
+}
+
+bool TraceCpuRawUringLinux::WriteTraceContent()
+{
+    if (!InitUring()) {
+        HILOG_INFO(LOG_CORE, "TraceCpuRawUringLinux: io_uring unavailable, fall back to read/write.");
+        return TraceCpuRawLinux::WriteTraceContent();
+    }
+    off_t curPos = lseek(traceFileFd_, 0, SEEK_CUR);
+    if (curPos == -1) {
+        HILOG_ERROR(LOG_CORE, "TraceCpuRawUringLinux: lseek failed, errno(%{public}d)", errno);
+        return false;
+    }
+    uint64_t fileOffset = static_cast<uint64_t>(curPos);
+    int cpuNums = GetCpuProcessors();
+    bool ret = true;
+    for (int cpuIdx = 0; cpuIdx < cpuNums; cpuIdx++) {
+        std::string srcPath = GetTraceRootPath() + "per_cpu/cpu" + std::to_string(cpuIdx) + "/trace_pipe_raw";
+        if (!WriteTracePipeRawDataByUring(srcPath, cpuIdx, fileOffset)) {
+            ret = false;
+            break;
+        }
+    }
+    // the following contents are still written at the current position of the file.
+    if (lseek(traceFileFd_, static_cast<off_t>(fileOffset), SEEK_SET) == -1) {
+        HILOG_ERROR(LOG_CORE, "TraceCpuRawUringLinux: lseek to the end of raw data failed, errno(%{public}d)", errno);
+        return false;
+    }
+    if (!ret) {
+        return false;
+    }
+    if (dumpStatus_ != TraceErrorCode::SUCCESS) {
+        HILOG_ERROR(LOG_CORE, "TraceCpuRawUringLinux WriteTraceContent failed, dump status: %{public}hhu.",
+            dumpStatus_);
+        return false;
+    }
+    return true;
+}
+
+bool TraceCpuRawUringLinux::WriteTracePipeRawDataByUring(const std::string& srcPath, const int cpuIdx,
+    uint64_t& fileOffset)
+{
+    if (!IsFileExist()) {
+        HILOG_ERROR(LOG_CORE, "WriteTracePipeRawDataByUring: trace file (%{public}s) not found.",
+            traceFilePath_.c_str());
+        return false;
+    }
+    std::string path = CanonicalizeSpecPath(srcPath.c_str());
+    auto rawTraceFd = SmartFd(open(path.c_str(), O_RDONLY | O_NONBLOCK));
+    if (!rawTraceFd) {
+        HILOG_ERROR(LOG_CORE, "WriteTracePipeRawDataByUring: open %{public}s failed.", srcPath.c_str());
+        return false;
+    }
+    const uint64_t headerOffset = fileOffset;
+    const uint64_t dataOffset = headerOffset + sizeof(TraceFileContentHeader);
+    const int fileSizeThreshold = request_.fileSize != 0 ? request_.fileSize : DEFAULT_FILE_SIZE * KB_PER_MB;
+    fileOffset = dataOffset;
+    writeLen_ = 0;
+    pageChkFailedTime_ = 0;
+    failedWriteOffset_ = std::numeric_limits<uint64_t>::max();
+    bool printFirstPageTime = false; // update first page time in every WriteTracePipeRawData calling.
+    bool endFlag = false;
+    bool ringFailed = false;
+    std::vector<uint16_t> freeSlots;
+    for (uint16_t slot = URING_SLOT_COUNT; slot > 0; slot--) {
+        freeSlots.push_back(slot - 1);
+    }
+    std::vector<uint16_t> readSlots;
+    std::vector<uint16_t> nextSlots;
+    if (!SubmitRawReads(rawTraceFd.GetFd(), freeSlots, readSlots)) {
+        ringFailed = true;
+    }
+    while (!ringFailed && !endFlag) {
+        if (!WaitRawReads(readSlots, freeSlots)) {
+            ringFailed = true;
+            break;
+        }
+        // the next reads are queued before this batch is handled, so they are in flight with its writes.
+        if (!SubmitRawReads(rawTraceFd.GetFd(), freeSlots, nextSlots)) {
+            ringFailed = true;
+            break;
+        }
+        // handle the pages in the order they were read, the accepted ones are queued as linked writes. The pages
+        // read ahead of the one which ends the dump are gone from trace_pipe_raw, so they are written as well.
+        for (auto slot : readSlots) {
+            if (!HandleRawPage(slot, readResults_[slot], fileOffset, endFlag, printFirstPageTime)) {
+                freeSlots.push_back(slot);
+            }
+        }
+        readSlots.swap(nextSlots);
+        nextSlots.clear();
+        if (ring_->Submit(0) < 0 || failedWriteOffset_ != std::numeric_limits<uint64_t>::max()) {
+            ringFailed = true;
+            break;
+        }
+        if (IsWriteFileOverflow(g_outputFileSize, static_cast<ssize_t>(fileOffset - dataOffset), fileSizeThreshold)) {
+            isOverFlow_ = true;
+            break;
+        }
+    }
+    // the batch still in flight is read ahead of the end of the dump.
+    if (!ringFailed && !readSlots.empty()) {
+        endFlag = true;
+        ringFailed = !WaitRawReads(readSlots, freeSlots);
+        for (auto slot : readSlots) {
+            if (!ringFailed && !HandleRawPage(slot, readResults_[slot], fileOffset, endFlag, printFirstPageTime)) {
+                freeSlots.push_back(slot);
+            }
+        }
+        ringFailed = ringFailed || ring_->Submit(0) < 0;
+    }
+    // the buffers are reused by the next cpu, so nothing may be left in flight.
+    while ((pendingReads_ > 0 || pendingWrites_ > 0) && ReapUringCompletions(freeSlots, true)) {}
+    // keep the raw data section consistent when some writes have failed.
+    uint64_t validDataEnd = std::min(fileOffset, failedWriteOffset_);
+    if (ringFailed || pendingReads_ > 0 || pendingWrites_ > 0) {
+        dumpStatus_ = TraceErrorCode::WRITE_TRACE_INFO_ERROR;
+    } else if (validDataEnd > dataOffset) {
+        dumpStatus_ = writeLen_ > 0 ? TraceErrorCode::SUCCESS : TraceErrorCode::WRITE_TRACE_INFO_ERROR;
+    }
+    TraceFileContentHeader rawtraceHdr;
+    rawtraceHdr.type = CONTENT_TYPE_CPU_RAW + cpuIdx;
+    rawtraceHdr.length = static_cast<uint32_t>(validDataEnd - dataOffset);
+    if (TEMP_FAILURE_RETRY(pwrite(traceFileFd_, &rawtraceHdr, sizeof(rawtraceHdr), headerOffset)) !=
+        static_cast<ssize_t>(sizeof(rawtraceHdr))) {
+        HILOG_ERROR(LOG_CORE, "WriteTracePipeRawDataByUring: write content header failed, errno(%{public}d)", errno);
+        fileOffset = headerOffset;
+        return false;
+    }
+    fileOffset = validDataEnd;
+    g_outputFileSize += static_cast<int>(rawtraceHdr.length + sizeof(TraceFileContentHeader));
+    IndexCpuRawSection(cpuIdx, static_cast<off_t>(dataOffset), rawtraceHdr.length);
+    HILOG_INFO(LOG_CORE, "WriteTracePipeRawDataByUring end, path: %{public}s, byte: %{public}u.",
+        srcPath.c_str(), rawtraceHdr.length);
+    return !ringFailed;
+}
+
+bool TraceCpuRawUringLinux::SubmitRawReads(const int srcFd, std::vector<uint16_t>& freeSlots,
+    std::vector<uint16_t>& readSlots)
+{
+    // wait for the written pages to give their buffers back.
+    while (freeSlots.empty() && pendingWrites_ > 0) {
+        if (!ReapUringCompletions(freeSlots, true)) {
+            return false;
+        }
+    }
+    size_t depth = std::min({freeSlots.size(), static_cast<size_t>(URING_READ_DEPTH),
+        static_cast<size_t>(ring_->GetSqSpace())});
+    for (size_t i = 0; i < depth; i++) {
+        uint16_t slot = freeSlots.back();
+        freeSlots.pop_back();
+        uint8_t* buf = bufferPool_.data() + static_cast<size_t>(slot) * PAGE_SIZE;
+        // reads of the same pipe are linked to keep the page order.
+        if (!ring_->PrepReadFixed(srcFd, buf, PAGE_SIZE, slot, (URING_OP_READ << URING_OP_SHIFT) | slot,
+            i + 1 < depth)) {
+            freeSlots.push_back(slot);
+            break;
+        }
+        readResults_[slot] = URING_READ_PENDING;
+        readSlots.push_back(slot);
+        pendingReads_++;
+    }
+    return ring_->Submit(0) >= 0;
+}
+
+bool TraceCpuRawUringLinux::WaitRawReads(const std::vector<uint16_t>& readSlots, std::vector<uint16_t>& freeSlots)
+{
+    // the completions of the other batch and of the writes are reaped on the way.
+    for (auto slot : readSlots) {
+        while (readResults_[slot] == URING_READ_PENDING) {
+            if (!ReapUringCompletions(freeSlots, true)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool TraceCpuRawUringLinux::ReapUringCompletions(std::vector<uint16_t>& freeSlots, const bool wait)
+{
+    uint64_t userData = 0;
+    int32_t res = 0;
+    bool reaped = false;
+    while (true) {
+        if (!ring_->PeekCqe(userData, res)) {
+            if (reaped || !wait) {
+                break;
+            }
+            if (ring_->Submit(1) < 0) {
+                return false;
+            }
+            continue;
+        }
+        reaped = true;
+        uint16_t slot = static_cast<uint16_t>(userData & 0xFFFF);
+        if (slot >= URING_SLOT_COUNT) {
+            continue;
+        }
+        if ((userData >> URING_OP_SHIFT) == URING_OP_READ) {
+            readResults_[slot] = res;
+            pendingReads_--;
+            continue;
+        }
+        pendingWrites_--;
+        // a short write breaks the chain of the linked writes, the section ends before the page it cut.
+        if (res == static_cast<int32_t>(writeSizes_[slot])) {
+            writeLen_ += res;
+        } else {
+            HILOG_ERROR(LOG_CORE, "ReapUringCompletions: write raw page failed, res(%{public}d) of %{public}u bytes.",
+                res, writeSizes_[slot]);
+            failedWriteOffset_ = std::min(failedWriteOffset_, writeOffsets_[slot]);
+        }
+        freeSlots.push_back(slot);
+    }
+    return true;
+}
+
+bool TraceCpuRawUringLinux::HandleRawPage(const uint16_t slot, const int32_t readBytes, uint64_t& fileOffset,
+    bool& endFlag, bool& printFirstPageTime)
+{
+    if (readBytes == -ECANCELED) { // the rest of the linked reads are canceled after a short read.
+        return false;
+    }
+    const bool isReadAhead = endFlag; // read before an earlier page of the batch ended the dump
+    if (readBytes <= 0) {
+        HILOG_DEBUG(LOG_CORE, "HandleRawPage: read raw trace done, size(%{public}d).", readBytes);
+        if (!isReadAhead) {
+            endFlag = true;
+            dumpStatus_ = TraceErrorCode::SUCCESS;
+        }
+        return false;
+    }
+    uint8_t* page = bufferPool_.data() + static_cast<size_t>(slot) * PAGE_SIZE;
+    uint64_t pageTraceTime = 0;
+    if (memcpy_s(&pageTraceTime, sizeof(pageTraceTime), page, sizeof(uint64_t)) != EOK) {
+        HILOG_ERROR(LOG_CORE, "HandleRawPage: failed to memcpy page to pageTraceTime.");
+        return false;
+    }
+    // only capture target duration trace data
+    int pageValid = IsCurrentTracePageValid(pageTraceTime, request_.traceStartTime, request_.traceEndTime);
+    if (isReadAhead) {
+        UpdateFirstLastPageTimeStamp(pageTraceTime, printFirstPageTime, firstPageTimeStamp_, lastPageTimeStamp_);
+        CollectSeenPages(page, static_cast<size_t>(readBytes));
+    } else if (pageValid < 0) {
+        endFlag = true;
+        dumpStatus_ = TraceErrorCode::OUT_OF_TIME;
+        if (!printFirstPageTime) {
+            return false;
+        }
+    } else if (pageValid == 0) {
+        return false;
+    } else {
+        UpdateFirstLastPageTimeStamp(pageTraceTime, printFirstPageTime, firstPageTimeStamp_, lastPageTimeStamp_);
+        if (!CheckPage(page)) {
+            pageChkFailedTime_++;
+        }
+        CollectSeenPages(page, static_cast<size_t>(readBytes));
+        if (pageChkFailedTime_ >= 2) { // 2 : check failed times threshold
+            endFlag = true;
+        }
+    }
+    // link the writes so that a failed write cancels the following ones instead of leaving holes, the queued
+    // writes are submitted first when the submission queue is full.
+    const uint64_t userData = (URING_OP_WRITE << URING_OP_SHIFT) | slot;
+    if (!ring_->PrepWriteFixed(traceFileFd_, page, static_cast<unsigned>(readBytes), fileOffset, slot, userData,
+        true) && (ring_->Submit(0) < 0 || !ring_->PrepWriteFixed(traceFileFd_, page,
+        static_cast<unsigned>(readBytes), fileOffset, slot, userData, true))) {
+        HILOG_ERROR(LOG_CORE, "HandleRawPage: no sqe for the raw page write.");
+        endFlag = true;
+        failedWriteOffset_ = std::min(failedWriteOffset_, fileOffset);
+        return false;
+    }
+    writeOffsets_[slot] = fileOffset;
+    writeSizes_[slot] = static_cast<uint32_t>(readBytes);
+    fileOffset += static_cast<uint64_t>(readBytes);
+    pendingWrites_++;
+    return true;
+}
+
 bool TraceCpuRawHM::WriteTraceContent()
 {
     std::string srcPath = GetTraceRootPath() + "trace_pipe_raw";
@@ -776,10 +1536,172 @@ bool TraceCpuRawHM::WriteTraceContent()
     return true;
 }
 
+TraceCpuRawCompress::TraceCpuRawCompress(const int fd, const std::string& traceFilePath, const bool ishm,
+    const TraceDumpRequest& request) : ITraceCpuRawContent(fd, traceFilePath, ishm, request) {}
+
+TraceCpuRawCompress::~TraceCpuRawCompress() = default;
+
+bool TraceCpuRawCompress::WriteTraceContent()
+{
+    if (compressor_ == nullptr) {
+        // leave the other half of the cpus to the read loop and the traced workload.
+        int workerCount = std::clamp(GetCpuProcessors() / 2, 1, COMPRESS_MAX_WORKERS);
+        compressor_ = std::make_unique<TraceChunkCompressor>(request_.compressLevel, workerCount);
+    }
+    if (isHm_) {
+        if (!WriteCompressedRawData(GetTraceRootPath() + "trace_pipe_raw", 0)) { // 0 : only one cpu raw pipe
+            return false;
+        }
+    } else {
+        int cpuNums = GetCpuProcessors();
+        for (int cpuIdx = 0; cpuIdx < cpuNums; cpuIdx++) {
+            std::string srcPath = GetTraceRootPath() + "per_cpu/cpu" + std::to_string(cpuIdx) + "/trace_pipe_raw";
+            if (!WriteCompressedRawData(srcPath, cpuIdx)) {
+                return false;
+            }
+        }
+    }
+    if (dumpStatus_ != TraceErrorCode::SUCCESS) {
+        HILOG_ERROR(LOG_CORE, "TraceCpuRawCompress WriteTraceContent failed, dump status: %{public}hhu.", dumpStatus_);
+        return false;
+    }
+    return true;
+}
+
+bool TraceCpuRawCompress::WriteCompressedRawData(const std::string& srcPath, const int cpuIdx)
+{
+    if (!IsFileExist()) {
+        HILOG_ERROR(LOG_CORE, "WriteCompressedRawData: trace file (%{public}s) not found.", traceFilePath_.c_str());
+        return false;
+    }
+    BufferLease bufferLease(*this);
+    if (!bufferLease.IsValid()) {
+        return false;
+    }
+    std::string path = CanonicalizeSpecPath(srcPath.c_str());
+    auto rawTraceFd = SmartFd(open(path.c_str(), O_RDONLY | O_NONBLOCK));
+    if (!rawTraceFd) {
+        HILOG_ERROR(LOG_CORE, "WriteCompressedRawData: open %{public}s failed.", srcPath.c_str());
+        return false;
+    }
+    struct TraceFileContentHeader sectionHeader;
+    if (!DoWriteTraceContentHeader(sectionHeader, CONTENT_TYPE_CPU_RAW_COMPRESSED)) {
+        return false;
+    }
+    off_t dataOffset = sectionWriter_.GetDataOffset();
+    TraceCompressedRawHeader rawHeader;
+    rawHeader.cpu = static_cast<uint8_t>(cpuIdx);
+    ssize_t writeLen = 0;
+    DoWriteTraceData(reinterpret_cast<const uint8_t*>(&rawHeader), sizeof(rawHeader), writeLen);
+    ssize_t readLen = 0;
+    int pageChkFailedTime = 0;
+    bool printFirstPageTime = false; // update first page time in every WriteCompressedRawData calling.
+    bool endFlag = false;
+    const int fileSizeThreshold = request_.fileSize != 0 ? request_.fileSize : DEFAULT_FILE_SIZE * KB_PER_MB;
+    std::deque<std::shared_ptr<TraceRawChunk>> pendingChunks;
+    while (!endFlag) {
+        int bytes = 0;
+        ReadTracePipeRawLoop(rawTraceFd.GetFd(), bytes, endFlag, pageChkFailedTime, printFirstPageTime);
+        readLen += bytes;
+        CollectSeenPages(buffer_, static_cast<size_t>(bytes));
+        SubmitRawChunks(bytes, pendingChunks);
+        // the chunks of the last read buffer are compressed while the next one is read.
+        while (pendingChunks.size() > COMPRESS_MAX_PENDING_CHUNKS) {
+            WriteRawChunk(pendingChunks.front(), cpuIdx, dataOffset, writeLen);
+            pendingChunks.pop_front();
+        }
+        if (IsWriteFileOverflow(g_outputFileSize, writeLen, fileSizeThreshold)) {
+            isOverFlow_ = true;
+            break;
+        }
+    }
+    while (!pendingChunks.empty()) {
+        WriteRawChunk(pendingChunks.front(), cpuIdx, dataOffset, writeLen);
+        pendingChunks.pop_front();
+    }
+    UpdateTraceContentHeader(sectionHeader, static_cast<uint32_t>(writeLen));
+    if (readLen > 0) {
+        dumpStatus_ = writeLen > static_cast<ssize_t>(sizeof(rawHeader)) ?
+            TraceErrorCode::SUCCESS : TraceErrorCode::WRITE_TRACE_INFO_ERROR;
+    }
+    HILOG_INFO(LOG_CORE, "WriteCompressedRawData end, path: %{public}s, byte: %{public}zd of %{public}zd.",
+        srcPath.c_str(), writeLen, readLen);
+    return true;
+}
+
+void TraceCpuRawCompress::SubmitRawChunks(const int bytes, std::deque<std::shared_ptr<TraceRawChunk>>& pendingChunks)
+{
+    for (size_t offset = 0; offset < static_cast<size_t>(bytes); offset += COMPRESS_CHUNK_SIZE) {
+        size_t size = std::min(COMPRESS_CHUNK_SIZE, static_cast<size_t>(bytes) - offset);
+        auto chunk = std::make_shared<TraceRawChunk>();
+        chunk->raw.assign(buffer_ + offset, buffer_ + offset + size);
+        chunk->pageCount = static_cast<uint32_t>((size + PAGE_SIZE - 1) / PAGE_SIZE);
+        size_t lastPageOffset = offset + (chunk->pageCount - 1) * PAGE_SIZE;
+        if (memcpy_s(&chunk->firstTimestamp, sizeof(uint64_t), buffer_ + offset, sizeof(uint64_t)) != EOK ||
+            memcpy_s(&chunk->lastTimestamp, sizeof(uint64_t), buffer_ + lastPageOffset, sizeof(uint64_t)) != EOK) {
+            HILOG_ERROR(LOG_CORE, "SubmitRawChunks: failed to memcpy page timestamp.");
+        }
+        compressor_->Submit(chunk);
+        pendingChunks.push_back(chunk);
+    }
+}
+
+void TraceCpuRawCompress::WriteRawChunk(const std::shared_ptr<TraceRawChunk>& chunk, const int cpuIdx,
+    const off_t dataOffset, ssize_t& writeLen)
+{
+    compressor_->Wait(chunk);
+    const auto& data = chunk->compressed.empty() ? chunk->raw : chunk->compressed;
+    TraceCompressedChunkHeader chunkHeader;
+    chunkHeader.compressedSize = static_cast<uint32_t>(data.size());
+    chunkHeader.uncompressedSize = static_cast<uint32_t>(chunk->raw.size());
+    chunkHeader.pageCount = chunk->pageCount;
+    TracePageIndexEntry entry;
+    entry.firstTimestamp = chunk->firstTimestamp;
+    entry.lastTimestamp = chunk->lastTimestamp;
+    entry.offset = static_cast<uint64_t>(dataOffset + writeLen);
+    entry.size = static_cast<uint32_t>(sizeof(chunkHeader) + data.size());
+    entry.cpu = static_cast<uint32_t>(cpuIdx);
+    DoWriteTraceData(reinterpret_cast<const uint8_t*>(&chunkHeader), sizeof(chunkHeader), writeLen);
+    DoWriteTraceData(data.data(), static_cast<int>(data.size()), writeLen);
+    if (dataOffset >= 0 && static_cast<uint64_t>(dataOffset + writeLen) == entry.offset + entry.size) {
+        pageIndex_.AddEntry(entry);
+    }
+}
+
+bool TraceCpuRawFlight::WriteTraceContent()
+{
+    auto& flightRecorder = TraceFlightRecorder::GetInstance();
+    for (int cpuIdx : flightRecorder.GetCpus()) {
+        auto pageRuns = flightRecorder.GetPageRuns(cpuIdx, request_.traceStartTime, request_.traceEndTime);
+        if (pageRuns.empty()) {
+            continue;
+        }
+        struct TraceFileContentHeader rawHeader;
+        if (!DoWriteTraceContentHeader(rawHeader, CONTENT_TYPE_CPU_RAW + (isHm_ ? 0 : cpuIdx))) {
+            return false;
+        }
+        ssize_t writeLen = 0;
+        for (const auto& pageRun : pageRuns) {
+            DoWriteTraceData(pageRun.block->data.data() + pageRun.offset, static_cast<int>(pageRun.size), writeLen);
+            CollectSeenPages(pageRun.block->data.data() + pageRun.offset, pageRun.size);
+            firstPageTimeStamp_ = std::min(firstPageTimeStamp_, pageRun.firstTimestamp);
+            lastPageTimeStamp_ = std::max(lastPageTimeStamp_, pageRun.lastTimestamp);
+        }
+        UpdateTraceContentHeader(rawHeader, static_cast<uint32_t>(writeLen));
+        dumpStatus_ = TraceErrorCode::SUCCESS;
+    }
+    if (dumpStatus_ != TraceErrorCode::SUCCESS) {
+        HILOG_ERROR(LOG_CORE, "TraceCpuRawFlight: no page in [%{public}" PRIu64 ", %{public}" PRIu64 "].",
+            request_.traceStartTime, request_.traceEndTime);
+        dumpStatus_ = TraceErrorCode::OUT_OF_TIME;
+        return false;
+    }
+    return true;
+}
+
 bool ITraceCpuRawRead::CopyTracePipeRawLoop(const int srcFd, const int cpu, ssize_t& writeLen,
     int& pageChkFailedTime, bool& printFirstPageTime)
 {
-    const size_t bufferSz = TraceBufferManager::GetInstance().GetBlockSize();
     auto buffer = TraceBufferManager::GetInstance().AllocateBlock(request_.taskId, cpu);
     if (buffer == nullptr) {
         HILOG_ERROR(LOG_CORE, "CopyTracePipeRawLoop: Failed to allocate memory block.");
@@ -787,9 +1709,10 @@ bool ITraceCpuRawRead::CopyTracePipeRawLoop(const int srcFd, const int cpu, ssiz
     }
     bool isStopRead = false;
     ssize_t blockReadSz = 0;
-    uint8_t pageBuffer[PAGE_SIZE] = {};
-    while (blockReadSz <= static_cast<ssize_t>(bufferSz - PAGE_SIZE)) {
-        ssize_t readBytes = TEMP_FAILURE_RETRY(read(srcFd, pageBuffer, PAGE_SIZE));
+    // pages are read into the tail of the block, a page is kept by committing it and dropped by leaving it there.
+    while (buffer->FreeBytes() >= PAGE_SIZE) {
+        uint8_t* page = buffer->Tail();
+        ssize_t readBytes = TEMP_FAILURE_RETRY(read(srcFd, page, PAGE_SIZE));
         if (readBytes <= 0) {
             HILOG_DEBUG(LOG_CORE, "CopyTracePipeRawLoop: read raw trace done, size(%{public}zd), err(%{public}s).",
                 readBytes, strerror(errno));
@@ -797,7 +1720,7 @@ bool ITraceCpuRawRead::CopyTracePipeRawLoop(const int srcFd, const int cpu, ssiz
             break;
         }
         uint64_t pageTraceTime = 0;
-        if (memcpy_s(&pageTraceTime, sizeof(pageTraceTime), pageBuffer, sizeof(uint64_t)) != EOK) {
+        if (memcpy_s(&pageTraceTime, sizeof(pageTraceTime), page, sizeof(uint64_t)) != EOK) {
             HILOG_ERROR(LOG_CORE, "CopyTracePipeRawLoop: failed to memcpy pagebuffer to pageTraceTime.");
             break;
         }
@@ -806,18 +1729,18 @@ bool ITraceCpuRawRead::CopyTracePipeRawLoop(const int srcFd, const int cpu, ssiz
         if (pageValid < 0) {
             isStopRead = true;
             blockReadSz += (printFirstPageTime ? readBytes : 0);
-            buffer->Append(pageBuffer, readBytes);
+            buffer->Commit(readBytes);
             dumpStatus_ = TraceErrorCode::OUT_OF_TIME;
             break;
         } else if (pageValid == 0) {
             continue;
         }
         UpdateFirstLastPageTimeStamp(pageTraceTime, printFirstPageTime, firstPageTimeStamp_, lastPageTimeStamp_);
-        if (!CheckPage(pageBuffer)) {
+        if (!CheckPage(page)) {
             pageChkFailedTime++;
         }
         blockReadSz += readBytes;
-        buffer->Append(pageBuffer, readBytes);
+        buffer->Commit(readBytes);
         if (pageChkFailedTime >= 2) { // 2 : check failed times threshold
             isStopRead = true;
             break;
@@ -846,6 +1769,57 @@ bool ITraceCpuRawRead::CacheTracePipeRawData(const std::string& srcPath, const i
     return true;
 }
 
+void ITraceCpuRawRead::KeepTailPages()
+{
+    if (!request_.limitFileSz || request_.fileSize <= 0) {
+        return;
+    }
+    auto buffers = TraceBufferManager::GetInstance().GetTaskBuffers(request_.taskId);
+    std::vector<uint64_t> pageTimes;
+    for (const auto& block : buffers) {
+        const uint8_t* data = block->data.data();
+        for (size_t offset = 0; offset + sizeof(uint64_t) <= block->usedBytes; offset += PAGE_SIZE) {
+            uint64_t pageTraceTime = 0;
+            if (memcpy_s(&pageTraceTime, sizeof(pageTraceTime), data + offset, sizeof(uint64_t)) == EOK) {
+                pageTimes.push_back(pageTraceTime);
+            }
+        }
+    }
+    size_t budgetPages = static_cast<size_t>(request_.fileSize) / PAGE_SIZE;
+    if (budgetPages == 0 || pageTimes.size() <= budgetPages) {
+        return;
+    }
+    // the newest budgetPages pages of all the cpus, the pages as old as the first dropped one are dropped too.
+    std::nth_element(pageTimes.begin(), pageTimes.begin() + budgetPages, pageTimes.end(), std::greater<uint64_t>());
+    uint64_t dropTime = pageTimes[budgetPages];
+    size_t keptBytes = 0;
+    firstPageTimeStamp_ = std::numeric_limits<uint64_t>::max();
+    for (auto& block : buffers) {
+        uint8_t* data = block->data.data();
+        size_t blockKeptBytes = 0;
+        for (size_t offset = 0; offset < block->usedBytes; offset += PAGE_SIZE) {
+            size_t pageBytes = std::min(PAGE_SIZE, block->usedBytes - offset);
+            uint64_t pageTraceTime = 0;
+            if (pageBytes < sizeof(uint64_t) ||
+                memcpy_s(&pageTraceTime, sizeof(pageTraceTime), data + offset, sizeof(uint64_t)) != EOK ||
+                pageTraceTime <= dropTime) {
+                continue;
+            }
+            if (blockKeptBytes != offset && memmove_s(data + blockKeptBytes, block->data.size() - blockKeptBytes,
+                data + offset, pageBytes) != EOK) {
+                continue;
+            }
+            blockKeptBytes += pageBytes;
+            firstPageTimeStamp_ = std::min(firstPageTimeStamp_, pageTraceTime);
+        }
+        block->usedBytes = blockKeptBytes;
+        keptBytes += blockKeptBytes;
+    }
+    isOverFlow_ = true;
+    HILOG_INFO(LOG_CORE, "KeepTailPages: %{public}zu of %{public}zu pages kept, first page time %{public}" PRIu64 ".",
+        keptBytes / PAGE_SIZE, pageTimes.size(), firstPageTimeStamp_);
+}
+
 bool TraceCpuRawReadLinux::WriteTraceContent()
 {
     int cpuNums = GetCpuProcessors();
@@ -855,6 +1829,7 @@ bool TraceCpuRawReadLinux::WriteTraceContent()
             return false;
         }
     }
+    KeepTailPages();
     if (dumpStatus_ != TraceErrorCode::SUCCESS) {
         HILOG_ERROR(LOG_CORE, "TraceCpuRawReadLinux WriteTraceContent failed, dump status: %{public}hhu.", dumpStatus_);
         TraceBufferManager::GetInstance().ReleaseTaskBlocks(request_.taskId);
@@ -869,6 +1844,7 @@ bool TraceCpuRawReadHM::WriteTraceContent()
     if (!CacheTracePipeRawData(srcPath, 0)) { // 0 : hongmeng kernel only has one cpu trace raw pipe
         return false;
     }
+    KeepTailPages();
     if (dumpStatus_ != TraceErrorCode::SUCCESS) {
         HILOG_ERROR(LOG_CORE, "TraceCpuRawReadHM WriteTraceContent failed, dump status: %{public}hhu.", dumpStatus_);
         TraceBufferManager::GetInstance().ReleaseTaskBlocks(request_.taskId);
@@ -935,6 +1911,11 @@ bool TraceCpuRawWriteHM::WriteTraceContent()
 TraceHeaderPageLinux::TraceHeaderPageLinux(const int fd, const std::string& traceFilePath)
     : ITraceHeaderPageContent(fd, traceFilePath, false)
 {
+    auto staticFiles = TraceMetadataCache::GetInstance().GetPreparedStaticFiles();
+    if (staticFiles != nullptr && !staticFiles->headerPage.empty()) {
+        staticFiles_ = staticFiles;
+        return;
+    }
     const std::string headerPagePath = GetTraceRootPath() + "events/header_page";
     traceSourceFd_ = SmartFd(open(headerPagePath.c_str(), O_RDONLY | O_NONBLOCK));
     if (!traceSourceFd_) {
@@ -944,6 +1925,9 @@ TraceHeaderPageLinux::TraceHeaderPageLinux(const int fd, const std::string& trac
 
 bool TraceHeaderPageLinux::WriteTraceContent()
 {
+    if (staticFiles_ != nullptr) {
+        return WriteCachedData(staticFiles_->headerPage, CONTENT_TYPE_HEADER_PAGE);
+    }
     return WriteTraceData(CONTENT_TYPE_HEADER_PAGE);
 }
 
@@ -955,6 +1939,11 @@ bool TraceHeaderPageHM::WriteTraceContent()
 TracePrintkFmtLinux::TracePrintkFmtLinux(const int fd, const std::string& traceFilePath)
     : ITracePrintkFmtContent(fd, traceFilePath, false)
 {
+    auto staticFiles = TraceMetadataCache::GetInstance().GetPreparedStaticFiles();
+    if (staticFiles != nullptr && !staticFiles->printkFormats.empty()) {
+        staticFiles_ = staticFiles;
+        return;
+    }
     const std::string printkFormatPath = GetTraceRootPath() + "printk_formats";
     traceSourceFd_ = SmartFd(open(printkFormatPath.c_str(), O_RDONLY | O_NONBLOCK));
     if (!traceSourceFd_) {
@@ -964,6 +1953,9 @@ TracePrintkFmtLinux::TracePrintkFmtLinux(const int fd, const std::string& traceF
 
 bool TracePrintkFmtLinux::WriteTraceContent()
 {
+    if (staticFiles_ != nullptr) {
+        return WriteCachedData(staticFiles_->printkFormats, CONTENT_TYPE_PRINTK_FORMATS);
+    }
     return WriteTraceData(CONTENT_TYPE_PRINTK_FORMATS);
 }
 
@@ -16,42 +16,47 @@
 #ifndef TRACE_CONTENT_H
 #define TRACE_CONTENT_H
 
+#include <deque>
+#include <memory>
 #include <string>
+#include <sys/types.h>
+#include <vector>
 
 #include "hitrace_define.h"
 #include "smart_fd.h"
 #include "trace_buffer_manager.h"
+#include "trace_compressor.h"
+#include "trace_file_format.h"
+#include "trace_metadata_cache.h"
+#include "trace_metadata_sidecar.h"
+#include "trace_page_index.h"
+#include "trace_process_table.h"
+#include "trace_section_table.h"
 
 namespace OHOS {
 namespace HiviewDFX {
 namespace Hitrace {
-constexpr int ALIGNMENT_COEFFICIENT = 4;
-constexpr uint16_t MAGIC_NUMBER = 57161;
-constexpr uint8_t FILE_RAW_TRACE = 0;
-constexpr uint16_t VERSION_NUMBER = 1;
-
-struct alignas(ALIGNMENT_COEFFICIENT) TraceFileHeader {
-    uint16_t magicNumber {MAGIC_NUMBER};
-    uint8_t fileType {FILE_RAW_TRACE};
-    uint16_t versionNumber {VERSION_NUMBER};
-    uint32_t reserved {0};
-};
+class TraceIoUring;
 
-enum ContentType : uint8_t {
-    CONTENT_TYPE_DEFAULT = 0,
-    CONTENT_TYPE_EVENTS_FORMAT = 1,
-    CONTENT_TYPE_CMDLINES  = 2,
-    CONTENT_TYPE_TGIDS = 3,
-    CONTENT_TYPE_CPU_RAW = 4,
-    CONTENT_TYPE_HEADER_PAGE = 30,
-    CONTENT_TYPE_PRINTK_FORMATS = 31,
-    CONTENT_TYPE_KALLSYMS = 32,
-    CONTENT_TYPE_BASE_INFO = 33
-};
+constexpr size_t CONTENT_BUFFER_SIZE = 1024 * 1024; // 1M, the staging buffer of a content writer
+constexpr size_t CONTENT_BUFFER_MAX_COUNT = 1; // the contents of one dump are written one after another
+
+/**
+ * @brief TraceSectionWriter writes one content section of the trace file.
+ * @note The header offset is taken once when the section begins, the header is backfilled with pwrite when the
+ * section length is known, so the file position only moves forward while the body is being written.
+ */
+class TraceSectionWriter {
+public:
+    explicit TraceSectionWriter(const int fd) : fd_(fd) {}
+    bool Begin(TraceFileContentHeader& contentHeader, const uint8_t contentType);
+    bool Commit(const TraceFileContentHeader& contentHeader);
+    void Discard();
+    off_t GetDataOffset() const;
 
-struct alignas(ALIGNMENT_COEFFICIENT) TraceFileContentHeader {
-    uint8_t type = CONTENT_TYPE_DEFAULT;
-    uint32_t length = 0;
+private:
+    int fd_ = -1;
+    off_t headerOffset_ = -1;
 };
 
 struct PageHeader {
@@ -77,16 +82,45 @@ public:
     static int GetCurrentFileSize();
     static void ResetCurrentFileSize();
     void WriteProcessLists(ssize_t& writeLen);
+    // the staging buffer is borrowed from the pool of the dump session, a private one is used if it is not set.
+    void SetBufferPool(std::shared_ptr<TraceDumpBufferPool> bufferPool) { bufferPool_ = bufferPool; }
+    // /proc is scanned once per dump session, a private table is scanned if it is not set.
+    void SetProcessTable(std::shared_ptr<TraceProcessTable> processTable) { processTable_ = processTable; }
 
-private:
-    bool AppendToBuffer(const std::string& data, int& bytes, ssize_t& writeLen);
 protected:
-    std::string ReadProcessName(const std::string& pid);
+    /**
+     * @brief BufferLease points buffer_ to a staging buffer of CONTENT_BUFFER_SIZE bytes during its lifetime,
+     *        a lease taken while buffer_ is already set does nothing, so the writers can be nested.
+     */
+    class BufferLease {
+    public:
+        explicit BufferLease(ITraceContent& content);
+        ~BufferLease();
+        BufferLease(const BufferLease&) = delete;
+        BufferLease& operator=(const BufferLease&) = delete;
+        bool IsValid() const { return content_.buffer_ != nullptr; }
+
+    private:
+        ITraceContent& content_;
+        bool isOwner_ = false;
+    };
+
+    std::shared_ptr<TraceProcessTable> GetProcessTable();
+    // write a section kept in memory with a single write after its header.
+    bool WriteCachedData(const std::string& content, const uint8_t contentType);
+    bool AppendToBuffer(const std::string& data, int& bytes, ssize_t& writeLen);
     virtual ssize_t WriteTraceDataContent();
     int traceFileFd_ = -1;
     SmartFd traceSourceFd_;
     std::string traceFilePath_;
     bool isHm_;
+    TraceSectionWriter sectionWriter_;
+    uint8_t* buffer_ = nullptr;
+
+private:
+    std::shared_ptr<TraceDumpBufferPool> bufferPool_;
+    std::shared_ptr<BufferBlockMemory> bufferMemory_;
+    std::shared_ptr<TraceProcessTable> processTable_;
 };
 
 class ITraceFileHdrContent : public ITraceContent {
@@ -95,6 +129,10 @@ public:
         : ITraceContent(fd, traceFilePath, ishm) {}
     bool WriteTraceContent() override = 0;
     bool InitTraceFileHdr(TraceFileHeader& fileHdr);
+    void SetVersionNumber(const uint16_t versionNumber) { versionNumber_ = versionNumber; }
+
+private:
+    uint16_t versionNumber_ = VERSION_NUMBER;
 };
 
 class TraceFileHdrLinux : public ITraceFileHdrContent {
@@ -132,6 +170,7 @@ public:
 private:
     bool WriteTraceContentInline();
     bool inlineEventFmt_ = false;
+    std::shared_ptr<const TraceEventFormats> eventFormats_;
 };
 
 class TraceCmdLinesContent : public ITraceContent {
@@ -139,8 +178,57 @@ public:
     TraceCmdLinesContent(const int fd, const std::string& traceFilePath,
         const bool ishm);
     bool WriteTraceContent() override;
+    // only the tasks seen in the cpu raw pages are written if they have been collected.
+    void SetSeenPids(std::shared_ptr<TraceSeenPids> seenPids) { seenPids_ = seenPids; }
 protected:
     ssize_t WriteTraceDataContent() override;
+
+private:
+    ssize_t WriteSeenCmdLines();
+
+    std::shared_ptr<TraceSeenPids> seenPids_;
+};
+
+/**
+ * @brief TraceSectionTableContent is written after all the other sections, it locates them for the readers which
+ *        seek into the file. libhitrace_reader skips it as an unknown type. hitrace_converter versions older than
+ *        the page index took every unknown section for cpu raw pages and can not read such files.
+ */
+class TraceSectionTableContent : public ITraceContent {
+public:
+    TraceSectionTableContent(const int fd, const std::string& traceFilePath, const bool ishm)
+        : ITraceContent(fd, traceFilePath, ishm) {}
+    bool WriteTraceContent() override;
+};
+
+/**
+ * @brief TraceMetadataRefContent takes the place of the events format, header page and printk formats sections of
+ *        a slice of a series, they are saved once into the sidecar file of the slice directory when it is created.
+ */
+class TraceMetadataRefContent : public ITraceContent {
+public:
+    TraceMetadataRefContent(const int fd, const std::string& traceFilePath, const bool ishm);
+    bool WriteTraceContent() override;
+    // false if the metadata is not prepared in memory or the sidecar cannot be saved, the slice keeps it inline then.
+    bool IsValid() const { return sidecar_ != nullptr; }
+
+private:
+    std::shared_ptr<const TraceMetadataSidecar> sidecar_;
+};
+
+/**
+ * @brief TraceKallsymsContent lists the kernel symbols of the addresses seen in the cpu raw pages of the file in the
+ *        format of kallsyms, the section is left out if no address is resolved.
+ */
+class TraceKallsymsContent : public ITraceContent {
+public:
+    TraceKallsymsContent(const int fd, const std::string& traceFilePath, const bool ishm)
+        : ITraceContent(fd, traceFilePath, ishm) {}
+    bool WriteTraceContent() override;
+    void SetSeenAddrs(std::shared_ptr<TraceSeenAddrs> seenAddrs) { seenAddrs_ = seenAddrs; }
+
+private:
+    std::shared_ptr<TraceSeenAddrs> seenAddrs_;
 };
 
 class TraceTgidsContent : public ITraceContent {
@@ -148,15 +236,25 @@ public:
     TraceTgidsContent(const int fd, const std::string& traceFilePath,
         const bool ishm);
     bool WriteTraceContent() override;
+    // only the tasks seen in the cpu raw pages are written if they have been collected.
+    void SetSeenPids(std::shared_ptr<TraceSeenPids> seenPids) { seenPids_ = seenPids; }
 protected:
     ssize_t WriteTraceDataContent() override;
+
+private:
+    ssize_t WriteSeenTgids();
+
+    std::shared_ptr<TraceSeenPids> seenPids_;
 };
 
 class ITraceCpuRawContent : public ITraceContent {
 public:
     ITraceCpuRawContent(const int fd, const std::string& traceFilePath,
         const bool ishm, const TraceDumpRequest& request)
-        : ITraceContent(fd, traceFilePath, ishm), request_(request) {}
+        : ITraceContent(fd, traceFilePath, ishm), request_(request)
+    {
+        SetBufferPool(request.bufferPool);
+    }
     bool WriteTraceContent() override = 0;
 
     bool WriteTracePipeRawData(const std::string& srcPath, const int cpuIdx);
@@ -168,13 +266,29 @@ public:
     uint64_t GetFirstPageTimeStamp() { return firstPageTimeStamp_; }
     uint64_t GetLastPageTimeStamp() { return lastPageTimeStamp_; }
     bool IsOverFlow();
+    virtual uint16_t GetFileVersionNumber() const { return VERSION_NUMBER; }
+    // write the page index of the cpu raw sections of record and cache files, nothing for the other dumps.
+    bool WritePageIndexContent();
 
 protected:
+    /**
+     * @brief move pages from trace_pipe_raw to the trace file through pipes with splice, only the page header
+     *        is peeked into user space with tee.
+     * @return true if the dump of current cpu is finished, false if the rest should be read by the read loop.
+     */
+    bool SpliceTracePipeRawLoop(const int srcFd, ssize_t& readLen, ssize_t& writeLen,
+        int& pageChkFailedTime, bool& printFirstPageTime);
+    bool FlushSplicePipe(const int pipeReadFd, int& batchBytes, ssize_t& writeLen);
+    void CollectSeenPages(const uint8_t* pages, const size_t size);
+    void IndexCpuRawSection(const int cpuIdx, const off_t dataOffset, const uint32_t length);
+
     TraceDumpRequest request_;
     TraceErrorCode dumpStatus_ = TraceErrorCode::UNSET;
     uint64_t firstPageTimeStamp_ = std::numeric_limits<uint64_t>::max();
     uint64_t lastPageTimeStamp_ = 0;
     bool isOverFlow_ = false;
+    TracePageIndex pageIndex_;
+    SmartFd pageIndexFd_; // the trace file is opened write only, the page timestamps are read back through it.
 };
 
 class TraceCpuRawLinux : public ITraceCpuRawContent {
@@ -184,6 +298,39 @@ public:
     bool WriteTraceContent() override;
 };
 
+/**
+ * @brief dump the per-cpu raw trace through io_uring, reads of trace_pipe_raw are kept in flight in registered
+ *        buffers while the accepted pages are written to the file in order, falls back to TraceCpuRawLinux
+ *        when io_uring is unavailable.
+ */
+class TraceCpuRawUringLinux : public TraceCpuRawLinux {
+public:
+    TraceCpuRawUringLinux(const int fd, const std::string& traceFilePath, const TraceDumpRequest& request);
+    ~TraceCpuRawUringLinux() override;
+    bool WriteTraceContent() override;
+
+private:
+    bool InitUring();
+    bool WriteTracePipeRawDataByUring(const std::string& srcPath, const int cpuIdx, uint64_t& fileOffset);
+    bool SubmitRawReads(const int srcFd, std::vector<uint16_t>& freeSlots, std::vector<uint16_t>& readSlots);
+    bool WaitRawReads(const std::vector<uint16_t>& readSlots, std::vector<uint16_t>& freeSlots);
+    bool ReapUringCompletions(std::vector<uint16_t>& freeSlots, const bool wait);
+    bool HandleRawPage(const uint16_t slot, const int32_t readBytes, uint64_t& fileOffset,
+        bool& endFlag, bool& printFirstPageTime);
+
+    std::unique_ptr<TraceIoUring> ring_;
+    std::vector<uint8_t> bufferPool_;
+    std::vector<int32_t> readResults_;
+    std::vector<uint64_t> writeOffsets_;
+    std::vector<uint32_t> writeSizes_;
+    int pendingReads_ = 0;
+    int pendingWrites_ = 0;
+    int pageChkFailedTime_ = 0;
+    ssize_t writeLen_ = 0;
+    uint64_t failedWriteOffset_ = std::numeric_limits<uint64_t>::max();
+    bool uringInited_ = false;
+};
+
 class TraceCpuRawHM : public ITraceCpuRawContent {
 public:
     TraceCpuRawHM(const int fd, const std::string& traceFilePath, const TraceDumpRequest& request)
@@ -191,6 +338,38 @@ public:
     bool WriteTraceContent() override;
 };
 
+/**
+ * @brief dump the pages of the requested time window from the in-memory flight recorder of cache trace instead
+ *        of draining trace_pipe_raw.
+ */
+class TraceCpuRawFlight : public ITraceCpuRawContent {
+public:
+    TraceCpuRawFlight(const int fd, const std::string& traceFilePath, const bool ishm,
+        const TraceDumpRequest& request) : ITraceCpuRawContent(fd, traceFilePath, ishm, request) {}
+    bool WriteTraceContent() override;
+};
+
+/**
+ * @brief dump the per-cpu raw trace of record and cache files as compressed sections, the chunks of pages are
+ *        compressed by a worker pool while the next ones are read.
+ */
+class TraceCpuRawCompress : public ITraceCpuRawContent {
+public:
+    TraceCpuRawCompress(const int fd, const std::string& traceFilePath, const bool ishm,
+        const TraceDumpRequest& request);
+    ~TraceCpuRawCompress() override;
+    bool WriteTraceContent() override;
+    uint16_t GetFileVersionNumber() const override { return VERSION_NUMBER_COMPRESSED_RAW; }
+
+private:
+    bool WriteCompressedRawData(const std::string& srcPath, const int cpuIdx);
+    void SubmitRawChunks(const int bytes, std::deque<std::shared_ptr<TraceRawChunk>>& pendingChunks);
+    void WriteRawChunk(const std::shared_ptr<TraceRawChunk>& chunk, const int cpuIdx, const off_t dataOffset,
+        ssize_t& writeLen);
+
+    std::unique_ptr<TraceChunkCompressor> compressor_;
+};
+
 class ITraceCpuRawRead : public ITraceContent {
 public:
     ITraceCpuRawRead(const bool ishm, const TraceDumpRequest& request)
@@ -204,12 +383,21 @@ public:
     TraceErrorCode GetDumpStatus() { return dumpStatus_; }
     uint64_t GetFirstPageTimeStamp() { return firstPageTimeStamp_; }
     uint64_t GetLastPageTimeStamp() { return lastPageTimeStamp_; }
+    // true if older pages have been dropped to fit the cached pages into the file size budget.
+    bool IsOverFlow() const { return isOverFlow_; }
 
 protected:
+    /**
+     * @brief keep the newest pages of all the cpus within the file size budget of the request, a page is kept
+     *        only if it is newer than every dropped page, so that all the cpus cover the same latest window.
+     */
+    void KeepTailPages();
+
     TraceDumpRequest request_;
     TraceErrorCode dumpStatus_ = TraceErrorCode::UNSET;
     uint64_t firstPageTimeStamp_ = std::numeric_limits<uint64_t>::max();
     uint64_t lastPageTimeStamp_ = 0;
+    bool isOverFlow_ = false;
 };
 
 class TraceCpuRawReadLinux : public ITraceCpuRawRead {
@@ -259,6 +447,9 @@ class TraceHeaderPageLinux : public ITraceHeaderPageContent {
 public:
     TraceHeaderPageLinux(const int fd, const std::string& traceFilePath);
     bool WriteTraceContent() override;
+
+private:
+    std::shared_ptr<const TraceStaticFiles> staticFiles_;
 };
 
 class TraceHeaderPageHM : public ITraceHeaderPageContent {
@@ -279,6 +470,9 @@ class TracePrintkFmtLinux : public ITracePrintkFmtContent {
 public:
     TracePrintkFmtLinux(const int fd, const std::string& traceFilePath);
     bool WriteTraceContent() override;
+
+private:
+    std::shared_ptr<const TraceStaticFiles> staticFiles_;
 };
 
 class TracePrintkFmtHM : public ITracePrintkFmtContent {
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRACE_FILE_FORMAT_H
+#define TRACE_FILE_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+// the layout of the raw trace file, shared by the writers and libhitrace_reader, which only includes this header.
+constexpr int ALIGNMENT_COEFFICIENT = 4;
+constexpr uint16_t MAGIC_NUMBER = 57161;
+constexpr uint8_t FILE_RAW_TRACE = 0;
+constexpr uint8_t HM_FILE_RAW_TRACE = 1;
+constexpr uint16_t VERSION_NUMBER = 1;
+constexpr uint16_t VERSION_NUMBER_COMPRESSED_RAW = 2; // the file may hold CONTENT_TYPE_CPU_RAW_COMPRESSED sections
+constexpr uint8_t TRACE_COMPRESS_ZLIB = 1;
+
+struct alignas(ALIGNMENT_COEFFICIENT) TraceFileHeader {
+    uint16_t magicNumber {MAGIC_NUMBER};
+    uint8_t fileType {FILE_RAW_TRACE};
+    uint16_t versionNumber {VERSION_NUMBER};
+    uint32_t reserved {0};
+};
+
+enum ContentType : uint8_t {
+    CONTENT_TYPE_DEFAULT = 0,
+    CONTENT_TYPE_EVENTS_FORMAT = 1,
+    CONTENT_TYPE_CMDLINES  = 2,
+    CONTENT_TYPE_TGIDS = 3,
+    CONTENT_TYPE_CPU_RAW = 4,
+    CONTENT_TYPE_HEADER_PAGE = 30,
+    CONTENT_TYPE_PRINTK_FORMATS = 31,
+    CONTENT_TYPE_KALLSYMS = 32,
+    CONTENT_TYPE_BASE_INFO = 33,
+    CONTENT_TYPE_PAGE_INDEX = 34,
+    CONTENT_TYPE_CPU_RAW_COMPRESSED = 35,
+    CONTENT_TYPE_SECTION_TABLE = 36,
+    CONTENT_TYPE_METADATA_REF = 37
+};
+
+struct alignas(ALIGNMENT_COEFFICIENT) TraceFileContentHeader {
+    uint8_t type = CONTENT_TYPE_DEFAULT;
+    uint32_t length = 0;
+};
+
+/**
+ * @brief a CONTENT_TYPE_CPU_RAW_COMPRESSED section starts with TraceCompressedRawHeader, which is followed by
+ *        chunks of at most PAGE_INDEX_STRIDE pages, each chunk is a TraceCompressedChunkHeader and its data.
+ * @note the data of a chunk is stored as it is when compressedSize equals uncompressedSize.
+ */
+struct alignas(ALIGNMENT_COEFFICIENT) TraceCompressedRawHeader {
+    uint8_t cpu = 0;
+    uint8_t algorithm = TRACE_COMPRESS_ZLIB;
+    uint16_t reserved = 0;
+};
+
+struct alignas(ALIGNMENT_COEFFICIENT) TraceCompressedChunkHeader {
+    uint32_t compressedSize = 0;
+    uint32_t uncompressedSize = 0;
+    uint32_t pageCount = 0;
+};
+
+constexpr uint32_t METADATA_SIDECAR_MAGIC = 0x4D445354; // "TSDM"
+constexpr char METADATA_SIDECAR_FILE_PREFIX[] = "saved_metadata_"; // followed by the hash in 16 hex digits
+
+/**
+ * @brief a CONTENT_TYPE_METADATA_REF section takes the place of the events format, header page and printk formats
+ *        sections of a slice of a series, it is written after the cpu raw sections. The sections are kept once in
+ *        the sidecar file of the hash in the directory of the slice, which starts with the same TraceMetadataRef.
+ */
+struct TraceMetadataRef {
+    uint64_t hash = 0; // FNV-1a of the sections of the sidecar
+    uint32_t sectionCount = 0;
+    uint32_t magic = METADATA_SIDECAR_MAGIC;
+};
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
+#endif // TRACE_FILE_FORMAT_H
@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace_flight_recorder.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <fcntl.h>
+#include <limits>
+#include <unistd.h>
+
+#include "common_define.h"
+#include "common_utils.h"
+#include "hilog/log.h"
+#include "hitrace_option_util.h"
+#include "securec.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+namespace {
+#ifdef LOG_DOMAIN
+#undef LOG_DOMAIN
+#define LOG_DOMAIN 0xD002D33
+#endif
+#ifdef LOG_TAG
+#undef LOG_TAG
+#define LOG_TAG "HitraceFlightRecorder"
+#endif
+
+constexpr int64_t FLIGHT_BLOCK_IDLE_TIMEOUT_S = 60;
+constexpr size_t PAGE_COMMIT_OFFSET = sizeof(uint64_t);
+constexpr int MAX_SPARSE_PAGE_CNT = 2;
+
+bool IsSparsePage(const uint8_t* page, const size_t size)
+{
+    uint64_t commit = 0;
+    if (size < PAGE_COMMIT_OFFSET + sizeof(commit) ||
+        memcpy_s(&commit, sizeof(commit), page + PAGE_COMMIT_OFFSET, sizeof(commit)) != EOK) {
+        return true;
+    }
+    return commit < static_cast<uint64_t>(PAGE_SIZE / 2); // 2 : less than half a page
+}
+} // namespace
+
+TraceFlightRecorder::TraceFlightRecorder()
+{
+    blockPool_ = std::make_shared<BufferBlockPool>(FLIGHT_BLOCK_SZ, FLIGHT_MAX_IDLE_SZ, FLIGHT_BLOCK_IDLE_TIMEOUT_S);
+}
+
+TraceFlightRecorder::~TraceFlightRecorder() {}
+
+void TraceFlightRecorder::Start(const size_t maxTotalSz, const uint64_t windowNs)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    cpuBlocks_.clear();
+    curTotalSz_ = 0;
+    latestTimestamp_ = 0;
+    // every cpu needs a block to append to, plus one to evict from.
+    size_t minTotalSz = static_cast<size_t>(GetCpuProcessors() + 1) * FLIGHT_BLOCK_SZ;
+    maxTotalSz_ = std::max(std::min(maxTotalSz, FLIGHT_MAX_TOTAL_SZ), minTotalSz);
+    windowNs_ = windowNs;
+    running_ = true;
+    HILOG_INFO(LOG_CORE, "TraceFlightRecorder: start, max size %{public}zu, window %{public}" PRIu64 " ns.",
+        maxTotalSz_, windowNs_);
+}
+
+void TraceFlightRecorder::Stop()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+    cpuBlocks_.clear();
+    curTotalSz_ = 0;
+    blockPool_->TrimIdleBlocks(true);
+    HILOG_INFO(LOG_CORE, "TraceFlightRecorder: stop.");
+}
+
+bool TraceFlightRecorder::IsRunning()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_;
+}
+
+bool TraceFlightRecorder::DrainTracePipeRaw()
+{
+    if (IsHmKernel()) {
+        SmartFd rawFd(open((GetTraceRootPath() + "trace_pipe_raw").c_str(), O_RDONLY | O_NONBLOCK));
+        return rawFd && DrainCpu(rawFd.GetFd(), 0, true); // 0 : hongmeng kernel only has one cpu trace raw pipe
+    }
+    int cpuNums = GetCpuProcessors();
+    for (int cpuIdx = 0; cpuIdx < cpuNums; cpuIdx++) {
+        std::string path = GetTraceRootPath() + "per_cpu/cpu" + std::to_string(cpuIdx) + "/trace_pipe_raw";
+        SmartFd rawFd(open(path.c_str(), O_RDONLY | O_NONBLOCK));
+        if (!rawFd) {
+            HILOG_ERROR(LOG_CORE, "DrainTracePipeRaw: open %{public}s failed.", path.c_str());
+            return false;
+        }
+        if (!DrainCpu(rawFd.GetFd(), cpuIdx, false)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TraceFlightRecorder::DrainCpu(const int srcFd, const int cpu, const bool isHm)
+{
+    int sparsePageCnt = 0;
+    // a cpu which writes as fast as it is drained must not hold the loop, drain at most the budget each round.
+    for (size_t drainedSz = 0; drainedSz < maxTotalSz_; drainedSz += PAGE_SIZE) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return false;
+        }
+        FlightBlock* flightBlock = GetWritableBlockLocked(cpu);
+        if (flightBlock == nullptr) {
+            HILOG_ERROR(LOG_CORE, "DrainCpu: failed to allocate block for cpu%{public}d.", cpu);
+            return false;
+        }
+        uint8_t* page = flightBlock->block->Tail();
+        ssize_t readBytes = TEMP_FAILURE_RETRY(read(srcFd, page, PAGE_SIZE));
+        if (readBytes <= 0) {
+            break;
+        }
+        uint64_t timestamp = 0;
+        if (memcpy_s(&timestamp, sizeof(timestamp), page, sizeof(uint64_t)) != EOK) {
+            break;
+        }
+        uint32_t offset = static_cast<uint32_t>(flightBlock->block->usedBytes);
+        flightBlock->block->Commit(static_cast<size_t>(readBytes));
+        flightBlock->pages.push_back({offset, static_cast<uint32_t>(readBytes), timestamp});
+        latestTimestamp_ = std::max(latestTimestamp_, timestamp);
+        bool isSparse = !isHm && IsSparsePage(page, static_cast<size_t>(readBytes));
+        EvictLocked();
+        if (isSparse && ++sparsePageCnt >= MAX_SPARSE_PAGE_CNT) {
+            break;
+        }
+    }
+    return true;
+}
+
+FlightBlock* TraceFlightRecorder::GetWritableBlockLocked(const int cpu)
+{
+    auto& blocks = cpuBlocks_[cpu];
+    if (!blocks.empty() && blocks.back().block->FreeBytes() >= PAGE_SIZE) {
+        return &blocks.back();
+    }
+    auto block = blockPool_->Acquire(cpu);
+    if (block == nullptr) {
+        return nullptr;
+    }
+    curTotalSz_ += FLIGHT_BLOCK_SZ;
+    blocks.push_back({block, {}});
+    // the new block may stay empty if the pipe has no more data, make room for it right now.
+    EvictLocked();
+    return &blocks.back();
+}
+
+void TraceFlightRecorder::EvictLocked()
+{
+    while (curTotalSz_ > maxTotalSz_) {
+        if (!PopOldestBlockLocked()) {
+            return;
+        }
+    }
+    if (windowNs_ == 0 || latestTimestamp_ <= windowNs_) {
+        return;
+    }
+    uint64_t windowStart = latestTimestamp_ - windowNs_;
+    while (true) {
+        // the front block of each cpu is the oldest one of the cpu, evict the ones which ended before the window.
+        auto expired = std::find_if(cpuBlocks_.begin(), cpuBlocks_.end(), [windowStart](const auto& item) {
+            return item.second.size() > 1 && !item.second.front().pages.empty() &&
+                item.second.front().pages.back().timestamp < windowStart;
+        });
+        if (expired == cpuBlocks_.end()) {
+            return;
+        }
+        expired->second.pop_front();
+        curTotalSz_ -= FLIGHT_BLOCK_SZ;
+    }
+}
+
+bool TraceFlightRecorder::PopOldestBlockLocked()
+{
+    auto oldest = cpuBlocks_.end();
+    uint64_t oldestTime = std::numeric_limits<uint64_t>::max();
+    for (auto it = cpuBlocks_.begin(); it != cpuBlocks_.end(); ++it) {
+        // keep the block each cpu is appending to.
+        if (it->second.size() <= 1) {
+            continue;
+        }
+        const auto& pages = it->second.front().pages;
+        uint64_t frontTime = pages.empty() ? 0 : pages.front().timestamp;
+        if (oldest == cpuBlocks_.end() || frontTime < oldestTime) {
+            oldest = it;
+            oldestTime = frontTime;
+        }
+    }
+    if (oldest == cpuBlocks_.end()) {
+        return false;
+    }
+    oldest->second.pop_front();
+    curTotalSz_ -= FLIGHT_BLOCK_SZ;
+    return true;
+}
+
+std::vector<int> TraceFlightRecorder::GetCpus()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<int> cpus;
+    for (const auto& item : cpuBlocks_) {
+        cpus.push_back(item.first);
+    }
+    return cpus;
+}
+
+std::vector<FlightPageRun> TraceFlightRecorder::GetPageRuns(const int cpu, const uint64_t startTime,
+    const uint64_t endTime)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<FlightPageRun> runs;
+    auto it = cpuBlocks_.find(cpu);
+    if (it == cpuBlocks_.end()) {
+        return runs;
+    }
+    for (const auto& flightBlock : it->second) {
+        if (flightBlock.pages.empty() || flightBlock.pages.back().timestamp < startTime ||
+            flightBlock.pages.front().timestamp > endTime) {
+            continue;
+        }
+        bool isRunOpen = false;
+        for (const auto& page : flightBlock.pages) {
+            if (page.timestamp < startTime || page.timestamp > endTime) {
+                isRunOpen = false;
+                continue;
+            }
+            if (isRunOpen && runs.back().offset + runs.back().size == page.offset) {
+                runs.back().size += page.size;
+                runs.back().lastTimestamp = page.timestamp;
+                continue;
+            }
+            runs.push_back({flightBlock.block, page.offset, page.size, page.timestamp, page.timestamp});
+            isRunOpen = true;
+        }
+    }
+    return runs;
+}
+
+size_t TraceFlightRecorder::GetCurrentTotalSize()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return curTotalSz_;
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
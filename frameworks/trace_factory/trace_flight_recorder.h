@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRACE_FLIGHT_RECORDER_H
+#define TRACE_FLIGHT_RECORDER_H
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "singleton.h"
+#include "trace_buffer_manager.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+constexpr size_t FLIGHT_BLOCK_SZ = 1024 * 1024; // 1 MB, the eviction unit of the flight recorder
+constexpr size_t FLIGHT_MAX_TOTAL_SZ = 128 * 1024 * 1024; // 128 MB
+constexpr size_t FLIGHT_MAX_IDLE_SZ = 4 * 1024 * 1024; // 4 MB
+
+struct FlightPage {
+    uint32_t offset = 0;
+    uint32_t size = 0;
+    uint64_t timestamp = 0;
+};
+
+struct FlightBlock {
+    BufferBlockPtr block;
+    std::vector<FlightPage> pages;
+};
+
+/**
+ * @brief FlightPageRun is a run of adjacent pages of a block, the block is kept alive by the run even if it has
+ *        been evicted from the recorder in the meantime.
+ */
+struct FlightPageRun {
+    BufferBlockPtr block;
+    uint32_t offset = 0;
+    uint32_t size = 0;
+    uint64_t firstTimestamp = 0;
+    uint64_t lastTimestamp = 0;
+};
+
+/**
+ * @brief TraceFlightRecorder keeps the most recent pages drained from trace_pipe_raw in a bounded ring of pooled
+ *        blocks per cpu, so that cache trace only touches the disk when a time window is requested.
+ * @note The oldest block of all the cpus is evicted once the recorder is over its memory budget, or once the last
+ *       page of the block is older than the window behind the newest page.
+ */
+class TraceFlightRecorder : public Singleton<TraceFlightRecorder> {
+    DECLARE_SINGLETON(TraceFlightRecorder);
+public:
+    void Start(const size_t maxTotalSz, const uint64_t windowNs);
+    void Stop();
+    bool IsRunning();
+    bool DrainTracePipeRaw();
+    std::vector<int> GetCpus();
+    std::vector<FlightPageRun> GetPageRuns(const int cpu, const uint64_t startTime, const uint64_t endTime);
+    size_t GetCurrentTotalSize();
+
+private:
+    bool DrainCpu(const int srcFd, const int cpu, const bool isHm);
+    FlightBlock* GetWritableBlockLocked(const int cpu);
+    void EvictLocked();
+    bool PopOldestBlockLocked();
+
+    std::mutex mutex_;
+    bool running_ = false;
+    size_t maxTotalSz_ = FLIGHT_MAX_TOTAL_SZ;
+    size_t curTotalSz_ = 0;
+    uint64_t windowNs_ = 0;
+    uint64_t latestTimestamp_ = 0;
+    std::shared_ptr<BufferBlockPool> blockPool_;
+    std::map<int, std::deque<FlightBlock>> cpuBlocks_;
+};
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
+#endif // TRACE_FLIGHT_RECORDER_H
@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace_io_uring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <hilog/log.h>
+#include <securec.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+#ifdef LOG_DOMAIN
+#undef LOG_DOMAIN
+#define LOG_DOMAIN 0xD002D33
+#endif
+#ifdef LOG_TAG
+#undef LOG_TAG
+#define LOG_TAG "HitraceSource"
+#endif
+namespace {
+constexpr unsigned PROBE_RING_ENTRIES = 2;
+
+int IoUringSetup(const unsigned entries, struct io_uring_params* params)
+{
+#ifdef __NR_io_uring_setup
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+int IoUringEnter(const int fd, const unsigned toSubmit, const unsigned minComplete, const unsigned flags)
+{
+#ifdef __NR_io_uring_enter
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+int IoUringRegister(const int fd, const unsigned opcode, const void* arg, const unsigned nrArgs)
+{
+#ifdef __NR_io_uring_register
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+void* RingPtr(void* base, const uint32_t offset)
+{
+    return static_cast<uint8_t*>(base) + offset;
+}
+}
+
+TraceIoUring::TraceIoUring(const unsigned entries)
+{
+    struct io_uring_params params;
+    if (memset_s(&params, sizeof(params), 0, sizeof(params)) != EOK) {
+        return;
+    }
+    int fd = IoUringSetup(entries, &params);
+    if (fd < 0) {
+        HILOG_WARN(LOG_CORE, "TraceIoUring: io_uring_setup failed, errno(%{public}d)", errno);
+        return;
+    }
+    ringFd_ = SmartFd(fd);
+    // reads of the tracefs pipes are issued with offset -1, which needs the current position support.
+    if ((params.features & IORING_FEAT_RW_CUR_POS) == 0 || !MapRings(params)) {
+        HILOG_WARN(LOG_CORE, "TraceIoUring: io_uring features(0x%{public}x) unsupported.", params.features);
+        UnmapRings();
+        ringFd_.Reset();
+    }
+}
+
+TraceIoUring::~TraceIoUring()
+{
+    UnmapRings();
+}
+
+bool TraceIoUring::MapRings(const struct io_uring_params& params)
+{
+    sqRingSz_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSz_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap) {
+        sqRingSz_ = std::max(sqRingSz_, cqRingSz_);
+        cqRingSz_ = sqRingSz_;
+    }
+    sqRing_ = mmap(nullptr, sqRingSz_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        ringFd_.GetFd(), IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED) {
+        sqRing_ = nullptr;
+        return false;
+    }
+    if (singleMmap) {
+        cqRing_ = sqRing_;
+    } else {
+        cqRing_ = mmap(nullptr, cqRingSz_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ringFd_.GetFd(), IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED) {
+            cqRing_ = nullptr;
+            return false;
+        }
+    }
+    sqesSz_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(nullptr, sqesSz_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        ringFd_.GetFd(), IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        return false;
+    }
+    sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+    sqHead_ = static_cast<unsigned*>(RingPtr(sqRing_, params.sq_off.head));
+    sqTail_ = static_cast<unsigned*>(RingPtr(sqRing_, params.sq_off.tail));
+    sqArray_ = static_cast<unsigned*>(RingPtr(sqRing_, params.sq_off.array));
+    sqMask_ = *static_cast<unsigned*>(RingPtr(sqRing_, params.sq_off.ring_mask));
+    sqEntries_ = params.sq_entries;
+    cqHead_ = static_cast<unsigned*>(RingPtr(cqRing_, params.cq_off.head));
+    cqTail_ = static_cast<unsigned*>(RingPtr(cqRing_, params.cq_off.tail));
+    cqes_ = static_cast<struct io_uring_cqe*>(RingPtr(cqRing_, params.cq_off.cqes));
+    cqMask_ = *static_cast<unsigned*>(RingPtr(cqRing_, params.cq_off.ring_mask));
+    sqLocalTail_ = *sqTail_;
+    return true;
+}
+
+void TraceIoUring::UnmapRings()
+{
+    if (sqes_ != nullptr) {
+        munmap(sqes_, sqesSz_);
+        sqes_ = nullptr;
+    }
+    if (cqRing_ != nullptr && cqRing_ != sqRing_) {
+        munmap(cqRing_, cqRingSz_);
+    }
+    cqRing_ = nullptr;
+    if (sqRing_ != nullptr) {
+        munmap(sqRing_, sqRingSz_);
+        sqRing_ = nullptr;
+    }
+}
+
+bool TraceIoUring::RegisterBuffers(const struct iovec* iovecs, const unsigned count)
+{
+    if (!IsValid()) {
+        return false;
+    }
+    if (IoUringRegister(ringFd_.GetFd(), IORING_REGISTER_BUFFERS, iovecs, count) < 0) {
+        HILOG_WARN(LOG_CORE, "RegisterBuffers: register %{public}u buffers failed, errno(%{public}d)", count, errno);
+        return false;
+    }
+    return true;
+}
+
+unsigned TraceIoUring::GetSqSpace() const
+{
+    if (!IsValid()) {
+        return 0;
+    }
+    return sqEntries_ - (sqLocalTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE));
+}
+
+struct io_uring_sqe* TraceIoUring::GetSqe()
+{
+    if (GetSqSpace() == 0) {
+        return nullptr;
+    }
+    unsigned idx = sqLocalTail_ & sqMask_;
+    struct io_uring_sqe* sqe = &sqes_[idx];
+    if (memset_s(sqe, sizeof(*sqe), 0, sizeof(*sqe)) != EOK) {
+        return nullptr;
+    }
+    sqArray_[idx] = idx;
+    sqLocalTail_++;
+    toSubmit_++;
+    return sqe;
+}
+
+bool TraceIoUring::PrepReadFixed(const int fd, uint8_t* buf, const unsigned len, const uint16_t bufIdx,
+    const uint64_t userData, const bool link)
+{
+    struct io_uring_sqe* sqe = GetSqe();
+    if (sqe == nullptr) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_READ_FIXED;
+    sqe->fd = fd;
+    sqe->off = static_cast<uint64_t>(-1); // read from the current position of the pipe.
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = len;
+    sqe->buf_index = bufIdx;
+    sqe->user_data = userData;
+    sqe->flags = link ? IOSQE_IO_LINK : 0;
+    return true;
+}
+
+bool TraceIoUring::PrepWriteFixed(const int fd, const uint8_t* buf, const unsigned len, const uint64_t offset,
+    const uint16_t bufIdx, const uint64_t userData, const bool link)
+{
+    struct io_uring_sqe* sqe = GetSqe();
+    if (sqe == nullptr) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->fd = fd;
+    sqe->off = offset;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = len;
+    sqe->buf_index = bufIdx;
+    sqe->user_data = userData;
+    sqe->flags = link ? IOSQE_IO_LINK : 0;
+    return true;
+}
+
+int TraceIoUring::Submit(const unsigned waitNr)
+{
+    if (!IsValid()) {
+        return -EBADF;
+    }
+    __atomic_store_n(sqTail_, sqLocalTail_, __ATOMIC_RELEASE);
+    unsigned flags = waitNr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    int ret = TEMP_FAILURE_RETRY(IoUringEnter(ringFd_.GetFd(), toSubmit_, waitNr, flags));
+    if (ret < 0) {
+        HILOG_ERROR(LOG_CORE, "TraceIoUring: io_uring_enter failed, errno(%{public}d)", errno);
+        return -errno;
+    }
+    toSubmit_ -= std::min(toSubmit_, static_cast<unsigned>(ret));
+    return ret;
+}
+
+bool TraceIoUring::PeekCqe(uint64_t& userData, int32_t& res)
+{
+    if (!IsValid()) {
+        return false;
+    }
+    unsigned head = *cqHead_;
+    if (head == __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    const struct io_uring_cqe& cqe = cqes_[head & cqMask_];
+    userData = cqe.user_data;
+    res = cqe.res;
+    __atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool TraceIoUring::IsSupported()
+{
+    static const bool isSupported = TraceIoUring(PROBE_RING_ENTRIES).IsValid();
+    return isSupported;
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
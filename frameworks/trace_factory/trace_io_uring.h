@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRACE_IO_URING_H
+#define TRACE_IO_URING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+#include "smart_fd.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+/**
+ * @brief TraceIoUring is a minimal io_uring ring built on the raw syscalls, only the operations needed
+ *        by the trace dump are provided.
+ * @note not thread safe, each dump thread owns its ring.
+ */
+class TraceIoUring {
+public:
+    explicit TraceIoUring(const unsigned entries);
+    ~TraceIoUring();
+    TraceIoUring(const TraceIoUring&) = delete;
+    TraceIoUring& operator=(const TraceIoUring&) = delete;
+
+    bool IsValid() const { return static_cast<bool>(ringFd_); }
+    bool RegisterBuffers(const struct iovec* iovecs, const unsigned count);
+    bool PrepReadFixed(const int fd, uint8_t* buf, const unsigned len, const uint16_t bufIdx,
+        const uint64_t userData, const bool link);
+    bool PrepWriteFixed(const int fd, const uint8_t* buf, const unsigned len, const uint64_t offset,
+        const uint16_t bufIdx, const uint64_t userData, const bool link);
+    /**
+     * @brief submit all the prepared sqes and wait for at least waitNr completions.
+     * @return the number of submitted sqes, or -errno.
+     */
+    int Submit(const unsigned waitNr);
+    bool PeekCqe(uint64_t& userData, int32_t& res);
+    unsigned GetSqSpace() const;
+
+    /**
+     * @brief check once per process whether io_uring can be set up, it may be disabled by the kernel
+     *        config or the security policy.
+     */
+    static bool IsSupported();
+
+private:
+    struct io_uring_sqe* GetSqe();
+    bool MapRings(const struct io_uring_params& params);
+    void UnmapRings();
+
+    SmartFd ringFd_;
+    void* sqRing_ = nullptr;
+    void* cqRing_ = nullptr;
+    struct io_uring_sqe* sqes_ = nullptr;
+    size_t sqRingSz_ = 0;
+    size_t cqRingSz_ = 0;
+    size_t sqesSz_ = 0;
+    unsigned* sqHead_ = nullptr;
+    unsigned* sqTail_ = nullptr;
+    unsigned* sqArray_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned sqEntries_ = 0;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    struct io_uring_cqe* cqes_ = nullptr;
+    unsigned cqMask_ = 0;
+    unsigned sqLocalTail_ = 0;
+    unsigned toSubmit_ = 0;
+};
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
+#endif // TRACE_IO_URING_H
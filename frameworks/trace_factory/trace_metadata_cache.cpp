@@ -0,0 +1,379 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace_metadata_cache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <unistd.h>
+
+#include "common_define.h"
+#include "common_utils.h"
+#include "hilog/log.h"
+#include "hitrace_option_util.h"
+#include "securec.h"
+#include "smart_fd.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+#ifdef LOG_DOMAIN
+#undef LOG_DOMAIN
+#define LOG_DOMAIN 0xD002D33
+#endif
+#ifdef LOG_TAG
+#undef LOG_TAG
+#define LOG_TAG "HitraceMetadataCache"
+#endif
+
+namespace {
+constexpr int DECIMAL_BASE = 10;
+constexpr size_t FORMAT_READ_SIZE = 4096; // tracefs reports no file size, the format files are read page by page
+constexpr int HEX_BASE = 16;
+constexpr uint64_t KALLSYMS_MAX_SYMBOL_SIZE = 1024 * 1024; // an address farther from its symbol is not resolved
+constexpr size_t KALLSYMS_ADDR_SIZE = 17; // 16 hex digits and '\0'
+
+// the text symbols, whose types are t, T, w or W, the addresses in the events are all in code.
+bool IsTextSymbol(const char type)
+{
+    return type == 't' || type == 'T' || type == 'w' || type == 'W';
+}
+
+// append a whole file of tracefs to content, false if it cannot be read.
+bool AppendFileContent(const std::string& filePath, std::string& content)
+{
+    SmartFd fd(open(CanonicalizeSpecPath(filePath.c_str()).c_str(), O_RDONLY));
+    if (!fd) {
+        HILOG_ERROR(LOG_CORE, "AppendFileContent: open %{public}s failed, errno(%{public}d).", filePath.c_str(), errno);
+        return false;
+    }
+    while (true) {
+        size_t used = content.size();
+        content.resize(used + FORMAT_READ_SIZE);
+        ssize_t readLen = TEMP_FAILURE_RETRY(read(fd.GetFd(), &content[used], FORMAT_READ_SIZE));
+        content.resize(used + static_cast<size_t>(std::max<ssize_t>(readLen, 0)));
+        if (readLen <= 0) {
+            return readLen == 0;
+        }
+    }
+}
+
+uint32_t ParseFieldValue(const std::string& line, const std::string& key)
+{
+    size_t pos = line.find(key);
+    return pos == std::string::npos ? 0 :
+        static_cast<uint32_t>(strtoul(line.c_str() + pos + key.size(), nullptr, DECIMAL_BASE));
+}
+
+// the content of a tracefs file, empty if it is missing.
+std::string ReadStaticFile(const std::string& relativePath)
+{
+    std::string content;
+    std::string filePath = GetTraceRootPath() + relativePath;
+    if (access(filePath.c_str(), R_OK) == -1 || !AppendFileContent(filePath, content)) {
+        content.clear();
+    }
+    content.shrink_to_fit();
+    return content;
+}
+
+// the name is the last word of the declaration before ';', such as "prev_comm" of "char prev_comm[16]".
+bool ParseEventField(const std::string& line, TraceEventField& field)
+{
+    const std::string fieldKey = "field:";
+    size_t declBegin = line.find(fieldKey);
+    size_t declEnd = line.find(';', declBegin);
+    if (declBegin == std::string::npos || declEnd == std::string::npos) {
+        return false;
+    }
+    std::string decl = line.substr(declBegin + fieldKey.size(), declEnd - declBegin - fieldKey.size());
+    if (!decl.empty() && decl.back() == ']') {
+        decl.erase(decl.rfind('['));
+    }
+    size_t nameBegin = decl.find_last_of(" *");
+    field.name = nameBegin == std::string::npos ? decl : decl.substr(nameBegin + 1);
+    field.offset = ParseFieldValue(line, "offset:");
+    field.size = ParseFieldValue(line, "size:");
+    field.isSigned = ParseFieldValue(line, "signed:") != 0;
+    return !field.name.empty() && field.size != 0;
+}
+} // namespace
+
+const TraceEventField* TraceEventLayout::FindField(const std::string& fieldName) const
+{
+    auto iter = std::find_if(fields.begin(), fields.end(), [&fieldName](const TraceEventField& field) {
+        return field.name == fieldName;
+    });
+    return iter == fields.end() ? nullptr : &(*iter);
+}
+
+TraceEventFormats::TraceEventFormats(const std::string& key, const std::vector<std::string>& formatPaths)
+    : key_(key)
+{
+    auto start = std::chrono::steady_clock::now();
+    const std::string& traceRootPath = GetTraceRootPath();
+    size_t fileCount = 0;
+    for (const auto& formatPath : formatPaths) {
+        std::string srcPath = traceRootPath + formatPath;
+        if (access(srcPath.c_str(), R_OK) != -1 && AppendFileContent(srcPath, content_)) {
+            fileCount++;
+        }
+    }
+    content_.shrink_to_fit();
+    ParseLayouts();
+    auto costUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    HILOG_INFO(LOG_CORE, "TraceEventFormats: %{public}zu files, %{public}zu bytes, %{public}zu events, cost "
+        "%{public}lld us.", fileCount, content_.size(), layouts_.size(), static_cast<long long>(costUs.count()));
+}
+
+void TraceEventFormats::ParseLayouts()
+{
+    const std::string nameKey = "name: ";
+    const std::string idKey = "ID: ";
+    size_t lineBegin = 0;
+    while (lineBegin < content_.size()) {
+        size_t lineEnd = content_.find('\n', lineBegin);
+        if (lineEnd == std::string::npos) {
+            lineEnd = content_.size();
+        }
+        std::string line = content_.substr(lineBegin, lineEnd - lineBegin);
+        lineBegin = lineEnd + 1;
+        TraceEventField field;
+        if (line.compare(0, nameKey.size(), nameKey) == 0) {
+            layouts_.emplace_back();
+            layouts_.back().name = line.substr(nameKey.size());
+        } else if (layouts_.empty()) {
+            continue;
+        } else if (line.compare(0, idKey.size(), idKey) == 0) {
+            layouts_.back().id = ParseFieldValue(line, idKey);
+        } else if (ParseEventField(line, field)) {
+            layouts_.back().fields.push_back(field);
+        }
+    }
+    std::sort(layouts_.begin(), layouts_.end(), [](const TraceEventLayout& left, const TraceEventLayout& right) {
+        return left.id < right.id;
+    });
+}
+
+const TraceEventLayout* TraceEventFormats::FindLayout(const uint32_t id) const
+{
+    auto iter = std::lower_bound(layouts_.begin(), layouts_.end(), id, [](const TraceEventLayout& layout,
+        const uint32_t value) { return layout.id < value; });
+    return (iter == layouts_.end() || iter->id != id) ? nullptr : &(*iter);
+}
+
+bool TraceEventFormats::Save(const std::string& filePath) const
+{
+    const std::string tmpPath = filePath + ".tmp";
+    SmartFd fd(open(tmpPath.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644)); // 0644:-rw-r--r--
+    if (!fd) {
+        HILOG_ERROR(LOG_CORE, "TraceEventFormats: open %{public}s failed, errno(%{public}d).", tmpPath.c_str(), errno);
+        return false;
+    }
+    ssize_t writeRet = TEMP_FAILURE_RETRY(write(fd.GetFd(), content_.data(), content_.size()));
+    fd = SmartFd();
+    if (writeRet != static_cast<ssize_t>(content_.size()) || rename(tmpPath.c_str(), filePath.c_str()) != 0) {
+        HILOG_ERROR(LOG_CORE, "TraceEventFormats: save %{public}s failed, errno(%{public}d).", filePath.c_str(), errno);
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+TraceKallsyms::TraceKallsyms(const std::string& kallsymsPath)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::ifstream kallsyms(kallsymsPath);
+    std::string line;
+    while (std::getline(kallsyms, line)) {
+        char* restBegin = nullptr;
+        uint64_t addr = strtoull(line.c_str(), &restBegin, HEX_BASE);
+        // the addresses are all 0 if they are hidden by kptr_restrict.
+        if (addr == 0 || restBegin[0] != ' ' || !IsTextSymbol(restBegin[1])) {
+            continue;
+        }
+        Symbol symbol;
+        symbol.addr = addr;
+        symbol.restOffset = static_cast<uint32_t>(pool_.size());
+        symbol.restSize = static_cast<uint32_t>(line.size() - (restBegin + 1 - line.c_str()));
+        pool_.append(restBegin + 1, symbol.restSize);
+        symbols_.push_back(symbol);
+    }
+    std::stable_sort(symbols_.begin(), symbols_.end(), [](const Symbol& left, const Symbol& right) {
+        return left.addr < right.addr;
+    });
+    symbols_.shrink_to_fit();
+    pool_.shrink_to_fit();
+    auto costUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    HILOG_INFO(LOG_CORE, "TraceKallsyms: %{public}zu symbols, %{public}zu bytes, cost %{public}lld us.",
+        symbols_.size(), pool_.size(), static_cast<long long>(costUs.count()));
+}
+
+bool TraceKallsyms::Find(const uint64_t addr, size_t& index) const
+{
+    auto iter = std::upper_bound(symbols_.begin(), symbols_.end(), addr, [](const uint64_t value,
+        const Symbol& symbol) { return value < symbol.addr; });
+    if (iter == symbols_.begin() || addr - (iter - 1)->addr >= KALLSYMS_MAX_SYMBOL_SIZE) {
+        return false;
+    }
+    index = static_cast<size_t>(iter - symbols_.begin()) - 1;
+    return true;
+}
+
+std::string TraceKallsyms::GetLine(const size_t index) const
+{
+    const Symbol& symbol = symbols_[index];
+    char addr[KALLSYMS_ADDR_SIZE] = {0};
+    if (sprintf_s(addr, sizeof(addr), "%016" PRIx64, symbol.addr) == -1) {
+        return "";
+    }
+    return std::string(addr) + " " + pool_.substr(symbol.restOffset, symbol.restSize) + "\n";
+}
+
+TraceMetadataCache& TraceMetadataCache::GetInstance()
+{
+    static TraceMetadataCache instance;
+    return instance;
+}
+
+std::string TraceMetadataCache::MakeEventFormatsKey(const std::vector<std::string>& formatPaths)
+{
+    std::string key = GetKernelVersion();
+    for (const auto& formatPath : formatPaths) {
+        key += "\n" + formatPath;
+    }
+    return key;
+}
+
+void TraceMetadataCache::PrepareEventFormats(const std::vector<std::string>& formatPaths,
+    const std::string& savedPath)
+{
+    std::string key = MakeEventFormatsKey(formatPaths);
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_future<std::shared_ptr<const TraceEventFormats>> sameFormats;
+    if (preparedKey_ == key) {
+        sameFormats = preparedFormats_;
+    } else if (builtFormats_ != nullptr && builtFormats_->GetKey() == key) {
+        std::promise<std::shared_ptr<const TraceEventFormats>> builtPromise;
+        builtPromise.set_value(builtFormats_);
+        sameFormats = builtPromise.get_future().share();
+    }
+    preparedKey_ = key;
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    preparedFormats_ = std::async(std::launch::async, [key, formatPaths, savedPath, sameFormats]() {
+        auto formats = sameFormats.valid() ? sameFormats.get() : nullptr;
+        if (formats == nullptr) {
+            formats = std::make_shared<const TraceEventFormats>(key, formatPaths);
+        }
+        formats->Save(savedPath);
+        return formats;
+    }).share();
+}
+
+std::shared_ptr<const TraceEventFormats> TraceMetadataCache::GetPreparedEventFormats()
+{
+    std::shared_future<std::shared_ptr<const TraceEventFormats>> preparedFormats;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        preparedFormats = preparedFormats_;
+    }
+    return preparedFormats.valid() ? preparedFormats.get() : nullptr;
+}
+
+std::shared_ptr<const TraceEventFormats> TraceMetadataCache::GetEventFormats(
+    const std::vector<std::string>& formatPaths)
+{
+    std::string key = MakeEventFormatsKey(formatPaths);
+    std::shared_future<std::shared_ptr<const TraceEventFormats>> preparedFormats;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (builtFormats_ != nullptr && builtFormats_->GetKey() == key) {
+            return builtFormats_;
+        }
+        if (preparedKey_ == key) {
+            preparedFormats = preparedFormats_;
+        }
+    }
+    auto formats = preparedFormats.valid() ? preparedFormats.get() : nullptr;
+    if (formats == nullptr) {
+        formats = std::make_shared<const TraceEventFormats>(key, formatPaths);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    builtFormats_ = formats;
+    return formats;
+}
+
+void TraceMetadataCache::PrepareStaticFiles()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    preparedStaticFiles_ = std::async(std::launch::async, []() {
+        auto staticFiles = std::make_shared<TraceStaticFiles>();
+        staticFiles->headerPage = ReadStaticFile("events/header_page");
+        staticFiles->printkFormats = ReadStaticFile("printk_formats");
+        HILOG_INFO(LOG_CORE, "PrepareStaticFiles: header_page %{public}zu bytes, printk_formats %{public}zu bytes.",
+            staticFiles->headerPage.size(), staticFiles->printkFormats.size());
+        return std::shared_ptr<const TraceStaticFiles>(staticFiles);
+    }).share();
+}
+
+std::shared_ptr<const TraceStaticFiles> TraceMetadataCache::GetPreparedStaticFiles()
+{
+    std::shared_future<std::shared_ptr<const TraceStaticFiles>> preparedStaticFiles;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        preparedStaticFiles = preparedStaticFiles_;
+    }
+    return preparedStaticFiles.valid() ? preparedStaticFiles.get() : nullptr;
+}
+
+void TraceMetadataCache::PrepareKallsyms(const std::string& kallsymsPath)
+{
+    std::lock_guard<std::mutex> lock(kallsymsMutex_);
+    kallsymsPath_ = kallsymsPath;
+    kallsyms_ = nullptr;
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void TraceMetadataCache::LockForFork()
+{
+    GetPreparedEventFormats();
+    GetPreparedStaticFiles();
+    mutex_.lock();
+    kallsymsMutex_.lock();
+}
+
+void TraceMetadataCache::UnlockAfterFork()
+{
+    kallsymsMutex_.unlock();
+    mutex_.unlock();
+}
+
+std::shared_ptr<const TraceKallsyms> TraceMetadataCache::GetKallsyms()
+{
+    std::lock_guard<std::mutex> lock(kallsymsMutex_);
+    if (kallsyms_ == nullptr && access(kallsymsPath_.c_str(), R_OK) == 0) {
+        kallsyms_ = std::make_shared<const TraceKallsyms>(kallsymsPath_);
+    }
+    return kallsyms_;
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRACE_METADATA_CACHE_H
+#define TRACE_METADATA_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+/**
+ * @brief TraceEventField is where a field is in the binary record of an event, it is parsed from a format line
+ *        such as "\tfield:pid_t prev_pid;\toffset:24;\tsize:4;\tsigned:1;".
+ */
+struct TraceEventField {
+    std::string name;
+    uint32_t offset = 0;
+    uint32_t size = 0;
+    bool isSigned = false;
+};
+
+struct TraceEventLayout {
+    uint32_t id = 0;
+    std::string name;
+    std::vector<TraceEventField> fields;
+
+    const TraceEventField* FindField(const std::string& fieldName) const;
+};
+
+/**
+ * @brief TraceEventFormats is the concatenated format files of a list of events together with the layouts of the
+ *        events, so the events format section of a trace file is written with a single write.
+ * @note it is never changed once built, the dumps share it without a lock.
+ */
+class TraceEventFormats {
+public:
+    TraceEventFormats(const std::string& key, const std::vector<std::string>& formatPaths);
+    const std::string& GetKey() const { return key_; }
+    const std::string& GetContent() const { return content_; }
+    // the layouts sorted by event id.
+    const std::vector<TraceEventLayout>& GetLayouts() const { return layouts_; }
+    const TraceEventLayout* FindLayout(const uint32_t id) const;
+    // replace the file with the content, the file is renamed into place so that the other readers never see a
+    // half written one.
+    bool Save(const std::string& filePath) const;
+
+private:
+    void ParseLayouts();
+
+    std::string key_;
+    std::string content_;
+    std::vector<TraceEventLayout> layouts_;
+};
+
+/**
+ * @brief TraceStaticFiles is a snapshot of the tracefs files which are copied into every trace file as they are,
+ *        an empty content means that the file could not be read.
+ */
+struct TraceStaticFiles {
+    std::string headerPage;
+    std::string printkFormats;
+};
+
+/**
+ * @brief TraceKallsyms is the text symbols of kallsyms sorted by address, an address is resolved to the symbol
+ *        with the largest address not above it.
+ * @note the rest of the lines after the addresses are kept in one pool instead of a string per symbol.
+ */
+class TraceKallsyms {
+public:
+    explicit TraceKallsyms(const std::string& kallsymsPath);
+    bool IsEmpty() const { return symbols_.empty(); }
+    size_t GetCount() const { return symbols_.size(); }
+    // the index of the symbol which covers addr, false if there is none.
+    bool Find(const uint64_t addr, size_t& index) const;
+    // the line of a symbol as it is in kallsyms, such as "ffffffc010081000 T schedule\n".
+    std::string GetLine(const size_t index) const;
+
+private:
+    struct Symbol {
+        uint64_t addr = 0;
+        uint32_t restOffset = 0;
+        uint32_t restSize = 0;
+    };
+
+    std::vector<Symbol> symbols_;
+    std::string pool_;
+};
+
+/**
+ * @brief TraceMetadataCache keeps the static sections of the trace files in memory, they only change with the
+ *        kernel and the enabled tags. OpenTrace prepares them in the background, the dumps of the session reuse
+ *        them without reading tracefs again.
+ */
+class TraceMetadataCache {
+public:
+    static TraceMetadataCache& GetInstance();
+    // build the event formats of the list in the background and save them to savedPath, the formats built
+    // for the same kernel and list are reused.
+    void PrepareEventFormats(const std::vector<std::string>& formatPaths, const std::string& savedPath);
+    // the formats of the last PrepareEventFormats, it waits for the background build, nullptr if none.
+    std::shared_ptr<const TraceEventFormats> GetPreparedEventFormats();
+    // the formats of the list, they are built in place if neither the prepared nor the last built ones match.
+    std::shared_ptr<const TraceEventFormats> GetEventFormats(const std::vector<std::string>& formatPaths);
+    // snapshot the static files in the background, every OpenTrace takes a new one since printk_formats grows
+    // with the loaded modules.
+    void PrepareStaticFiles();
+    // the last snapshot, it waits for the background read, nullptr if none.
+    std::shared_ptr<const TraceStaticFiles> GetPreparedStaticFiles();
+    // drop the kallsyms table of the last session, the modules may have been loaded or unloaded since then.
+    void PrepareKallsyms(const std::string& kallsymsPath = "/proc/kallsyms");
+    // the kallsyms table of the session, it is loaded by the first call, nullptr if kallsyms cannot be read.
+    std::shared_ptr<const TraceKallsyms> GetKallsyms();
+    // changed by every Prepare call, a forked dump process which holds an older copy of the cache is restarted.
+    uint64_t GetGeneration() const { return generation_.load(std::memory_order_acquire); }
+    // hold the locks of the cache across fork, so a forked process never inherits one of them locked by another
+    // thread, the prepared metadata is waited for first since the threads which build it are not forked.
+    void LockForFork();
+    void UnlockAfterFork();
+
+private:
+    TraceMetadataCache() = default;
+    static std::string MakeEventFormatsKey(const std::vector<std::string>& formatPaths);
+
+    std::mutex mutex_;
+    std::shared_future<std::shared_ptr<const TraceEventFormats>> preparedFormats_;
+    std::string preparedKey_;
+    std::shared_ptr<const TraceEventFormats> builtFormats_;
+    std::shared_future<std::shared_ptr<const TraceStaticFiles>> preparedStaticFiles_;
+    std::mutex kallsymsMutex_;
+    std::string kallsymsPath_ = "/proc/kallsyms";
+    std::shared_ptr<const TraceKallsyms> kallsyms_;
+    std::atomic<uint64_t> generation_ = 0;
+};
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
+#endif // TRACE_METADATA_CACHE_H
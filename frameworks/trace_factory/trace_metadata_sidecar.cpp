@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace_metadata_sidecar.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <mutex>
+#include <securec.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+#include <vector>
+
+#include "hilog/log.h"
+#include "smart_fd.h"
+#include "trace_content.h"
+#include "trace_file_utils.h"
+#include "trace_page_index.h"
+#include "trace_section_table.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+#ifdef LOG_DOMAIN
+#undef LOG_DOMAIN
+#define LOG_DOMAIN 0xD002D33
+#endif
+#ifdef LOG_TAG
+#undef LOG_TAG
+#define LOG_TAG "HitraceMetadataSidecar"
+#endif
+
+namespace {
+constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
+constexpr size_t HASH_NAME_SIZE = 17; // 16 hex digits and '\0'
+
+uint64_t HashSections(const std::string& sections)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (const char byte : sections) {
+        hash ^= static_cast<uint8_t>(byte);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+std::string GetFileDir(const std::string& filePath)
+{
+    size_t pos = filePath.rfind('/');
+    return pos == std::string::npos ? "" : filePath.substr(0, pos + 1);
+}
+
+bool WriteAll(const int fd, const void* data, const size_t size)
+{
+    return TEMP_FAILURE_RETRY(write(fd, data, size)) == static_cast<ssize_t>(size);
+}
+
+// the sections of a trace file and the sidecar it refers to, false if it is no trace file or refers to no sidecar.
+bool ReadMetadataRef(const int fd, std::vector<TraceSectionTableEntry>& entries, TraceMetadataRef& ref)
+{
+    struct stat fileStat = {};
+    TraceFileHeader fileHeader;
+    if (fstat(fd, &fileStat) != 0 || static_cast<size_t>(fileStat.st_size) < sizeof(fileHeader) ||
+        TEMP_FAILURE_RETRY(pread(fd, &fileHeader, sizeof(fileHeader), 0)) != static_cast<ssize_t>(sizeof(fileHeader)) ||
+        fileHeader.magicNumber != MAGIC_NUMBER ||
+        !BuildSectionTable(fd, static_cast<uint64_t>(fileStat.st_size), entries)) {
+        return false;
+    }
+    auto refEntry = std::find_if(entries.begin(), entries.end(), [](const TraceSectionTableEntry& entry) {
+        return entry.type == CONTENT_TYPE_METADATA_REF;
+    });
+    return refEntry != entries.end() && refEntry->length == sizeof(ref) &&
+        TEMP_FAILURE_RETRY(pread(fd, &ref, sizeof(ref), static_cast<off_t>(refEntry->offset +
+        sizeof(TraceFileContentHeader)))) == static_cast<ssize_t>(sizeof(ref)) && ref.magic == METADATA_SIDECAR_MAGIC;
+}
+
+// the sections of the sidecar file, false if it is missing or does not hold the sections of ref.
+bool ReadSidecarSections(const std::string& sidecarPath, const TraceMetadataRef& ref, std::string& sections)
+{
+    SmartFd fd(open(sidecarPath.c_str(), O_RDONLY));
+    struct stat fileStat = {};
+    TraceMetadataRef sidecarRef;
+    if (!fd || fstat(fd.GetFd(), &fileStat) != 0 || static_cast<size_t>(fileStat.st_size) < sizeof(sidecarRef) ||
+        TEMP_FAILURE_RETRY(pread(fd.GetFd(), &sidecarRef, sizeof(sidecarRef), 0)) !=
+        static_cast<ssize_t>(sizeof(sidecarRef))) {
+        HILOG_ERROR(LOG_CORE, "ReadSidecarSections: read %{public}s failed, errno(%{public}d).", sidecarPath.c_str(),
+            errno);
+        return false;
+    }
+    if (sidecarRef.magic != ref.magic || sidecarRef.hash != ref.hash ||
+        sidecarRef.sectionCount != ref.sectionCount) {
+        HILOG_ERROR(LOG_CORE, "ReadSidecarSections: %{public}s does not match the slice.", sidecarPath.c_str());
+        return false;
+    }
+    sections.resize(static_cast<size_t>(fileStat.st_size) - sizeof(sidecarRef));
+    if (TEMP_FAILURE_RETRY(pread(fd.GetFd(), &sections[0], sections.size(), sizeof(sidecarRef))) !=
+        static_cast<ssize_t>(sections.size()) || HashSections(sections) != ref.hash) {
+        HILOG_ERROR(LOG_CORE, "ReadSidecarSections: %{public}s is broken.", sidecarPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// copy the file header and the sections of srcFd to dstFd, the ref section is replaced with the sidecar sections.
+bool WriteInlinedFile(const int srcFd, const int dstFd, const std::vector<TraceSectionTableEntry>& entries,
+    const std::string& sections)
+{
+    if (!CopyFileRange(srcFd, 0, dstFd, sizeof(TraceFileHeader))) {
+        return false;
+    }
+    for (const auto& entry : entries) {
+        if (entry.type == CONTENT_TYPE_METADATA_REF) {
+            if (!WriteAll(dstFd, sections.data(), sections.size())) {
+                return false;
+            }
+            continue;
+        }
+        if (!CopyFileRange(srcFd, entry.offset, dstFd, sizeof(TraceFileContentHeader) + entry.length)) {
+            return false;
+        }
+    }
+    return AppendSectionTable(dstFd);
+}
+} // namespace
+
+TraceMetadataSidecar::TraceMetadataSidecar(std::shared_ptr<const TraceEventFormats> eventFormats,
+    std::shared_ptr<const TraceStaticFiles> staticFiles) : eventFormats_(eventFormats), staticFiles_(staticFiles)
+{
+    AppendSection(CONTENT_TYPE_EVENTS_FORMAT, eventFormats_->GetContent());
+    AppendSection(CONTENT_TYPE_HEADER_PAGE, staticFiles_->headerPage);
+    AppendSection(CONTENT_TYPE_PRINTK_FORMATS, staticFiles_->printkFormats);
+    ref_.hash = HashSections(sections_);
+}
+
+void TraceMetadataSidecar::AppendSection(const uint8_t contentType, const std::string& content)
+{
+    TraceFileContentHeader contentHeader;
+    contentHeader.type = contentType;
+    contentHeader.length = static_cast<uint32_t>(content.size());
+    sections_.append(reinterpret_cast<const char*>(&contentHeader), sizeof(contentHeader));
+    sections_.append(content);
+    ref_.sectionCount++;
+}
+
+std::string TraceMetadataSidecar::GetFilePath(const std::string& dir, const uint64_t hash)
+{
+    char hashName[HASH_NAME_SIZE] = {0};
+    if (sprintf_s(hashName, sizeof(hashName), "%016" PRIx64, hash) == -1) {
+        return "";
+    }
+    return dir + METADATA_SIDECAR_FILE_PREFIX + hashName;
+}
+
+bool TraceMetadataSidecar::Save(const std::string& dir) const
+{
+    const std::string filePath = GetFilePath(dir, ref_.hash);
+    if (filePath.empty()) {
+        return false;
+    }
+    // the file is named by the hash of its sections, the one already there holds the same ones.
+    if (access(filePath.c_str(), F_OK) == 0) {
+        return true;
+    }
+    const std::string tmpPath = filePath + ".tmp";
+    SmartFd fd(open(tmpPath.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644)); // 0644:-rw-r--r--
+    if (!fd) {
+        HILOG_ERROR(LOG_CORE, "TraceMetadataSidecar: open %{public}s failed, errno(%{public}d).", tmpPath.c_str(),
+            errno);
+        return false;
+    }
+    bool isWritten = WriteAll(fd.GetFd(), &ref_, sizeof(ref_)) &&
+        WriteAll(fd.GetFd(), sections_.data(), sections_.size());
+    fd = SmartFd();
+    if (!isWritten || rename(tmpPath.c_str(), filePath.c_str()) != 0) {
+        HILOG_ERROR(LOG_CORE, "TraceMetadataSidecar: save %{public}s failed, errno(%{public}d).", filePath.c_str(),
+            errno);
+        remove(tmpPath.c_str());
+        return false;
+    }
+    HILOG_INFO(LOG_CORE, "TraceMetadataSidecar: %{public}s saved, %{public}zu bytes.", filePath.c_str(),
+        sections_.size());
+    return true;
+}
+
+std::shared_ptr<const TraceMetadataSidecar> TraceMetadataSidecar::GetPrepared()
+{
+    auto eventFormats = TraceMetadataCache::GetInstance().GetPreparedEventFormats();
+    auto staticFiles = TraceMetadataCache::GetInstance().GetPreparedStaticFiles();
+    if (eventFormats == nullptr || staticFiles == nullptr || staticFiles->headerPage.empty()) {
+        return nullptr;
+    }
+    // the slices of a session share the prepared metadata, the sidecar is only hashed again when it changes.
+    static std::mutex mutex;
+    static std::shared_ptr<const TraceMetadataSidecar> sidecar;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (sidecar == nullptr || sidecar->eventFormats_ != eventFormats || sidecar->staticFiles_ != staticFiles) {
+        sidecar = std::make_shared<const TraceMetadataSidecar>(eventFormats, staticFiles);
+    }
+    return sidecar;
+}
+
+bool InlineMetadataSidecar(const std::string& traceFile)
+{
+    SmartFd srcFd(open(traceFile.c_str(), O_RDONLY));
+    if (!srcFd) {
+        HILOG_ERROR(LOG_CORE, "InlineMetadataSidecar: open %{public}s failed, errno(%{public}d).", traceFile.c_str(),
+            errno);
+        return false;
+    }
+    std::vector<TraceSectionTableEntry> entries;
+    TraceMetadataRef ref;
+    if (!ReadMetadataRef(srcFd.GetFd(), entries, ref)) {
+        HILOG_INFO(LOG_CORE, "InlineMetadataSidecar: %{public}s refers to no sidecar.", traceFile.c_str());
+        return false;
+    }
+    std::string sections;
+    if (!ReadSidecarSections(TraceMetadataSidecar::GetFilePath(GetFileDir(traceFile), ref.hash), ref, sections)) {
+        return false;
+    }
+    const std::string tmpFile = traceFile + ".tmp";
+    SmartFd dstFd(open(tmpFile.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644)); // 0644 : -rw-r--r--
+    bool isWritten = dstFd && WriteInlinedFile(srcFd.GetFd(), dstFd.GetFd(), entries, sections);
+    dstFd = SmartFd();
+    if (!isWritten || rename(tmpFile.c_str(), traceFile.c_str()) != 0) {
+        HILOG_ERROR(LOG_CORE, "InlineMetadataSidecar: write %{public}s failed, errno(%{public}d).", tmpFile.c_str(),
+            errno);
+        remove(tmpFile.c_str());
+        return false;
+    }
+    HILOG_INFO(LOG_CORE, "InlineMetadataSidecar: %{public}s inlined, %{public}zu bytes of metadata.",
+        traceFile.c_str(), sections.size());
+    return true;
+}
+
+void RemoveUnusedMetadataSidecars(const std::string& dir)
+{
+    std::vector<std::string> sidecarFiles;
+    std::vector<std::string> traceFiles;
+    const size_t prefixLen = strlen(METADATA_SIDECAR_FILE_PREFIX);
+    TraverseFiles(dir, false, [&sidecarFiles, &traceFiles, prefixLen](const char* dirPath, const dirent* entry) {
+        if (entry->d_type != DT_REG && entry->d_type != DT_UNKNOWN) {
+            return;
+        }
+        std::string filePath = std::string(dirPath) + "/" + entry->d_name;
+        if (strncmp(entry->d_name, METADATA_SIDECAR_FILE_PREFIX, prefixLen) != 0) {
+            traceFiles.push_back(filePath);
+        } else if (strlen(entry->d_name) == prefixLen + HASH_NAME_SIZE - 1) { // the .tmp files are being saved
+            sidecarFiles.push_back(filePath);
+        }
+    });
+    if (sidecarFiles.empty()) {
+        return;
+    }
+    std::unordered_set<uint64_t> usedHashes;
+    for (const auto& traceFile : traceFiles) {
+        SmartFd fd(open(traceFile.c_str(), O_RDONLY));
+        std::vector<TraceSectionTableEntry> entries;
+        TraceMetadataRef ref;
+        if (fd && ReadMetadataRef(fd.GetFd(), entries, ref)) {
+            usedHashes.insert(ref.hash);
+        }
+    }
+    for (const auto& sidecarFile : sidecarFiles) {
+        uint64_t hash = std::strtoull(sidecarFile.c_str() + sidecarFile.size() - (HASH_NAME_SIZE - 1), nullptr,
+            16); // 16 : hex
+        if (usedHashes.count(hash) != 0) {
+            continue;
+        }
+        if (remove(sidecarFile.c_str()) == 0) {
+            HILOG_INFO(LOG_CORE, "RemoveUnusedMetadataSidecars: %{public}s removed.", sidecarFile.c_str());
+        } else {
+            HILOG_WARN(LOG_CORE, "RemoveUnusedMetadataSidecars: remove %{public}s failed, errno(%{public}d).",
+                sidecarFile.c_str(), errno);
+        }
+    }
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRACE_METADATA_SIDECAR_H
+#define TRACE_METADATA_SIDECAR_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "trace_file_format.h"
+#include "trace_metadata_cache.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+/**
+ * @brief TraceMetadataSidecar is the static sections of a trace file laid out as they are in the file, so they are
+ *        copied into a slice as a whole when it is inlined.
+ * @note it is never changed once built, the dumps share it without a lock.
+ */
+class TraceMetadataSidecar {
+public:
+    TraceMetadataSidecar(std::shared_ptr<const TraceEventFormats> eventFormats,
+        std::shared_ptr<const TraceStaticFiles> staticFiles);
+    const TraceMetadataRef& GetRef() const { return ref_; }
+    const std::string& GetSections() const { return sections_; }
+    // write the sidecar file into dir unless it is there already, dir ends with '/'.
+    bool Save(const std::string& dir) const;
+    static std::string GetFilePath(const std::string& dir, const uint64_t hash);
+    // the sidecar of the prepared metadata of the trace session, nullptr if any of it is not prepared.
+    static std::shared_ptr<const TraceMetadataSidecar> GetPrepared();
+
+private:
+    void AppendSection(const uint8_t contentType, const std::string& content);
+
+    std::shared_ptr<const TraceEventFormats> eventFormats_;
+    std::shared_ptr<const TraceStaticFiles> staticFiles_;
+    TraceMetadataRef ref_;
+    std::string sections_;
+};
+
+/**
+ * @brief replace the CONTENT_TYPE_METADATA_REF section of traceFile with the sections of its sidecar, so the file
+ *        can be exported on its own. The cpu raw sections are not moved, the page index stays valid, the file ends
+ *        with a new section table.
+ * @return false if the file refers to no sidecar or the sidecar is missing or broken, the file is unchanged then.
+ */
+bool InlineMetadataSidecar(const std::string& traceFile);
+
+/**
+ * @brief remove the sidecar files of dir which no trace file of dir refers to any more, it is called after the
+ *        slices are aged or inlined, when no slice of dir is being written.
+ */
+void RemoveUnusedMetadataSidecars(const std::string& dir);
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
+#endif // TRACE_METADATA_SIDECAR_H
@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace_page_index.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <fcntl.h>
+#include <limits>
+#include <map>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "common_define.h"
+#include "hilog/log.h"
+#include "smart_fd.h"
+#include "trace_content.h"
+#include "trace_section_table.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+#ifdef LOG_DOMAIN
+#undef LOG_DOMAIN
+#define LOG_DOMAIN 0xD002D33
+#endif
+#ifdef LOG_TAG
+#undef LOG_TAG
+#define LOG_TAG "HitracePageIndex"
+#endif
+
+namespace {
+constexpr size_t COPY_BUFFER_SIZE = 64 * 1024;
+
+struct TraceSection {
+    uint64_t offset = 0; // offset of the content header
+    TraceFileContentHeader header;
+};
+
+struct PageRange {
+    uint64_t offset = 0;
+    uint64_t size = 0;
+};
+
+bool IsCpuRawSection(const uint8_t type)
+{
+    return (type >= CONTENT_TYPE_CPU_RAW && type < CONTENT_TYPE_HEADER_PAGE) || type == CONTENT_TYPE_CPU_RAW_COMPRESSED;
+}
+
+bool IsCompressedFile(const std::vector<TraceSection>& sections)
+{
+    return std::any_of(sections.begin(), sections.end(),
+        [](const TraceSection& section) { return section.header.type == CONTENT_TYPE_CPU_RAW_COMPRESSED; });
+}
+
+bool ReadPageTimestamp(const int fd, const uint64_t offset, uint64_t& timestamp)
+{
+    return TEMP_FAILURE_RETRY(pread(fd, &timestamp, sizeof(timestamp), static_cast<off_t>(offset))) ==
+        static_cast<ssize_t>(sizeof(timestamp));
+}
+
+bool CopyFileRangeByReadWrite(const int srcFd, uint64_t offset, const int dstFd, uint64_t size)
+{
+    std::vector<uint8_t> buffer(std::min(static_cast<uint64_t>(COPY_BUFFER_SIZE), size));
+    while (size > 0) {
+        size_t chunk = static_cast<size_t>(std::min(static_cast<uint64_t>(buffer.size()), size));
+        ssize_t readBytes = TEMP_FAILURE_RETRY(pread(srcFd, buffer.data(), chunk, static_cast<off_t>(offset)));
+        if (readBytes <= 0 ||
+            TEMP_FAILURE_RETRY(write(dstFd, buffer.data(), static_cast<size_t>(readBytes))) != readBytes) {
+            HILOG_ERROR(LOG_CORE, "CopyFileRange: read/write failed, errno(%{public}d).", errno);
+            return false;
+        }
+        offset += static_cast<uint64_t>(readBytes);
+        size -= static_cast<uint64_t>(readBytes);
+    }
+    return true;
+}
+
+bool ReadTraceSections(const int fd, std::vector<TraceSection>& sections, std::vector<TracePageIndexEntry>& entries)
+{
+    struct stat fileStat = {};
+    TraceFileHeader fileHeader;
+    if (fstat(fd, &fileStat) != 0 || TEMP_FAILURE_RETRY(pread(fd, &fileHeader, sizeof(fileHeader), 0)) !=
+        static_cast<ssize_t>(sizeof(fileHeader)) || fileHeader.magicNumber != MAGIC_NUMBER) {
+        return false;
+    }
+    uint64_t fileSize = static_cast<uint64_t>(fileStat.st_size);
+    uint64_t offset = sizeof(TraceFileHeader);
+    while (offset + sizeof(TraceFileContentHeader) <= fileSize) {
+        TraceSection section;
+        section.offset = offset;
+        if (TEMP_FAILURE_RETRY(pread(fd, &section.header, sizeof(section.header), static_cast<off_t>(offset))) !=
+            static_cast<ssize_t>(sizeof(section.header)) || section.header.type == CONTENT_TYPE_DEFAULT) {
+            break;
+        }
+        offset += sizeof(TraceFileContentHeader) + section.header.length;
+        if (offset > fileSize) {
+            break;
+        }
+        if (section.header.type == CONTENT_TYPE_SECTION_TABLE) {
+            continue;
+        }
+        if (section.header.type != CONTENT_TYPE_PAGE_INDEX) {
+            sections.push_back(section);
+            continue;
+        }
+        entries.resize(section.header.length / sizeof(TracePageIndexEntry));
+        size_t indexSize = entries.size() * sizeof(TracePageIndexEntry);
+        if (TEMP_FAILURE_RETRY(pread(fd, entries.data(), indexSize,
+            static_cast<off_t>(section.offset + sizeof(TraceFileContentHeader)))) != static_cast<ssize_t>(indexSize)) {
+            entries.clear();
+        }
+    }
+    return !entries.empty();
+}
+
+void AppendPageRange(std::vector<PageRange>& ranges, const uint64_t offset, const uint64_t size)
+{
+    if (!ranges.empty() && ranges.back().offset + ranges.back().size == offset) {
+        ranges.back().size += size;
+        return;
+    }
+    ranges.push_back({offset, size});
+}
+
+// select the pages of the window, only the entries on the edges of the window are looked into page by page.
+// the entries of compressed sections locate whole chunks, the chunks on the edges are kept as they are.
+std::map<uint32_t, std::vector<PageRange>> SelectPageRanges(const int fd,
+    const std::vector<TracePageIndexEntry>& entries, const uint64_t startTime, const uint64_t endTime,
+    const bool isCompressed, uint64_t& firstPageTime, uint64_t& lastPageTime)
+{
+    std::map<uint32_t, std::vector<PageRange>> cpuRanges;
+    for (const auto& entry : entries) {
+        if (entry.lastTimestamp < startTime || entry.firstTimestamp > endTime) {
+            continue;
+        }
+        auto& ranges = cpuRanges[entry.cpu];
+        if (isCompressed || (entry.firstTimestamp >= startTime && entry.lastTimestamp <= endTime)) {
+            AppendPageRange(ranges, entry.offset, entry.size);
+            firstPageTime = std::min(firstPageTime, entry.firstTimestamp);
+            lastPageTime = std::max(lastPageTime, entry.lastTimestamp);
+            continue;
+        }
+        for (uint64_t pageOffset = 0; pageOffset < entry.size; pageOffset += PAGE_SIZE) {
+            uint64_t timestamp = 0;
+            if (!ReadPageTimestamp(fd, entry.offset + pageOffset, timestamp)) {
+                break;
+            }
+            if (timestamp < startTime || timestamp > endTime) {
+                continue;
+            }
+            AppendPageRange(ranges, entry.offset + pageOffset,
+                std::min(static_cast<uint64_t>(PAGE_SIZE), entry.size - pageOffset));
+            firstPageTime = std::min(firstPageTime, timestamp);
+            lastPageTime = std::max(lastPageTime, timestamp);
+        }
+    }
+    return cpuRanges;
+}
+
+bool WriteCpuRawSections(const int srcFd, const int dstFd,
+    const std::map<uint32_t, std::vector<PageRange>>& cpuRanges, const bool isCompressed)
+{
+    for (const auto& [cpu, ranges] : cpuRanges) {
+        uint64_t length = isCompressed ? sizeof(TraceCompressedRawHeader) : 0;
+        for (const auto& range : ranges) {
+            length += range.size;
+        }
+        if (ranges.empty()) {
+            continue;
+        }
+        TraceFileContentHeader rawHeader;
+        rawHeader.type = isCompressed ? static_cast<uint8_t>(CONTENT_TYPE_CPU_RAW_COMPRESSED) :
+            static_cast<uint8_t>(CONTENT_TYPE_CPU_RAW + cpu);
+        rawHeader.length = static_cast<uint32_t>(std::min(length,
+            static_cast<uint64_t>(std::numeric_limits<uint32_t>::max())));
+        if (TEMP_FAILURE_RETRY(write(dstFd, &rawHeader, sizeof(rawHeader))) !=
+            static_cast<ssize_t>(sizeof(rawHeader))) {
+            return false;
+        }
+        uint64_t copyBytes = 0;
+        if (isCompressed) {
+            TraceCompressedRawHeader compressedHeader;
+            compressedHeader.cpu = static_cast<uint8_t>(cpu);
+            if (TEMP_FAILURE_RETRY(write(dstFd, &compressedHeader, sizeof(compressedHeader))) !=
+                static_cast<ssize_t>(sizeof(compressedHeader))) {
+                return false;
+            }
+            copyBytes = sizeof(compressedHeader);
+        }
+        for (const auto& range : ranges) {
+            uint64_t size = std::min(range.size, static_cast<uint64_t>(rawHeader.length) - copyBytes);
+            if (!CopyFileRange(srcFd, range.offset, dstFd, size)) {
+                return false;
+            }
+            copyBytes += size;
+        }
+    }
+    return true;
+}
+
+bool WriteTraceWindow(const int srcFd, const int dstFd, const std::vector<TraceSection>& sections,
+    const std::map<uint32_t, std::vector<PageRange>>& cpuRanges, const bool isCompressed)
+{
+    if (!CopyFileRange(srcFd, 0, dstFd, sizeof(TraceFileHeader))) {
+        return false;
+    }
+    bool isCpuRawWritten = false;
+    for (const auto& section : sections) {
+        if (!IsCpuRawSection(section.header.type)) {
+            if (!CopyFileRange(srcFd, section.offset, dstFd, sizeof(TraceFileContentHeader) + section.header.length)) {
+                return false;
+            }
+            continue;
+        }
+        // the cut cpu raw sections take the place of the first cpu raw section of the source.
+        if (!isCpuRawWritten && !WriteCpuRawSections(srcFd, dstFd, cpuRanges, isCompressed)) {
+            return false;
+        }
+        isCpuRawWritten = true;
+    }
+    return isCpuRawWritten;
+}
+} // namespace
+
+bool CopyFileRange(const int srcFd, const uint64_t offset, const int dstFd, uint64_t size)
+{
+    loff_t srcOffset = static_cast<loff_t>(offset);
+    while (size > 0) {
+        ssize_t copyBytes = TEMP_FAILURE_RETRY(copy_file_range(srcFd, &srcOffset, dstFd, nullptr,
+            static_cast<size_t>(size), 0));
+        if (copyBytes > 0) {
+            size -= static_cast<uint64_t>(copyBytes);
+            continue;
+        }
+        if (copyBytes < 0 && errno != ENOSYS && errno != EXDEV && errno != EINVAL && errno != EOPNOTSUPP) {
+            HILOG_ERROR(LOG_CORE, "CopyFileRange: copy_file_range failed, errno(%{public}d).", errno);
+            return false;
+        }
+        // the file system can not copy the range in kernel, or the source is shorter than its sections claim.
+        return CopyFileRangeByReadWrite(srcFd, static_cast<uint64_t>(srcOffset), dstFd, size);
+    }
+    return true;
+}
+
+bool TracePageIndex::AddSection(const int fd, const uint32_t cpu, const uint64_t dataOffset, const uint32_t length)
+{
+    uint64_t strideSize = static_cast<uint64_t>(PAGE_INDEX_STRIDE) * PAGE_SIZE;
+    for (uint64_t offset = 0; offset < length; offset += strideSize) {
+        TracePageIndexEntry entry;
+        entry.offset = dataOffset + offset;
+        entry.size = static_cast<uint32_t>(std::min(strideSize, length - offset));
+        entry.cpu = cpu;
+        uint64_t lastPageOffset = (entry.size - 1) / PAGE_SIZE * PAGE_SIZE;
+        if (!ReadPageTimestamp(fd, entry.offset, entry.firstTimestamp) ||
+            !ReadPageTimestamp(fd, entry.offset + lastPageOffset, entry.lastTimestamp)) {
+            HILOG_WARN(LOG_CORE, "TracePageIndex: read page timestamp failed, errno(%{public}d).", errno);
+            return false;
+        }
+        entries_.push_back(entry);
+    }
+    return true;
+}
+
+bool ExtractTraceWindow(const std::string& srcFile, const std::string& dstFile, const uint64_t startTime,
+    const uint64_t endTime, uint64_t& firstPageTime, uint64_t& lastPageTime)
+{
+    SmartFd srcFd(open(srcFile.c_str(), O_RDONLY));
+    if (!srcFd) {
+        HILOG_ERROR(LOG_CORE, "ExtractTraceWindow: open %{public}s failed, errno(%{public}d).", srcFile.c_str(), errno);
+        return false;
+    }
+    std::vector<TraceSection> sections;
+    std::vector<TracePageIndexEntry> entries;
+    if (!ReadTraceSections(srcFd.GetFd(), sections, entries)) {
+        HILOG_INFO(LOG_CORE, "ExtractTraceWindow: %{public}s has no page index.", srcFile.c_str());
+        return false;
+    }
+    firstPageTime = std::numeric_limits<uint64_t>::max();
+    lastPageTime = 0;
+    bool isCompressed = IsCompressedFile(sections);
+    auto cpuRanges = SelectPageRanges(srcFd.GetFd(), entries, startTime, endTime, isCompressed, firstPageTime,
+        lastPageTime);
+    if (firstPageTime > lastPageTime) {
+        HILOG_INFO(LOG_CORE, "ExtractTraceWindow: no page of %{public}s in [%{public}" PRIu64 ", %{public}" PRIu64
+            "].", srcFile.c_str(), startTime, endTime);
+        return false;
+    }
+    SmartFd dstFd(open(dstFile.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644)); // 0644 : -rw-r--r--
+    if (!dstFd) {
+        HILOG_ERROR(LOG_CORE, "ExtractTraceWindow: open %{public}s failed, errno(%{public}d).", dstFile.c_str(), errno);
+        return false;
+    }
+    if (!WriteTraceWindow(srcFd.GetFd(), dstFd.GetFd(), sections, cpuRanges, isCompressed) ||
+        !AppendSectionTable(dstFd.GetFd())) {
+        HILOG_ERROR(LOG_CORE, "ExtractTraceWindow: write %{public}s failed.", dstFile.c_str());
+        unlink(dstFile.c_str());
+        return false;
+    }
+    HILOG_INFO(LOG_CORE, "ExtractTraceWindow: %{public}s [%{public}" PRIu64 ", %{public}" PRIu64 "] to %{public}s.",
+        srcFile.c_str(), firstPageTime, lastPageTime, dstFile.c_str());
+    return true;
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
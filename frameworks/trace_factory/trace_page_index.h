@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRACE_PAGE_INDEX_H
+#define TRACE_PAGE_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+constexpr uint32_t PAGE_INDEX_STRIDE = 64; // pages of a cpu raw section per index entry, 256 KB
+
+/**
+ * @brief TracePageIndexEntry locates a run of at most PAGE_INDEX_STRIDE pages of one cpu raw section, the pages
+ *        are PAGE_SIZE apart from offset and their timestamps are in [firstTimestamp, lastTimestamp].
+ */
+struct TracePageIndexEntry {
+    uint64_t firstTimestamp = 0;
+    uint64_t lastTimestamp = 0;
+    uint64_t offset = 0;
+    uint32_t size = 0;
+    uint32_t cpu = 0;
+};
+
+class TracePageIndex {
+public:
+    // index the pages of a cpu raw section which has been written to the file, fd must be readable.
+    bool AddSection(const int fd, const uint32_t cpu, const uint64_t dataOffset, const uint32_t length);
+    void AddEntry(const TracePageIndexEntry& entry) { entries_.push_back(entry); }
+    const std::vector<TracePageIndexEntry>& GetEntries() const { return entries_; }
+
+private:
+    std::vector<TracePageIndexEntry> entries_;
+};
+
+// copy [offset, offset + size) of srcFd to the current position of dstFd without passing through user space if the
+// file system can, it falls back to pread and write otherwise.
+bool CopyFileRange(const int srcFd, const uint64_t offset, const int dstFd, uint64_t size);
+
+/**
+ * @brief build dstFile from the sections of srcFile, the cpu raw sections are cut to the pages in
+ *        [startTime, endTime] through the page index of srcFile and copied with copy_file_range, compressed
+ *        sections are cut by whole chunks, dstFile ends with a section table of its own.
+ * @return false if srcFile has no page index or no page in the window, dstFile is not left behind then.
+ */
+bool ExtractTraceWindow(const std::string& srcFile, const std::string& dstFile, const uint64_t startTime,
+    const uint64_t endTime, uint64_t& firstPageTime, uint64_t& lastPageTime);
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
+#endif // TRACE_PAGE_INDEX_H
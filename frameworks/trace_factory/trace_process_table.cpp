@@ -0,0 +1,588 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace_process_table.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "common_define.h"
+#include "hilog/log.h"
+#include "securec.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+#ifdef LOG_DOMAIN
+#undef LOG_DOMAIN
+#define LOG_DOMAIN 0xD002D33
+#endif
+#ifdef LOG_TAG
+#undef LOG_TAG
+#define LOG_TAG "HitraceProcessTable"
+#endif
+
+namespace {
+constexpr size_t DIRENT_BUFFER_SIZE = 16 * 1024; // about 500 entries of /proc for one getdents64
+constexpr int DECIMAL_BASE = 10;
+constexpr int PID_MAX_LIMIT = 4 * 1024 * 1024; // the largest pid_max of the kernel
+constexpr size_t BITS_PER_WORD = 64;
+constexpr uint32_t TYPE_LEN_MASK = 0x1f;
+constexpr uint32_t TIME_DELTA_SHIFT = 5;
+constexpr uint32_t TYPE_PADDING = 29;
+constexpr uint32_t TYPE_TIME_EXTEND = 30;
+constexpr uint32_t TYPE_TIME_STAMP = 31;
+constexpr uint32_t TIME_EXTEND_SHIFT = 27; // the upper bits of a time extend are in array[0]
+constexpr uint64_t TIME_DELTA_MAX = (1ULL << TIME_EXTEND_SHIFT) - 1;
+constexpr uint64_t COMMIT_MASK = (1ULL << 27) - 1; // the high bits of commit flag missed events
+constexpr uint64_t MISSED_EVENTS_FLAG = 1ULL << 31;
+constexpr uint32_t EVENT_ALIGN_MASK = 3;
+constexpr size_t EVENT_HEADER_SIZE = sizeof(uint32_t);
+constexpr size_t TIME_EXTEND_SIZE = 2 * sizeof(uint32_t);
+constexpr size_t COMMON_PID_OFFSET = 4; // after u16 common_type, u8 common_flags and u8 common_preempt_count
+constexpr size_t FILTER_READY_PAGE_COUNT = 64; // the kept pages are handed to the sink 256KB at a time
+// the fields of the events which hold kernel code addresses, such as ip of ftrace print and function of
+// workqueue_execute_start.
+const char* const ADDR_FIELD_NAMES[] = { "ip", "parent_ip", "function", "call_site", "caller" };
+
+// the record layout of getdents64, which is the same for all the architectures.
+struct LinuxDirent64 {
+    uint64_t ino;
+    int64_t off;
+    unsigned short reclen;
+    unsigned char type;
+    char name[1]; // null terminated, reclen covers the whole name
+};
+
+bool IsPidName(const char* name)
+{
+    if (*name == '\0') {
+        return false;
+    }
+    for (const char* ch = name; *ch != '\0'; ch++) {
+        if (*ch < '0' || *ch > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename T>
+T ReadValue(const uint8_t* pos)
+{
+    T value = 0;
+    if (memcpy_s(&value, sizeof(T), pos, sizeof(T)) != EOK) {
+        return 0;
+    }
+    return value;
+}
+
+// a header_page line looks like "\tfield: local_t commit;\toffset:8;\tsize:8;\tsigned:1;".
+bool ParseHeaderPageField(const std::string& line, const std::string& name, size_t& offset, size_t& size)
+{
+    const std::string offsetKey = "offset:";
+    const std::string sizeKey = "size:";
+    size_t offsetPos = line.find(offsetKey);
+    size_t sizePos = line.find(sizeKey);
+    if (line.find(" " + name + ";") == std::string::npos || offsetPos == std::string::npos ||
+        sizePos == std::string::npos) {
+        return false;
+    }
+    offset = strtoul(line.c_str() + offsetPos + offsetKey.size(), nullptr, DECIMAL_BASE);
+    size = strtoul(line.c_str() + sizePos + sizeKey.size(), nullptr, DECIMAL_BASE);
+    return true;
+}
+
+uint64_t ReadCommit(const TracePageLayout& layout, const uint8_t* page)
+{
+    return layout.commitSize == sizeof(uint32_t) ? ReadValue<uint32_t>(page + layout.commitOffset) :
+        ReadValue<uint64_t>(page + layout.commitOffset);
+}
+
+// a record of a ring buffer page, pid is -1 for the time extends, the time stamps and the paddings.
+struct PageRecord {
+    size_t offset = 0;
+    size_t size = 0;
+    uint64_t time = 0; // the timestamp of the page plus the deltas of all the records up to this one
+    int pid = -1;
+    size_t data = 0; // the offset of the event data, only set for the data records
+};
+
+// the size of a data record, whose type_len is in [0, TYPE_PADDING), 0 if it is truncated.
+size_t GetDataRecordSize(const uint8_t* page, const size_t pos, const size_t end)
+{
+    uint32_t typeLen = ReadValue<uint32_t>(page + pos) & TYPE_LEN_MASK;
+    if (typeLen != 0) {
+        return EVENT_HEADER_SIZE + typeLen * sizeof(uint32_t);
+    }
+    if (pos + EVENT_HEADER_SIZE + sizeof(uint32_t) > end) {
+        return 0;
+    }
+    // array[0] is the length of the event data with array[0] itself.
+    uint32_t array0 = ReadValue<uint32_t>(page + pos + EVENT_HEADER_SIZE);
+    if (array0 < sizeof(uint32_t)) {
+        return 0;
+    }
+    return EVENT_HEADER_SIZE + sizeof(uint32_t) +
+        ((array0 - sizeof(uint32_t) + EVENT_ALIGN_MASK) & ~static_cast<size_t>(EVENT_ALIGN_MASK));
+}
+
+// walk the records of a page until the handler returns false, the same way as the kbuffer of libtraceevent.
+template<typename Handler>
+void TraversePageRecords(const TracePageLayout& layout, const uint8_t* page, const size_t size, Handler&& handler)
+{
+    if (!layout.IsValid() || size < layout.dataOffset) {
+        return;
+    }
+    const size_t end = std::min(static_cast<size_t>(layout.dataOffset + (ReadCommit(layout, page) & COMMIT_MASK)),
+        size);
+    PageRecord record;
+    record.time = ReadValue<uint64_t>(page);
+    for (size_t pos = layout.dataOffset; pos + EVENT_HEADER_SIZE <= end; pos += record.size) {
+        uint32_t header = ReadValue<uint32_t>(page + pos);
+        uint32_t typeLen = header & TYPE_LEN_MASK;
+        uint64_t delta = header >> TIME_DELTA_SHIFT;
+        record.offset = pos;
+        record.pid = -1;
+        if (typeLen == TYPE_PADDING && delta == 0) {
+            break; // the rest of the page is padding
+        }
+        if (typeLen >= TYPE_PADDING) {
+            if (pos + TIME_EXTEND_SIZE > end) {
+                break;
+            }
+            uint64_t array0 = ReadValue<uint32_t>(page + pos + EVENT_HEADER_SIZE);
+            if (typeLen == TYPE_PADDING) {
+                record.size = EVENT_HEADER_SIZE + array0; // a discarded event
+                record.time += delta;
+            } else {
+                record.size = TIME_EXTEND_SIZE;
+                uint64_t time = (array0 << TIME_EXTEND_SHIFT) | delta;
+                record.time = typeLen == TYPE_TIME_STAMP ? time : record.time + time;
+            }
+        } else {
+            record.size = GetDataRecordSize(page, pos, end);
+            size_t data = pos + EVENT_HEADER_SIZE + (typeLen == 0 ? sizeof(uint32_t) : 0);
+            if (record.size == 0 || data + COMMON_PID_OFFSET + sizeof(int32_t) > pos + record.size) {
+                break;
+            }
+            record.time += delta;
+            record.pid = ReadValue<int32_t>(page + data + COMMON_PID_OFFSET);
+            record.data = data;
+        }
+        if (pos + record.size > end || !handler(record)) {
+            break;
+        }
+    }
+}
+} // namespace
+
+const std::vector<TraceProcessEntry>& TraceProcessTable::GetProcesses()
+{
+    if (!isScanned_) {
+        Scan();
+    }
+    return processes_;
+}
+
+std::string TraceProcessTable::GetProcessName(const std::string& pid)
+{
+    if (!IsPidName(pid.c_str())) {
+        return "";
+    }
+    int pidNum = static_cast<int>(strtol(pid.c_str(), nullptr, DECIMAL_BASE));
+    auto iter = std::lower_bound(processes_.begin(), processes_.end(), pidNum,
+        [](const TraceProcessEntry& process, const int value) { return process.pid < value; });
+    if (iter != processes_.end() && iter->pid == pidNum) {
+        return iter->name;
+    }
+    std::string name;
+    ReadProcessName(pid, name);
+    return name;
+}
+
+bool TraceProcessTable::OpenProcDir()
+{
+    if (!procFd_) {
+        procFd_ = SmartFd(open(procPath_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+        if (!procFd_) {
+            HILOG_ERROR(LOG_CORE, "OpenProcDir: open %{public}s failed, errno(%{public}d).", procPath_.c_str(),
+                errno);
+        }
+    }
+    return static_cast<bool>(procFd_);
+}
+
+void TraceProcessTable::Scan()
+{
+    isScanned_ = true;
+    if (!OpenProcDir()) {
+        return;
+    }
+    alignas(LinuxDirent64) char dirents[DIRENT_BUFFER_SIZE];
+    while (true) {
+        long bytes = syscall(SYS_getdents64, procFd_.GetFd(), dirents, sizeof(dirents));
+        if (bytes < 0) {
+            HILOG_ERROR(LOG_CORE, "Scan: getdents64 failed, errno(%{public}d).", errno);
+        }
+        if (bytes <= 0) {
+            break;
+        }
+        for (long pos = 0; pos < bytes;) {
+            const auto* entry = reinterpret_cast<const LinuxDirent64*>(dirents + pos);
+            pos += entry->reclen;
+            if ((entry->type != DT_DIR && entry->type != DT_UNKNOWN) || !IsPidName(entry->name)) {
+                continue;
+            }
+            TraceProcessEntry process;
+            process.pid = static_cast<int>(strtol(entry->name, nullptr, DECIMAL_BASE));
+            if (ReadProcessName(entry->name, process.name)) {
+                processes_.push_back(std::move(process));
+            }
+        }
+    }
+    std::sort(processes_.begin(), processes_.end(),
+        [](const TraceProcessEntry& lhs, const TraceProcessEntry& rhs) { return lhs.pid < rhs.pid; });
+    HILOG_INFO(LOG_CORE, "Scan: %{public}zu processes in %{public}s.", processes_.size(), procPath_.c_str());
+}
+
+bool TraceProcessTable::ReadProcessName(const std::string& pid, std::string& name)
+{
+    if (!OpenProcDir()) {
+        return false;
+    }
+    SmartFd commFd(openat(procFd_.GetFd(), (pid + "/comm").c_str(), O_RDONLY | O_CLOEXEC));
+    if (!commFd) {
+        return false; // the process has exited since it was listed
+    }
+    ssize_t len = TEMP_FAILURE_RETRY(pread(commFd.GetFd(), nameBuffer_, sizeof(nameBuffer_), 0));
+    if (len <= 0) {
+        return false;
+    }
+    while (len > 0 && nameBuffer_[len - 1] == '\n') {
+        len--;
+    }
+    name.assign(nameBuffer_, static_cast<size_t>(len));
+    return true;
+}
+
+bool TracePageLayout::Parse(const std::string& headerPagePath)
+{
+    std::ifstream headerPage(headerPagePath);
+    std::string line;
+    size_t data = 0;
+    size_t dataSize = 0;
+    while (std::getline(headerPage, line)) {
+        if (!ParseHeaderPageField(line, "commit", commitOffset, commitSize)) {
+            ParseHeaderPageField(line, "data", data, dataSize);
+        }
+    }
+    if ((commitSize != sizeof(uint32_t) && commitSize != sizeof(uint64_t)) || data < commitOffset + commitSize) {
+        HILOG_WARN(LOG_CORE, "TracePageLayout: unknown page layout in %{public}s.", headerPagePath.c_str());
+        return false;
+    }
+    dataOffset = data;
+    return true;
+}
+
+TracePagePids::TracePagePids(const std::string& headerPagePath)
+{
+    layout_.Parse(headerPagePath);
+}
+
+void TraceSeenPids::CollectPage(const uint8_t* page, const size_t size)
+{
+    TraversePageRecords(GetLayout(), page, size, [this](const PageRecord& record) {
+        Add(record.pid);
+        return true;
+    });
+}
+
+TraceSeenAddrs::TraceSeenAddrs(const std::string& headerPagePath, const TraceEventFormats& eventFormats)
+{
+    layout_.Parse(headerPagePath);
+    for (const auto& layout : eventFormats.GetLayouts()) {
+        for (const auto& field : layout.fields) {
+            if ((field.size != sizeof(uint32_t) && field.size != sizeof(uint64_t)) || field.isSigned ||
+                std::find(std::begin(ADDR_FIELD_NAMES), std::end(ADDR_FIELD_NAMES), field.name) ==
+                std::end(ADDR_FIELD_NAMES)) {
+                continue;
+            }
+            addrFields_[layout.id].push_back(field);
+        }
+    }
+}
+
+void TraceSeenAddrs::CollectPage(const uint8_t* page, const size_t size)
+{
+    TraversePageRecords(layout_, page, size, [this, page](const PageRecord& record) {
+        if (record.pid < 0) {
+            return true;
+        }
+        auto fields = addrFields_.find(ReadValue<uint16_t>(page + record.data));
+        if (fields == addrFields_.end()) {
+            return true;
+        }
+        for (const auto& field : fields->second) {
+            size_t offset = record.data + field.offset;
+            if (offset + field.size > record.offset + record.size) {
+                continue;
+            }
+            uint64_t addr = field.size == sizeof(uint64_t) ? ReadValue<uint64_t>(page + offset) :
+                ReadValue<uint32_t>(page + offset);
+            if (addr != 0) {
+                addrs_.insert(addr);
+            }
+        }
+        return true;
+    });
+}
+
+void TracePidSet::Add(const int pid)
+{
+    if (pid <= 0 || pid > PID_MAX_LIMIT) {
+        return; // the idle tasks are not listed in saved_cmdlines
+    }
+    size_t word = static_cast<size_t>(pid) / BITS_PER_WORD;
+    if (word >= bitmap_.size()) {
+        bitmap_.resize(word + 1, 0);
+    }
+    uint64_t bit = 1ULL << (static_cast<size_t>(pid) % BITS_PER_WORD);
+    if ((bitmap_[word] & bit) == 0) {
+        bitmap_[word] |= bit;
+        count_++;
+    }
+}
+
+void TracePidSet::Remove(const int pid)
+{
+    if (Contains(pid)) {
+        bitmap_[static_cast<size_t>(pid) / BITS_PER_WORD] &= ~(1ULL << (static_cast<size_t>(pid) % BITS_PER_WORD));
+        count_--;
+    }
+}
+
+bool TracePidSet::Contains(const int pid) const
+{
+    size_t word = static_cast<size_t>(pid) / BITS_PER_WORD;
+    return pid > 0 && word < bitmap_.size() &&
+        (bitmap_[word] & (1ULL << (static_cast<size_t>(pid) % BITS_PER_WORD))) != 0;
+}
+
+void TracePidSet::Clear()
+{
+    bitmap_.clear();
+    count_ = 0;
+}
+
+void TracePidSet::ForEach(const std::function<void(const int pid)>& handler) const
+{
+    for (size_t word = 0; word < bitmap_.size(); word++) {
+        for (uint64_t bits = bitmap_[word]; bits != 0; bits &= bits - 1) {
+            handler(static_cast<int>(word * BITS_PER_WORD + static_cast<size_t>(__builtin_ctzll(bits))));
+        }
+    }
+}
+
+TracePagePidFilter::TracePagePidFilter(std::shared_ptr<const TracePagePids> pids, const PageSink& sink)
+    : pids_(pids), layout_(pids->GetLayout()), sink_(sink), readyPages_(FILTER_READY_PAGE_COUNT * PAGE_SIZE) {}
+
+void TracePagePidFilter::FilterPages(const uint8_t* pages, const size_t size)
+{
+    auto start = std::chrono::steady_clock::now();
+    uint64_t sinkNs = sinkNs_;
+    for (size_t offset = 0; offset < size; offset += PAGE_SIZE) {
+        FilterPage(pages + offset, std::min(static_cast<size_t>(PAGE_SIZE), size - offset));
+    }
+    auto costNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    costNs_ += static_cast<uint64_t>(costNs.count()) - (sinkNs_ - sinkNs);
+}
+
+void TracePagePidFilter::Flush()
+{
+    ClosePage();
+    FlushReadyPages();
+}
+
+void TracePagePidFilter::FilterPage(const uint8_t* page, const size_t size)
+{
+    inputBytes_ += size;
+    bool allKept = true;
+    TraversePageRecords(layout_, page, size, [this, &allKept](const PageRecord& record) {
+        allKept = record.pid < 0 || pids_->Contains(record.pid);
+        return allKept;
+    });
+    if (allKept && openPage_ == nullptr) {
+        PassPage(page, size);
+        return;
+    }
+    // the consecutive kept events are copied as a run, only the delta of the first one is rewritten.
+    size_t runBegin = 0;
+    size_t runEnd = 0;
+    uint64_t runTime = 0;
+    uint64_t runLastTime = 0;
+    TraversePageRecords(layout_, page, size, [&, this](const PageRecord& record) {
+        if (record.pid >= 0 && pids_->Contains(record.pid)) {
+            if (runEnd == 0) {
+                runBegin = record.offset;
+                runTime = record.time;
+            }
+            runEnd = record.offset + record.size;
+            runLastTime = record.time;
+            return true;
+        }
+        droppedEvents_ += record.pid >= 0 ? 1 : 0;
+        if (runEnd != 0) {
+            AppendEvents(page, runBegin, runEnd, runTime, runLastTime);
+            runEnd = 0;
+        }
+        return true;
+    });
+    if (runEnd != 0) {
+        AppendEvents(page, runBegin, runEnd, runTime, runLastTime);
+    }
+    if (openPage_ != nullptr) {
+        openFlags_ |= ReadCommit(layout_, page) & MISSED_EVENTS_FLAG;
+    }
+}
+
+void TracePagePidFilter::AppendEvents(const uint8_t* page, size_t begin, const size_t end, uint64_t time,
+    uint64_t lastTime)
+{
+    const size_t capacity = PAGE_SIZE - layout_.dataOffset;
+    while (begin < end) {
+        if (openPage_ == nullptr && !OpenPage(time)) {
+            return;
+        }
+        uint64_t delta = time > openTime_ ? time - openTime_ : 0;
+        size_t extendSize = delta > TIME_DELTA_MAX ? TIME_EXTEND_SIZE : 0;
+        // find the events which fit into the open page, it is all of them unless the page is filled.
+        size_t fitEnd = end;
+        uint64_t fitTime = lastTime;
+        if (openUsed_ + extendSize + (end - begin) > capacity) {
+            fitEnd = begin;
+            fitTime = time;
+            for (uint64_t nextTime = time; fitEnd < end;) {
+                size_t recordSize = GetDataRecordSize(page, fitEnd, end);
+                if (recordSize == 0 || openUsed_ + extendSize + (fitEnd + recordSize - begin) > capacity) {
+                    break;
+                }
+                fitTime = nextTime;
+                fitEnd += recordSize;
+                nextTime += fitEnd < end ? ReadValue<uint32_t>(page + fitEnd) >> TIME_DELTA_SHIFT : 0;
+            }
+        }
+        if (fitEnd == begin) {
+            if (openUsed_ == 0) {
+                return; // an event larger than a page, which the kernel never writes
+            }
+            ClosePage();
+            continue;
+        }
+        uint8_t* dest = openPage_ + layout_.dataOffset + openUsed_;
+        if (extendSize != 0) {
+            uint32_t extend[] = {
+                TYPE_TIME_EXTEND | static_cast<uint32_t>((delta & TIME_DELTA_MAX) << TIME_DELTA_SHIFT),
+                static_cast<uint32_t>(delta >> TIME_EXTEND_SHIFT)
+            };
+            (void)memcpy_s(dest, TIME_EXTEND_SIZE, extend, sizeof(extend));
+            dest += TIME_EXTEND_SIZE;
+            delta = 0;
+        }
+        (void)memcpy_s(dest, fitEnd - begin, page + begin, fitEnd - begin);
+        uint32_t header = (ReadValue<uint32_t>(dest) & TYPE_LEN_MASK) |
+            static_cast<uint32_t>(delta << TIME_DELTA_SHIFT);
+        (void)memcpy_s(dest, sizeof(header), &header, sizeof(header));
+        openUsed_ += extendSize + (fitEnd - begin);
+        openTime_ = fitTime;
+        if (fitEnd == end) {
+            return;
+        }
+        ClosePage();
+        time = fitTime + (ReadValue<uint32_t>(page + fitEnd) >> TIME_DELTA_SHIFT);
+        begin = fitEnd;
+    }
+}
+
+bool TracePagePidFilter::OpenPage(const uint64_t time)
+{
+    if (readyBytes_ + PAGE_SIZE > readyPages_.size()) {
+        FlushReadyPages();
+    }
+    openPage_ = readyPages_.data() + readyBytes_;
+    if (memset_s(openPage_, PAGE_SIZE, 0, PAGE_SIZE) != EOK ||
+        memcpy_s(openPage_, sizeof(time), &time, sizeof(time)) != EOK) {
+        openPage_ = nullptr;
+        return false;
+    }
+    openUsed_ = 0;
+    openTime_ = time;
+    openFlags_ = 0;
+    return true;
+}
+
+void TracePagePidFilter::ClosePage()
+{
+    if (openPage_ == nullptr) {
+        return;
+    }
+    uint64_t commit = openUsed_ | openFlags_;
+    if (layout_.commitSize == sizeof(uint32_t)) {
+        uint32_t commit32 = static_cast<uint32_t>(commit);
+        (void)memcpy_s(openPage_ + layout_.commitOffset, sizeof(commit32), &commit32, sizeof(commit32));
+    } else {
+        (void)memcpy_s(openPage_ + layout_.commitOffset, sizeof(commit), &commit, sizeof(commit));
+    }
+    readyBytes_ += PAGE_SIZE;
+    openPage_ = nullptr;
+}
+
+void TracePagePidFilter::PassPage(const uint8_t* page, const size_t size)
+{
+    if (readyBytes_ + PAGE_SIZE > readyPages_.size()) {
+        FlushReadyPages();
+    }
+    uint8_t* dest = readyPages_.data() + readyBytes_;
+    if (memcpy_s(dest, PAGE_SIZE, page, size) != EOK ||
+        (size < PAGE_SIZE && memset_s(dest + size, PAGE_SIZE - size, 0, PAGE_SIZE - size) != EOK)) {
+        return;
+    }
+    readyBytes_ += PAGE_SIZE;
+}
+
+void TracePagePidFilter::FlushReadyPages()
+{
+    if (readyBytes_ == 0) {
+        return;
+    }
+    if (sink_) {
+        auto start = std::chrono::steady_clock::now();
+        sink_(readyPages_.data(), readyBytes_);
+        sinkNs_ += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+    outputBytes_ += readyBytes_;
+    readyBytes_ = 0;
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRACE_PROCESS_TABLE_H
+#define TRACE_PROCESS_TABLE_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "smart_fd.h"
+#include "trace_metadata_cache.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+struct TraceProcessEntry {
+    int pid = 0;
+    std::string name;
+};
+
+/**
+ * @brief TraceProcessTable lists the processes of /proc with their names, it is scanned once and then shared by
+ *        the contents of one trace file.
+ * @note The names are read from /proc/<pid>/comm, which holds the same name as the Name line of status.
+ *       A table belongs to one trace file, it is not thread safe.
+ */
+class TraceProcessTable {
+public:
+    explicit TraceProcessTable(const std::string& procPath = "/proc") : procPath_(procPath) {}
+    // the processes sorted by pid, /proc is scanned by the first call.
+    const std::vector<TraceProcessEntry>& GetProcesses();
+    // the name of a scanned process, the others, such as threads, are read on demand without a scan.
+    std::string GetProcessName(const std::string& pid);
+
+private:
+    void Scan();
+    bool OpenProcDir();
+    bool ReadProcessName(const std::string& pid, std::string& name);
+
+    std::string procPath_;
+    SmartFd procFd_;
+    bool isScanned_ = false;
+    std::vector<TraceProcessEntry> processes_;
+    char nameBuffer_[64] = {0}; // 64 : comm is at most 16 bytes, the buffer is reused by every read
+};
+
+/**
+ * @brief TracePageLayout is where the commit field and the events are in a ring buffer page, it is parsed from
+ *        events/header_page, such as "field: local_t commit;\toffset:8;\tsize:8;\tsigned:1;".
+ */
+struct TracePageLayout {
+    size_t commitOffset = 0;
+    size_t commitSize = 0;
+    size_t dataOffset = 0;
+
+    bool Parse(const std::string& headerPagePath);
+    bool IsValid() const { return dataOffset != 0; }
+};
+
+/**
+ * @brief TracePidSet is a bitmap of pids, the idle tasks and the pids out of the range of the kernel are ignored.
+ */
+class TracePidSet {
+public:
+    bool IsEmpty() const { return count_ == 0; }
+    size_t GetCount() const { return count_; }
+    void Add(const int pid);
+    void Remove(const int pid);
+    bool Contains(const int pid) const;
+    void Clear();
+    void ForEach(const std::function<void(const int pid)>& handler) const;
+
+private:
+    std::vector<uint64_t> bitmap_;
+    size_t count_ = 0;
+};
+
+/**
+ * @brief TracePagePids is a pid set together with the page layout which is needed to walk the events of the pages.
+ * @note nothing should be walked if the layout cannot be parsed, see IsValid.
+ */
+class TracePagePids : public TracePidSet {
+public:
+    explicit TracePagePids(const std::string& headerPagePath);
+    bool IsValid() const { return layout_.IsValid(); }
+    const TracePageLayout& GetLayout() const { return layout_; }
+
+private:
+    TracePageLayout layout_;
+};
+
+/**
+ * @brief TraceSeenPids is a bitmap of the pids of the events in the dumped cpu raw pages, it restricts the
+ *        cmdlines and tgids sections of a trace file to the tasks which appear in it.
+ */
+class TraceSeenPids : public TracePagePids {
+public:
+    explicit TraceSeenPids(const std::string& headerPagePath) : TracePagePids(headerPagePath) {}
+    void CollectPage(const uint8_t* page, const size_t size);
+};
+
+/**
+ * @brief TraceSeenAddrs collects the kernel addresses held by the events in the dumped cpu raw pages, such as the ip
+ *        of ftrace print, the fields of the addresses are found by name in the layouts of the event formats.
+ */
+class TraceSeenAddrs {
+public:
+    TraceSeenAddrs(const std::string& headerPagePath, const TraceEventFormats& eventFormats);
+    // false if the page layout is unknown or no event holds an address.
+    bool IsValid() const { return layout_.IsValid() && !addrFields_.empty(); }
+    void CollectPage(const uint8_t* page, const size_t size);
+    const std::unordered_set<uint64_t>& GetAddrs() const { return addrs_; }
+    void Clear() { addrs_.clear(); }
+
+private:
+    TracePageLayout layout_;
+    std::unordered_map<uint32_t, std::vector<TraceEventField>> addrFields_; // the address fields by event id
+    std::unordered_set<uint64_t> addrs_;
+};
+
+/**
+ * @brief TracePagePidFilter drops the events of the tasks out of a pid set from the pages of one cpu, and packs the
+ *        kept events into dense pages. The time deltas of the dropped events are carried by the next kept event,
+ *        a time extend is inserted when the carried delta does not fit into the event header.
+ * @note the pages are passed through untouched when all of their events are kept and no page is open.
+ *       The missed events flag of a page is kept, the count of the missed events is not.
+ */
+class TracePagePidFilter {
+public:
+    using PageSink = std::function<void(const uint8_t* pages, const size_t size)>;
+
+    TracePagePidFilter(std::shared_ptr<const TracePagePids> pids, const PageSink& sink);
+    // filter whole pages, the filled pages are handed to the sink in batches.
+    void FilterPages(const uint8_t* pages, const size_t size);
+    // close the open page and hand all the kept pages to the sink.
+    void Flush();
+    uint64_t GetInputBytes() const { return inputBytes_; }
+    uint64_t GetOutputBytes() const { return outputBytes_; }
+    uint64_t GetDroppedEvents() const { return droppedEvents_; }
+    // the time spent on walking and packing the pages, the sink is not counted.
+    uint64_t GetCostUs() const { return costNs_ / 1000; } // 1000 : ns per us
+
+private:
+    void FilterPage(const uint8_t* page, const size_t size);
+    void AppendEvents(const uint8_t* page, size_t begin, const size_t end, uint64_t time, uint64_t lastTime);
+    bool OpenPage(const uint64_t time);
+    void ClosePage();
+    void PassPage(const uint8_t* page, const size_t size);
+    void FlushReadyPages();
+
+    std::shared_ptr<const TracePagePids> pids_;
+    TracePageLayout layout_;
+    PageSink sink_;
+    std::vector<uint8_t> readyPages_;
+    size_t readyBytes_ = 0;
+    uint8_t* openPage_ = nullptr; // the page being packed, it is the next page of readyPages_
+    size_t openUsed_ = 0; // bytes of events in the open page
+    uint64_t openTime_ = 0; // the time of the last event of the open page
+    uint64_t openFlags_ = 0;
+    uint64_t inputBytes_ = 0;
+    uint64_t outputBytes_ = 0;
+    uint64_t droppedEvents_ = 0;
+    uint64_t costNs_ = 0;
+    uint64_t sinkNs_ = 0;
+};
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
+#endif // TRACE_PROCESS_TABLE_H
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace_section_table.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <limits>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "common_define.h"
+#include "hilog/log.h"
+#include "trace_content.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+#ifdef LOG_DOMAIN
+#undef LOG_DOMAIN
+#define LOG_DOMAIN 0xD002D33
+#endif
+#ifdef LOG_TAG
+#undef LOG_TAG
+#define LOG_TAG "HitraceSectionTable"
+#endif
+
+namespace {
+bool ReadAt(const int fd, void* buffer, const size_t size, const uint64_t offset)
+{
+    return TEMP_FAILURE_RETRY(pread(fd, buffer, size, static_cast<off_t>(offset))) == static_cast<ssize_t>(size);
+}
+
+void ReadPageIndexEntries(const int fd, const uint64_t dataOffset, const uint32_t length,
+    std::vector<TracePageIndexEntry>& indexEntries)
+{
+    indexEntries.resize(length / sizeof(TracePageIndexEntry));
+    if (!ReadAt(fd, indexEntries.data(), indexEntries.size() * sizeof(TracePageIndexEntry), dataOffset)) {
+        indexEntries.clear();
+    }
+}
+
+// the pages of a plain section are PAGE_SIZE apart, the timestamps of linux pages are the first 8 bytes of each
+// page, the page header of the hongmeng kernel is not parsed here, so its timestamps are left 0.
+void FillPlainRawEntry(const int fd, const bool isHm, TraceSectionTableEntry& entry)
+{
+    uint64_t dataOffset = entry.offset + sizeof(TraceFileContentHeader);
+    entry.pageCount = (static_cast<uint64_t>(entry.length) + PAGE_SIZE - 1) / PAGE_SIZE;
+    if (isHm || entry.pageCount == 0 || !ReadAt(fd, &entry.firstTimestamp, sizeof(uint64_t), dataOffset) ||
+        !ReadAt(fd, &entry.lastTimestamp, sizeof(uint64_t), dataOffset + (entry.pageCount - 1) * PAGE_SIZE)) {
+        entry.firstTimestamp = 0;
+        entry.lastTimestamp = 0;
+    }
+}
+
+// the pages of a compressed section are counted through its chunk headers, the timestamps come from the page
+// index, whose entries of compressed sections locate the chunks, they are left 0 for the hongmeng kernel as well.
+void FillCompressedRawEntry(const int fd, const bool isHm, const std::vector<TracePageIndexEntry>& indexEntries,
+    TraceSectionTableEntry& entry)
+{
+    uint64_t dataOffset = entry.offset + sizeof(TraceFileContentHeader);
+    uint64_t endOffset = dataOffset + entry.length;
+    uint64_t chunkOffset = dataOffset + sizeof(TraceCompressedRawHeader);
+    TraceCompressedChunkHeader chunkHeader;
+    while (chunkOffset + sizeof(chunkHeader) <= endOffset && ReadAt(fd, &chunkHeader, sizeof(chunkHeader),
+        chunkOffset)) {
+        entry.pageCount += chunkHeader.pageCount;
+        chunkOffset += sizeof(chunkHeader) + chunkHeader.compressedSize;
+    }
+    if (isHm) {
+        return;
+    }
+    uint64_t firstTimestamp = std::numeric_limits<uint64_t>::max();
+    for (const auto& indexEntry : indexEntries) {
+        if (indexEntry.offset < dataOffset || indexEntry.offset >= endOffset) {
+            continue;
+        }
+        firstTimestamp = std::min(firstTimestamp, indexEntry.firstTimestamp);
+        entry.lastTimestamp = std::max(entry.lastTimestamp, indexEntry.lastTimestamp);
+    }
+    entry.firstTimestamp = firstTimestamp > entry.lastTimestamp ? 0 : firstTimestamp;
+}
+} // namespace
+
+bool BuildSectionTable(const int fd, const uint64_t endOffset, std::vector<TraceSectionTableEntry>& entries)
+{
+    TraceFileHeader fileHeader;
+    if (!ReadAt(fd, &fileHeader, sizeof(fileHeader), 0)) {
+        return false;
+    }
+    bool isHm = fileHeader.fileType == HM_FILE_RAW_TRACE;
+    std::vector<TracePageIndexEntry> indexEntries;
+    uint64_t offset = sizeof(TraceFileHeader);
+    while (offset + sizeof(TraceFileContentHeader) <= endOffset) {
+        TraceFileContentHeader contentHeader;
+        if (!ReadAt(fd, &contentHeader, sizeof(contentHeader), offset) ||
+            contentHeader.type == CONTENT_TYPE_DEFAULT) {
+            break;
+        }
+        uint64_t dataOffset = offset + sizeof(TraceFileContentHeader);
+        if (dataOffset + contentHeader.length > endOffset) {
+            break;
+        }
+        if (contentHeader.type == CONTENT_TYPE_PAGE_INDEX) {
+            ReadPageIndexEntries(fd, dataOffset, contentHeader.length, indexEntries);
+        }
+        if (contentHeader.type != CONTENT_TYPE_SECTION_TABLE) {
+            TraceSectionTableEntry entry;
+            entry.offset = offset;
+            entry.length = contentHeader.length;
+            entry.type = contentHeader.type;
+            entries.push_back(entry);
+        }
+        offset = dataOffset + contentHeader.length;
+    }
+    for (auto& entry : entries) {
+        if (entry.type >= CONTENT_TYPE_CPU_RAW && entry.type < CONTENT_TYPE_HEADER_PAGE) {
+            FillPlainRawEntry(fd, isHm, entry);
+        } else if (entry.type == CONTENT_TYPE_CPU_RAW_COMPRESSED) {
+            FillCompressedRawEntry(fd, isHm, indexEntries, entry);
+        }
+    }
+    return !entries.empty();
+}
+
+bool AppendSectionTable(const int fd)
+{
+    off_t tableOffset = lseek(fd, 0, SEEK_CUR);
+    std::vector<TraceSectionTableEntry> entries;
+    if (tableOffset == -1 || !BuildSectionTable(fd, static_cast<uint64_t>(tableOffset), entries)) {
+        return false;
+    }
+    TraceSectionTableTrailer trailer;
+    trailer.tableOffset = static_cast<uint64_t>(tableOffset);
+    trailer.entryCount = static_cast<uint32_t>(entries.size());
+    TraceFileContentHeader contentHeader;
+    contentHeader.type = CONTENT_TYPE_SECTION_TABLE;
+    contentHeader.length = static_cast<uint32_t>(entries.size() * sizeof(TraceSectionTableEntry) + sizeof(trailer));
+    struct iovec iov[] = {
+        {&contentHeader, sizeof(contentHeader)},
+        {entries.data(), entries.size() * sizeof(TraceSectionTableEntry)},
+        {&trailer, sizeof(trailer)},
+    };
+    ssize_t totalSize = static_cast<ssize_t>(sizeof(contentHeader) + contentHeader.length);
+    if (TEMP_FAILURE_RETRY(writev(fd, iov, sizeof(iov) / sizeof(iov[0]))) != totalSize) {
+        HILOG_ERROR(LOG_CORE, "AppendSectionTable: write failed, errno(%{public}d).", errno);
+        return false;
+    }
+    return true;
+}
+
+bool ReadSectionTable(const int fd, std::vector<TraceSectionTableEntry>& entries)
+{
+    struct stat fileStat = {};
+    TraceSectionTableTrailer trailer;
+    if (fstat(fd, &fileStat) != 0 || static_cast<uint64_t>(fileStat.st_size) < sizeof(TraceFileHeader) +
+        sizeof(TraceFileContentHeader) + sizeof(trailer)) {
+        return false;
+    }
+    uint64_t fileSize = static_cast<uint64_t>(fileStat.st_size);
+    if (!ReadAt(fd, &trailer, sizeof(trailer), fileSize - sizeof(trailer)) || trailer.magic != SECTION_TABLE_MAGIC) {
+        return false;
+    }
+    uint64_t tableSize = static_cast<uint64_t>(trailer.entryCount) * sizeof(TraceSectionTableEntry) +
+        sizeof(trailer);
+    TraceFileContentHeader contentHeader;
+    if (trailer.tableOffset + sizeof(contentHeader) + tableSize != fileSize ||
+        !ReadAt(fd, &contentHeader, sizeof(contentHeader), trailer.tableOffset) ||
+        contentHeader.type != CONTENT_TYPE_SECTION_TABLE || contentHeader.length != tableSize) {
+        HILOG_WARN(LOG_CORE, "ReadSectionTable: the trailer does not match the section table.");
+        return false;
+    }
+    entries.resize(trailer.entryCount);
+    if (!ReadAt(fd, entries.data(), entries.size() * sizeof(TraceSectionTableEntry),
+        trailer.tableOffset + sizeof(contentHeader))) {
+        entries.clear();
+        return false;
+    }
+    return true;
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
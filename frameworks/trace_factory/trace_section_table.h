@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRACE_SECTION_TABLE_H
+#define TRACE_SECTION_TABLE_H
+
+#include <cstdint>
+#include <vector>
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+constexpr uint32_t SECTION_TABLE_MAGIC = 0x42545354; // "TSTB"
+
+/**
+ * @brief TraceSectionTableEntry locates one section of the trace file, offset is where its content header is.
+ * @note the timestamps and the page count are only set for the cpu raw sections, the timestamps are 0 in the files
+ *       of the hongmeng kernel, whose page header differs from the linux one.
+ */
+struct TraceSectionTableEntry {
+    uint64_t offset = 0;
+    uint32_t length = 0;
+    uint8_t type = 0;
+    uint8_t reserved[3] = {0};
+    uint64_t firstTimestamp = 0;
+    uint64_t lastTimestamp = 0;
+    uint64_t pageCount = 0;
+};
+
+/**
+ * @brief a CONTENT_TYPE_SECTION_TABLE section is the last one of the file, its entries are followed by
+ *        TraceSectionTableTrailer, so the trailer is the last bytes of the file and points back to the section.
+ */
+struct TraceSectionTableTrailer {
+    uint64_t tableOffset = 0;
+    uint32_t entryCount = 0;
+    uint32_t magic = SECTION_TABLE_MAGIC;
+};
+
+// walk the sections in [sizeof(TraceFileHeader), endOffset) of a readable fd, sections tables are skipped.
+bool BuildSectionTable(const int fd, const uint64_t endOffset, std::vector<TraceSectionTableEntry>& entries);
+
+// append the section table of the file to its current position, fd must be opened for reading and writing.
+bool AppendSectionTable(const int fd);
+
+// read the section table through the trailer, false if the file does not end with a valid table.
+bool ReadSectionTable(const int fd, std::vector<TraceSectionTableEntry>& entries);
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
+#endif // TRACE_SECTION_TABLE_H
@@ -15,12 +15,15 @@
 
 #include "trace_source_factory.h"
 
+#include <cinttypes>
 #include <fcntl.h>
 #include <hilog/log.h>
 #include <string>
 #include <unistd.h>
 
 #include "common_utils.h"
+#include "trace_file_utils.h"
+#include "trace_io_uring.h"
 
 namespace OHOS {
 namespace HiviewDFX {
@@ -41,7 +44,8 @@ namespace {
 bool UpdateFileFd(const std::string& traceFile, SmartFd& fd)
 {
     std::string path = CanonicalizeSpecPath(traceFile.c_str());
-    SmartFd newFd(open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_UNCACHE, 0644)); // 0644 : -rw-r--r--
+    // readable as well, the section table is built by walking the sections written through the fd.
+    SmartFd newFd(open(path.c_str(), O_CREAT | O_RDWR | O_TRUNC | O_UNCACHE, 0644)); // 0644 : -rw-r--r--
     if (!newFd) {
         HILOG_ERROR(LOG_CORE, "TraceSource: open %{public}s failed, errno(%{public}d).", traceFile.c_str(), errno);
         return false;
@@ -49,6 +53,12 @@ bool UpdateFileFd(const std::string& traceFile, SmartFd& fd)
     fd = std::move(newFd);
     return true;
 }
+
+bool IsCompressRequest(const TraceDumpRequest& request)
+{
+    return request.compressLevel > 0 &&
+        (request.type == TraceDumpType::TRACE_RECORDING || request.type == TraceDumpType::TRACE_CACHE);
+}
 }
 
 ITraceSourceFactory::ITraceSourceFactory(const std::string& traceFilePath) : traceFilePath_(traceFilePath)
@@ -57,7 +67,8 @@ ITraceSourceFactory::ITraceSourceFactory(const std::string& traceFilePath) : tra
         return;
     }
     std::string path = CanonicalizeSpecPath(traceFilePath.c_str());
-    traceFileFd_ = SmartFd(open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_UNCACHE, 0644)); // 0644 : -rw-r--r--
+    // readable as well, the section table is built by walking the sections written through the fd.
+    traceFileFd_ = SmartFd(open(path.c_str(), O_CREAT | O_RDWR | O_TRUNC | O_UNCACHE, 0644)); // 0644 : -rw-r--r--
     if (!traceFileFd_) {
         HILOG_ERROR(LOG_CORE, "TraceSourceFactory: open %{public}s failed.", traceFilePath.c_str());
     }
@@ -77,6 +88,44 @@ bool ITraceSourceFactory::UpdateTraceFile(const std::string& traceFilePath)
     return true;
 }
 
+bool ITraceSourceFactory::IsTraceFileExist()
+{
+    return traceFileFd_ && !IsFileUnlinked(traceFileFd_.GetFd());
+}
+
+bool ITraceSourceFactory::PreallocateTraceFile(const int64_t fileSize)
+{
+    if (!traceFileFd_ || fileSize <= 0) {
+        return false;
+    }
+    // keep the file size unchanged, readers of an unfinished trace file never see the preallocated blocks.
+    if (fallocate(traceFileFd_.GetFd(), FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(fileSize)) == -1) {
+        HILOG_WARN(LOG_CORE, "TraceSource: fallocate %{public}" PRId64 " bytes failed, errno(%{public}d).",
+            fileSize, errno);
+        return false;
+    }
+    return true;
+}
+
+bool ITraceSourceFactory::TrimTraceFile()
+{
+    if (!traceFileFd_) {
+        return false;
+    }
+    off_t fileEnd = lseek(traceFileFd_.GetFd(), 0, SEEK_CUR);
+    if (fileEnd == -1) {
+        HILOG_WARN(LOG_CORE, "TraceSource: lseek failed, errno(%{public}d).", errno);
+        return false;
+    }
+    // release the preallocated blocks beyond the data which has been written.
+    if (ftruncate(traceFileFd_.GetFd(), fileEnd) == -1) {
+        HILOG_WARN(LOG_CORE, "TraceSource: ftruncate to %{public}" PRId64 " failed, errno(%{public}d).",
+            static_cast<int64_t>(fileEnd), errno);
+        return false;
+    }
+    return true;
+}
+
 TraceSourceLinuxFactory::TraceSourceLinuxFactory(const std::string& traceFilePath)
     : ITraceSourceFactory(traceFilePath) {}
 
@@ -92,6 +141,17 @@ std::unique_ptr<TraceBaseInfoContent> TraceSourceLinuxFactory::GetTraceBaseInfo(
 
 std::unique_ptr<ITraceCpuRawContent> TraceSourceLinuxFactory::GetTraceCpuRaw(const TraceDumpRequest& request)
 {
+    if (request.engine == TraceDumpEngine::ENGINE_FLIGHT_RECORDER) {
+        return std::make_unique<TraceCpuRawFlight>(traceFileFd_.GetFd(), traceFilePath_, false, request);
+    }
+    if (IsCompressRequest(request)) {
+        return std::make_unique<TraceCpuRawCompress>(traceFileFd_.GetFd(), traceFilePath_, false, request);
+    }
+    // the pages read through io_uring go to the file without being walked, the pid filter needs the read loop.
+    if (request.engine == TraceDumpEngine::ENGINE_IO_URING && request.eventPids == nullptr &&
+        TraceIoUring::IsSupported()) {
+        return std::make_unique<TraceCpuRawUringLinux>(traceFileFd_.GetFd(), traceFilePath_, request);
+    }
     return std::make_unique<TraceCpuRawLinux>(traceFileFd_.GetFd(), traceFilePath_, request);
 }
 
@@ -120,6 +180,21 @@ std::unique_ptr<TraceTgidsContent> TraceSourceLinuxFactory::GetTraceTgids()
     return std::make_unique<TraceTgidsContent>(traceFileFd_.GetFd(), traceFilePath_, false);
 }
 
+std::unique_ptr<TraceSectionTableContent> TraceSourceLinuxFactory::GetTraceSectionTable()
+{
+    return std::make_unique<TraceSectionTableContent>(traceFileFd_.GetFd(), traceFilePath_, false);
+}
+
+std::unique_ptr<TraceMetadataRefContent> TraceSourceLinuxFactory::GetTraceMetadataRef()
+{
+    return std::make_unique<TraceMetadataRefContent>(traceFileFd_.GetFd(), traceFilePath_, false);
+}
+
+std::unique_ptr<TraceKallsymsContent> TraceSourceLinuxFactory::GetTraceKallsyms()
+{
+    return std::make_unique<TraceKallsymsContent>(traceFileFd_.GetFd(), traceFilePath_, false);
+}
+
 std::unique_ptr<ITraceCpuRawRead> TraceSourceLinuxFactory::GetTraceCpuRawRead(const TraceDumpRequest& request)
 {
     return std::make_unique<TraceCpuRawReadLinux>(request);
@@ -144,6 +219,12 @@ std::unique_ptr<TraceBaseInfoContent> TraceSourceHMFactory::GetTraceBaseInfo()
 
 std::unique_ptr<ITraceCpuRawContent> TraceSourceHMFactory::GetTraceCpuRaw(const TraceDumpRequest& request)
 {
+    if (request.engine == TraceDumpEngine::ENGINE_FLIGHT_RECORDER) {
+        return std::make_unique<TraceCpuRawFlight>(traceFileFd_.GetFd(), traceFilePath_, true, request);
+    }
+    if (IsCompressRequest(request)) {
+        return std::make_unique<TraceCpuRawCompress>(traceFileFd_.GetFd(), traceFilePath_, true, request);
+    }
     return std::make_unique<TraceCpuRawHM>(traceFileFd_.GetFd(), traceFilePath_, request);
 }
 
@@ -172,6 +253,21 @@ std::unique_ptr<TraceTgidsContent> TraceSourceHMFactory::GetTraceTgids()
     return std::make_unique<TraceTgidsContent>(traceFileFd_.GetFd(), traceFilePath_, true);
 }
 
+std::unique_ptr<TraceSectionTableContent> TraceSourceHMFactory::GetTraceSectionTable()
+{
+    return std::make_unique<TraceSectionTableContent>(traceFileFd_.GetFd(), traceFilePath_, true);
+}
+
+std::unique_ptr<TraceMetadataRefContent> TraceSourceHMFactory::GetTraceMetadataRef()
+{
+    return std::make_unique<TraceMetadataRefContent>(traceFileFd_.GetFd(), traceFilePath_, true);
+}
+
+std::unique_ptr<TraceKallsymsContent> TraceSourceHMFactory::GetTraceKallsyms()
+{
+    return std::make_unique<TraceKallsymsContent>(traceFileFd_.GetFd(), traceFilePath_, true);
+}
+
 std::unique_ptr<ITraceCpuRawRead> TraceSourceHMFactory::GetTraceCpuRawRead(const TraceDumpRequest& request)
 {
     return std::make_unique<TraceCpuRawReadHM>(request);
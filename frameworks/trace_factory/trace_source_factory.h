@@ -41,10 +41,16 @@ public:
     virtual std::unique_ptr<TraceEventFmtContent> GetTraceEventFmt() = 0;
     virtual std::unique_ptr<TraceCmdLinesContent> GetTraceCmdLines() = 0;
     virtual std::unique_ptr<TraceTgidsContent> GetTraceTgids() = 0;
+    virtual std::unique_ptr<TraceSectionTableContent> GetTraceSectionTable() = 0;
+    virtual std::unique_ptr<TraceMetadataRefContent> GetTraceMetadataRef() = 0;
+    virtual std::unique_ptr<TraceKallsymsContent> GetTraceKallsyms() = 0;
     virtual std::unique_ptr<ITraceCpuRawRead> GetTraceCpuRawRead(const TraceDumpRequest& request) = 0;
     virtual std::unique_ptr<ITraceCpuRawWrite> GetTraceCpuRawWrite(const uint64_t taskId) = 0;
     virtual const std::string& GetTraceFilePath();
     virtual bool UpdateTraceFile(const std::string& traceFilePath);
+    bool IsTraceFileExist();
+    bool PreallocateTraceFile(const int64_t fileSize);
+    bool TrimTraceFile();
 protected:
     SmartFd traceFileFd_;
     std::string traceFilePath_;
@@ -64,6 +70,9 @@ public:
     std::unique_ptr<TraceEventFmtContent> GetTraceEventFmt() override;
     std::unique_ptr<TraceCmdLinesContent> GetTraceCmdLines() override;
     std::unique_ptr<TraceTgidsContent> GetTraceTgids() override;
+    std::unique_ptr<TraceSectionTableContent> GetTraceSectionTable() override;
+    std::unique_ptr<TraceMetadataRefContent> GetTraceMetadataRef() override;
+    std::unique_ptr<TraceKallsymsContent> GetTraceKallsyms() override;
     std::unique_ptr<ITraceCpuRawRead> GetTraceCpuRawRead(const TraceDumpRequest& request) override;
     std::unique_ptr<ITraceCpuRawWrite> GetTraceCpuRawWrite(const uint64_t taskId) override;
 };
@@ -82,6 +91,9 @@ public:
     std::unique_ptr<TraceEventFmtContent> GetTraceEventFmt() override;
     std::unique_ptr<TraceCmdLinesContent> GetTraceCmdLines() override;
     std::unique_ptr<TraceTgidsContent> GetTraceTgids() override;
+    std::unique_ptr<TraceSectionTableContent> GetTraceSectionTable() override;
+    std::unique_ptr<TraceMetadataRefContent> GetTraceMetadataRef() override;
+    std::unique_ptr<TraceKallsymsContent> GetTraceKallsyms() override;
     std::unique_ptr<ITraceCpuRawRead> GetTraceCpuRawRead(const TraceDumpRequest& request) override;
     std::unique_ptr<ITraceCpuRawWrite> GetTraceCpuRawWrite(const uint64_t taskId) override;
 };
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace_buffer_waiter.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sstream>
+#include <string>
+#include <sys/epoll.h>
+#include <thread>
+
+#include "common_define.h"
+#include "common_utils.h"
+#include "hilog/log.h"
+#include "hitrace_option_util.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+#ifdef LOG_DOMAIN
+#undef LOG_DOMAIN
+#define LOG_DOMAIN 0xD002D33
+#endif
+#ifdef LOG_TAG
+#undef LOG_TAG
+#define LOG_TAG "HitraceBufferWaiter"
+#endif
+
+namespace {
+const char* const STATS_OVERRUN = "overrun:";
+const char* const STATS_DROPPED_EVENTS = "dropped events:";
+
+uint64_t GetStatsValue(const std::string& line, const std::string& key)
+{
+    uint64_t value = 0;
+    if (line.compare(0, key.size(), key) != 0) {
+        return value;
+    }
+    size_t begin = line.find_first_not_of(' ', key.size());
+    if (begin == std::string::npos || !StringToUint64(line.substr(begin), value)) {
+        return 0;
+    }
+    return value;
+}
+}
+
+TraceBufferWaiter::TraceBufferWaiter(const int maxLatencyMs, const int minIntervalMs)
+    : maxLatencyMs_(maxLatencyMs), minIntervalMs_(minIntervalMs), lastWakeup_(std::chrono::steady_clock::now())
+{
+    if (!InitEpoll()) {
+        HILOG_INFO(LOG_CORE, "TraceBufferWaiter: trace_pipe_raw is not pollable, wait %{public}d ms per round.",
+            maxLatencyMs_);
+        epollFd_ = SmartFd();
+        rawFds_.clear();
+    }
+}
+
+bool TraceBufferWaiter::InitEpoll()
+{
+    if (IsHmKernel()) {
+        return false;
+    }
+    epollFd_ = SmartFd(epoll_create1(EPOLL_CLOEXEC));
+    if (!epollFd_) {
+        HILOG_WARN(LOG_CORE, "TraceBufferWaiter: epoll_create1 failed, errno(%{public}d).", errno);
+        return false;
+    }
+    int cpuNums = GetCpuProcessors();
+    for (int cpuIdx = 0; cpuIdx < cpuNums; cpuIdx++) {
+        std::string path = GetTraceRootPath() + "per_cpu/cpu" + std::to_string(cpuIdx) + "/trace_pipe_raw";
+        // never read through this fd, it only reports the fill level of the ring buffer of the cpu.
+        SmartFd rawFd(open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC));
+        if (!rawFd) {
+            HILOG_WARN(LOG_CORE, "TraceBufferWaiter: open %{public}s failed, errno(%{public}d).", path.c_str(), errno);
+            return false;
+        }
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u32 = static_cast<uint32_t>(cpuIdx);
+        if (epoll_ctl(epollFd_.GetFd(), EPOLL_CTL_ADD, rawFd.GetFd(), &event) < 0) {
+            return false;
+        }
+        rawFds_.emplace_back(std::move(rawFd));
+    }
+    return !rawFds_.empty();
+}
+
+bool TraceBufferWaiter::IsPollable() const
+{
+    return static_cast<bool>(epollFd_);
+}
+
+void TraceBufferWaiter::Wait()
+{
+    if (!epollFd_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(maxLatencyMs_));
+        lastWakeup_ = std::chrono::steady_clock::now();
+        return;
+    }
+    std::vector<struct epoll_event> events(rawFds_.size());
+    int ret = TEMP_FAILURE_RETRY(epoll_wait(epollFd_.GetFd(), events.data(), static_cast<int>(events.size()),
+        maxLatencyMs_));
+    if (ret < 0) {
+        HILOG_ERROR(LOG_CORE, "TraceBufferWaiter: epoll_wait failed, errno(%{public}d), stop polling.", errno);
+        epollFd_ = SmartFd();
+        rawFds_.clear();
+    }
+    for (int i = 0; i < ret; i++) {
+        if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+            HILOG_WARN(LOG_CORE, "TraceBufferWaiter: cpu%{public}u trace_pipe_raw hang up, stop polling.",
+                events[i].data.u32);
+            epollFd_ = SmartFd();
+            rawFds_.clear();
+            break;
+        }
+    }
+    // a cpu writing faster than the drain keeps its fd ready, drain it at most once per minIntervalMs.
+    auto nextWakeup = lastWakeup_ + std::chrono::milliseconds(minIntervalMs_);
+    auto now = std::chrono::steady_clock::now();
+    if (now < nextWakeup) {
+        std::this_thread::sleep_for(nextWakeup - now);
+    }
+    lastWakeup_ = std::chrono::steady_clock::now();
+}
+
+uint64_t TraceBufferWaiter::GetLostEvents()
+{
+    if (IsHmKernel()) {
+        return 0;
+    }
+    uint64_t lostEvents = 0;
+    int cpuNums = GetCpuProcessors();
+    for (int cpuIdx = 0; cpuIdx < cpuNums; cpuIdx++) {
+        std::string stats = ReadFile("per_cpu/cpu" + std::to_string(cpuIdx) + "/stats", GetTraceRootPath());
+        std::istringstream statsStream(stats);
+        std::string line;
+        while (std::getline(statsStream, line)) {
+            lostEvents += GetStatsValue(line, STATS_OVERRUN) + GetStatsValue(line, STATS_DROPPED_EVENTS);
+        }
+    }
+    return lostEvents;
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
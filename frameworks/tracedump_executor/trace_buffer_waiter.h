@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRACE_BUFFER_WAITER_H
+#define TRACE_BUFFER_WAITER_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "smart_fd.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+/**
+ * Blocks the record and cache loops until a cpu ring buffer crosses the buffer_percent watermark of tracefs,
+ * or until maxLatencyMs passed so that the data of slow cpus is still drained in time.
+ * Falls back to a plain sleep of maxLatencyMs when trace_pipe_raw can not be polled.
+ */
+class TraceBufferWaiter {
+public:
+    TraceBufferWaiter(const int maxLatencyMs, const int minIntervalMs);
+    ~TraceBufferWaiter() = default;
+
+    void Wait();
+    bool IsPollable() const;
+    // overrun and dropped events of all the cpu ring buffers, 0 if tracefs does not report them.
+    static uint64_t GetLostEvents();
+
+private:
+    bool InitEpoll();
+
+    int maxLatencyMs_ = 0;
+    int minIntervalMs_ = 0;
+    SmartFd epollFd_;
+    std::vector<SmartFd> rawFds_;
+    std::chrono::steady_clock::time_point lastWakeup_;
+};
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
+#endif // TRACE_BUFFER_WAITER_H
@@ -15,8 +15,14 @@
 
 #include "trace_dump_executor.h"
 
+#include <algorithm>
+#include <chrono>
+#include <climits>
 #include <securec.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/prctl.h>
+#include <thread>
 #include <unistd.h>
 
 #include "common_define.h"
@@ -24,8 +30,11 @@
 #include "file_ageing_utils.h"
 #include "hitrace_option_util.h"
 #include "hilog/log.h"
+#include "trace_buffer_waiter.h"
 #include "trace_dump_state.h"
 #include "trace_file_utils.h"
+#include "trace_flight_recorder.h"
+#include "trace_metadata_sidecar.h"
 #include "trace_strategy_factory.h"
 
 namespace OHOS {
@@ -42,7 +51,9 @@ namespace Hitrace {
 namespace {
 constexpr int BYTE_PER_KB = 1024;
 constexpr int READ_TIMEOUT_MS = 200;
-constexpr int MONITOR_EMPTY_LOOP_COUNT = 15;
+constexpr int MONITOR_TICK_MS = 1000; // wake up every second to check the sync return timeout of tasks
+constexpr int MONITOR_IDLE_TIMEOUT_MS = 15 * 1000; // 15 : the dump process exits after 15 seconds without task
+constexpr int MONITOR_EPOLL_EVENTS = 2; // task submit pipe and task event fd
 #ifdef HITRACE_UNITTEST
 constexpr int DEFAULT_CACHE_FILE_SIZE = 15 * 1024;
 #else
@@ -51,9 +62,27 @@ constexpr int DEFAULT_CACHE_FILE_SIZE = 150 * 1024;
 constexpr uint64_t SYNC_RETURN_TIMEOUT_NS = 5000000000; // 5s
 constexpr int64_t ASYNC_DUMP_FILE_SIZE_ADDITION = 1024 * 1024; // 1MB
 constexpr int MAX_WRITE_RETRY = 10;
+constexpr uint64_t FLIGHT_RECORDER_WINDOW_NS = 60 * S_TO_NS; // in-memory cache trace covers the last minute
+constexpr int FLIGHT_DRAIN_MAX_LATENCY_MS = 1000;
+constexpr int FLIGHT_DRAIN_MIN_INTERVAL_MS = 10;
 
 static bool g_isRootVer = IsRootVersion();
 
+bool AddFdToEpollSet(const int epollFd, const int fd)
+{
+    if (fd < 0) {
+        return false;
+    }
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        HILOG_ERROR(LOG_CORE, "AddFdToEpollSet: epoll_ctl failed, errno(%{public}d)", errno);
+        return false;
+    }
+    return true;
+}
+
 std::vector<std::string> FilterLoopTraceResult(const std::vector<TraceFileInfo>& looptraceFiles)
 {
     std::vector<std::string> outputFiles = {};
@@ -111,6 +140,8 @@ bool TraceDumpExecutor::StartDumpTraceLoop(const TraceDumpParam& param, const st
             FileAgeingUtils::HandleAgeing(loopTraceFiles_, param.type, param.cacheTotalFileSizeLmt);
         }
         std::string traceFile = GenerateTraceFileName(param.type, outputPath);
+        // a metadata sidecar goes with the last aged slice that refers to it.
+        RemoveUnusedMetadataSidecars(traceFile.substr(0, traceFile.rfind('/') + 1));
         if (DoDumpTraceLoop(param, traceFile, true)) {
             std::lock_guard<std::mutex> lck(traceFileMutex_);
             loopTraceFiles_.emplace_back(traceFile);
@@ -131,11 +162,17 @@ std::vector<std::string> TraceDumpExecutor::StopDumpTraceLoop()
 
 bool TraceDumpExecutor::StartCacheTraceLoop(const TraceDumpParam& param)
 {
+    if (param.cacheInMemory) {
+        bool ret = DoFlightRecordLoop(param);
+        TraceDumpState::GetInstance().EndLoopDumpSelf();
+        return ret;
+    }
     while (TraceDumpState::GetInstance().IsLoopDumpRunning()) {
         auto traceFile = GenerateTraceFileName(param.type);
         if (DoDumpTraceLoop(param, traceFile, true)) {
             std::lock_guard<std::mutex> cacheLock(traceFileMutex_);
             ClearCacheTraceFileBySize(cacheTraceFiles_, param.cacheTotalFileSizeLmt);
+            RemoveUnusedMetadataSidecars(traceFile.substr(0, traceFile.rfind('/') + 1));
             HILOG_INFO(LOG_CORE, "ProcessCacheTask: save cache file.");
         } else {
             break;
@@ -157,8 +194,12 @@ TraceDumpRet TraceDumpExecutor::DumpTrace(const TraceDumpParam& param, const std
     return DumpTraceInner(param, traceFile);
 }
 
-std::vector<TraceFileInfo> TraceDumpExecutor::GetCacheTraceFiles()
+std::vector<TraceFileInfo> TraceDumpExecutor::GetCacheTraceFiles(const uint64_t traceStartTime,
+    const uint64_t traceEndTime)
 {
+    if (TraceFlightRecorder::GetInstance().IsRunning()) {
+        return DumpFlightRecorder(traceStartTime, traceEndTime);
+    }
     TraceDumpState::GetInstance().InterruptCache();
     std::vector<TraceFileInfo> cacheFiles;
     {
@@ -169,6 +210,24 @@ std::vector<TraceFileInfo> TraceDumpExecutor::GetCacheTraceFiles()
     return cacheFiles;
 }
 
+bool TraceDumpExecutor::PopTraceDumpTaskLocked(std::deque<uint64_t>& taskQueue,
+    std::initializer_list<TraceDumpStatus> states, TraceDumpTask& task)
+{
+    while (!taskQueue.empty()) {
+        uint64_t taskId = taskQueue.front();
+        taskQueue.pop_front();
+        auto it = traceDumpTasks_.find(taskId);
+        if (it == traceDumpTasks_.end()) {
+            continue;
+        }
+        if (std::find(states.begin(), states.end(), it->second.status) != states.end()) {
+            task = it->second;
+            return true;
+        }
+    }
+    return false;
+}
+
 void TraceDumpExecutor::ReadRawTraceLoop()
 {
     const std::string threadName = "ReadRawTraceLoop";
@@ -180,21 +239,12 @@ void TraceDumpExecutor::ReadRawTraceLoop()
         {
             std::unique_lock<std::mutex> lck(taskQueueMutex_);
             readCondVar_.wait(lck, [this]() {
-                return !TraceDumpState::GetInstance().IsAsyncReadContinue() ||
-                    std::any_of(traceDumpTaskVec_.begin(), traceDumpTaskVec_.end(), [](const TraceDumpTask& task) {
-                        return task.status == TraceDumpStatus::START && task.code == TraceErrorCode::UNSET;
-                    });
+                return !TraceDumpState::GetInstance().IsAsyncReadContinue() || !readTaskQueue_.empty();
             });
             if (!TraceDumpState::GetInstance().IsAsyncReadContinue()) {
                 break;
             }
-            auto it = std::find_if(traceDumpTaskVec_.begin(), traceDumpTaskVec_.end(), [](const TraceDumpTask& task) {
-                return task.status == TraceDumpStatus::START && task.code == TraceErrorCode::UNSET;
-            });
-            if (it != traceDumpTaskVec_.end()) {
-                currentTask = *it;
-                hasTask = true;
-            }
+            hasTask = PopTraceDumpTaskLocked(readTaskQueue_, { TraceDumpStatus::START }, currentTask);
         }
         if (hasTask) {
             HILOG_INFO(LOG_CORE, "ReadRawTraceLoop : start read trace of taskid[%{public}" PRIu64 "]",
@@ -202,11 +252,14 @@ void TraceDumpExecutor::ReadRawTraceLoop()
             if (!DoReadRawTrace(currentTask)) {
                 HILOG_WARN(LOG_CORE, "ReadRawTraceLoop : do read raw trace failed, taskid[%{public}" PRIu64 "]",
                     currentTask.time);
+                if (currentTask.status == TraceDumpStatus::START) {
+                    // the task failed before reading anything, let the monitor return the error.
+                    currentTask.status = TraceDumpStatus::READ_DONE;
+                    UpdateTraceDumpTask(currentTask);
+                }
             } else {
                 HILOG_INFO(LOG_CORE, "ReadRawTraceLoop : read raw trace done, taskid[%{public}" PRIu64 "]",
                     currentTask.time);
-                std::lock_guard<std::mutex> lck(taskQueueMutex_);
-                writeCondVar_.notify_one();
             }
         }
     }
@@ -224,27 +277,24 @@ void TraceDumpExecutor::WriteTraceLoop()
         {
             std::unique_lock<std::mutex> lck(taskQueueMutex_);
             writeCondVar_.wait(lck, [this]() {
-                return !TraceDumpState::GetInstance().IsAsyncWriteContinue() ||
-                    std::any_of(traceDumpTaskVec_.begin(), traceDumpTaskVec_.end(), [](const TraceDumpTask& task) {
-                        return task.status == TraceDumpStatus::READ_DONE || task.status == TraceDumpStatus::WAIT_WRITE;
-                    });
+                return !TraceDumpState::GetInstance().IsAsyncWriteContinue() || !writeTaskQueue_.empty();
             });
             if (!TraceDumpState::GetInstance().IsAsyncWriteContinue()) {
                 break;
             }
-            auto it = std::find_if(traceDumpTaskVec_.begin(), traceDumpTaskVec_.end(), [](const TraceDumpTask& task) {
-                return task.status == TraceDumpStatus::READ_DONE || task.status == TraceDumpStatus::WAIT_WRITE;
-            });
-            if (it != traceDumpTaskVec_.end()) {
-                currentTask = *it;
-                hasTask = true;
-            }
+            hasTask = PopTraceDumpTaskLocked(writeTaskQueue_,
+                { TraceDumpStatus::READ_DONE, TraceDumpStatus::WAIT_WRITE }, currentTask);
         }
         if (hasTask) {
             HILOG_INFO(LOG_CORE, "WriteTraceLoop : start write trace of taskid[%{public}" PRIu64 "]", currentTask.time);
             if (!DoWriteRawTrace(currentTask)) {
                 HILOG_WARN(LOG_CORE, "WriteTraceLoop : do write raw trace failed, taskid[%{public}" PRIu64 "]",
                     currentTask.time);
+                if (currentTask.status != TraceDumpStatus::WRITE_DONE) {
+                    // the task failed before writing anything, let the monitor return the error.
+                    currentTask.status = TraceDumpStatus::WRITE_DONE;
+                    UpdateTraceDumpTask(currentTask);
+                }
             } else {
                 HILOG_INFO(LOG_CORE, "WriteTraceLoop : write raw trace done, taskid[%{public}" PRIu64 "]",
                     currentTask.time);
@@ -254,14 +304,13 @@ void TraceDumpExecutor::WriteTraceLoop()
     HILOG_INFO(LOG_CORE, "WriteTraceLoop end.");
 }
 
-void TraceDumpExecutor::ProcessNewTask(std::shared_ptr<HitraceDumpPipe>& dumpPipe, int& sleepCnt)
+void TraceDumpExecutor::ProcessNewTask(std::shared_ptr<HitraceDumpPipe>& dumpPipe)
 {
     TraceDumpTask newTask;
     if (dumpPipe->ReadTraceTask(READ_TIMEOUT_MS, newTask)) {
         std::lock_guard<std::mutex> lck(taskQueueMutex_);
-        traceDumpTaskVec_.push_back(newTask);
-        readCondVar_.notify_one();
-        sleepCnt = 0;
+        traceDumpTasks_[newTask.time] = newTask;
+        EnqueueTraceDumpTaskLocked(newTask);
     }
 }
 
@@ -294,7 +343,6 @@ void TraceDumpExecutor::DoProcessTraceDumpTask(std::shared_ptr<HitraceDumpPipe>&
             if (dumpPipe->WriteSyncReturn(task)) {
                 task.hasSyncReturn = true;
                 task.status = TraceDumpStatus::WAIT_WRITE;
-                writeCondVar_.notify_one();
             }
         }
     }
@@ -305,46 +353,130 @@ void TraceDumpExecutor::DoProcessTraceDumpTask(std::shared_ptr<HitraceDumpPipe>&
     }
 }
 
+void TraceDumpExecutor::ProcessReturnTasks(std::shared_ptr<HitraceDumpPipe>& dumpPipe,
+    std::set<uint64_t>& returnTaskIds)
+{
+    std::lock_guard<std::mutex> lck(taskQueueMutex_);
+    while (!returnTaskQueue_.empty()) {
+        returnTaskIds.insert(returnTaskQueue_.front());
+        returnTaskQueue_.pop_front();
+    }
+    std::vector<TraceDumpTask> completedTasks;
+    for (auto it = returnTaskIds.begin(); it != returnTaskIds.end();) {
+        auto taskIt = traceDumpTasks_.find(*it);
+        if (taskIt == traceDumpTasks_.end()) {
+            it = returnTaskIds.erase(it);
+            continue;
+        }
+        DoProcessTraceDumpTask(dumpPipe, taskIt->second, completedTasks);
+        // a task which has returned synchronously comes back with its WRITE_DONE transition.
+        if (taskIt->second.status == TraceDumpStatus::WAIT_WRITE) {
+            it = returnTaskIds.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (const auto& task : completedTasks) {
+        returnTaskIds.erase(task.time);
+        traceDumpTasks_.erase(task.time);
+        EraseTaskFromQueuesLocked(task.time);
+    }
+}
+
+bool TraceDumpExecutor::WaitTraceDumpTaskEvent(const int epollFd, const int submitFd, const int timeoutMs)
+{
+    if (epollFd < 0) {
+        // no epoll available, poll the submit pipe on every tick.
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+        return true;
+    }
+    struct epoll_event events[MONITOR_EPOLL_EVENTS];
+    int ret = TEMP_FAILURE_RETRY(epoll_wait(epollFd, events, MONITOR_EPOLL_EVENTS, timeoutMs));
+    if (ret < 0) {
+        HILOG_ERROR(LOG_CORE, "WaitTraceDumpTaskEvent: epoll_wait failed, errno(%{public}d)", errno);
+        return false;
+    }
+    bool hasNewTask = false;
+    for (int i = 0; i < ret; i++) {
+        if (events[i].data.fd != submitFd) {
+            uint64_t eventCnt = 0;
+            TEMP_FAILURE_RETRY(read(events[i].data.fd, &eventCnt, sizeof(eventCnt)));
+            continue;
+        }
+        if (events[i].events & EPOLLIN) {
+            hasNewTask = true;
+        } else if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+            HILOG_WARN(LOG_CORE, "WaitTraceDumpTaskEvent: submit pipe hang up, stop watching it.");
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, submitFd, nullptr);
+        }
+    }
+    return hasNewTask;
+}
+
 void TraceDumpExecutor::TraceDumpTaskMonitor()
 {
     auto dumpPipe = std::make_shared<HitraceDumpPipe>(false);
-    int loopCnt = 0;
+    SmartFd eventFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+    SmartFd epollFd(epoll_create1(EPOLL_CLOEXEC));
+    if (!eventFd || !epollFd || !AddFdToEpollSet(epollFd.GetFd(), eventFd.GetFd()) ||
+        !AddFdToEpollSet(epollFd.GetFd(), dumpPipe->GetTaskSubmitFd())) {
+        HILOG_WARN(LOG_CORE, "TraceDumpTaskMonitor : event loop unavailable, fall back to polling.");
+        epollFd = SmartFd();
+    } else {
+        std::lock_guard<std::mutex> lck(taskQueueMutex_);
+        taskEventFd_ = eventFd.GetFd();
+    }
+    std::set<uint64_t> returnTaskIds;
+    auto idleSince = std::chrono::steady_clock::now();
     do {
-        std::vector<TraceDumpTask> completedTasks;
-        {
-            std::lock_guard<std::mutex> lck(taskQueueMutex_);
-            for (auto& task : traceDumpTaskVec_) {
-                DoProcessTraceDumpTask(dumpPipe, task, completedTasks);
-            }
-            // Remove completed tasks
-            for (const auto& task : completedTasks) {
-                auto it = std::remove_if(traceDumpTaskVec_.begin(), traceDumpTaskVec_.end(),
-                    [&task](const TraceDumpTask& t) { return t.time == task.time; });
-                traceDumpTaskVec_.erase(it, traceDumpTaskVec_.end());
-            }
-            if (!traceDumpTaskVec_.empty()) {
-                loopCnt = 0;
-            }
+        if (WaitTraceDumpTaskEvent(epollFd.GetFd(), dumpPipe->GetTaskSubmitFd(), MONITOR_TICK_MS)) {
+            ProcessNewTask(dumpPipe);
         }
-        // Check for new tasks
-        ProcessNewTask(dumpPipe, loopCnt);
-        sleep(1); // sleep 1s to wait for new tasks
-        loopCnt++;
-    } while (loopCnt < MONITOR_EMPTY_LOOP_COUNT || !IsTraceDumpTaskEmpty());
+        ProcessReturnTasks(dumpPipe, returnTaskIds);
+        if (!IsTraceDumpTaskEmpty()) {
+            idleSince = std::chrono::steady_clock::now();
+        }
+    } while (std::chrono::steady_clock::now() - idleSince < std::chrono::milliseconds(MONITOR_IDLE_TIMEOUT_MS));
     HILOG_INFO(LOG_CORE, "TraceDumpTaskMonitor : no task, dump process exit.");
     TraceDumpState::GetInstance().EndAsyncReadWrite();
     std::lock_guard<std::mutex> lck(taskQueueMutex_);
+    taskEventFd_ = -1;
     readCondVar_.notify_all();
     writeCondVar_.notify_all();
 }
 
+void TraceDumpExecutor::EnqueueTraceDumpTaskLocked(const TraceDumpTask& task)
+{
+    if (task.status == TraceDumpStatus::START && task.code == TraceErrorCode::UNSET) {
+        readTaskQueue_.push_back(task.time);
+        readCondVar_.notify_one();
+        return;
+    }
+    if (task.status == TraceDumpStatus::READ_DONE && task.code == TraceErrorCode::SUCCESS) {
+        writeTaskQueue_.push_back(task.time);
+        writeCondVar_.notify_one();
+    }
+    if (task.status == TraceDumpStatus::READ_DONE || task.status == TraceDumpStatus::WRITE_DONE) {
+        returnTaskQueue_.push_back(task.time);
+        if (taskEventFd_ >= 0) {
+            uint64_t event = 1;
+            TEMP_FAILURE_RETRY(write(taskEventFd_, &event, sizeof(event)));
+        }
+    }
+}
+
+void TraceDumpExecutor::EraseTaskFromQueuesLocked(const uint64_t time)
+{
+    for (auto* taskQueue : { &readTaskQueue_, &writeTaskQueue_, &returnTaskQueue_ }) {
+        taskQueue->erase(std::remove(taskQueue->begin(), taskQueue->end(), time), taskQueue->end());
+    }
+}
+
 void TraceDumpExecutor::RemoveTraceDumpTask(const uint64_t time)
 {
     std::lock_guard<std::mutex> lck(taskQueueMutex_);
-    auto it = std::remove_if(traceDumpTaskVec_.begin(), traceDumpTaskVec_.end(),
-        [time](const TraceDumpTask& task) { return task.time == time; });
-    if (it != traceDumpTaskVec_.end()) {
-        traceDumpTaskVec_.erase(it, traceDumpTaskVec_.end());
+    if (traceDumpTasks_.erase(time) > 0) {
+        EraseTaskFromQueuesLocked(time);
         HILOG_INFO(LOG_CORE, "EraseTraceDumpTask: task removed from task list.");
     } else {
         HILOG_WARN(LOG_CORE, "EraseTraceDumpTask: task not found in task list.");
@@ -354,51 +486,55 @@ void TraceDumpExecutor::RemoveTraceDumpTask(const uint64_t time)
 bool TraceDumpExecutor::UpdateTraceDumpTask(const TraceDumpTask& task)
 {
     std::lock_guard<std::mutex> lck(taskQueueMutex_);
-    for (auto& dumpTask : traceDumpTaskVec_) {
-        if (dumpTask.time == task.time) {
-            // attention: avoid updating hasSyncReturn field, it is only used in monitor thread.
-            dumpTask.code = task.code;
-            dumpTask.status = task.status;
-            dumpTask.fileSize = task.fileSize;
-            dumpTask.traceStartTime = task.traceStartTime;
-            dumpTask.traceEndTime = task.traceEndTime;
-            if (strcpy_s(dumpTask.outputFile, sizeof(dumpTask.outputFile), task.outputFile) != 0) {
-                HILOG_ERROR(LOG_CORE, "UpdateTraceDumpTask: strcpy_s failed.");
-            }
-            HILOG_INFO(LOG_CORE, "UpdateTraceDumpTask: task id: %{public}" PRIu64 ", status: %{public}hhu, "
-                "file: %{public}s, filesize: %{public}" PRId64 ".",
-                task.time, task.status, task.outputFile, task.fileSize);
-            return true;
-        }
+    auto it = traceDumpTasks_.find(task.time);
+    if (it == traceDumpTasks_.end()) {
+        HILOG_WARN(LOG_CORE, "UpdateTraceDumpTask: task[%{public}" PRIu64 "] not found in lists.", task.time);
+        return false;
     }
-    HILOG_WARN(LOG_CORE, "UpdateTraceDumpTask: task[%{public}" PRIu64 "] not found in lists.", task.time);
-    return false;
+    auto& dumpTask = it->second;
+    // attention: avoid updating hasSyncReturn field, it is only used in monitor thread.
+    dumpTask.code = task.code;
+    dumpTask.status = task.status;
+    dumpTask.fileSize = task.fileSize;
+    dumpTask.traceStartTime = task.traceStartTime;
+    dumpTask.traceEndTime = task.traceEndTime;
+    if (strcpy_s(dumpTask.outputFile, sizeof(dumpTask.outputFile), task.outputFile) != 0) {
+        HILOG_ERROR(LOG_CORE, "UpdateTraceDumpTask: strcpy_s failed.");
+    }
+    EnqueueTraceDumpTaskLocked(dumpTask);
+    HILOG_INFO(LOG_CORE, "UpdateTraceDumpTask: task id: %{public}" PRIu64 ", status: %{public}hhu, "
+        "file: %{public}s, filesize: %{public}" PRId64 ".",
+        task.time, task.status, task.outputFile, task.fileSize);
+    return true;
 }
 
 void TraceDumpExecutor::AddTraceDumpTask(const TraceDumpTask& task)
 {
     std::lock_guard<std::mutex> lck(taskQueueMutex_);
-    traceDumpTaskVec_.emplace_back(task);
-    readCondVar_.notify_one();
+    traceDumpTasks_[task.time] = task;
+    EnqueueTraceDumpTaskLocked(task);
     HILOG_INFO(LOG_CORE, "AddTraceDumpTask: task added to the list.");
 }
 
 void TraceDumpExecutor::ClearTraceDumpTask()
 {
     std::lock_guard<std::mutex> lck(taskQueueMutex_);
-    traceDumpTaskVec_.clear();
+    traceDumpTasks_.clear();
+    readTaskQueue_.clear();
+    writeTaskQueue_.clear();
+    returnTaskQueue_.clear();
 }
 
 bool TraceDumpExecutor::IsTraceDumpTaskEmpty()
 {
     std::lock_guard<std::mutex> lck(taskQueueMutex_);
-    return traceDumpTaskVec_.empty();
+    return traceDumpTasks_.empty();
 }
 
 size_t TraceDumpExecutor::GetTraceDumpTaskCount()
 {
     std::lock_guard<std::mutex> lck(taskQueueMutex_);
-    return traceDumpTaskVec_.size();
+    return traceDumpTasks_.size();
 }
 
 #ifdef HITRACE_UNITTEST
@@ -446,7 +582,13 @@ bool TraceDumpExecutor::DoDumpTraceLoop(const TraceDumpParam& param, std::string
         .limitFileSz = isLimited,
         .traceStartTime = param.traceStartTime,
         .traceEndTime = param.traceEndTime,
-        .cacheSliceDuration = param.cacheSliceDuration
+        .cacheSliceDuration = param.cacheSliceDuration,
+        .engine = param.engine,
+        .compressLevel = param.compressLevel,
+        .seenPidsOnly = param.seenPidsOnly,
+        .filterEventPids = param.filterEventPids,
+        .metadataSidecar = param.metadataSidecar,
+        .withKallsyms = param.withKallsyms
     };
     auto dumpRet = ExecuteDumpTrace(traceSourceFactory, request);
     HILOG_INFO(LOG_CORE, "DoDumpTraceLoop: ExecuteDumpTrace done, errorcode: %{public}d, tracefile: %{public}s",
@@ -473,6 +615,57 @@ bool TraceDumpExecutor::DoDumpTraceLoop(const TraceDumpParam& param, std::string
     return true;
 }
 
+bool TraceDumpExecutor::DoFlightRecordLoop(const TraceDumpParam& param)
+{
+    if (Hitrace::GetTraceRootPath().empty()) {
+        HILOG_ERROR(LOG_CORE, "DoFlightRecordLoop : Trace fs path is empty.");
+        return false;
+    }
+    MarkClockSync(Hitrace::GetTraceRootPath());
+    auto& flightRecorder = TraceFlightRecorder::GetInstance();
+    flightRecorder.Start(static_cast<size_t>(param.cacheTotalFileSizeLmt), FLIGHT_RECORDER_WINDOW_NS);
+    TraceBufferWaiter bufferWaiter(FLIGHT_DRAIN_MAX_LATENCY_MS, FLIGHT_DRAIN_MIN_INTERVAL_MS);
+    bool ret = true;
+    while (TraceDumpState::GetInstance().IsLoopDumpRunning()) {
+        bufferWaiter.Wait();
+        if (!flightRecorder.DrainTracePipeRaw()) {
+            HILOG_ERROR(LOG_CORE, "DoFlightRecordLoop : drain trace_pipe_raw failed.");
+            ret = false;
+            break;
+        }
+    }
+    flightRecorder.Stop();
+    return ret;
+}
+
+std::vector<TraceFileInfo> TraceDumpExecutor::DumpFlightRecorder(const uint64_t traceStartTime,
+    const uint64_t traceEndTime)
+{
+    std::vector<TraceFileInfo> cacheFiles;
+    TraceDumpParam param = {
+        .type = TraceDumpType::TRACE_SNAPSHOT,
+        .traceStartTime = traceStartTime,
+        .traceEndTime = traceEndTime,
+        .engine = TraceDumpEngine::ENGINE_FLIGHT_RECORDER
+    };
+    std::string traceFile = GenerateTraceFileName(TraceDumpType::TRACE_CACHE);
+    auto dumpRet = DumpTraceInner(param, traceFile);
+    if (dumpRet.code != TraceErrorCode::SUCCESS) {
+        HILOG_ERROR(LOG_CORE, "DumpFlightRecorder : dump failed, errorcode: %{public}d.",
+            static_cast<uint8_t>(dumpRet.code));
+        RemoveFile(traceFile);
+        return cacheFiles;
+    }
+    TraceFileInfo traceFileInfo;
+    TimestampRange range{dumpRet.traceStartTime, dumpRet.traceEndTime};
+    if (!SetFileInfo(true, dumpRet.outputFile, range, traceFileInfo)) {
+        RemoveFile(dumpRet.outputFile);
+        return cacheFiles;
+    }
+    cacheFiles.emplace_back(traceFileInfo);
+    return cacheFiles;
+}
+
 TraceDumpRet TraceDumpExecutor::DumpTraceInner(const TraceDumpParam& param, const std::string& traceFile)
 {
     std::shared_ptr<ITraceSourceFactory> traceSourceFactory = nullptr;
@@ -489,7 +682,11 @@ TraceDumpRet TraceDumpExecutor::DumpTraceInner(const TraceDumpParam& param, cons
     TraceDumpRequest request = {
         .type = param.type,
         .traceStartTime = param.traceStartTime,
-        .traceEndTime = param.traceEndTime
+        .traceEndTime = param.traceEndTime,
+        .engine = param.engine,
+        .seenPidsOnly = param.seenPidsOnly,
+        .filterEventPids = param.filterEventPids,
+        .withKallsyms = param.withKallsyms
     };
     return ExecuteDumpTrace(traceSourceFactory, request);
 }
@@ -508,8 +705,13 @@ bool TraceDumpExecutor::DoReadRawTrace(TraceDumpTask& task)
         traceSourceFactory = std::make_shared<TraceSourceLinuxFactory>("");
     }
 
+    // keep the newest pages within the limit, ASYNC_DUMP_FILE_SIZE_ADDITION is left for the other contents.
+    int64_t rawSizeBudget = std::min(task.fileSizeLimit - ASYNC_DUMP_FILE_SIZE_ADDITION,
+        static_cast<int64_t>(INT_MAX));
     TraceDumpRequest request = {
         .type = TraceDumpType::TRACE_ASYNC_READ,
+        .fileSize = rawSizeBudget > 0 ? static_cast<int>(rawSizeBudget) : 0,
+        .limitFileSz = rawSizeBudget > 0,
         .traceStartTime = task.traceStartTime,
         .traceEndTime = task.traceEndTime,
         .taskId = task.time
@@ -517,6 +719,7 @@ bool TraceDumpExecutor::DoReadRawTrace(TraceDumpTask& task)
     auto ret = ExecuteDumpTrace(traceSourceFactory, request);
     task.code = ret.code;
     task.fileSize = ret.fileSize + ASYNC_DUMP_FILE_SIZE_ADDITION;
+    task.isFileSizeOverLimit = ret.isFileSizeOverLimit;
     if (strncpy_s(task.outputFile, TRACE_FILE_LEN, ret.outputFile, TRACE_FILE_LEN - 1) != 0) {
         HILOG_ERROR(LOG_CORE, "DoReadRawTrace: strncpy_s failed.");
     }
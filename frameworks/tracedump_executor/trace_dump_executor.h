@@ -16,7 +16,11 @@
 #ifndef TRACE_DUMP_EXECUTOR_H
 #define TRACE_DUMP_EXECUTOR_H
 
+#include <condition_variable>
+#include <deque>
+#include <map>
 #include <mutex>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -39,6 +43,13 @@ struct TraceDumpParam {
     uint64_t traceEndTime = std::numeric_limits<uint64_t>::max();
     uint64_t cacheTotalFileSizeLmt = 0;
     uint64_t cacheSliceDuration = 30; // 30 : 30 seconds as default cache trace slice duration
+    TraceDumpEngine engine = TraceDumpEngine::ENGINE_DEFAULT;
+    bool cacheInMemory = false; // keep cache trace in the flight recorder, files are only written on request
+    int compressLevel = 0; // zlib level of the cpu raw sections of record and cache files, 0 : not compressed
+    bool seenPidsOnly = false; // cmdlines and tgids only list the tasks of the dumped cpu raw pages
+    bool filterEventPids = false; // drop the events of the tasks out of the trace filter pids from cpu raw pages
+    bool metadataSidecar = false; // keep the static sections of record and cache slices in a shared sidecar file
+    bool withKallsyms = false; // write the kernel symbols of the addresses in the dumped cpu raw pages
 };
 
 class TraceDumpExecutor : public DelayedRefSingleton<TraceDumpExecutor> {
@@ -52,7 +63,9 @@ public:
     void StopCacheTraceLoop();
     TraceDumpRet DumpTrace(const TraceDumpParam& param, const std::string& outputPath = "");
 
-    std::vector<TraceFileInfo> GetCacheTraceFiles();
+    // traceStartTime and traceEndTime are boot time in ns, only used by the flight recorder of in-memory cache.
+    std::vector<TraceFileInfo> GetCacheTraceFiles(const uint64_t traceStartTime = 0,
+        const uint64_t traceEndTime = std::numeric_limits<uint64_t>::max());
     void ReadRawTraceLoop();
     void WriteTraceLoop();
     void TraceDumpTaskMonitor();
@@ -72,16 +85,30 @@ private:
     TraceDumpRet ExecuteDumpTrace(std::shared_ptr<ITraceSourceFactory> traceSourceFactory,
         const TraceDumpRequest& request);
     bool DoDumpTraceLoop(const TraceDumpParam& param, std::string& traceFile, bool isLimited);
+    bool DoFlightRecordLoop(const TraceDumpParam& param);
+    std::vector<TraceFileInfo> DumpFlightRecorder(const uint64_t traceStartTime, const uint64_t traceEndTime);
     TraceDumpRet DumpTraceInner(const TraceDumpParam& param, const std::string& traceFile);
     bool DoReadRawTrace(TraceDumpTask& task);
     bool DoWriteRawTrace(TraceDumpTask& task);
     void DoProcessTraceDumpTask(std::shared_ptr<HitraceDumpPipe>& dumpPipe, TraceDumpTask& task,
         std::vector<TraceDumpTask>& completedTasks);
-    void ProcessNewTask(std::shared_ptr<HitraceDumpPipe>& dumpPipe, int& sleepCnt);
+    void ProcessNewTask(std::shared_ptr<HitraceDumpPipe>& dumpPipe);
+    void ProcessReturnTasks(std::shared_ptr<HitraceDumpPipe>& dumpPipe, std::set<uint64_t>& returnTaskIds);
+    bool WaitTraceDumpTaskEvent(const int epollFd, const int submitFd, const int timeoutMs);
+    void EnqueueTraceDumpTaskLocked(const TraceDumpTask& task);
+    void EraseTaskFromQueuesLocked(const uint64_t time);
+    bool PopTraceDumpTaskLocked(std::deque<uint64_t>& taskQueue, std::initializer_list<TraceDumpStatus> states,
+        TraceDumpTask& task);
 
     std::vector<TraceFileInfo> loopTraceFiles_ = {};
     std::vector<TraceFileInfo> cacheTraceFiles_ = {};
-    std::vector<TraceDumpTask> traceDumpTaskVec_ = {};
+    // all tasks by task id, the queues below only hold the ids of the tasks waiting in each state.
+    std::map<uint64_t, TraceDumpTask> traceDumpTasks_ = {};
+    std::deque<uint64_t> readTaskQueue_ = {};
+    std::deque<uint64_t> writeTaskQueue_ = {};
+    std::deque<uint64_t> returnTaskQueue_ = {};
+    // eventfd of the task monitor, signalled on every status transition which needs a return.
+    int taskEventFd_ = -1;
     std::mutex traceFileMutex_;
     std::mutex taskQueueMutex_;
     std::condition_variable readCondVar_;
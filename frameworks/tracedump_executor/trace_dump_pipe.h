@@ -40,6 +40,7 @@ public:
     bool ReadTraceTask(const int timeoutMs, TraceDumpTask& task);
     bool WriteSyncReturn(TraceDumpTask& task);
     bool WriteAsyncReturn(TraceDumpTask& task);
+    int GetTaskSubmitFd() const { return taskSubmitFd_.GetFd(); }
 
 private:
     void InitPipeFd();
@@ -23,8 +23,11 @@
 #include "common_utils.h"
 #include "trace_context.h"
 #include "hilog/log.h"
+#include "hitrace_option_util.h"
+#include "trace_buffer_waiter.h"
 #include "trace_dump_state.h"
 #include "trace_file_utils.h"
+#include "trace_metadata_cache.h"
 #include "trace_strategy_factory.h"
 
 namespace OHOS {
@@ -41,11 +44,13 @@ namespace Hitrace {
 
 namespace {
 constexpr int MAX_NEW_TRACE_FILE_LIMIT = 5;
+constexpr int DRAIN_MAX_LATENCY_MS = 1000; // drain the cpus which never reach buffer_percent at least once per second
+constexpr int DRAIN_MIN_INTERVAL_MS = 10;
 
 bool IsGenerateNewFile(std::shared_ptr<ITraceSourceFactory> traceSourceFactory,
     const TraceDumpType traceType, int& count)
 {
-    if (access(traceSourceFactory->GetTraceFilePath().c_str(), F_OK) == 0) {
+    if (traceSourceFactory->IsTraceFileExist()) {
         return false;
     }
     if (count > MAX_NEW_TRACE_FILE_LIMIT) {
@@ -59,6 +64,35 @@ bool IsGenerateNewFile(std::shared_ptr<ITraceSourceFactory> traceSourceFactory,
     return true;
 }
 
+// the threads of the filtered processes, whose events are kept by the drain of the cpu raw pages.
+std::shared_ptr<TracePagePids> GetFilterEventPids(const TraceFilterContext& filterContext)
+{
+    auto eventPids = std::make_shared<TracePagePids>(GetTraceRootPath() + "events/header_page");
+    if (!eventPids->IsValid()) {
+        return nullptr;
+    }
+    filterContext.TraverseFilterPid([&eventPids](const int pid) { eventPids->Add(pid); });
+    filterContext.TraverseTGidsContent([&eventPids](const std::pair<int, int>& tgid) { eventPids->Add(tgid.first); });
+    if (eventPids->IsEmpty()) {
+        HILOG_WARN(LOG_CORE, "GetFilterEventPids: no task to keep, the events are not filtered.");
+        return nullptr;
+    }
+    HILOG_INFO(LOG_CORE, "GetFilterEventPids: keep the events of %{public}zu tasks.", eventPids->GetCount());
+    return eventPids;
+}
+
+// the addresses of the events are collected through the layouts of the event formats prepared for the session.
+std::shared_ptr<TraceSeenAddrs> GetSeenAddrs()
+{
+    auto eventFormats = TraceMetadataCache::GetInstance().GetPreparedEventFormats();
+    if (eventFormats == nullptr) {
+        HILOG_WARN(LOG_CORE, "GetSeenAddrs: no event formats, the kallsyms section is not written.");
+        return nullptr;
+    }
+    auto seenAddrs = std::make_shared<TraceSeenAddrs>(GetTraceRootPath() + "events/header_page", *eventFormats);
+    return seenAddrs->IsValid() ? seenAddrs : nullptr;
+}
+
 template<typename T>
 void SafeWriteTraceContent(const std::unique_ptr<T>& component, const std::string& componentName)
 {
@@ -68,13 +102,16 @@ void SafeWriteTraceContent(const std::unique_ptr<T>& component, const std::strin
 }
 
 template<typename T, typename F>
-bool SafeGetTraceContent(std::unique_ptr<T>& target, F&& getter, const std::string& componentName)
+bool SafeGetTraceContent(std::unique_ptr<T>& target, F&& getter, const std::string& componentName,
+    const TraceDumpRequest& request)
 {
     target = std::forward<F>(getter)(); // perfect forwarding
     if (target == nullptr) {
         HILOG_ERROR(LOG_CORE, "CreateTraceContentPtr: %s failed.", componentName.c_str());
         return false;
     }
+    target->SetBufferPool(request.bufferPool);
+    target->SetProcessTable(request.processTable);
     return true;
 }
 } // namespace
@@ -86,13 +123,26 @@ TraceDumpRet ITraceDumpStrategy::Execute(std::shared_ptr<ITraceSourceFactory> tr
     if (filterContext != nullptr) {
         filterContext->FilterTraceContent();
     }
+    // the staging buffers of the content writers are only mapped while the session is active.
+    TraceDumpRequest sessionRequest = request;
+    sessionRequest.bufferPool = std::make_shared<TraceDumpBufferPool>(CONTENT_BUFFER_SIZE, CONTENT_BUFFER_MAX_COUNT);
+    if (request.seenPidsOnly) {
+        auto seenPids = std::make_shared<TraceSeenPids>(GetTraceRootPath() + "events/header_page");
+        sessionRequest.seenPids = seenPids->IsValid() ? seenPids : nullptr;
+    }
+    if (request.filterEventPids && filterContext != nullptr) {
+        sessionRequest.eventPids = GetFilterEventPids(*filterContext);
+    }
+    if (request.withKallsyms) {
+        sessionRequest.seenAddrs = GetSeenAddrs();
+    }
     int newFileCount = 1;
     TraceDumpRet ret;
     do {
-        if (!ProcessTraceDumpIteration(traceSourceFactory, request, ret, newFileCount)) {
+        if (!ProcessTraceDumpIteration(traceSourceFactory, sessionRequest, ret, newFileCount)) {
             break;
         }
-    } while (ShouldContinueWithNewFile(traceSourceFactory, request, newFileCount));
+    } while (ShouldContinueWithNewFile(traceSourceFactory, sessionRequest, newFileCount));
 
     return ret;
 }
@@ -100,8 +150,12 @@ TraceDumpRet ITraceDumpStrategy::Execute(std::shared_ptr<ITraceSourceFactory> tr
 bool ITraceDumpStrategy::ProcessTraceDumpIteration(std::shared_ptr<ITraceSourceFactory> traceSourceFactory,
     const TraceDumpRequest& request, TraceDumpRet& ret, int& newFileCount)
 {
+    // /proc is scanned once for each file, the contents of the file share the scan, so a file rolled over later in
+    // the session lists the processes alive when it is written.
+    TraceDumpRequest fileRequest = request;
+    fileRequest.processTable = std::make_shared<TraceProcessTable>();
     TraceContentPtr traceContentPtr;
-    if (!InitializeTraceContent(traceSourceFactory, request, traceContentPtr)) {
+    if (!InitializeTraceContent(traceSourceFactory, fileRequest, traceContentPtr)) {
         HILOG_ERROR(LOG_CORE,
             "InitializeTraceContent failed, dumpType=%{public}u taskId=%{public}" PRIu64,
             static_cast<unsigned>(request.type), request.taskId);
@@ -109,12 +163,20 @@ bool ITraceDumpStrategy::ProcessTraceDumpIteration(std::shared_ptr<ITraceSourceF
         return false;
     }
 
+    // only the preallocated file has blocks beyond its end to release, the others are left as written.
+    bool preallocated = PreallocateTraceFile(traceSourceFactory, request);
     ExecutePreProcessing(traceContentPtr);
     if (!DoCore(traceSourceFactory, request, traceContentPtr, ret)) {
+        if (preallocated) {
+            traceSourceFactory->TrimTraceFile();
+        }
         return HandleCoreFailure(traceSourceFactory, request, ret, newFileCount);
     }
 
     ExecutePostProcessing(traceContentPtr);
+    if (preallocated) {
+        traceSourceFactory->TrimTraceFile();
+    }
     return true;
 }
 
@@ -133,6 +195,17 @@ bool ITraceDumpStrategy::InitializeTraceContent(std::shared_ptr<ITraceSourceFact
     return true;
 }
 
+bool ITraceDumpStrategy::PreallocateTraceFile(std::shared_ptr<ITraceSourceFactory> traceSourceFactory,
+    const TraceDumpRequest& request)
+{
+    // only the size limited dump knows how large the trace file will grow.
+    if (!NeedDoPreAndPost() || !request.limitFileSz || request.fileSize <= 0 ||
+        (request.type != TraceDumpType::TRACE_RECORDING && request.type != TraceDumpType::TRACE_CACHE)) {
+        return false;
+    }
+    return traceSourceFactory->PreallocateTraceFile(request.fileSize);
+}
+
 void ITraceDumpStrategy::ExecutePreProcessing(const TraceContentPtr& traceContentPtr)
 {
     if (NeedDoPreAndPost()) {
@@ -172,52 +245,90 @@ void ITraceDumpStrategy::OnPre(const TraceContentPtr& traceContentPtr)
     traceContentPtr.fileHdr->ResetCurrentFileSize();
     SafeWriteTraceContent(traceContentPtr.fileHdr, "fileHdr");
     SafeWriteTraceContent(traceContentPtr.baseInfo, "baseInfo");
-    SafeWriteTraceContent(traceContentPtr.eventFmt, "eventFmt");
+    if (traceContentPtr.metadataRef == nullptr) {
+        SafeWriteTraceContent(traceContentPtr.eventFmt, "eventFmt");
+    }
 }
 
 void ITraceDumpStrategy::OnPost(const TraceContentPtr& traceContentPtr)
 {
     SafeWriteTraceContent(traceContentPtr.cmdLines, "cmdLines");
     SafeWriteTraceContent(traceContentPtr.tgids, "tgids");
-    SafeWriteTraceContent(traceContentPtr.headerPage, "headerPage");
-    SafeWriteTraceContent(traceContentPtr.printkFmt, "printkFmt");
+    if (traceContentPtr.metadataRef != nullptr) {
+        // the ref follows the cpu raw sections, so they stay where they are when the sidecar is inlined.
+        SafeWriteTraceContent(traceContentPtr.metadataRef, "metadataRef");
+    } else {
+        SafeWriteTraceContent(traceContentPtr.headerPage, "headerPage");
+        SafeWriteTraceContent(traceContentPtr.printkFmt, "printkFmt");
+    }
+    SafeWriteTraceContent(traceContentPtr.kallsyms, "kallsyms");
+    if (!traceContentPtr.cpuRaw->WritePageIndexContent()) {
+        HILOG_INFO(LOG_CORE, "cpuRaw WritePageIndexContent failed.");
+    }
+    // the section table must stay the last section, it locates all the sections written before it.
+    SafeWriteTraceContent(traceContentPtr.sectionTable, "sectionTable");
 }
 
 bool ITraceDumpStrategy::CreateTraceContentPtr(std::shared_ptr<ITraceSourceFactory> traceSourceFactory,
     const TraceDumpRequest& request, TraceContentPtr& contentPtr)
 {
+    if (request.seenPids != nullptr) {
+        request.seenPids->Clear(); // the tasks are collected for every file of the session
+    }
+    if (request.seenAddrs != nullptr) {
+        request.seenAddrs->Clear();
+    }
     if (!SafeGetTraceContent(contentPtr.fileHdr,
-        [&]() { return traceSourceFactory->GetTraceFileHeader(); }, "GetTraceFileHeader")) {
+        [&]() { return traceSourceFactory->GetTraceFileHeader(); }, "GetTraceFileHeader", request)) {
         return false;
     }
     if (!SafeGetTraceContent(contentPtr.baseInfo,
-        [&]() { return traceSourceFactory->GetTraceBaseInfo(); }, "GetTraceBaseInfo")) {
+        [&]() { return traceSourceFactory->GetTraceBaseInfo(); }, "GetTraceBaseInfo", request)) {
         return false;
     }
     if (!SafeGetTraceContent(contentPtr.eventFmt,
-        [&]() { return traceSourceFactory->GetTraceEventFmt(); }, "GetTraceEventFmt")) {
+        [&]() { return traceSourceFactory->GetTraceEventFmt(); }, "GetTraceEventFmt", request)) {
         return false;
     }
     if (!SafeGetTraceContent(contentPtr.cpuRaw,
-        [&]() { return traceSourceFactory->GetTraceCpuRaw(request); }, "GetTraceCpuRaw")) {
+        [&]() { return traceSourceFactory->GetTraceCpuRaw(request); }, "GetTraceCpuRaw", request)) {
         return false;
     }
+    contentPtr.fileHdr->SetVersionNumber(contentPtr.cpuRaw->GetFileVersionNumber());
     if (!SafeGetTraceContent(contentPtr.cmdLines,
-        [&]() { return traceSourceFactory->GetTraceCmdLines(); }, "GetTraceCmdLines")) {
+        [&]() { return traceSourceFactory->GetTraceCmdLines(); }, "GetTraceCmdLines", request)) {
         return false;
     }
     if (!SafeGetTraceContent(contentPtr.tgids,
-        [&]() { return traceSourceFactory->GetTraceTgids(); }, "GetTraceTgids")) {
+        [&]() { return traceSourceFactory->GetTraceTgids(); }, "GetTraceTgids", request)) {
         return false;
     }
+    contentPtr.cmdLines->SetSeenPids(request.seenPids);
+    contentPtr.tgids->SetSeenPids(request.seenPids);
     if (!SafeGetTraceContent(contentPtr.headerPage,
-        [&]() { return traceSourceFactory->GetTraceHeaderPage(); }, "GetTraceHeaderPage")) {
+        [&]() { return traceSourceFactory->GetTraceHeaderPage(); }, "GetTraceHeaderPage", request)) {
         return false;
     }
     if (!SafeGetTraceContent(contentPtr.printkFmt,
-        [&]() { return traceSourceFactory->GetTracePrintkFmt(); }, "GetTracePrintkFmt")) {
+        [&]() { return traceSourceFactory->GetTracePrintkFmt(); }, "GetTracePrintkFmt", request)) {
+        return false;
+    }
+    if (!SafeGetTraceContent(contentPtr.sectionTable,
+        [&]() { return traceSourceFactory->GetTraceSectionTable(); }, "GetTraceSectionTable", request)) {
         return false;
     }
+    if (!SafeGetTraceContent(contentPtr.kallsyms,
+        [&]() { return traceSourceFactory->GetTraceKallsyms(); }, "GetTraceKallsyms", request)) {
+        return false;
+    }
+    contentPtr.kallsyms->SetSeenAddrs(request.seenAddrs);
+    if (request.metadataSidecar) {
+        contentPtr.metadataRef = traceSourceFactory->GetTraceMetadataRef();
+        if (contentPtr.metadataRef != nullptr && !contentPtr.metadataRef->IsValid()) {
+            HILOG_WARN(LOG_CORE, "CreateTraceContentPtr: no metadata sidecar, the static sections are kept inline.");
+            contentPtr.metadataRef = nullptr;
+        }
+    }
     return true;
 }
 
@@ -242,9 +353,11 @@ bool RecordTraceDumpStrategy::DoCore(std::shared_ptr<ITraceSourceFactory> traceS
     const TraceDumpRequest& request, const TraceContentPtr& traceContentPtr, TraceDumpRet& ret)
 {
     thread_local bool isOverFlow = false;
+    TraceBufferWaiter bufferWaiter(DRAIN_MAX_LATENCY_MS, DRAIN_MIN_INTERVAL_MS);
+    uint64_t lostEventsBegin = TraceBufferWaiter::GetLostEvents();
     while (TraceDumpState::GetInstance().IsLoopDumpRunning()) {
         if (!isOverFlow) {
-            sleep(1); // sleep 1s to wait for trace data.
+            bufferWaiter.Wait();
         }
         auto updatedRequest = request;
         updatedRequest.traceEndTime = GetCurBootTime();
@@ -266,24 +379,24 @@ bool RecordTraceDumpStrategy::DoCore(std::shared_ptr<ITraceSourceFactory> traceS
             break;
         }
     }
+    HILOG_INFO(LOG_CORE, "RecordTraceDumpStrategy: %{public}" PRIu64 " events lost, pollable: %{public}d.",
+        TraceBufferWaiter::GetLostEvents() - lostEventsBegin, bufferWaiter.IsPollable());
     return true;
 }
 
 bool CacheTraceDumpStrategy::DoCore(std::shared_ptr<ITraceSourceFactory> traceSourceFactory,
     const TraceDumpRequest& request, const TraceContentPtr& traceContentPtr, TraceDumpRet& ret)
 {
-    uint64_t sliceDuration = 0;
+    uint64_t sliceDuration = 0; // ns
+    TraceBufferWaiter bufferWaiter(DRAIN_MAX_LATENCY_MS, DRAIN_MIN_INTERVAL_MS);
+    uint64_t lostEventsBegin = TraceBufferWaiter::GetLostEvents();
     while (TraceDumpState::GetInstance().IsLoopDumpRunning()) {
-        struct timespec bts = {0, 0};
-        clock_gettime(CLOCK_BOOTTIME, &bts);
-        uint64_t startTime = static_cast<uint64_t>(bts.tv_sec * S_TO_NS + bts.tv_nsec);
-        sleep(1); // sleep 1s to wait for trace data.
+        uint64_t startTime = GetCurBootTime();
+        bufferWaiter.Wait();
         if (!traceContentPtr.cpuRaw->WriteTraceContent()) {
             return false;
         }
-        clock_gettime(CLOCK_BOOTTIME, &bts);
-        uint64_t endTime = static_cast<uint64_t>(bts.tv_sec * S_TO_NS + bts.tv_nsec);
-        uint64_t timeDiff = (endTime - startTime) / S_TO_NS;
+        uint64_t timeDiff = GetCurBootTime() - startTime;
         const auto& traceFile = traceContentPtr.cpuRaw->GetTraceFilePath();
         ret.code = traceContentPtr.cpuRaw->GetDumpStatus();
         ret.traceStartTime = traceContentPtr.cpuRaw->GetFirstPageTimeStamp();
@@ -293,11 +406,13 @@ bool CacheTraceDumpStrategy::DoCore(std::shared_ptr<ITraceSourceFactory> traceSo
             return false;
         }
         sliceDuration += timeDiff;
-        if (sliceDuration >= request.cacheSliceDuration || TraceDumpState::GetInstance().IsInterruptCache()) {
+        if (sliceDuration >= request.cacheSliceDuration * S_TO_NS || TraceDumpState::GetInstance().IsInterruptCache()) {
             sliceDuration = 0;
             break;
         }
     }
+    HILOG_INFO(LOG_CORE, "CacheTraceDumpStrategy: %{public}" PRIu64 " events lost, pollable: %{public}d.",
+        TraceBufferWaiter::GetLostEvents() - lostEventsBegin, bufferWaiter.IsPollable());
     return true;
 }
 
@@ -313,6 +428,7 @@ bool AsyncTraceReadStrategy::DoCore(std::shared_ptr<ITraceSourceFactory> traceSo
     ret.fileSize = static_cast<int64_t>(TraceBufferManager::GetInstance().GetTaskTotalUsedBytes(request.taskId));
     ret.traceStartTime = cpuRawRead->GetFirstPageTimeStamp();
     ret.traceEndTime = cpuRawRead->GetLastPageTimeStamp();
+    ret.isFileSizeOverLimit = cpuRawRead->IsOverFlow();
     auto tracefile = GenerateTraceFileNameByTraceTime(request.type, ret.traceStartTime, ret.traceEndTime);
     if (strncpy_s(ret.outputFile, TRACE_FILE_LEN, tracefile.c_str(), TRACE_FILE_LEN - 1) != 0) {
         HILOG_ERROR(LOG_CORE, "AsyncTraceReadStrategy: strncpy_s failed.");
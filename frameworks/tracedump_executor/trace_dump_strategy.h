@@ -30,6 +30,7 @@ struct TraceDumpRet {
     int64_t fileSize = 0;
     uint64_t traceStartTime = 0;
     uint64_t traceEndTime = 0;
+    bool isFileSizeOverLimit = false; // older pages have been dropped to fit into the file size limit
 };
 
 struct TraceContentPtr {
@@ -41,6 +42,9 @@ struct TraceContentPtr {
     std::unique_ptr<TraceTgidsContent> tgids;
     std::unique_ptr<ITraceHeaderPageContent> headerPage;
     std::unique_ptr<ITracePrintkFmtContent> printkFmt;
+    std::unique_ptr<TraceSectionTableContent> sectionTable;
+    std::unique_ptr<TraceMetadataRefContent> metadataRef; // set if the static sections are kept in the sidecar
+    std::unique_ptr<TraceKallsymsContent> kallsyms;
 };
 
 class ITraceDumpStrategy {
@@ -68,6 +72,8 @@ private:
         const TraceDumpRequest& request, TraceDumpRet& ret, int& newFileCount);
     bool InitializeTraceContent(std::shared_ptr<ITraceSourceFactory> traceSourceFactory,
         const TraceDumpRequest& request, TraceContentPtr& traceContentPtr);
+    bool PreallocateTraceFile(std::shared_ptr<ITraceSourceFactory> traceSourceFactory,
+        const TraceDumpRequest& request);
     void ExecutePreProcessing(const TraceContentPtr& traceContentPtr);
     void ExecutePostProcessing(const TraceContentPtr& traceContentPtr);
     bool HandleCoreFailure(std::shared_ptr<ITraceSourceFactory> traceSourceFactory,
@@ -40,6 +40,9 @@ public:
     using Creator = std::function<std::unique_ptr<ITraceDumpStrategy>()>;
     bool Register(TraceDumpType type, Creator creator);
     std::unique_ptr<ITraceDumpStrategy> Create(TraceDumpType type);
+    // hold the lock of the registry across fork, see StartSyncDumpWorker in hitrace_dump.cpp.
+    void LockForFork() { mutex_.lock(); }
+    void UnlockAfterFork() { mutex_.unlock(); }
 
 private:
     std::mutex mutex_;
@@ -139,6 +139,12 @@ bool AddSymlinkXattr(const std::string& fileName);
  * remove trace file xattr flag
  */
 bool RemoveSymlinkXattr(const std::string& fileName);
+
+/**
+ * Convert a raw trace file with compressed cpu raw sections to the plain format, for readers that cannot inflate
+ * the sections themselves.
+ */
+bool DecompressTraceFile(const std::string& srcFile, const std::string& dstFile);
 } // Hitrace
 
 }
@@ -15,20 +15,29 @@
 
 #ifndef HITRACE_TRACE_FILTER_CONTEXT_H
 #define HITRACE_TRACE_FILTER_CONTEXT_H
+#include <atomic>
 #include <condition_variable>
 #include <functional>
-#include <map>
 #include <memory>
 #include <mutex>
-#include <set>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace OHOS {
 namespace HiviewDFX {
 namespace Hitrace {
 
+/**
+ * @brief TraceFilterContext keeps the threads of the filtered processes with their saved cmdlines.
+ * @note FilterTraceContent refreshes the context in place, the tasks found by the former refreshes stay until their
+ *       tids are reused by the other processes, so the tasks which have exited are still listed.
+ *       The threads of a filter pid are scanned once when it is added, the threads and processes forked later are
+ *       added to set_event_pid by the kernel through the event-fork option, or by adding the pid again on the
+ *       kernels without the option.
+ */
 class TraceFilterContext {
 public:
     TraceFilterContext();
@@ -36,19 +45,25 @@ public:
     bool AddFilterPids(const std::vector<std::string>& filterPids);
     void FilterTraceContent();
     void TraverseSavedCmdLine(const std::function<void(const std::string& savedCmdLine)>& handler) const;
+    void TraverseFilterPid(const std::function<void(const int pid)>& handler) const;
+    void TraverseTGidsContent(const std::function<void(const std::pair<int, int>& tgid)>& handler) const;
+    // the string typed callbacks of the former interface, the numbers are formatted for every call.
     void TraverseFilterPid(const std::function<void(const std::string& pid)>& handler) const;
     void TraverseTGidsContent(
         const std::function<void(const std::pair<std::string, std::string>& tgid)>& handler) const;
 private:
     void FilterTGidsContent();
     void FilterSavedCmdLine();
-    std::vector<std::string> filterCmdLines_;
-    std::map<std::string, std::string> originTGids_;
-    std::vector<std::pair<std::string, std::string>> filterTGidsContent_;
-    std::set<std::string> filterPids_;
+    std::unordered_map<int, std::string> filterCmdLines_; // tid -> the line of saved_cmdlines
+    std::unordered_map<int, int> originTGids_; // tid -> pid, the threads of the filter pids when they are added
+    std::unordered_map<int, int> filterTGidsContent_; // tid -> pid
+    std::unordered_set<int> filterPids_;
+    std::vector<std::pair<int, int>> savedTGids_; // the lines of saved_tgids, reused by every refresh
     pid_t initPid_ = -1;
     pid_t standInTid_ = -1;
-    struct StandInThreadContext* standInThreadContext_;
+    bool isEventForkOn_ = false;
+    bool isEventForkOriginOn_ = false; // event-fork is restored when the context is released
+    struct StandInThreadContext* standInThreadContext_ = nullptr;
 };
 
 class TraceContextManager {
@@ -56,8 +71,13 @@ public:
     static TraceContextManager& GetInstance();
     std::shared_ptr<TraceFilterContext> GetTraceFilterContext(bool createIfNotExisted = false);
     void ReleaseContext();
+    // changed whenever the filter context is created, released or given more pids, a forked dump process which
+    // holds an older copy of the context is restarted.
+    uint64_t GetGeneration() const { return generation_.load(std::memory_order_acquire); }
+    void BumpGeneration() { generation_.fetch_add(1, std::memory_order_acq_rel); }
 private:
     std::shared_ptr<TraceFilterContext> traceFilterContext_ = nullptr;
+    std::atomic<uint64_t> generation_ = 0;
 };
 }
 }
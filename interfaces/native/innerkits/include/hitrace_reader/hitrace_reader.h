@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HITRACE_READER_H
+#define HITRACE_READER_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+struct TraceEventField {
+    std::string type;
+    std::string name;
+    uint16_t offset = 0;
+    uint16_t size = 0;
+    bool isSigned = false;
+};
+
+struct TraceEventFormat {
+    uint16_t id = 0;
+    std::string name;
+    std::string printFmt;
+    std::vector<TraceEventField> fields;
+
+    const TraceEventField* GetField(const std::string_view fieldName) const;
+};
+
+/**
+ * @brief one event of a cpu raw section, data points to the record which starts with common_type, it stays valid
+ *        until the cursor moves to the next page, or as long as the reader is open for uncompressed files.
+ */
+struct TraceRawEvent {
+    uint64_t timestamp = 0;
+    uint32_t cpu = 0;
+    uint16_t id = 0;
+    uint32_t size = 0;
+    const uint8_t* data = nullptr;
+};
+
+struct TraceSectionView {
+    uint8_t type = 0;
+    uint32_t length = 0;
+    const uint8_t* data = nullptr;
+};
+
+// pages of a cpu raw section, or one zlib chunk of a compressed section when rawSize differs from size.
+struct TraceRawSpan {
+    const uint8_t* data = nullptr;
+    uint32_t size = 0;
+    uint32_t rawSize = 0;
+};
+
+// where the commit word and the events are in a ring buffer page, taken from the header_page section.
+struct TracePageLayout {
+    uint32_t commitOffset = 8;
+    uint32_t commitSize = 8;
+    uint32_t dataOffset = 16;
+};
+
+/**
+ * @brief TraceCpuEventCursor walks the pages and events of one cpu in file order, the events of uncompressed
+ *        sections are read in place from the mapped file.
+ */
+class TraceCpuEventCursor {
+public:
+    TraceCpuEventCursor(const uint32_t cpu, const std::vector<TraceRawSpan>* spans, const TracePageLayout& layout);
+    bool Next(TraceRawEvent& event);
+    uint32_t GetCpu() const { return cpu_; }
+    uint64_t GetPageCount() const { return pageCount_; }
+
+private:
+    bool NextPage();
+    bool LoadSpan();
+
+    uint32_t cpu_ = 0;
+    const std::vector<TraceRawSpan>* spans_ = nullptr;
+    TracePageLayout layout_;
+    size_t spanIdx_ = 0;
+    const uint8_t* pages_ = nullptr;
+    size_t pagesSize_ = 0;
+    size_t pageOffset_ = 0;
+    const uint8_t* eventPos_ = nullptr;
+    const uint8_t* eventEnd_ = nullptr;
+    uint64_t timestamp_ = 0;
+    uint64_t pageCount_ = 0;
+    std::vector<uint8_t> chunkBuffer_;
+};
+
+/**
+ * @brief TraceMergedEventCursor merges the events of all the cpus by timestamp with a min-heap of the cpu cursors.
+ */
+class TraceMergedEventCursor {
+public:
+    explicit TraceMergedEventCursor(std::vector<TraceCpuEventCursor>&& cursors);
+    bool Next(TraceRawEvent& event);
+
+private:
+    void SiftDown(size_t pos);
+    bool IsEarlier(const size_t lhs, const size_t rhs) const;
+
+    std::vector<TraceCpuEventCursor> cursors_;
+    std::vector<TraceRawEvent> heads_;
+    std::vector<size_t> heap_;
+    bool isStarted_ = false;
+};
+
+/**
+ * @brief TraceReader maps a trace file written by hitrace and decodes its sections without copying the pages,
+ *        the cursors it hands out must not outlive it.
+ * @note the sections kept in the metadata sidecar of a slice are read from the sidecar file next to it and listed
+ *       by GetSections as if they were inline.
+ */
+class TraceReader {
+public:
+    TraceReader() = default;
+    ~TraceReader();
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+
+    bool Open(const std::string& traceFile);
+    void Close();
+
+    uint16_t GetVersionNumber() const { return versionNumber_; }
+    const std::vector<TraceSectionView>& GetSections() const { return sections_; }
+    const TraceEventFormat* GetEventFormat(const uint16_t id) const;
+    const std::unordered_map<uint16_t, TraceEventFormat>& GetEventFormats() const { return eventFormats_; }
+    const std::unordered_map<int32_t, std::string>& GetCmdlines() const { return cmdlines_; }
+    const std::unordered_map<int32_t, int32_t>& GetTgids() const { return tgids_; }
+    std::vector<uint32_t> GetCpus() const;
+    TraceCpuEventCursor GetCpuEvents(const uint32_t cpu) const;
+    TraceMergedEventCursor GetMergedEvents() const;
+
+private:
+    bool ParseSections();
+    void AddSection(const TraceSectionView& section);
+    bool AddCompressedSection(const TraceSectionView& section);
+    bool LoadMetadataSidecar(const TraceSectionView& refSection);
+    void ParseEventFormats(const std::string_view content);
+    void ParseHeaderPage(const std::string_view content);
+    void ParseCmdlines(const std::string_view content);
+    void ParseTgids(const std::string_view content);
+
+    uint8_t* mapAddr_ = nullptr;
+    size_t mapSize_ = 0;
+    uint16_t versionNumber_ = 0;
+    std::string traceDir_;
+    std::string sidecarContent_; // the sections of the sidecar, sections_ points into it
+    std::vector<TraceSectionView> sections_;
+    std::unordered_map<uint16_t, TraceEventFormat> eventFormats_;
+    std::unordered_map<int32_t, std::string> cmdlines_;
+    std::unordered_map<int32_t, int32_t> tgids_;
+    std::map<uint32_t, std::vector<TraceRawSpan>> cpuSpans_;
+    TracePageLayout pageLayout_;
+};
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
+#endif // HITRACE_READER_H
@@ -24,10 +24,12 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <poll.h>
 #include <set>
 #include <sys/epoll.h>
 #include <sys/file.h>
 #include <sys/prctl.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <sys/xattr.h>
@@ -49,11 +51,16 @@
 #include "hilog/log.h"
 #include "parameters.h"
 #include "securec.h"
+#include "trace_compressor.h"
 #include "trace_context.h"
 #include "trace_dump_executor.h"
 #include "trace_dump_pipe.h"
 #include "trace_file_utils.h"
 #include "trace_json_parser.h"
+#include "trace_metadata_cache.h"
+#include "trace_metadata_sidecar.h"
+#include "trace_page_index.h"
+#include "trace_strategy_factory.h"
 
 namespace OHOS {
 namespace HiviewDFX {
@@ -82,14 +89,44 @@ struct TraceParams {
 };
 
 constexpr int SAVED_CMDLINES_SIZE = 3072; // 3M
+constexpr int TRACE_BUFFER_PERCENT = 25; // wake the record and cache loops when a cpu ring buffer is a quarter full
 constexpr int32_t MAX_RATIO_UNIT = 1000;
 constexpr uint32_t DURATION_TOLERANCE = 100;
 constexpr int32_t DEFAULT_FULL_TRACE_LENGTH = 30;
 constexpr uint64_t SNAPSHOT_MIN_REMAINING_SPACE = 300 * 1024 * 1024;     // 300M
 constexpr uint64_t DEFAULT_ASYNC_TRACE_SIZE = 50 * 1024 * 1024;          // 50M
 constexpr int ASYNC_WAIT_EMPTY_LOOP_CNT = 180; // 3 minutes
+constexpr int SYNC_DUMP_WORKER_IDLE_MS = 60 * 1000; // the sync dump worker exits after one minute without request
+constexpr int SYNC_DUMP_WORKER_MAX_START = 2;
+
+struct SyncDumpRequest {
+    uint64_t traceStartTime = 0;
+    uint64_t traceEndTime = std::numeric_limits<uint64_t>::max();
+    TraceDumpEngine engine = TraceDumpEngine::ENGINE_DEFAULT;
+    bool seenPidsOnly = false;
+    bool filterEventPids = false;
+    bool withKallsyms = false;
+    char outputPath[PATH_MAX] = { 0 };
+};
+
+// long-lived process which serves the snapshot dump requests, forked on demand instead of once per dump.
+// the worker holds the filter context and the metadata cache as they were at fork, it is restarted once the
+// generation of either one has changed.
+struct SyncDumpWorker {
+    pid_t pid = -1;
+    SmartFd channel;
+    uint64_t filterGeneration = 0;
+    uint64_t metadataGeneration = 0;
+};
+
+enum class SyncDumpWaitRet {
+    DONE,
+    TIMEOUT,
+    WORKER_GONE
+};
 
 static volatile sig_atomic_t g_traceDumpTaskPid = -1;
+SyncDumpWorker g_syncDumpWorker;
 std::atomic<pid_t> g_asyncWaitTid(-1);
 
 std::mutex g_traceMutex;
@@ -107,6 +144,7 @@ uint8_t g_dumpStatus(TraceErrorCode::UNSET);
 std::vector<TraceFileInfo> g_traceFileVec{};
 
 TraceParams g_currentTraceParams = {};
+std::string g_savedBufferPercent; // buffer_percent before the trace was opened, empty if it was not changed
 
 std::mutex g_traceRetAndCallbackMutex;
 std::map<uint64_t, std::function<void(TraceRetInfo)>> g_callbacks;
@@ -347,6 +385,33 @@ void SetClock(const std::string& clockType)
     }
 }
 
+// buffer_percent is left to the other tracefs users as it was before the trace is opened.
+void SetBufferPercent()
+{
+    if (IsHmKernel()) {
+        return;
+    }
+    if (g_savedBufferPercent.empty()) {
+        std::string bufferPercent = ReadFile("buffer_percent", GetTraceRootPath());
+        g_savedBufferPercent = bufferPercent.substr(0, bufferPercent.find("\n"));
+    }
+    if (!WriteStrToFile("buffer_percent", std::to_string(TRACE_BUFFER_PERCENT))) {
+        HILOG_WARN(LOG_CORE, "SetBufferPercent: Write buffer_percent failed.");
+    }
+}
+
+void RestoreBufferPercent()
+{
+    if (g_savedBufferPercent.empty()) {
+        return;
+    }
+    if (!WriteStrToFile("buffer_percent", g_savedBufferPercent)) {
+        HILOG_WARN(LOG_CORE, "RestoreBufferPercent: Write buffer_percent %{public}s failed.",
+            g_savedBufferPercent.c_str());
+    }
+    g_savedBufferPercent.clear();
+}
+
 bool SetTraceSetting(const TraceParams& traceParams, const std::map<std::string, TraceTag>& allTags,
     const std::map<std::string, std::vector<std::string>>& tagGroupTable, std::vector<std::string>& tagFmts)
 {
@@ -369,6 +434,7 @@ bool SetTraceSetting(const TraceParams& traceParams, const std::map<std::string,
     if (!WriteStrToFile("buffer_size_kb", traceParams.bufferSize)) {
         HILOG_ERROR(LOG_CORE, "SetTraceSetting: WriteStrToFile fail.");
     }
+    SetBufferPercent();
 
     SetClock(traceParams.clockType);
 
@@ -459,6 +525,32 @@ int32_t GetTraceFileFromVec(const uint64_t& inputTraceStartTime, const uint64_t&
     return coverDuration;
 }
 
+// a cache slice which is longer than the target window is cut to the pages of the window instead of taken as a whole.
+bool ExtractCacheFileWindow(const uint64_t& inputTraceStartTime, const uint64_t& inputTraceEndTime,
+    TraceFileInfo& file)
+{
+    if ((g_traceStartTime == 0 && g_traceEndTime == std::numeric_limits<uint64_t>::max()) ||
+        (file.traceStartTime >= inputTraceStartTime * S_TO_MS && file.traceEndTime <= inputTraceEndTime * S_TO_MS)) {
+        return false;
+    }
+    std::string windowFile = GenerateTraceFileName(TraceDumpType::TRACE_SNAPSHOT);
+    TimestampRange range{0, 0};
+    if (windowFile.empty() || !ExtractTraceWindow(file.filename, windowFile, g_traceStartTime, g_traceEndTime,
+        range.firstPageTimestamp, range.lastPageTimestamp)) {
+        return false;
+    }
+    TraceFileInfo windowFileInfo;
+    if (!SetFileInfo(true, windowFile, range, windowFileInfo)) {
+        RemoveFile(windowFile);
+        return false;
+    }
+    HILOG_INFO(LOG_CORE, "ExtractCacheFileWindow: %{public}s is cut to %{public}s, %{public}" PRId64
+        " of %{public}" PRId64 " bytes.", file.filename.c_str(), windowFileInfo.filename.c_str(),
+        windowFileInfo.fileSize, file.fileSize);
+    file = windowFileInfo;
+    return true;
+}
+
 void SearchTraceFiles(const uint64_t& inputTraceStartTime, const uint64_t& inputTraceEndTime,
     TraceRetInfo& traceRetInfo)
 {
@@ -469,11 +561,17 @@ void SearchTraceFiles(const uint64_t& inputTraceStartTime, const uint64_t& input
     int32_t coverDuration = 0;
     std::vector<TraceFileInfo> targetFiles;
     coverDuration += GetTraceFileFromVec(inputTraceStartTime, inputTraceEndTime, g_traceFileVec, targetFiles);
-    auto inputCacheFiles = TraceDumpExecutor::GetInstance().GetCacheTraceFiles();
+    auto inputCacheFiles = TraceDumpExecutor::GetInstance().GetCacheTraceFiles(g_traceStartTime, g_traceEndTime);
     coverDuration += GetTraceFileFromVec(inputTraceStartTime, inputTraceEndTime, inputCacheFiles, targetFiles);
     for (auto& file : targetFiles) {
         if (file.filename.find(CACHE_FILE_PREFIX) != std::string::npos) {
-            file.filename = RenameCacheFile(file.filename);
+            if (!ExtractCacheFileWindow(inputTraceStartTime, inputTraceEndTime, file)) {
+                file.filename = RenameCacheFile(file.filename);
+            }
+            // a slice of a series leaves with its metadata, the sidecar stays for the slices still cached.
+            if (InlineMetadataSidecar(file.filename)) {
+                file.fileSize = static_cast<int64_t>(GetFileSize(file.filename));
+            }
             g_traceFileVec.push_back(file);
         }
         traceRetInfo.outputFiles.push_back(file.filename);
@@ -482,6 +580,49 @@ void SearchTraceFiles(const uint64_t& inputTraceStartTime, const uint64_t& input
     traceRetInfo.coverDuration += coverDuration;
 }
 
+TraceDumpEngine GetTraceDumpEngine()
+{
+    std::string engine = OHOS::system::GetParameter(TRACE_DUMP_ENGINE, "");
+    if (engine == "splice") {
+        return TraceDumpEngine::ENGINE_SPLICE;
+    }
+    if (engine == "io_uring") {
+        return TraceDumpEngine::ENGINE_IO_URING;
+    }
+    return TraceDumpEngine::ENGINE_DEFAULT;
+}
+
+bool IsCacheInMemory()
+{
+    return OHOS::system::GetParameter(TRACE_CACHE_MODE, "") == "memory";
+}
+
+int GetTraceCompressLevel()
+{
+    int level = OHOS::system::GetIntParameter<int>(TRACE_COMPRESS_LEVEL, 0);
+    return (level >= TRACE_COMPRESS_LEVEL_MIN && level <= TRACE_COMPRESS_LEVEL_MAX) ? level : 0;
+}
+
+bool IsSeenPidsOnly()
+{
+    return OHOS::system::GetBoolParameter(TRACE_SEEN_PIDS_ONLY, false);
+}
+
+bool IsFilterEventPids()
+{
+    return OHOS::system::GetBoolParameter(TRACE_FILTER_EVENT_PIDS, false);
+}
+
+bool IsMetadataSidecar()
+{
+    return OHOS::system::GetBoolParameter(TRACE_METADATA_SIDECAR, false);
+}
+
+bool IsDumpKallsyms()
+{
+    return OHOS::system::GetBoolParameter(TRACE_DUMP_KALLSYMS, false);
+}
+
 void ProcessCacheTask()
 {
     const std::string threadName = "CacheTraceTask";
@@ -492,7 +633,14 @@ void ProcessCacheTask()
         .fileLimit = g_currentTraceParams.fileLimit,
         .fileSize = g_currentTraceParams.fileSize,
         .cacheTotalFileSizeLmt = g_totalFileSizeLimit,
-        .cacheSliceDuration = g_sliceMaxDuration
+        .cacheSliceDuration = g_sliceMaxDuration,
+        .engine = GetTraceDumpEngine(),
+        .cacheInMemory = IsCacheInMemory(),
+        .compressLevel = GetTraceCompressLevel(),
+        .seenPidsOnly = IsSeenPidsOnly(),
+        .filterEventPids = IsFilterEventPids(),
+        .metadataSidecar = IsMetadataSidecar(),
+        .withKallsyms = IsDumpKallsyms()
     };
     if (!TraceDumpExecutor::GetInstance().StartCacheTraceLoop(param)) {
         HILOG_ERROR(LOG_CORE, "ProcessCacheTask: StartCacheTraceLoop failed.");
@@ -514,6 +662,12 @@ void ProcessRecordTask(const std::string& outputPath)
         std::numeric_limits<uint64_t>::max(),
         g_currentTraceParams.totalSize
     };
+    param.engine = GetTraceDumpEngine();
+    param.compressLevel = GetTraceCompressLevel();
+    param.seenPidsOnly = IsSeenPidsOnly();
+    param.filterEventPids = IsFilterEventPids();
+    param.metadataSidecar = IsMetadataSidecar();
+    param.withKallsyms = IsDumpKallsyms();
     TraceDumpExecutor::GetInstance().StartDumpTraceLoop(param, outputPath);
 }
 
@@ -583,19 +737,127 @@ void WaitForChildProcess(const pid_t pid)
     }
 }
 
-bool EpollWaitforChildProcess(pid_t& pid, int pipefd, std::string& reOutPath)
+void StopSyncDumpWorker(const bool logStack)
+{
+    // the worker may still be dumping, kill it instead of waiting for it to see the closed channel.
+    g_syncDumpWorker.channel.Reset();
+    pid_t pid = g_syncDumpWorker.pid;
+    g_syncDumpWorker.pid = -1;
+    if (pid <= 0) {
+        return;
+    }
+    if (logStack) {
+        LogStackTrace(pid);
+    }
+    if (kill(pid, SIGKILL) != 0) {
+        HILOG_ERROR(LOG_CORE, "StopSyncDumpWorker: kill dump worker failed.");
+    }
+    WaitForChildProcess(pid);
+}
+
+bool IsSyncDumpWorkerAlive()
+{
+    if (g_syncDumpWorker.pid <= 0 || !g_syncDumpWorker.channel) {
+        return false;
+    }
+    if (TEMP_FAILURE_RETRY(waitpid(g_syncDumpWorker.pid, nullptr, WNOHANG)) != 0) {
+        HILOG_INFO(LOG_CORE, "IsSyncDumpWorkerAlive: dump worker %{public}d has exited.", g_syncDumpWorker.pid);
+        g_syncDumpWorker.pid = -1;
+        g_syncDumpWorker.channel.Reset();
+        return false;
+    }
+    return true;
+}
+
+void SyncDumpWorkerLoop(const int channelFd)
+{
+    signal(SIGUSR1, TimeoutSignalHandler);
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    std::string processName = "HitraceDump";
+    SetProcessName(processName);
+    struct pollfd pollFd = { channelFd, POLLIN, 0 };
+    while (TEMP_FAILURE_RETRY(poll(&pollFd, 1, SYNC_DUMP_WORKER_IDLE_MS)) > 0) {
+        SyncDumpRequest request;
+        if (TEMP_FAILURE_RETRY(recv(channelFd, &request, sizeof(request), 0)) != sizeof(request)) {
+            break;
+        }
+        request.outputPath[PATH_MAX - 1] = '\0';
+        struct TraceDumpParam param = { TRACE_SNAPSHOT, "", 0, 0, request.traceStartTime, request.traceEndTime };
+        param.engine = request.engine;
+        param.seenPidsOnly = request.seenPidsOnly;
+        param.filterEventPids = request.filterEventPids;
+        param.withKallsyms = request.withKallsyms;
+        TraceDumpRet ret = TraceDumpExecutor::GetInstance().DumpTrace(param, request.outputPath);
+        HILOG_INFO(LOG_CORE,
+            "TraceDumpRet : %{public}d, outputFile: %{public}s, [%{public}" PRIu64 ", %{public}" PRIu64 "].",
+            ret.code, ret.outputFile, ret.traceStartTime, ret.traceEndTime);
+        if (TEMP_FAILURE_RETRY(send(channelFd, &ret, sizeof(ret), MSG_NOSIGNAL)) != sizeof(ret)) {
+            break;
+        }
+    }
+    _exit(EXIT_SUCCESS);
+}
+
+bool IsSyncDumpWorkerStale()
+{
+    return g_syncDumpWorker.filterGeneration != TraceContextManager::GetInstance().GetGeneration() ||
+        g_syncDumpWorker.metadataGeneration != TraceMetadataCache::GetInstance().GetGeneration();
+}
+
+/**
+ * Fork safety of the locks taken by the worker while dumping:
+ * - TraceMetadataCache mutexes and the TraceStrategyFactory mutex: held by the forking thread across fork, so the
+ *   worker gets them unlocked, the prepared metadata is built before fork since its threads are not forked.
+ * - g_traceMutex: held by the forking thread, the worker never takes it.
+ * - TraceContextManager: no lock, the worker only reads its copy of the filter context.
+ * - the dump buffer pool and the dump state: per dump session, created by the worker itself.
+ * - malloc: the allocator locks are reset in the child by libc, see TraceMetadataCacheTest004, HiLog is used the
+ *   same way as by the forked async dump process.
+ */
+bool StartSyncDumpWorker()
+{
+    int fds[2] = { -1, -1 };
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) == -1) {
+        HILOG_ERROR(LOG_CORE, "StartSyncDumpWorker: socketpair creation error, errno(%{public}d).", errno);
+        return false;
+    }
+    SmartFd parentFd(fds[0]);
+    SmartFd childFd(fds[1]);
+    uint64_t filterGeneration = TraceContextManager::GetInstance().GetGeneration();
+    uint64_t metadataGeneration = TraceMetadataCache::GetInstance().GetGeneration();
+    TraceMetadataCache::GetInstance().LockForFork();
+    TraceStrategyFactory::GetInstance().LockForFork();
+    pid_t pid = fork();
+    TraceStrategyFactory::GetInstance().UnlockAfterFork();
+    TraceMetadataCache::GetInstance().UnlockAfterFork();
+    if (pid < 0) {
+        HILOG_ERROR(LOG_CORE, "StartSyncDumpWorker: fork error.");
+        return false;
+    } else if (pid == 0) {
+        parentFd.Reset();
+        SyncDumpWorkerLoop(childFd.GetFd());
+    }
+    g_syncDumpWorker.pid = pid;
+    g_syncDumpWorker.channel = std::move(parentFd);
+    g_syncDumpWorker.filterGeneration = filterGeneration;
+    g_syncDumpWorker.metadataGeneration = metadataGeneration;
+    HILOG_INFO(LOG_CORE, "StartSyncDumpWorker: dump worker %{public}d started.", pid);
+    return true;
+}
+
+SyncDumpWaitRet EpollWaitForSyncDumpWorker(const int channelFd, TraceDumpRet& retVal)
 {
     SmartFd epollfd = SmartFd(epoll_create1(0));
     if (!epollfd) {
         HILOG_ERROR(LOG_CORE, "epoll_create1 error.");
-        return false;
+        return SyncDumpWaitRet::WORKER_GONE;
     }
     struct epoll_event event;
     event.events = EPOLLIN;
-    event.data.fd = pipefd;
-    if (epoll_ctl(epollfd.GetFd(), EPOLL_CTL_ADD, pipefd, &event) == -1) {
+    event.data.fd = channelFd;
+    if (epoll_ctl(epollfd.GetFd(), EPOLL_CTL_ADD, channelFd, &event) == -1) {
         HILOG_ERROR(LOG_CORE, "epoll_ctl error.");
-        return false;
+        return SyncDumpWaitRet::WORKER_GONE;
     }
     struct epoll_event events[1];
     int numEvents = 0;
@@ -607,25 +869,18 @@ bool EpollWaitforChildProcess(pid_t& pid, int pipefd, std::string& reOutPath)
         }
     }
     if (numEvents <= 0) {
-        LogStackTrace(pid);
-        HILOG_ERROR(LOG_CORE, "kill timeout child process.");
-        if (kill(pid, SIGKILL) != 0) {
-            HILOG_ERROR(LOG_CORE, "kill child process failed.");
-        }
-        WaitForChildProcess(pid);
-        return false;
+        return SyncDumpWaitRet::TIMEOUT;
     }
-    TraceDumpRet retVal;
-    read(pipefd, &retVal, sizeof(retVal));
+    // a worker which has gone away only hangs up the channel without a reply.
+    if (TEMP_FAILURE_RETRY(recv(channelFd, &retVal, sizeof(retVal), MSG_DONTWAIT)) != sizeof(retVal)) {
+        HILOG_WARN(LOG_CORE, "Epoll wait read : dump worker hang up without reply.");
+        return SyncDumpWaitRet::WORKER_GONE;
+    }
+    retVal.outputFile[TRACE_FILE_LEN - 1] = '\0';
     HILOG_INFO(LOG_CORE,
         "Epoll wait read : %{public}d, outputFile: %{public}s, [%{public}" PRIu64 ", %{public}" PRIu64 "].",
         retVal.code, retVal.outputFile, retVal.traceStartTime, retVal.traceEndTime);
-    g_dumpStatus = retVal.code;
-    reOutPath = retVal.outputFile;
-    g_firstPageTimestamp = retVal.traceStartTime;
-    g_lastPageTimestamp = retVal.traceEndTime;
-    WaitForChildProcess(pid);
-    return true;
+    return SyncDumpWaitRet::DONE;
 }
 
 TraceErrorCode HandleDumpResult(std::string& reOutPath, TraceRetInfo& traceRetInfo, const std::string& outputPath)
@@ -698,42 +953,52 @@ TraceErrorCode ProcessDumpSync(TraceRetInfo& traceRetInfo, const std::string& ou
         return TraceErrorCode::FILE_ERROR;
     }
 
-    int pipefd[2]{-1};
-    if (pipe(pipefd) == -1) {
-        HILOG_ERROR(LOG_CORE, "ProcessDumpSync: pipe creation error.");
-        return TraceErrorCode::PIPE_CREATE_ERROR;
+    SyncDumpRequest request = {
+        .traceStartTime = g_traceStartTime,
+        .traceEndTime = g_traceEndTime,
+        .engine = GetTraceDumpEngine(),
+        .seenPidsOnly = IsSeenPidsOnly(),
+        .filterEventPids = IsFilterEventPids(),
+        .withKallsyms = IsDumpKallsyms()
+    };
+    if (strcpy_s(request.outputPath, sizeof(request.outputPath), outputPath.c_str()) != EOK) {
+        HILOG_ERROR(LOG_CORE, "ProcessDumpSync: output path is too long.");
+        return TraceErrorCode::FILE_ERROR;
     }
     g_dumpStatus = TraceErrorCode::UNSET;
-    /*Child process handles task, Father process wait.*/
-    pid_t pid = fork();
-    if (pid < 0) {
-        SmartFd readFd(pipefd[0]);
-        SmartFd writeFd(pipefd[1]);
-        HILOG_ERROR(LOG_CORE, "fork error.");
-        return TraceErrorCode::FORK_ERROR;
-    } else if (pid == 0) {
-        signal(SIGUSR1, TimeoutSignalHandler);
-        {
-            SmartFd readFd(pipefd[0]);
+    if (IsSyncDumpWorkerAlive() && IsSyncDumpWorkerStale()) {
+        HILOG_INFO(LOG_CORE, "ProcessDumpSync: trace state changed, restart dump worker.");
+        StopSyncDumpWorker(false);
+    }
+    TraceDumpRet retVal;
+    SyncDumpWaitRet waitRet = SyncDumpWaitRet::WORKER_GONE;
+    // a worker may exit for being idle right when the request is sent, so a gone worker is restarted once.
+    for (int attempt = 0; attempt < SYNC_DUMP_WORKER_MAX_START && waitRet == SyncDumpWaitRet::WORKER_GONE;
+        attempt++) {
+        if (!IsSyncDumpWorkerAlive() && !StartSyncDumpWorker()) {
+            return TraceErrorCode::FORK_ERROR;
+        }
+        if (TEMP_FAILURE_RETRY(send(g_syncDumpWorker.channel.GetFd(), &request, sizeof(request), MSG_NOSIGNAL)) !=
+            sizeof(request)) {
+            HILOG_WARN(LOG_CORE, "ProcessDumpSync: send request failed, errno(%{public}d).", errno);
+            StopSyncDumpWorker(false);
+            continue;
+        }
+        waitRet = EpollWaitForSyncDumpWorker(g_syncDumpWorker.channel.GetFd(), retVal);
+        if (waitRet == SyncDumpWaitRet::TIMEOUT) {
+            HILOG_ERROR(LOG_CORE, "kill timeout dump worker.");
+            StopSyncDumpWorker(true);
+        } else if (waitRet == SyncDumpWaitRet::WORKER_GONE) {
+            StopSyncDumpWorker(false);
         }
-        SmartFd writeFd(pipefd[1]);
-        std::string processName = "HitraceDump";
-        SetProcessName(processName);
-        struct TraceDumpParam param = { TRACE_SNAPSHOT, "", 0, 0, g_traceStartTime, g_traceEndTime };
-        TraceDumpRet ret = TraceDumpExecutor::GetInstance().DumpTrace(param, outputPath);
-        HILOG_INFO(LOG_CORE,
-            "TraceDumpRet : %{public}d, outputFile: %{public}s, [%{public}" PRIu64 ", %{public}" PRIu64 "].",
-            ret.code, ret.outputFile, ret.traceStartTime, ret.traceEndTime);
-        write(writeFd.GetFd(), &ret, sizeof(ret));
-        _exit(EXIT_SUCCESS);
-    } else {
-        SmartFd writeFd(pipefd[1]);
     }
-    SmartFd readFd(pipefd[0]);
-    std::string reOutPath;
-    if (!EpollWaitforChildProcess(pid, readFd.GetFd(), reOutPath)) {
+    if (waitRet != SyncDumpWaitRet::DONE) {
         return TraceErrorCode::EPOLL_WAIT_ERROR;
     }
+    g_dumpStatus = retVal.code;
+    std::string reOutPath = retVal.outputFile;
+    g_firstPageTimestamp = retVal.traceStartTime;
+    g_lastPageTimestamp = retVal.traceEndTime;
     return HandleDumpResult(reOutPath, traceRetInfo, outputPath);
 }
 
@@ -1006,24 +1271,15 @@ void StartCpuBufferBalanceService()
         }, intervalTimeInSecond, threadName);
 }
 
-bool PreWriteEventsFormat(const std::vector<std::string>& eventFormats)
+// the formats are read in the background, the dumps of this process take them from memory and the others from
+// the saved file.
+void PreWriteEventsFormat(const std::vector<std::string>& eventFormats)
 {
     DelSavedEventsFormat();
     const std::string savedEventsFormatPath = std::string(TRACE_FILE_DEFAULT_DIR) +
         std::string(TRACE_SAVED_EVENTS_FORMAT);
-    SmartFd fd = SmartFd(open(savedEventsFormatPath.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644)); // 0644:-rw-r--r--
-    if (!fd) {
-        HILOG_ERROR(LOG_CORE, "PreWriteEventsFormat: open %{public}s failed.", savedEventsFormatPath.c_str());
-        return false;
-    }
-    for (auto& format : eventFormats) {
-        const std::string srcPath = GetTraceRootPath() + format;
-        if (access(srcPath.c_str(), R_OK) != -1) {
-            WriteEventFile(srcPath, fd.GetFd());
-        }
-    }
-    HILOG_INFO(LOG_CORE, "PreWriteEventsFormat end.");
-    return true;
+    TraceMetadataCache::GetInstance().PrepareEventFormats(eventFormats, savedEventsFormatPath);
+    HILOG_INFO(LOG_CORE, "PreWriteEventsFormat: %{public}zu formats are being prepared.", eventFormats.size());
 }
 
 TraceErrorCode HandleTraceOpen(const TraceParams& traceParams,
@@ -1036,6 +1292,8 @@ TraceErrorCode HandleTraceOpen(const TraceParams& traceParams,
     }
     SetTraceNodeStatus(TRACING_ON_NODE, true);
     PreWriteEventsFormat(tagFmts);
+    TraceMetadataCache::GetInstance().PrepareStaticFiles();
+    TraceMetadataCache::GetInstance().PrepareKallsyms();
     g_currentTraceParams = traceParams;
     return TraceErrorCode::SUCCESS;
 }
@@ -1189,10 +1447,13 @@ void SetTotalFileSizeLimitAndSliceMaxDuration(const uint64_t& totalFileSize, con
     }
 }
 
-void GetFileInCache(TraceRetInfo& traceRetInfo)
+void GetFileInCache(const uint32_t maxDuration, const uint64_t utTraceEndTime, TraceRetInfo& traceRetInfo)
 {
     HILOG_INFO(LOG_CORE, "DumpTrace: Trace is caching, get cache file.");
+    // the boot time window selects the pages of the in-memory cache, the whole cache is taken if it is invalid.
+    (void)SetTimeIntervalBoundary(maxDuration, utTraceEndTime);
     SearchTraceFiles(g_utDestTraceStartTime, g_utDestTraceEndTime, traceRetInfo);
+    RestoreTimeIntervalBoundary();
     if (traceRetInfo.outputFiles.empty()) {
         HILOG_ERROR(LOG_CORE, "DumpTrace: Trace is caching, but failed to retrieve target trace file.");
         traceRetInfo.errorCode = OUT_OF_TIME;
@@ -1232,6 +1493,7 @@ static TraceErrorCode ResetTracePipelineLocked()
     if (IsRecordOn() || IsCacheOn()) {
         TraceDumpExecutor::GetInstance().StopDumpTraceLoop();
     }
+    StopSyncDumpWorker(false);
     ClearFilterParam();
     g_traceMode = TraceMode::CLOSE;
     g_cpuBufferBalanceService = nullptr;
@@ -1242,6 +1504,7 @@ static TraceErrorCode ResetTracePipelineLocked()
         return TAG_ERROR;
     }
     TraceInit(allTags);
+    RestoreBufferPercent();
     TruncateFile(TRACE_NODE);
     if (IsHmKernel()) {
         ClearNoFilterEvents();
@@ -1614,7 +1877,7 @@ TraceRetInfo DumpTrace(uint32_t maxDuration, uint64_t utTraceEndTime, const std:
     int32_t committedDuration =
         std::min(DEFAULT_FULL_TRACE_LENGTH, static_cast<int32_t>(g_utDestTraceEndTime - g_utDestTraceStartTime));
     if (UNEXPECTANTLY(IsCacheOn())) {
-        GetFileInCache(ret);
+        GetFileInCache(maxDuration, utTraceEndTime, ret);
         LoadDumpRet(ret, committedDuration);
         SanitizeRetInfo(ret);
         return ret;
@@ -1663,7 +1926,7 @@ TraceRetInfo DumpTraceAsync(uint32_t maxDuration, uint64_t utTraceEndTime, int64
     int32_t committedDuration =
         std::min(DEFAULT_FULL_TRACE_LENGTH, static_cast<int32_t>(g_utDestTraceEndTime - g_utDestTraceStartTime));
     if (UNEXPECTANTLY(IsCacheOn())) {
-        GetFileInCache(ret);
+        GetFileInCache(maxDuration, utTraceEndTime, ret);
         LoadDumpRet(ret, committedDuration);
         SanitizeRetInfo(ret);
         replyIfNeeded(ret);
@@ -1733,6 +1996,15 @@ TraceRetInfo RecordTraceOff()
     }
 
     ret.outputFiles = TraceDumpExecutor::GetInstance().StopDumpTraceLoop();
+    // the slices leave with their metadata, the sidecars are removed once no slice refers to them.
+    std::set<std::string> sliceDirs;
+    for (const auto& file : ret.outputFiles) {
+        (void)InlineMetadataSidecar(file);
+        sliceDirs.insert(file.substr(0, file.rfind('/') + 1));
+    }
+    for (const auto& dir : sliceDirs) {
+        RemoveUnusedMetadataSidecars(dir);
+    }
     ret.errorCode = SUCCESS;
     HILOG_INFO(LOG_CORE, "Recording trace off.");
     g_traceMode &= ~TraceMode::RECORD;
@@ -16,11 +16,13 @@
 #include "trace_context.h"
 
 #include <algorithm>
+#include <climits>
 #include <cstring>
+#include <dirent.h>
 #include <fcntl.h>
 #include <memory>
-#include <set>
 #include <sstream>
+#include <unistd.h>
 
 #include "hilog/log.h"
 #include "hitrace_option_util.h"
@@ -39,47 +41,69 @@ namespace Hitrace {
 
 namespace {
 constexpr auto SET_EVENT_PID = "set_event_pid";
+constexpr auto EVENT_FORK_OPTION = "options/event-fork";
 
-bool ParseNumberStr(const char* lineContent, std::string& result)
+constexpr int DECIMAL_BASE = 10;
+
+// parse the decimal at pos and move pos behind it.
+bool ParseNumber(const char*& pos, int& result)
 {
-    size_t validStrLength = 0;
-    while (isdigit(lineContent[validStrLength])) {
-        validStrLength++;
-    }
-    if (validStrLength == 0) {
-        return false;
+    const char* begin = pos;
+    long value = 0;
+    for (; isdigit(*pos); pos++) {
+        value = value * DECIMAL_BASE + (*pos - '0');
+        if (value > INT_MAX) {
+            return false;
+        }
     }
-    result = std::string(lineContent, validStrLength);
-    return true;
+    result = static_cast<int>(value);
+    return pos != begin;
 }
 
-bool GetSetEventPid(std::set<std::string>& set)
+bool GetSetEventPid(std::unordered_set<int>& set)
 {
     const std::string& traceRootPath = Hitrace::GetTraceRootPath();
     if (traceRootPath.empty()) {
         return false;
     }
     return TraverseFileLineByLine(traceRootPath + SET_EVENT_PID, [&set](const char* lineContent, size_t lineNum) {
-        std::string tid;
-        if (ParseNumberStr(lineContent, tid)) {
+        int tid = 0;
+        if (ParseNumber(lineContent, tid)) {
             set.insert(tid);
         }
         return true;
     });
 }
 
-bool ParseTGid(const char* lineContent, std::pair<std::string, std::string>& result)
+// a line of saved_tgids is "<tid> <tgid>".
+bool ParseTGid(const char* lineContent, std::pair<int, int>& result)
 {
-    if (!ParseNumberStr(lineContent, result.first)) {
+    if (!ParseNumber(lineContent, result.first) || !isspace(*lineContent)) {
         return false;
-    };
-    if (!isspace(lineContent[result.first.length()])) {
+    }
+    lineContent++;
+    return ParseNumber(lineContent, result.second);
+}
+
+// with event-fork on, the kernel adds the tasks forked by the tasks of set_event_pid to it and removes them when
+// they exit, false if the option is not supported by the kernel.
+bool EnableEventFork(bool& isOriginOn)
+{
+    const std::string& traceRootPath = Hitrace::GetTraceRootPath();
+    if (traceRootPath.empty() || access((traceRootPath + EVENT_FORK_OPTION).c_str(), W_OK) != 0) {
         return false;
     }
-    return ParseNumberStr(lineContent + result.first.length() + 1, result.second);
+    isOriginOn = false;
+    TraverseFileLineByLine(traceRootPath + EVENT_FORK_OPTION, [&isOriginOn](const char* lineContent, size_t lineNum) {
+        isOriginOn = lineContent[0] == '1';
+        return false;
+    });
+    return isOriginOn || AppendTracePoint(EVENT_FORK_OPTION, "1");
 }
 }
 
+// a thread of this process which stays in set_event_pid ahead of the filter pids, it is only kept on the kernels
+// without event-fork.
 struct StandInThreadContext {
     std::mutex mutex;
     std::condition_variable cv;
@@ -121,14 +145,21 @@ StandInThreadContext::~StandInThreadContext()
 TraceFilterContext::TraceFilterContext()
 {
     initPid_ = getpid();
-    standInThreadContext_ = new StandInThreadContext();
-    standInTid_ = standInThreadContext_->tid;
+    isEventForkOn_ = EnableEventFork(isEventForkOriginOn_);
+    if (!isEventForkOn_) {
+        standInThreadContext_ = new StandInThreadContext();
+        standInTid_ = standInThreadContext_->tid;
+    }
     ClearTracePoint(SET_EVENT_PID);
+    HILOG_INFO(LOG_CORE, "TraceFilterContext: event-fork %{public}s", isEventForkOn_ ? "on" : "unsupported");
 }
 
 TraceFilterContext::~TraceFilterContext()
 {
     ClearTracePoint(SET_EVENT_PID);
+    if (isEventForkOn_ && !isEventForkOriginOn_) {
+        AppendTracePoint(EVENT_FORK_OPTION, "0");
+    }
     if (initPid_ == getpid()) {
         delete standInThreadContext_;
     }
@@ -140,7 +171,7 @@ bool TraceFilterContext::AddFilterPids(const std::vector<std::string> &filterPid
         return false;
     }
     FileLock fileLock(Hitrace::GetTraceRootPath() + SET_EVENT_PID, O_RDWR);
-    std::string initContent = std::to_string(standInTid_);
+    std::string initContent = standInThreadContext_ == nullptr ? "" : std::to_string(standInTid_);
     for (const auto& tid : filterPids) {
         initContent += (" " + tid);
     }
@@ -149,8 +180,15 @@ bool TraceFilterContext::AddFilterPids(const std::vector<std::string> &filterPid
         return false;
     }
     HILOG_INFO(LOG_CORE, "success add content %{public}s to set_event_pid", initContent.c_str());
+    TraceContextManager::GetInstance().BumpGeneration();
     std::vector<std::string> tids;
     for (auto& pid : filterPids) {
+        const char* pidStr = pid.c_str();
+        int tgid = 0;
+        bool isPid = ParseNumber(pidStr, tgid) && *pidStr == '\0';
+        if (isEventForkOn_ && isPid && originTGids_.count(tgid) != 0) {
+            continue; // the threads created after the first scan are added by the kernel
+        }
         const std::string dirPath = "/proc/" + pid + "/task/";
         const auto dir = std::unique_ptr<DIR, void(*)(DIR*)>(opendir(dirPath.c_str()), [](DIR* dir) {
             if (dir != nullptr) {
@@ -165,7 +203,11 @@ bool TraceFilterContext::AddFilterPids(const std::vector<std::string> &filterPid
             if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
                 continue;
             }
-            originTGids_[entry->d_name] = pid;
+            const char* tidStr = entry->d_name;
+            int tid = 0;
+            if (isPid && ParseNumber(tidStr, tid)) {
+                originTGids_[tid] = tgid;
+            }
             if (write(fileLock.Fd(), entry->d_name, strlen(entry->d_name)) < 0) {
                 HILOG_ERROR(LOG_CORE, "AppendToFile: set_event_pid %{public}s failed %{public}d", entry->d_name, errno);
                 return false;
@@ -178,23 +220,19 @@ bool TraceFilterContext::AddFilterPids(const std::vector<std::string> &filterPid
 
 void TraceFilterContext::FilterSavedCmdLine()
 {
-    filterCmdLines_.clear();
+    for (auto iter = filterCmdLines_.begin(); iter != filterCmdLines_.end();) {
+        iter = filterTGidsContent_.count(iter->first) == 0 ? filterCmdLines_.erase(iter) : std::next(iter);
+    }
     const std::string& traceRootPath = Hitrace::GetTraceRootPath();
     if (traceRootPath.empty()) {
         return;
     }
     TraverseFileLineByLine(traceRootPath + "saved_cmdlines",
         [this](const char* lineContent, size_t lineNum) {
-            std::string tid;
-            if (!ParseNumberStr(lineContent, tid)) {
-                return true;
-            }
-            bool ret = std::any_of(filterTGidsContent_.begin(), filterTGidsContent_.end(),
-                [&tid] (const std::pair<std::string, std::string>& tgids) {
-                        return tid == tgids.first;
-                });
-            if (ret) {
-                filterCmdLines_.emplace_back(lineContent);
+            const char* pos = lineContent;
+            int tid = 0;
+            if (ParseNumber(pos, tid) && filterTGidsContent_.count(tid) != 0) {
+                filterCmdLines_[tid] = lineContent;
             }
             return true;
         });
@@ -202,75 +240,88 @@ void TraceFilterContext::FilterSavedCmdLine()
 
 void TraceFilterContext::FilterTGidsContent()
 {
-    filterTGidsContent_.clear();
-    filterPids_.clear();
     const std::string& traceRootPath = Hitrace::GetTraceRootPath();
-    std::set<std::string> set;
+    std::unordered_set<int> set;
     if (traceRootPath.empty() || !GetSetEventPid(set)) {
         return;
     }
-    const auto standInTidStr = std::to_string(standInTid_);
+    // saved_tgids is read once, the processes of the tids in set_event_pid are known after the whole file.
+    savedTGids_.clear();
     TraverseFileLineByLine(traceRootPath + "saved_tgids",
-        [this, &set, &standInTidStr](const char* lineContent, size_t lineNum) {
-            std::pair<std::string, std::string> tGid;
-            if (!ParseTGid(lineContent, tGid)) {
+        [this, &set](const char* lineContent, size_t lineNum) {
+            std::pair<int, int> tGid;
+            if (!ParseTGid(lineContent, tGid) || tGid.first == standInTid_) {
                 return true;
             }
-            if (set.find(tGid.first) != set.end()) {
-                if (tGid.first == standInTidStr) {
-                    return true;
-                }
-                auto originTGid = originTGids_.find(tGid.first);
-                if (originTGid != originTGids_.end() && originTGid->second != tGid.second) {
-                    return true;
-                }
-                filterPids_.insert(tGid.second);
-            }
-            return true;
-        });
-    TraverseFileLineByLine(traceRootPath + "saved_tgids",
-        [this, &standInTidStr](const char* lineContent, size_t lineNum) {
-            std::pair<std::string, std::string> tGid;
-            if (!ParseTGid(lineContent, tGid)) {
+            savedTGids_.push_back(tGid);
+            if (set.count(tGid.first) == 0) {
                 return true;
             }
-            if (filterPids_.find(tGid.second) != filterPids_.end()) {
-                if (tGid.first != standInTidStr) {
-                    filterTGidsContent_.emplace_back(tGid);
-                }
+            auto originTGid = originTGids_.find(tGid.first);
+            if (originTGid == originTGids_.end() || originTGid->second == tGid.second) {
+                filterPids_.insert(tGid.second);
             }
             return true;
         });
+    for (const auto& tGid : savedTGids_) {
+        if (filterPids_.count(tGid.second) != 0) {
+            filterTGidsContent_[tGid.first] = tGid.second;
+        } else {
+            filterTGidsContent_.erase(tGid.first); // the tid is reused by a process out of the filter
+        }
+    }
 }
 
 void TraceFilterContext::FilterTraceContent()
 {
     FilterTGidsContent();
     FilterSavedCmdLine();
+    HILOG_INFO(LOG_CORE, "FilterTraceContent: %{public}zu processes, %{public}zu threads, %{public}zu cmdlines",
+        filterPids_.size(), filterTGidsContent_.size(), filterCmdLines_.size());
 }
 
 void TraceFilterContext::TraverseSavedCmdLine(const std::function<void(const std::string& savedCmdLine)>& handler) const
 {
     if (handler) {
-        std::for_each(filterCmdLines_.begin(),  filterCmdLines_.end(), handler);
+        for (const auto& cmdLine : filterCmdLines_) {
+            handler(cmdLine.second);
+        }
     }
 }
 
-void TraceFilterContext::TraverseTGidsContent(
-    const std::function<void(const std::pair<std::string, std::string>& tgid)>& handler) const
+void TraceFilterContext::TraverseTGidsContent(const std::function<void(const std::pair<int, int>& tgid)>& handler) const
 {
     if (handler) {
-        std::for_each(filterTGidsContent_.begin(),  filterTGidsContent_.end(), handler);
+        for (const auto& tGid : filterTGidsContent_) {
+            handler(tGid);
+        }
     }
 }
 
-void TraceFilterContext::TraverseFilterPid(const std::function<void(const std::string& pid)>& handler) const
+void TraceFilterContext::TraverseFilterPid(const std::function<void(const int pid)>& handler) const
 {
     if (handler) {
         std::for_each(filterPids_.begin(),  filterPids_.end(), handler);
     }
 }
 
+void TraceFilterContext::TraverseFilterPid(const std::function<void(const std::string& pid)>& handler) const
+{
+    if (handler) {
+        TraverseFilterPid([&handler](const int pid) { handler(std::to_string(pid)); });
+    }
+}
+
+void TraceFilterContext::TraverseTGidsContent(
+    const std::function<void(const std::pair<std::string, std::string>& tgid)>& handler) const
+{
+    if (handler) {
+        TraverseTGidsContent([&handler](const std::pair<int, int>& tgid) {
+            handler(std::make_pair(std::to_string(tgid.first), std::to_string(tgid.second)));
+        });
+    }
+}
+
 TraceContextManager &TraceContextManager::GetInstance()
 {
     static TraceContextManager instance;
@@ -280,6 +331,7 @@ TraceContextManager &TraceContextManager::GetInstance()
 void TraceContextManager::ReleaseContext()
 {
     traceFilterContext_ = nullptr;
+    BumpGeneration();
 }
 
 std::shared_ptr<TraceFilterContext> TraceContextManager::GetTraceFilterContext(bool createIfNotExisted)
@@ -288,6 +340,7 @@ std::shared_ptr<TraceFilterContext> TraceContextManager::GetTraceFilterContext(b
         return traceFilterContext_;
     }
     traceFilterContext_ = std::make_shared<TraceFilterContext>();
+    BumpGeneration();
     return traceFilterContext_;
 }
 }
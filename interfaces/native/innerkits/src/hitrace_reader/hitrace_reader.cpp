@@ -0,0 +1,594 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hitrace_reader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "common_define.h"
+#include "hilog/log.h"
+#include "securec.h"
+#include "trace_file_format.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+#ifdef LOG_DOMAIN
+#undef LOG_DOMAIN
+#define LOG_DOMAIN 0xD002D33
+#endif
+#ifdef LOG_TAG
+#undef LOG_TAG
+#define LOG_TAG "HitraceReader"
+#endif
+
+namespace {
+constexpr uint32_t TYPE_LEN_MASK = 0x1f;
+constexpr uint32_t TIME_DELTA_SHIFT = 5;
+constexpr uint32_t TIME_EXTEND_SHIFT = 27;
+constexpr uint32_t TYPE_PADDING = 29;
+constexpr uint32_t TYPE_TIME_EXTEND = 30;
+constexpr uint32_t TYPE_TIME_STAMP = 31;
+constexpr uint64_t COMMIT_MASK = (1ULL << 27) - 1; // the high bits of commit flag missed events
+constexpr uint32_t EVENT_ALIGN_MASK = 3;
+constexpr uint32_t CPU_RAW_MAX_CPU = CONTENT_TYPE_HEADER_PAGE - CONTENT_TYPE_CPU_RAW;
+constexpr std::string_view NAME_PREFIX = "name: ";
+constexpr std::string_view ID_PREFIX = "ID: ";
+constexpr std::string_view FIELD_PREFIX = "field:";
+constexpr std::string_view PRINT_FMT_PREFIX = "print fmt: ";
+constexpr size_t HASH_NAME_SIZE = 17; // 16 hex digits and '\0'
+
+inline uint32_t ReadU32(const uint8_t* pos)
+{
+    uint32_t value = 0;
+    memcpy(&value, pos, sizeof(value));
+    return value;
+}
+
+inline uint64_t ReadU64(const uint8_t* pos)
+{
+    uint64_t value = 0;
+    memcpy(&value, pos, sizeof(value));
+    return value;
+}
+
+std::string_view TrimLeft(std::string_view str)
+{
+    size_t pos = str.find_first_not_of(" \t");
+    return pos == std::string_view::npos ? std::string_view() : str.substr(pos);
+}
+
+template<typename T>
+bool ParseNumber(const std::string_view str, T& value)
+{
+    auto ret = std::from_chars(str.data(), str.data() + str.size(), value);
+    return ret.ec == std::errc();
+}
+
+// value of "key:N;" in a field line of a format file, such as "offset:8;".
+template<typename T>
+bool ParseFieldAttr(const std::string_view line, const std::string_view key, T& value)
+{
+    size_t pos = line.find(key);
+    return pos != std::string_view::npos && ParseNumber(line.substr(pos + key.size()), value);
+}
+
+// "\tfield:unsigned char buf[12];\toffset:16;\tsize:12;\tsigned:0;"
+bool ParseField(std::string_view line, TraceEventField& field)
+{
+    line = TrimLeft(line.substr(FIELD_PREFIX.size()));
+    size_t declEnd = line.find(';');
+    if (declEnd == std::string_view::npos) {
+        return false;
+    }
+    std::string_view decl = line.substr(0, declEnd);
+    size_t nameBegin = decl.rfind(' ');
+    if (nameBegin == std::string_view::npos) {
+        return false;
+    }
+    std::string_view name = decl.substr(nameBegin + 1);
+    field.type = std::string(decl.substr(0, nameBegin));
+    field.name = std::string(name.substr(0, name.find('[')));
+    int isSigned = 0;
+    if (!ParseFieldAttr(line, "offset:", field.offset) || !ParseFieldAttr(line, "size:", field.size) ||
+        !ParseFieldAttr(line, "signed:", isSigned)) {
+        return false;
+    }
+    field.isSigned = isSigned != 0;
+    return true;
+}
+
+template<typename Handler>
+void ForEachLine(std::string_view content, Handler&& handler)
+{
+    while (!content.empty()) {
+        size_t lineEnd = content.find('\n');
+        handler(content.substr(0, lineEnd));
+        if (lineEnd == std::string_view::npos) {
+            break;
+        }
+        content.remove_prefix(lineEnd + 1);
+    }
+}
+
+// "pid value" lines of the cmdlines and tgids sections.
+template<typename Handler>
+void ForEachPidLine(const std::string_view content, Handler&& handler)
+{
+    ForEachLine(content, [&handler](std::string_view line) {
+        line = TrimLeft(line);
+        size_t sep = line.find(' ');
+        int32_t pid = 0;
+        if (sep != std::string_view::npos && ParseNumber(line.substr(0, sep), pid)) {
+            handler(pid, line.substr(sep + 1));
+        }
+    });
+}
+
+const std::vector<TraceRawSpan> EMPTY_SPANS;
+} // namespace
+
+const TraceEventField* TraceEventFormat::GetField(const std::string_view fieldName) const
+{
+    for (const auto& field : fields) {
+        if (field.name == fieldName) {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+TraceCpuEventCursor::TraceCpuEventCursor(const uint32_t cpu, const std::vector<TraceRawSpan>* spans,
+    const TracePageLayout& layout) : cpu_(cpu), spans_(spans), layout_(layout) {}
+
+bool TraceCpuEventCursor::LoadSpan()
+{
+    while (spanIdx_ < spans_->size()) {
+        const TraceRawSpan& span = (*spans_)[spanIdx_++];
+        pageOffset_ = 0;
+        if (span.rawSize == span.size) {
+            pages_ = span.data;
+            pagesSize_ = span.size;
+            return true;
+        }
+        chunkBuffer_.resize(span.rawSize);
+        uLongf rawSize = span.rawSize;
+        int ret = uncompress(chunkBuffer_.data(), &rawSize, span.data, span.size);
+        if (ret != Z_OK || rawSize != span.rawSize) {
+            HILOG_WARN(LOG_CORE, "TraceCpuEventCursor: skip a broken chunk of cpu %{public}u, ret(%{public}d).",
+                cpu_, ret);
+            continue;
+        }
+        pages_ = chunkBuffer_.data();
+        pagesSize_ = chunkBuffer_.size();
+        return true;
+    }
+    pages_ = nullptr;
+    pagesSize_ = 0;
+    return false;
+}
+
+bool TraceCpuEventCursor::NextPage()
+{
+    while (pages_ == nullptr || pageOffset_ + layout_.dataOffset > pagesSize_) {
+        if (!LoadSpan()) {
+            return false;
+        }
+    }
+    const uint8_t* page = pages_ + pageOffset_;
+    size_t pageSize = std::min(PAGE_SIZE, pagesSize_ - pageOffset_);
+    pageOffset_ += PAGE_SIZE;
+    timestamp_ = ReadU64(page);
+    uint64_t commit = layout_.commitSize == sizeof(uint32_t) ? ReadU32(page + layout_.commitOffset) :
+        ReadU64(page + layout_.commitOffset);
+    eventPos_ = page + layout_.dataOffset;
+    eventEnd_ = page + std::min(static_cast<size_t>(layout_.dataOffset + (commit & COMMIT_MASK)), pageSize);
+    pageCount_++;
+    return true;
+}
+
+bool TraceCpuEventCursor::Next(TraceRawEvent& event)
+{
+    while (true) {
+        if (eventPos_ + sizeof(uint32_t) > eventEnd_) {
+            if (!NextPage()) {
+                return false;
+            }
+            continue;
+        }
+        uint32_t header = ReadU32(eventPos_);
+        uint32_t typeLen = header & TYPE_LEN_MASK;
+        uint32_t timeDelta = header >> TIME_DELTA_SHIFT;
+        const uint8_t* body = eventPos_ + sizeof(uint32_t);
+        const uint8_t* data = body;
+        uint32_t size = typeLen * sizeof(uint32_t);
+        if (typeLen >= TYPE_PADDING || typeLen == 0) {
+            if ((typeLen == TYPE_PADDING && timeDelta == 0) || body + sizeof(uint32_t) > eventEnd_) {
+                eventPos_ = eventEnd_; // the rest of the page is padding
+                continue;
+            }
+            uint32_t array0 = ReadU32(body);
+            if (typeLen == TYPE_TIME_EXTEND || typeLen == TYPE_TIME_STAMP) {
+                uint64_t time = (static_cast<uint64_t>(array0) << TIME_EXTEND_SHIFT) + timeDelta;
+                timestamp_ = typeLen == TYPE_TIME_STAMP ? time : timestamp_ + time;
+                eventPos_ = body + sizeof(uint32_t);
+                continue;
+            }
+            if (typeLen == TYPE_PADDING) { // a discarded event
+                timestamp_ += timeDelta;
+                eventPos_ = body + array0;
+                continue;
+            }
+            if (array0 < sizeof(uint32_t)) {
+                eventPos_ = eventEnd_;
+                continue;
+            }
+            data = body + sizeof(uint32_t);
+            size = array0 - sizeof(uint32_t);
+        }
+        eventPos_ = data + ((size + EVENT_ALIGN_MASK) & ~EVENT_ALIGN_MASK);
+        timestamp_ += timeDelta;
+        if (data + size > eventEnd_) {
+            eventPos_ = eventEnd_;
+            continue;
+        }
+        event.timestamp = timestamp_;
+        event.cpu = cpu_;
+        event.size = size;
+        event.data = data;
+        event.id = 0;
+        if (size >= sizeof(uint16_t)) {
+            memcpy(&event.id, data, sizeof(uint16_t));
+        }
+        return true;
+    }
+}
+
+TraceMergedEventCursor::TraceMergedEventCursor(std::vector<TraceCpuEventCursor>&& cursors)
+    : cursors_(std::move(cursors)), heads_(cursors_.size()) {}
+
+bool TraceMergedEventCursor::IsEarlier(const size_t lhs, const size_t rhs) const
+{
+    const auto& left = heads_[lhs];
+    const auto& right = heads_[rhs];
+    return left.timestamp < right.timestamp || (left.timestamp == right.timestamp && left.cpu < right.cpu);
+}
+
+void TraceMergedEventCursor::SiftDown(size_t pos)
+{
+    const size_t count = heap_.size();
+    while (true) {
+        size_t left = pos * 2 + 1; // 2 : binary heap
+        if (left >= count) {
+            return;
+        }
+        size_t child = (left + 1 < count && IsEarlier(heap_[left + 1], heap_[left])) ? left + 1 : left;
+        if (!IsEarlier(heap_[child], heap_[pos])) {
+            return;
+        }
+        std::swap(heap_[child], heap_[pos]);
+        pos = child;
+    }
+}
+
+bool TraceMergedEventCursor::Next(TraceRawEvent& event)
+{
+    if (!isStarted_) {
+        isStarted_ = true;
+        for (size_t i = 0; i < cursors_.size(); i++) {
+            if (cursors_[i].Next(heads_[i])) {
+                heap_.push_back(i);
+            }
+        }
+        for (size_t pos = heap_.size() / 2; pos > 0; pos--) { // 2 : the last parent of the heap
+            SiftDown(pos - 1);
+        }
+    } else if (!heap_.empty()) {
+        // the cursor of the last returned event only moves now, so its page is valid until this call.
+        size_t top = heap_[0];
+        if (!cursors_[top].Next(heads_[top])) {
+            heap_[0] = heap_.back();
+            heap_.pop_back();
+        }
+        SiftDown(0);
+    }
+    if (heap_.empty()) {
+        return false;
+    }
+    event = heads_[heap_[0]];
+    return true;
+}
+
+TraceReader::~TraceReader()
+{
+    Close();
+}
+
+bool TraceReader::Open(const std::string& traceFile)
+{
+    Close();
+    int fd = open(traceFile.c_str(), O_RDONLY);
+    if (fd < 0) {
+        HILOG_ERROR(LOG_CORE, "TraceReader: open %{public}s failed, errno(%{public}d).", traceFile.c_str(), errno);
+        return false;
+    }
+    struct stat fileStat = {};
+    if (fstat(fd, &fileStat) != 0 || static_cast<size_t>(fileStat.st_size) < sizeof(TraceFileHeader)) {
+        HILOG_ERROR(LOG_CORE, "TraceReader: %{public}s is too small.", traceFile.c_str());
+        close(fd);
+        return false;
+    }
+    mapSize_ = static_cast<size_t>(fileStat.st_size);
+    void* addr = mmap(nullptr, mapSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        HILOG_ERROR(LOG_CORE, "TraceReader: mmap %{public}s failed, errno(%{public}d).", traceFile.c_str(), errno);
+        mapSize_ = 0;
+        return false;
+    }
+    mapAddr_ = static_cast<uint8_t*>(addr);
+    madvise(mapAddr_, mapSize_, MADV_SEQUENTIAL);
+    TraceFileHeader fileHeader;
+    memcpy(&fileHeader, mapAddr_, sizeof(fileHeader));
+    if (fileHeader.magicNumber != MAGIC_NUMBER || fileHeader.fileType != FILE_RAW_TRACE) {
+        HILOG_ERROR(LOG_CORE, "TraceReader: %{public}s is not a linux raw trace file.", traceFile.c_str());
+        Close();
+        return false;
+    }
+    versionNumber_ = fileHeader.versionNumber;
+    traceDir_ = traceFile.substr(0, traceFile.rfind('/') + 1);
+    return ParseSections();
+}
+
+void TraceReader::Close()
+{
+    if (mapAddr_ != nullptr) {
+        munmap(mapAddr_, mapSize_);
+    }
+    mapAddr_ = nullptr;
+    mapSize_ = 0;
+    versionNumber_ = 0;
+    traceDir_.clear();
+    sidecarContent_.clear();
+    sections_.clear();
+    eventFormats_.clear();
+    cmdlines_.clear();
+    tgids_.clear();
+    cpuSpans_.clear();
+    pageLayout_ = TracePageLayout();
+}
+
+bool TraceReader::ParseSections()
+{
+    size_t offset = sizeof(TraceFileHeader);
+    while (offset + sizeof(TraceFileContentHeader) <= mapSize_) {
+        TraceFileContentHeader contentHeader;
+        memcpy(&contentHeader, mapAddr_ + offset, sizeof(contentHeader));
+        if (contentHeader.type == CONTENT_TYPE_DEFAULT) {
+            break;
+        }
+        offset += sizeof(TraceFileContentHeader);
+        // a file which is still being written may end in the middle of a section, keep what is there.
+        TraceSectionView section = { contentHeader.type,
+            static_cast<uint32_t>(std::min(static_cast<size_t>(contentHeader.length), mapSize_ - offset)),
+            mapAddr_ + offset };
+        offset += contentHeader.length;
+        if (section.type == CONTENT_TYPE_METADATA_REF) {
+            LoadMetadataSidecar(section);
+            continue;
+        }
+        AddSection(section);
+    }
+    HILOG_INFO(LOG_CORE, "TraceReader: %{public}zu sections, %{public}zu event formats, %{public}zu cpus.",
+        sections_.size(), eventFormats_.size(), cpuSpans_.size());
+    return true;
+}
+
+void TraceReader::AddSection(const TraceSectionView& section)
+{
+    sections_.push_back(section);
+    std::string_view content(reinterpret_cast<const char*>(section.data), section.length);
+    if (section.type >= CONTENT_TYPE_CPU_RAW && section.type < CONTENT_TYPE_CPU_RAW + CPU_RAW_MAX_CPU) {
+        cpuSpans_[section.type - CONTENT_TYPE_CPU_RAW].push_back({ section.data, section.length, section.length });
+    } else if (section.type == CONTENT_TYPE_CPU_RAW_COMPRESSED) {
+        AddCompressedSection(section);
+    } else if (section.type == CONTENT_TYPE_EVENTS_FORMAT) {
+        ParseEventFormats(content);
+    } else if (section.type == CONTENT_TYPE_HEADER_PAGE) {
+        ParseHeaderPage(content);
+    } else if (section.type == CONTENT_TYPE_CMDLINES) {
+        ParseCmdlines(content);
+    } else if (section.type == CONTENT_TYPE_TGIDS) {
+        ParseTgids(content);
+    }
+}
+
+bool TraceReader::LoadMetadataSidecar(const TraceSectionView& refSection)
+{
+    TraceMetadataRef ref;
+    if (refSection.length != sizeof(ref) || !sidecarContent_.empty()) {
+        return false;
+    }
+    char hashName[HASH_NAME_SIZE] = {0};
+    if (memcpy_s(&ref, sizeof(ref), refSection.data, sizeof(ref)) != EOK ||
+        sprintf_s(hashName, sizeof(hashName), "%016" PRIx64, ref.hash) < 0) {
+        HILOG_ERROR(LOG_CORE, "TraceReader: parse the metadata ref failed.");
+        return false;
+    }
+    std::string sidecarPath = traceDir_ + METADATA_SIDECAR_FILE_PREFIX + hashName;
+    std::ifstream sidecarFile(sidecarPath, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(sidecarFile)), std::istreambuf_iterator<char>());
+    TraceMetadataRef sidecarRef;
+    if (content.size() < sizeof(sidecarRef)) {
+        HILOG_ERROR(LOG_CORE, "TraceReader: read the sidecar %{public}s failed.", sidecarPath.c_str());
+        return false;
+    }
+    if (memcpy_s(&sidecarRef, sizeof(sidecarRef), content.data(), sizeof(sidecarRef)) != EOK) {
+        HILOG_ERROR(LOG_CORE, "TraceReader: parse the sidecar %{public}s failed.", sidecarPath.c_str());
+        return false;
+    }
+    if (sidecarRef.magic != ref.magic || sidecarRef.hash != ref.hash || sidecarRef.sectionCount != ref.sectionCount) {
+        HILOG_ERROR(LOG_CORE, "TraceReader: the sidecar %{public}s does not match the file.", sidecarPath.c_str());
+        return false;
+    }
+    sidecarContent_ = std::move(content);
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(sidecarContent_.data());
+    size_t offset = sizeof(sidecarRef);
+    while (offset + sizeof(TraceFileContentHeader) <= sidecarContent_.size()) {
+        TraceFileContentHeader contentHeader;
+        if (memcpy_s(&contentHeader, sizeof(contentHeader), data + offset, sizeof(contentHeader)) != EOK) {
+            break;
+        }
+        offset += sizeof(TraceFileContentHeader);
+        if (contentHeader.length > sidecarContent_.size() - offset) {
+            break;
+        }
+        AddSection({ contentHeader.type, contentHeader.length, data + offset });
+        offset += contentHeader.length;
+    }
+    return true;
+}
+
+bool TraceReader::AddCompressedSection(const TraceSectionView& section)
+{
+    TraceCompressedRawHeader rawHeader;
+    if (section.length < sizeof(rawHeader)) {
+        return false;
+    }
+    memcpy(&rawHeader, section.data, sizeof(rawHeader));
+    if (rawHeader.algorithm != TRACE_COMPRESS_ZLIB) {
+        HILOG_WARN(LOG_CORE, "TraceReader: unknown compress algorithm %{public}hhu.", rawHeader.algorithm);
+        return false;
+    }
+    auto& spans = cpuSpans_[rawHeader.cpu];
+    size_t offset = sizeof(rawHeader);
+    while (offset + sizeof(TraceCompressedChunkHeader) <= section.length) {
+        TraceCompressedChunkHeader chunkHeader;
+        memcpy(&chunkHeader, section.data + offset, sizeof(chunkHeader));
+        offset += sizeof(chunkHeader);
+        if (chunkHeader.compressedSize > section.length - offset) {
+            break;
+        }
+        spans.push_back({ section.data + offset, chunkHeader.compressedSize, chunkHeader.uncompressedSize });
+        offset += chunkHeader.compressedSize;
+    }
+    return true;
+}
+
+void TraceReader::ParseEventFormats(const std::string_view content)
+{
+    TraceEventFormat format;
+    bool hasId = false;
+    ForEachLine(content, [this, &format, &hasId](std::string_view line) {
+        line = TrimLeft(line);
+        if (line.compare(0, FIELD_PREFIX.size(), FIELD_PREFIX) == 0) {
+            TraceEventField field;
+            if (ParseField(line, field)) {
+                format.fields.push_back(std::move(field));
+            }
+        } else if (line.compare(0, NAME_PREFIX.size(), NAME_PREFIX) == 0) {
+            format = TraceEventFormat();
+            format.name = std::string(line.substr(NAME_PREFIX.size()));
+            hasId = false;
+        } else if (line.compare(0, ID_PREFIX.size(), ID_PREFIX) == 0) {
+            hasId = ParseNumber(line.substr(ID_PREFIX.size()), format.id);
+        } else if (line.compare(0, PRINT_FMT_PREFIX.size(), PRINT_FMT_PREFIX) == 0 && hasId) {
+            format.printFmt = std::string(line.substr(PRINT_FMT_PREFIX.size()));
+            uint16_t id = format.id;
+            eventFormats_[id] = std::move(format);
+            format = TraceEventFormat();
+            hasId = false;
+        }
+    });
+}
+
+void TraceReader::ParseHeaderPage(const std::string_view content)
+{
+    ForEachLine(content, [this](std::string_view line) {
+        line = TrimLeft(line);
+        TraceEventField field;
+        if (line.compare(0, FIELD_PREFIX.size(), FIELD_PREFIX) != 0 || !ParseField(line, field)) {
+            return;
+        }
+        if (field.name == "commit" && (field.size == sizeof(uint32_t) || field.size == sizeof(uint64_t))) {
+            pageLayout_.commitOffset = field.offset;
+            pageLayout_.commitSize = field.size;
+        } else if (field.name == "data" && field.offset < PAGE_SIZE) {
+            pageLayout_.dataOffset = field.offset;
+        }
+    });
+}
+
+void TraceReader::ParseCmdlines(const std::string_view content)
+{
+    ForEachPidLine(content, [this](const int32_t pid, const std::string_view comm) {
+        cmdlines_[pid] = std::string(comm);
+    });
+}
+
+void TraceReader::ParseTgids(const std::string_view content)
+{
+    ForEachPidLine(content, [this](const int32_t pid, const std::string_view value) {
+        int32_t tgid = 0;
+        if (ParseNumber(value, tgid)) {
+            tgids_[pid] = tgid;
+        }
+    });
+}
+
+const TraceEventFormat* TraceReader::GetEventFormat(const uint16_t id) const
+{
+    auto iter = eventFormats_.find(id);
+    return iter == eventFormats_.end() ? nullptr : &iter->second;
+}
+
+std::vector<uint32_t> TraceReader::GetCpus() const
+{
+    std::vector<uint32_t> cpus;
+    for (const auto& [cpu, spans] : cpuSpans_) {
+        cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+TraceCpuEventCursor TraceReader::GetCpuEvents(const uint32_t cpu) const
+{
+    auto iter = cpuSpans_.find(cpu);
+    return TraceCpuEventCursor(cpu, iter == cpuSpans_.end() ? &EMPTY_SPANS : &iter->second, pageLayout_);
+}
+
+TraceMergedEventCursor TraceReader::GetMergedEvents() const
+{
+    std::vector<TraceCpuEventCursor> cursors;
+    for (const auto& [cpu, spans] : cpuSpans_) {
+        cursors.emplace_back(cpu, &spans, pageLayout_);
+    }
+    return TraceMergedEventCursor(std::move(cursors));
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
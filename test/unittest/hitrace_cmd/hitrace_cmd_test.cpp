@@ -1856,6 +1856,41 @@ HWTEST_F(HitraceCMDTest, HitraceCMDTest056, TestSize.Level1)
     GTEST_LOG_(INFO) << "HitraceCMDTest056: end.";
 }
 
+/**
+ * @tc.name: HitraceCMDTest057
+ * @tc.desc: test --decompress command when the source file or the output file is illegal
+ * @tc.type: FUNC
+ */
+HWTEST_F(HitraceCMDTest, HitraceCMDTest057, TestSize.Level1)
+{
+    GTEST_LOG_(INFO) << "HitraceCMDTest057: start.";
+
+    std::string cmd = "hitrace --decompress /data/local/tmp/not_exist_trace.sys -o /data/local/tmp/plain.sys";
+    std::vector<std::string> keywords = {
+        "error: the trace file to decompress is illegal",
+    };
+    EXPECT_TRUE(CheckTraceCommandOutput(cmd, keywords));
+
+    const std::string srcFile = "/data/local/tmp/hitrace_cmd_decompress.sys";
+    std::ofstream(srcFile) << "not a raw trace file";
+    cmd = "hitrace --decompress " + srcFile;
+    keywords = {
+        "DECOMPRESS_TRACE_FILE",
+        "error: the output file is not specified",
+    };
+    EXPECT_TRUE(CheckTraceCommandOutput(cmd, keywords));
+
+    cmd = "hitrace --decompress " + srcFile + " -o /data/local/tmp/hitrace_cmd_plain.sys";
+    keywords = {
+        "error: decompress " + srcFile + " failed",
+    };
+    EXPECT_TRUE(CheckTraceCommandOutput(cmd, keywords));
+    remove(srcFile.c_str());
+    remove("/data/local/tmp/hitrace_cmd_plain.sys");
+
+    GTEST_LOG_(INFO) << "HitraceCMDTest057: end.";
+}
+
 }
 }
 }
@@ -1640,6 +1640,35 @@ HWTEST_F(HitraceDumpTest, OpenTraceTest004, TestSize.Level1)
     GTEST_LOG_(INFO) << "OpenTraceTest004: end.";
 }
 
+/**
+ * @tc.name: OpenTraceTest005
+ * @tc.desc: Test buffer_percent is raised while the trace is open and restored by CloseTrace
+ * @tc.type: FUNC
+ */
+HWTEST_F(HitraceDumpTest, OpenTraceTest005, TestSize.Level1)
+{
+    if (IsHmKernel()) {
+        GTEST_LOG_(INFO) << "OpenTraceTest005: buffer_percent is not set on hm kernel, skip.";
+        return;
+    }
+    ASSERT_TRUE(!GetTraceRootPath().empty());
+    auto readBufferPercent = []() {
+        std::string bufferPercent = ReadFile("buffer_percent", GetTraceRootPath());
+        return bufferPercent.substr(0, bufferPercent.find("\n"));
+    };
+    const std::string oldBufferPercent = "50";
+    std::ofstream(GetTraceRootPath() + "buffer_percent", std::ios::trunc) << oldBufferPercent;
+    TraceArgs traceArgs = {
+        .tags = { "app" },
+        .bufferSize = DEFAULT_BUFFER_SIZE,
+        .fileSizeLimit = DEFAULT_FILE_SIZE_LIMIT
+    };
+    ASSERT_EQ(static_cast<int>(OpenTrace(traceArgs)), static_cast<int>(TraceErrorCode::SUCCESS));
+    EXPECT_EQ(readBufferPercent(), "25");
+    ASSERT_EQ(static_cast<int>(CloseTrace()), static_cast<int>(TraceErrorCode::SUCCESS));
+    EXPECT_EQ(readBufferPercent(), oldBufferPercent);
+}
+
 /**
  * @tc.name: DynamicBufferTest001
  * @tc.desc: Test DynaMicBuffer
@@ -18,6 +18,7 @@
 #include "parameters.h"
 #include "common_utils.h"
 #include "hitrace_option/hitrace_option.h"
+#include "hitrace_option/hitrace_option_util.h"
 #include "hitrace_option/trace_context.h"
 
 #include <unistd.h>
@@ -32,6 +33,16 @@ namespace OHOS {
 namespace HiviewDFX {
 namespace HitraceTest {
 
+namespace {
+char ReadOption(const std::string& path)
+{
+    std::ifstream file(path);
+    char value = '\0';
+    file >> value;
+    return value;
+}
+}
+
 class HitraceContextTest : public testing::Test {
 public:
     void SetUp() override;
@@ -84,12 +95,12 @@ HWTEST_F(HitraceContextTest, HitraceContextTest004, TestSize.Level1)
     ASSERT_TRUE(filterTraceContext->AddFilterPids({ std::to_string(getpid()) }));
     std::this_thread::sleep_for(std::chrono::seconds(4));
     filterTraceContext->FilterTraceContent();
-    filterTraceContext->TraverseFilterPid({});
-    filterTraceContext->TraverseFilterPid([] (const std::string& pid) {
+    filterTraceContext->TraverseFilterPid(std::function<void(const int)>());
+    filterTraceContext->TraverseFilterPid([] (const int pid) {
         GTEST_LOG_(INFO) << "FilterPid: " << pid;
     });
-    filterTraceContext->TraverseTGidsContent({});
-    filterTraceContext->TraverseTGidsContent([] (const std::pair<std::string, std::string>& tgid) {
+    filterTraceContext->TraverseTGidsContent(std::function<void(const std::pair<int, int>&)>());
+    filterTraceContext->TraverseTGidsContent([] (const std::pair<int, int>& tgid) {
         GTEST_LOG_(INFO) << "FilterTGids: tid " << tgid.first  << " pid " << tgid.second;
     });
     filterTraceContext->TraverseSavedCmdLine({});
@@ -98,6 +109,60 @@ HWTEST_F(HitraceContextTest, HitraceContextTest004, TestSize.Level1)
     });
     ASSERT_TRUE(true);
 }
+/**
+ * @tc.name: HitraceContextTest005
+ * @tc.desc: the filter context turns event-fork on and restores it when it is released.
+ * @tc.type: FUNC
+ */
+HWTEST_F(HitraceContextTest, HitraceContextTest005, TestSize.Level1)
+{
+    const std::string eventForkPath = GetTraceRootPath() + "options/event-fork";
+    if (access(eventForkPath.c_str(), W_OK) != 0) {
+        GTEST_SKIP() << "event-fork is not supported";
+    }
+    TraceContextManager::GetInstance().ReleaseContext();
+    ASSERT_TRUE(AppendToFile(eventForkPath, "0"));
+    auto filterTraceContext = TraceContextManager::GetInstance().GetTraceFilterContext(true);
+    ASSERT_NE(filterTraceContext, nullptr);
+    EXPECT_EQ(ReadOption(eventForkPath), '1');
+    ASSERT_TRUE(filterTraceContext->AddFilterPids({ std::to_string(getpid()) }));
+    ASSERT_TRUE(filterTraceContext->AddFilterPids({ std::to_string(getpid()) }));
+    filterTraceContext = nullptr;
+    TraceContextManager::GetInstance().ReleaseContext();
+    EXPECT_EQ(ReadOption(eventForkPath), '0');
+}
+
+/**
+ * @tc.name: HitraceContextTest006
+ * @tc.desc: the string typed traverse callbacks list the same pids and tgids as the int typed ones.
+ * @tc.type: FUNC
+ */
+HWTEST_F(HitraceContextTest, HitraceContextTest006, TestSize.Level1)
+{
+    auto filterTraceContext = TraceContextManager::GetInstance().GetTraceFilterContext();
+    ASSERT_NE(filterTraceContext, nullptr);
+    ASSERT_TRUE(filterTraceContext->AddFilterPids({ std::to_string(getpid()) }));
+    filterTraceContext->FilterTraceContent();
+    std::vector<std::string> pids;
+    filterTraceContext->TraverseFilterPid([&pids] (const int pid) {
+        pids.push_back(std::to_string(pid));
+    });
+    std::vector<std::string> strPids;
+    filterTraceContext->TraverseFilterPid([&strPids] (const std::string& pid) {
+        strPids.push_back(pid);
+    });
+    EXPECT_FALSE(pids.empty());
+    EXPECT_EQ(strPids, pids);
+    std::vector<std::pair<std::string, std::string>> tgids;
+    filterTraceContext->TraverseTGidsContent([&tgids] (const std::pair<int, int>& tgid) {
+        tgids.emplace_back(std::to_string(tgid.first), std::to_string(tgid.second));
+    });
+    std::vector<std::pair<std::string, std::string>> strTGids;
+    filterTraceContext->TraverseTGidsContent([&strTGids] (const std::pair<std::string, std::string>& tgid) {
+        strTGids.push_back(tgid);
+    });
+    EXPECT_EQ(strTGids, tgids);
+}
 } // namespace HitraceTest
 } // namespace HiviewDFX
 } // namespace OHOS
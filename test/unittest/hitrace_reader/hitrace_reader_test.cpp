@@ -0,0 +1,323 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#include "common_define.h"
+#include "fake_tracefs.h"
+#include "hitrace_reader.h"
+#include "trace_file_format.h"
+
+using namespace testing::ext;
+using namespace std;
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+namespace {
+const char* const TRACE_FILE = "/data/local/tmp/hitrace_reader_test.sys";
+const char* const COMPRESSED_TRACE_FILE = "/data/local/tmp/hitrace_reader_test_compressed.sys";
+const char* const SIDECAR_FILE = "/data/local/tmp/saved_metadata_0123456789abcdef";
+constexpr uint64_t SIDECAR_HASH = 0x0123456789abcdef;
+constexpr uint64_t FIRST_PAGE_TIME = 1000000000;
+constexpr uint64_t PAGE_INTERVAL = 1000000;
+constexpr size_t EVENTS_PER_PAGE = 127; // (4096 - 16) / 32, see FakeTracefs::FillRawPage
+constexpr size_t CHUNK_PAGES = 64;
+constexpr int BENCHMARK_CPUS = 4;
+constexpr size_t BENCHMARK_PAGES_PER_CPU = 4096; // 16M of raw data per cpu
+constexpr double BYTE_PER_GB = 1024.0 * 1024.0 * 1024.0;
+constexpr double MS_PER_S = 1000.0;
+
+const char EVENT_FORMAT[] =
+    "name: fake_event\nID: 1024\nformat:\n"
+    "\tfield:unsigned short common_type;\toffset:0;\tsize:2;\tsigned:0;\n"
+    "\tfield:unsigned char common_flags;\toffset:2;\tsize:1;\tsigned:0;\n"
+    "\tfield:unsigned char common_preempt_count;\toffset:3;\tsize:1;\tsigned:0;\n"
+    "\tfield:int common_pid;\toffset:4;\tsize:4;\tsigned:1;\n\n"
+    "\tfield:unsigned long ip;\toffset:8;\tsize:8;\tsigned:0;\n"
+    "\tfield:char buf[12];\toffset:16;\tsize:12;\tsigned:0;\n\n"
+    "print fmt: \"%ps: %s\", (void *)REC->ip, REC->buf\n";
+const char HEADER_PAGE[] =
+    "\tfield: u64 timestamp;\toffset:0;\tsize:8;\tsigned:0;\n"
+    "\tfield: local_t commit;\toffset:8;\tsize:8;\tsigned:1;\n"
+    "\tfield: int overwrite;\toffset:8;\tsize:1;\tsigned:1;\n"
+    "\tfield: char data;\toffset:16;\tsize:4080;\tsigned:1;\n";
+const char CMDLINES[] = "1 init\n100 fake_task_100\n1000 fake_task_1000\n";
+const char TGIDS[] = "1 1\n100 100\n1000 100\n";
+const std::vector<int> PIDS = { 1, 100, 1000 };
+
+void WriteSection(std::ofstream& out, const uint8_t type, const void* data, const size_t size)
+{
+    TraceFileContentHeader header;
+    header.type = type;
+    header.length = static_cast<uint32_t>(size);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+}
+
+std::vector<uint8_t> MakeCpuPages(const int cpu, const int cpuCount, const size_t pageCount)
+{
+    std::vector<uint8_t> pages(pageCount * PAGE_SIZE);
+    for (size_t i = 0; i < pageCount; i++) {
+        // the pages of the cpus interleave, so that the merge has to switch cpus.
+        uint64_t timestamp = FIRST_PAGE_TIME + i * PAGE_INTERVAL + PAGE_INTERVAL * cpu / cpuCount;
+        FakeTracefs::FillRawPage(pages.data() + i * PAGE_SIZE, timestamp, PIDS, i);
+    }
+    return pages;
+}
+
+std::vector<uint8_t> CompressPages(const int cpu, const std::vector<uint8_t>& pages)
+{
+    TraceCompressedRawHeader rawHeader;
+    rawHeader.cpu = static_cast<uint8_t>(cpu);
+    std::vector<uint8_t> section(reinterpret_cast<const uint8_t*>(&rawHeader),
+        reinterpret_cast<const uint8_t*>(&rawHeader) + sizeof(rawHeader));
+    for (size_t offset = 0; offset < pages.size(); offset += CHUNK_PAGES * PAGE_SIZE) {
+        size_t rawSize = std::min(CHUNK_PAGES * PAGE_SIZE, pages.size() - offset);
+        std::vector<uint8_t> compressed(compressBound(rawSize));
+        uLongf compressedSize = compressed.size();
+        compress2(compressed.data(), &compressedSize, pages.data() + offset, rawSize, 1);
+        TraceCompressedChunkHeader chunkHeader;
+        chunkHeader.compressedSize = static_cast<uint32_t>(compressedSize);
+        chunkHeader.uncompressedSize = static_cast<uint32_t>(rawSize);
+        chunkHeader.pageCount = static_cast<uint32_t>(rawSize / PAGE_SIZE);
+        section.insert(section.end(), reinterpret_cast<const uint8_t*>(&chunkHeader),
+            reinterpret_cast<const uint8_t*>(&chunkHeader) + sizeof(chunkHeader));
+        section.insert(section.end(), compressed.begin(), compressed.begin() + compressedSize);
+    }
+    return section;
+}
+
+bool WriteSyntheticTraceFile(const std::string& path, const int cpuCount, const size_t pagesPerCpu,
+    const bool isCompressed)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    TraceFileHeader fileHeader;
+    fileHeader.versionNumber = isCompressed ? VERSION_NUMBER_COMPRESSED_RAW : VERSION_NUMBER;
+    out.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+    WriteSection(out, CONTENT_TYPE_EVENTS_FORMAT, EVENT_FORMAT, sizeof(EVENT_FORMAT) - 1);
+    for (int cpu = 0; cpu < cpuCount; cpu++) {
+        auto pages = MakeCpuPages(cpu, cpuCount, pagesPerCpu);
+        if (isCompressed) {
+            auto section = CompressPages(cpu, pages);
+            WriteSection(out, CONTENT_TYPE_CPU_RAW_COMPRESSED, section.data(), section.size());
+        } else {
+            WriteSection(out, CONTENT_TYPE_CPU_RAW + cpu, pages.data(), pages.size());
+        }
+    }
+    WriteSection(out, CONTENT_TYPE_CMDLINES, CMDLINES, sizeof(CMDLINES) - 1);
+    WriteSection(out, CONTENT_TYPE_TGIDS, TGIDS, sizeof(TGIDS) - 1);
+    WriteSection(out, CONTENT_TYPE_HEADER_PAGE, HEADER_PAGE, sizeof(HEADER_PAGE) - 1);
+    return out.good();
+}
+
+// a slice of a series, its events format and header page are in the sidecar file it refers to.
+bool WriteSidecarTraceFile(const std::string& path, const int cpuCount, const size_t pagesPerCpu)
+{
+    TraceMetadataRef ref;
+    ref.hash = SIDECAR_HASH;
+    ref.sectionCount = 2; // 2 : events format and header page
+    std::ofstream sidecar(SIDECAR_FILE, std::ios::binary | std::ios::trunc);
+    sidecar.write(reinterpret_cast<const char*>(&ref), sizeof(ref));
+    WriteSection(sidecar, CONTENT_TYPE_EVENTS_FORMAT, EVENT_FORMAT, sizeof(EVENT_FORMAT) - 1);
+    WriteSection(sidecar, CONTENT_TYPE_HEADER_PAGE, HEADER_PAGE, sizeof(HEADER_PAGE) - 1);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    TraceFileHeader fileHeader;
+    out.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+    for (int cpu = 0; cpu < cpuCount; cpu++) {
+        auto pages = MakeCpuPages(cpu, cpuCount, pagesPerCpu);
+        WriteSection(out, CONTENT_TYPE_CPU_RAW + cpu, pages.data(), pages.size());
+    }
+    WriteSection(out, CONTENT_TYPE_CMDLINES, CMDLINES, sizeof(CMDLINES) - 1);
+    WriteSection(out, CONTENT_TYPE_TGIDS, TGIDS, sizeof(TGIDS) - 1);
+    WriteSection(out, CONTENT_TYPE_METADATA_REF, &ref, sizeof(ref));
+    return sidecar.good() && out.good();
+}
+
+size_t CountMergedEvents(const TraceReader& reader, bool& isOrdered)
+{
+    auto cursor = reader.GetMergedEvents();
+    TraceRawEvent event;
+    uint64_t lastTimestamp = 0;
+    size_t count = 0;
+    isOrdered = true;
+    while (cursor.Next(event)) {
+        isOrdered = isOrdered && event.timestamp >= lastTimestamp;
+        lastTimestamp = event.timestamp;
+        count++;
+    }
+    return count;
+}
+}
+
+class HitraceReaderTest : public testing::Test {
+public:
+    static void TearDownTestCase()
+    {
+        remove(TRACE_FILE);
+        remove(COMPRESSED_TRACE_FILE);
+        remove(SIDECAR_FILE);
+    }
+};
+
+/**
+ * @tc.name: HitraceReaderTest001
+ * @tc.desc: Test the sections, event formats, cmdlines and tgids of a trace file are parsed.
+ * @tc.type: FUNC
+ */
+HWTEST_F(HitraceReaderTest, HitraceReaderTest001, TestSize.Level2)
+{
+    ASSERT_TRUE(WriteSyntheticTraceFile(TRACE_FILE, 2, 4, false)); // 2 : cpus, 4 : pages per cpu
+    TraceReader reader;
+    ASSERT_TRUE(reader.Open(TRACE_FILE));
+    EXPECT_EQ(reader.GetVersionNumber(), VERSION_NUMBER);
+    EXPECT_EQ(reader.GetSections().size(), 6); // 6 : format, 2 cpus, cmdlines, tgids and header page
+    EXPECT_EQ(reader.GetCpus(), std::vector<uint32_t>({ 0, 1 }));
+    const TraceEventFormat* format = reader.GetEventFormat(FAKE_EVENT_ID);
+    ASSERT_NE(format, nullptr);
+    EXPECT_EQ(format->name, "fake_event");
+    EXPECT_EQ(format->fields.size(), 6); // 6 : 4 common fields, ip and buf
+    const TraceEventField* pidField = format->GetField("common_pid");
+    ASSERT_NE(pidField, nullptr);
+    EXPECT_EQ(pidField->offset, 4); // 4 : offset of common_pid
+    EXPECT_TRUE(pidField->isSigned);
+    const TraceEventField* bufField = format->GetField("buf");
+    ASSERT_NE(bufField, nullptr);
+    EXPECT_EQ(bufField->size, 12); // 12 : char buf[12]
+    EXPECT_EQ(reader.GetCmdlines().at(100), "fake_task_100");
+    EXPECT_EQ(reader.GetTgids().at(1000), 100);
+    EXPECT_EQ(reader.GetEventFormat(0), nullptr);
+}
+
+/**
+ * @tc.name: HitraceReaderTest002
+ * @tc.desc: Test the events of a cpu are decoded in place with their timestamps and fields.
+ * @tc.type: FUNC
+ */
+HWTEST_F(HitraceReaderTest, HitraceReaderTest002, TestSize.Level2)
+{
+    constexpr size_t pageCount = 4;
+    ASSERT_TRUE(WriteSyntheticTraceFile(TRACE_FILE, 1, pageCount, false));
+    TraceReader reader;
+    ASSERT_TRUE(reader.Open(TRACE_FILE));
+    const TraceEventField* pidField = reader.GetEventFormat(FAKE_EVENT_ID)->GetField("common_pid");
+    ASSERT_NE(pidField, nullptr);
+    auto cursor = reader.GetCpuEvents(0);
+    TraceRawEvent event;
+    size_t count = 0;
+    while (cursor.Next(event)) {
+        size_t page = count / EVENTS_PER_PAGE;
+        size_t idx = count % EVENTS_PER_PAGE;
+        EXPECT_EQ(event.id, FAKE_EVENT_ID);
+        EXPECT_EQ(event.cpu, 0);
+        EXPECT_EQ(event.timestamp, FIRST_PAGE_TIME + page * PAGE_INTERVAL + (idx + 1) * 1000); // 1000 : time delta
+        int32_t pid = 0;
+        memcpy(&pid, event.data + pidField->offset, sizeof(pid));
+        EXPECT_EQ(pid, PIDS[(page + idx) % PIDS.size()]);
+        count++;
+    }
+    EXPECT_EQ(count, pageCount * EVENTS_PER_PAGE);
+    EXPECT_EQ(cursor.GetPageCount(), pageCount);
+    EXPECT_FALSE(reader.GetCpuEvents(1).Next(event));
+}
+
+/**
+ * @tc.name: HitraceReaderTest003
+ * @tc.desc: Test the events of all the cpus are merged by timestamp, for plain and compressed sections.
+ * @tc.type: FUNC
+ */
+HWTEST_F(HitraceReaderTest, HitraceReaderTest003, TestSize.Level2)
+{
+    constexpr int cpuCount = 3;
+    constexpr size_t pageCount = 100; // more than one chunk per cpu
+    ASSERT_TRUE(WriteSyntheticTraceFile(TRACE_FILE, cpuCount, pageCount, false));
+    ASSERT_TRUE(WriteSyntheticTraceFile(COMPRESSED_TRACE_FILE, cpuCount, pageCount, true));
+    for (const char* file : { TRACE_FILE, COMPRESSED_TRACE_FILE }) {
+        TraceReader reader;
+        ASSERT_TRUE(reader.Open(file));
+        bool isOrdered = false;
+        EXPECT_EQ(CountMergedEvents(reader, isOrdered), cpuCount * pageCount * EVENTS_PER_PAGE);
+        EXPECT_TRUE(isOrdered);
+    }
+}
+
+/**
+ * @tc.name: HitraceReaderTest004
+ * @tc.desc: Test a file which is not a hitrace raw trace file is refused.
+ * @tc.type: FUNC
+ */
+HWTEST_F(HitraceReaderTest, HitraceReaderTest004, TestSize.Level2)
+{
+    TraceReader reader;
+    EXPECT_FALSE(reader.Open("/data/local/tmp/hitrace_reader_not_exist.sys"));
+    std::ofstream(TRACE_FILE, std::ios::trunc) << "not a trace file";
+    EXPECT_FALSE(reader.Open(TRACE_FILE));
+    EXPECT_TRUE(reader.GetCpus().empty());
+}
+
+/**
+ * @tc.name: HitraceReaderTest005
+ * @tc.desc: Test the throughput of the merged event iteration over a synthetic file.
+ * @tc.type: FUNC
+ */
+HWTEST_F(HitraceReaderTest, HitraceReaderTest005, TestSize.Level2)
+{
+    ASSERT_TRUE(WriteSyntheticTraceFile(TRACE_FILE, BENCHMARK_CPUS, BENCHMARK_PAGES_PER_CPU, false));
+    TraceReader reader;
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(reader.Open(TRACE_FILE));
+    bool isOrdered = false;
+    size_t count = CountMergedEvents(reader, isOrdered);
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(count, BENCHMARK_CPUS * BENCHMARK_PAGES_PER_CPU * EVENTS_PER_PAGE);
+    EXPECT_TRUE(isOrdered);
+    double rawGb = static_cast<double>(BENCHMARK_CPUS * BENCHMARK_PAGES_PER_CPU * PAGE_SIZE) / BYTE_PER_GB;
+    GTEST_LOG_(INFO) << "merged read: " << count << " events in " << wallMs << " ms, " <<
+        static_cast<double>(count) * MS_PER_S / wallMs << " events/s, " << rawGb * MS_PER_S / wallMs << " GB/s";
+}
+
+/**
+ * @tc.name: HitraceReaderTest006
+ * @tc.desc: Test the metadata ref of a slice is resolved from its sidecar file, and refused without it.
+ * @tc.type: FUNC
+ */
+HWTEST_F(HitraceReaderTest, HitraceReaderTest006, TestSize.Level2)
+{
+    constexpr int cpuCount = 2;
+    constexpr size_t pageCount = 4;
+    ASSERT_TRUE(WriteSidecarTraceFile(TRACE_FILE, cpuCount, pageCount));
+    TraceReader reader;
+    ASSERT_TRUE(reader.Open(TRACE_FILE));
+    EXPECT_EQ(reader.GetSections().size(), 6); // 6 : 2 cpus, cmdlines, tgids, format and header page of the sidecar
+    const TraceEventFormat* format = reader.GetEventFormat(FAKE_EVENT_ID);
+    ASSERT_NE(format, nullptr);
+    EXPECT_EQ(format->name, "fake_event");
+    bool isOrdered = false;
+    EXPECT_EQ(CountMergedEvents(reader, isOrdered), cpuCount * pageCount * EVENTS_PER_PAGE);
+    EXPECT_TRUE(isOrdered);
+
+    remove(SIDECAR_FILE);
+    TraceReader noSidecarReader;
+    ASSERT_TRUE(noSidecarReader.Open(TRACE_FILE));
+    EXPECT_EQ(noSidecarReader.GetEventFormat(FAKE_EVENT_ID), nullptr);
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
@@ -19,6 +19,7 @@
 #include <sys/stat.h>
 #include <thread>
 #include <unistd.h>
+#include <vector>
 
 #include "common_define.h"
 #include "common_utils.h"
@@ -526,6 +527,173 @@ HWTEST_F(HitraceFactoryTest, TraceSourceTest020, TestSize.Level2)
     }
 }
 
+/**
+ * @tc.name: TraceSourceTest021
+ * @tc.desc: Test ITraceCpuRawContent class WriteTraceContent function with the splice engine and a trace time window.
+ * @tc.type: FUNC
+ */
+HWTEST_F(HitraceFactoryTest, TraceSourceTest021, TestSize.Level2)
+{
+    ASSERT_EQ(static_cast<int>(CloseTrace()), static_cast<int>(TraceErrorCode::SUCCESS));
+    std::string appArgs = "tags:sched,binder,ohos bufferSize:102400 overwrite:1";
+    ASSERT_EQ(static_cast<int>(OpenTrace(appArgs)), static_cast<int>(TraceErrorCode::SUCCESS));
+    uint64_t traceStartTime = GetCurBootTime();
+    sleep(1);
+    uint64_t traceEndTime = GetCurBootTime();
+    sleep(1);
+    std::shared_ptr<ITraceSourceFactory> traceSourceFactory = nullptr;
+    if (IsHmKernel()) {
+        traceSourceFactory = std::make_shared<TraceSourceHMFactory>(TEST_TRACE_TEMP_FILE);
+    } else {
+        traceSourceFactory = std::make_shared<TraceSourceLinuxFactory>(TEST_TRACE_TEMP_FILE);
+    }
+    ASSERT_TRUE(traceSourceFactory != nullptr);
+    TraceDumpRequest request = {
+        .type = TraceDumpType::TRACE_SNAPSHOT,
+        .traceStartTime = traceStartTime,
+        .traceEndTime = traceEndTime,
+        .engine = TraceDumpEngine::ENGINE_SPLICE
+    };
+    auto traceCpuRaw = traceSourceFactory->GetTraceCpuRaw(request);
+    ASSERT_TRUE(traceCpuRaw != nullptr);
+    ASSERT_TRUE(traceCpuRaw->WriteTraceContent());
+    ASSERT_GE(traceCpuRaw->GetFirstPageTimeStamp(), traceStartTime);
+    ASSERT_GT(GetFileSize(TEST_TRACE_TEMP_FILE), sizeof(TraceFileContentHeader));
+    ASSERT_EQ(static_cast<int>(CloseTrace()), static_cast<int>(TraceErrorCode::SUCCESS));
+    if (remove(TEST_TRACE_TEMP_FILE) != 0) {
+        GTEST_LOG_(ERROR) << "Delete test trace file failed.";
+    }
+}
+
+/**
+ * @tc.name: TraceSourceTest022
+ * @tc.desc: Test ITraceSourceFactory class GetTraceCpuRaw function with io_uring dump engine.
+ * @tc.type: FUNC
+ */
+HWTEST_F(HitraceFactoryTest, TraceSourceTest022, TestSize.Level2)
+{
+    ASSERT_EQ(static_cast<int>(CloseTrace()), static_cast<int>(TraceErrorCode::SUCCESS));
+    std::string appArgs = "tags:sched,binder,ohos bufferSize:102400 overwrite:1";
+    ASSERT_EQ(static_cast<int>(OpenTrace(appArgs)), static_cast<int>(TraceErrorCode::SUCCESS));
+    sleep(1);
+    std::shared_ptr<ITraceSourceFactory> traceSourceFactory = nullptr;
+    if (IsHmKernel()) {
+        traceSourceFactory = std::make_shared<TraceSourceHMFactory>(TEST_TRACE_TEMP_FILE);
+    } else {
+        traceSourceFactory = std::make_shared<TraceSourceLinuxFactory>(TEST_TRACE_TEMP_FILE);
+    }
+    ASSERT_TRUE(traceSourceFactory != nullptr);
+    TraceDumpRequest request = {
+        .type = TraceDumpType::TRACE_SNAPSHOT,
+        .engine = TraceDumpEngine::ENGINE_IO_URING,
+    };
+    auto traceFileHdr = traceSourceFactory->GetTraceFileHeader();
+    ASSERT_TRUE(traceFileHdr != nullptr);
+    traceFileHdr->ResetCurrentFileSize();
+    ASSERT_TRUE(traceFileHdr->WriteTraceContent());
+    auto traceCpuRaw = traceSourceFactory->GetTraceCpuRaw(request);
+    ASSERT_TRUE(traceCpuRaw != nullptr);
+    ASSERT_TRUE(traceCpuRaw->WriteTraceContent());
+    ASSERT_EQ(static_cast<int>(traceCpuRaw->GetDumpStatus()), static_cast<int>(TraceErrorCode::SUCCESS));
+    ASSERT_LT(traceCpuRaw->GetFirstPageTimeStamp(), std::numeric_limits<uint64_t>::max());
+    auto tracePrintkFmt = traceSourceFactory->GetTracePrintkFmt();
+    ASSERT_TRUE(tracePrintkFmt != nullptr);
+    ASSERT_TRUE(tracePrintkFmt->WriteTraceContent());
+    // the contents after the raw data are appended right behind the last cpu raw section.
+    ASSERT_EQ(GetFileSize(TEST_TRACE_TEMP_FILE), sizeof(TraceFileHeader) + ITraceContent::GetCurrentFileSize());
+    ASSERT_EQ(static_cast<int>(CloseTrace()), static_cast<int>(TraceErrorCode::SUCCESS));
+    if (remove(TEST_TRACE_TEMP_FILE) != 0) {
+        GTEST_LOG_(ERROR) << "Delete test trace file failed.";
+    }
+}
+
+/**
+ * @tc.name: TraceSourceTest023
+ * @tc.desc: Test ITraceSourceFactory class PreallocateTraceFile/TrimTraceFile function.
+ * @tc.type: FUNC
+ */
+HWTEST_F(HitraceFactoryTest, TraceSourceTest023, TestSize.Level2)
+{
+    constexpr int64_t preallocSize = 4 * 1024 * 1024; // 4 : 4MB
+    std::shared_ptr<ITraceSourceFactory> traceSourceFactory =
+        std::make_shared<TraceSourceLinuxFactory>(TEST_TRACE_TEMP_FILE);
+    ASSERT_TRUE(traceSourceFactory != nullptr);
+    ASSERT_FALSE(traceSourceFactory->PreallocateTraceFile(0));
+    bool preallocated = traceSourceFactory->PreallocateTraceFile(preallocSize);
+    // the preallocated blocks never change the visible size of the trace file.
+    ASSERT_EQ(GetFileSize(TEST_TRACE_TEMP_FILE), 0);
+    auto traceFileHdr = traceSourceFactory->GetTraceFileHeader();
+    ASSERT_TRUE(traceFileHdr != nullptr);
+    traceFileHdr->ResetCurrentFileSize();
+    ASSERT_TRUE(traceFileHdr->WriteTraceContent());
+    auto traceBaseInfo = traceSourceFactory->GetTraceBaseInfo();
+    ASSERT_TRUE(traceBaseInfo != nullptr);
+    ASSERT_TRUE(traceBaseInfo->WriteTraceContent());
+    ASSERT_TRUE(traceSourceFactory->TrimTraceFile());
+    ASSERT_EQ(GetFileSize(TEST_TRACE_TEMP_FILE), sizeof(TraceFileHeader) + ITraceContent::GetCurrentFileSize());
+    struct stat fileStat;
+    ASSERT_EQ(stat(TEST_TRACE_TEMP_FILE, &fileStat), 0);
+    if (preallocated) {
+        ASSERT_LT(fileStat.st_blocks * 512, preallocSize); // 512 : st_blocks unit
+    }
+    if (remove(TEST_TRACE_TEMP_FILE) != 0) {
+        GTEST_LOG_(ERROR) << "Delete test trace file failed.";
+    }
+}
+
+/**
+ * @tc.name: TraceSourceTest024
+ * @tc.desc: Test that the content writers notice the removal of the trace file at once.
+ * @tc.type: FUNC
+ */
+HWTEST_F(HitraceFactoryTest, TraceSourceTest024, TestSize.Level2)
+{
+    std::shared_ptr<ITraceSourceFactory> traceSourceFactory =
+        std::make_shared<TraceSourceLinuxFactory>(TEST_TRACE_TEMP_FILE);
+    ASSERT_TRUE(traceSourceFactory != nullptr);
+    ASSERT_TRUE(traceSourceFactory->IsTraceFileExist());
+    auto traceFileHdr = traceSourceFactory->GetTraceFileHeader();
+    ASSERT_TRUE(traceFileHdr != nullptr);
+    ASSERT_TRUE(traceFileHdr->WriteTraceContent());
+    ASSERT_TRUE(traceFileHdr->IsFileExist());
+    ASSERT_EQ(remove(TEST_TRACE_TEMP_FILE), 0);
+    ASSERT_FALSE(traceSourceFactory->IsTraceFileExist());
+    ASSERT_FALSE(traceFileHdr->IsFileExist());
+    auto traceHeaderPage = traceSourceFactory->GetTraceHeaderPage();
+    ASSERT_TRUE(traceHeaderPage != nullptr);
+    ASSERT_FALSE(traceHeaderPage->WriteTraceContent());
+    ASSERT_TRUE(traceSourceFactory->UpdateTraceFile(TEST_TRACE_TEMP_FILE));
+    ASSERT_TRUE(traceSourceFactory->IsTraceFileExist());
+    if (remove(TEST_TRACE_TEMP_FILE) != 0) {
+        GTEST_LOG_(ERROR) << "Delete test trace file failed.";
+    }
+}
+
+/**
+ * @tc.name: TraceSourceTest025
+ * @tc.desc: Test ITraceContent class CheckPage function reads the commit size from the page header.
+ * @tc.type: FUNC
+ */
+HWTEST_F(HitraceFactoryTest, TraceSourceTest025, TestSize.Level2)
+{
+    std::shared_ptr<ITraceSourceFactory> traceSourceFactory =
+        std::make_shared<TraceSourceLinuxFactory>(TEST_TRACE_TEMP_FILE);
+    ASSERT_TRUE(traceSourceFactory != nullptr);
+    auto traceHeaderPage = traceSourceFactory->GetTraceHeaderPage();
+    ASSERT_TRUE(traceHeaderPage != nullptr);
+    // the page header is the timestamp followed by the commit size, a page less than half full fails the check.
+    std::vector<uint8_t> page(PAGE_SIZE, 0);
+    const uint64_t pageThreshold = PAGE_SIZE / 2;
+    const uint64_t fullPageSize = PAGE_SIZE - sizeof(uint64_t) * 2;
+    for (uint64_t commitSize : { fullPageSize, pageThreshold, pageThreshold - 1, static_cast<uint64_t>(0) }) {
+        *reinterpret_cast<uint64_t*>(page.data() + sizeof(uint64_t)) = commitSize;
+        EXPECT_EQ(traceHeaderPage->CheckPage(page.data()), commitSize >= pageThreshold) << commitSize;
+    }
+    if (remove(TEST_TRACE_TEMP_FILE) != 0) {
+        GTEST_LOG_(ERROR) << "Delete test trace file failed.";
+    }
+}
+
 /**
  * @tc.name: TraceBufferManagerTest01
  * @tc.desc: Test TraceBufferManager class AllocateBlock/GetTaskBuffers/GetCurrentTotalSize function.
@@ -681,6 +849,44 @@ HWTEST_F(HitraceFactoryTest, TraceBufferManagerTest05, TestSize.Level2)
         TraceBufferManager::GetInstance().ReleaseTaskBlocks(i + 1);
     }
 }
+
+/**
+ * @tc.name: TraceBufferManagerTest06
+ * @tc.desc: Test TraceBufferManager class recycles released blocks through the block pool.
+ * @tc.type: FUNC
+ */
+HWTEST_F(HitraceFactoryTest, TraceBufferManagerTest06, TestSize.Level2)
+{
+    const uint64_t taskId1 = 1;
+    const uint64_t taskId2 = 2;
+    TraceBufferManager::GetInstance().TrimIdleBlocks();
+    auto block = TraceBufferManager::GetInstance().AllocateBlock(taskId1, 0);
+    ASSERT_TRUE(block != nullptr);
+    const uint8_t page[] = {1, 2, 3, 4};
+    ASSERT_TRUE(block->Append(page, sizeof(page)));
+    ASSERT_NE(block->Tail(), nullptr);
+    ASSERT_TRUE(block->Commit(sizeof(page)));
+    EXPECT_EQ(block->usedBytes, sizeof(page) * 2); // 2 : appended and committed
+    EXPECT_FALSE(block->Commit(DEFAULT_BLOCK_SZ));
+    uint8_t* blockData = block->data.data();
+    TraceBufferManager::GetInstance().ReleaseTaskBlocks(taskId1);
+    EXPECT_EQ(TraceBufferManager::GetInstance().GetCurrentTotalSize(), 0);
+    // the block is still referenced here, it returns to the pool when the last reference is dropped.
+    EXPECT_EQ(TraceBufferManager::GetInstance().GetIdleBlockCount(), 0);
+    block.reset();
+    EXPECT_EQ(TraceBufferManager::GetInstance().GetIdleBlockCount(), 1);
+    auto reused = TraceBufferManager::GetInstance().AllocateBlock(taskId2, 1);
+    ASSERT_TRUE(reused != nullptr);
+    EXPECT_EQ(reused->data.data(), blockData);
+    EXPECT_EQ(reused->cpu, 1);
+    EXPECT_EQ(reused->usedBytes, 0);
+    EXPECT_EQ(reused->FreeBytes(), DEFAULT_BLOCK_SZ);
+    EXPECT_EQ(TraceBufferManager::GetInstance().GetIdleBlockCount(), 0);
+    TraceBufferManager::GetInstance().ReleaseTaskBlocks(taskId2);
+    reused.reset();
+    TraceBufferManager::GetInstance().TrimIdleBlocks();
+    EXPECT_EQ(TraceBufferManager::GetInstance().GetIdleBlockCount(), 0);
+}
 } // namespace
 } // namespace Hitrace
 } // namespace HiviewDFX
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+
+#include "common_define.h"
+#include "fake_tracefs_test_utils.h"
+#include "smart_fd.h"
+#include "trace_content.h"
+#include "trace_compressor.h"
+#include "trace_dump_executor.h"
+#include "trace_file_utils.h"
+#include "trace_page_index.h"
+#include "trace_section_table.h"
+
+using namespace testing::ext;
+using namespace std;
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+class TraceCompressorTest : public FakeTracefsTest {};
+
+/**
+ * @tc.name: TraceCompressorTest001
+ * @tc.desc: Test a record file with compressed cpu raw sections, its conversion and window extraction.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceCompressorTest, TraceCompressorTest001, TestSize.Level2)
+{
+    FakeTracefsConfig config;
+    config.pagesPerCpu = RECORD_PAGES_PER_CPU;
+    ASSERT_TRUE(fakeTracefs_.Build(config));
+    TraceDumpParam param = {
+        .type = TraceDumpType::TRACE_RECORDING,
+        .compressLevel = TRACE_COMPRESS_LEVEL_MIN
+    };
+    BenchmarkSample sample;
+    BenchmarkTimer timer;
+    auto outputFiles = RunRecordLoop(param);
+    timer.Stop(sample);
+    ASSERT_FALSE(outputFiles.empty());
+    EXPECT_EQ(GetTraceFileVersion(outputFiles[0]), VERSION_NUMBER_COMPRESSED_RAW);
+
+    SmartFd traceFd(open(outputFiles[0].c_str(), O_RDONLY));
+    std::vector<TraceSectionTableEntry> entries;
+    ASSERT_TRUE(ReadSectionTable(traceFd.GetFd(), entries));
+    for (const auto& entry : entries) {
+        if (entry.type == CONTENT_TYPE_CPU_RAW_COMPRESSED) {
+            EXPECT_GE(entry.pageCount, RECORD_PAGES_PER_CPU);
+            EXPECT_LT(entry.firstTimestamp, entry.lastTimestamp);
+        }
+    }
+
+    std::string plainFile = std::string(TEST_OUTPUT_DIR) + "trace_decompressed.sys";
+    ASSERT_TRUE(DecompressTraceFile(outputFiles[0], plainFile));
+    EXPECT_EQ(GetTraceFileVersion(plainFile), VERSION_NUMBER);
+    sample.inputBytes = static_cast<uint64_t>(GetFileSize(plainFile));
+    sample.outputBytes = static_cast<uint64_t>(GetFileSize(outputFiles[0]));
+    EXPECT_LT(sample.outputBytes, sample.inputBytes);
+
+    uint64_t edge = GetWindowEdge();
+    std::string windowFile = std::string(TEST_OUTPUT_DIR) + "trace_window.sys";
+    uint64_t firstPageTime = 0;
+    uint64_t lastPageTime = 0;
+    ASSERT_TRUE(ExtractTraceWindow(outputFiles[0], windowFile, fakeTracefs_.GetFirstPageTime() + edge,
+        fakeTracefs_.GetLastPageTime() - edge, firstPageTime, lastPageTime));
+    EXPECT_LE(firstPageTime, lastPageTime);
+    EXPECT_LT(GetFileSize(windowFile), GetFileSize(outputFiles[0]));
+    EXPECT_TRUE(DecompressTraceFile(windowFile, plainFile));
+    remove(windowFile.c_str());
+    remove(plainFile.c_str());
+    for (const auto& file : outputFiles) {
+        remove(file.c_str());
+    }
+    ReportSample("compressed record", config, sample);
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
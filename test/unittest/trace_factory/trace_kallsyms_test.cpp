@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <fstream>
+
+#include "common_define.h"
+#include "fake_tracefs_test_utils.h"
+#include "trace_dump_executor.h"
+#include "trace_metadata_cache.h"
+
+using namespace testing::ext;
+using namespace std;
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+namespace {
+const char* const SAVED_EVENTS_FORMAT_FILE = "/data/local/tmp/hitrace_saved_events_format";
+const char* const FAKE_KALLSYMS_FILE = "/data/local/tmp/hitrace_fake_kallsyms";
+}
+
+class TraceKallsymsTest : public FakeTracefsTest {};
+
+/**
+ * @tc.name: TraceKallsymsTest001
+ * @tc.desc: Test the kallsyms section only holds the text symbols of the addresses in the dumped events, and it is
+ *           not written without the option.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceKallsymsTest, TraceKallsymsTest001, TestSize.Level2)
+{
+    FakeTracefsConfig config;
+    config.eventFormats = { "events/sched/sched_switch/format", "events/sched/sched_wakeup/format",
+        "events/ftrace/print/format" };
+    ASSERT_TRUE(fakeTracefs_.Build(config));
+    TraceMetadataCache& metadataCache = TraceMetadataCache::GetInstance();
+    metadataCache.PrepareEventFormats(config.eventFormats, SAVED_EVENTS_FORMAT_FILE);
+    ASSERT_NE(metadataCache.GetPreparedEventFormats(), nullptr);
+    remove(SAVED_EVENTS_FORMAT_FILE);
+
+    // the ips of the fake events start at 0xffffffc010000000 and go up by one.
+    const std::string usedSymbols = "ffffffc010000000 T fake_func_a\n"
+        "ffffffc010000010 t fake_func_b\t[fake_module]\n";
+    std::ofstream(FAKE_KALLSYMS_FILE, std::ios::trunc) << "ffffffc00fff0000 T before_text\n" << usedSymbols <<
+        "ffffffc010000020 D fake_data\n" << "ffffffc010100000 T unused_func\n";
+    metadataCache.PrepareKallsyms(FAKE_KALLSYMS_FILE);
+    auto kallsyms = metadataCache.GetKallsyms();
+    ASSERT_NE(kallsyms, nullptr);
+    EXPECT_EQ(kallsyms->GetCount(), 4); // 4 : the text symbols
+
+    TraceDumpParam param = {
+        .type = TraceDumpType::TRACE_SNAPSHOT,
+        .withKallsyms = true
+    };
+    auto start = std::chrono::steady_clock::now();
+    TraceDumpRet ret = TraceDumpExecutor::GetInstance().DumpTrace(param, TEST_OUTPUT_DIR);
+    double dumpMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(ret.code, TraceErrorCode::SUCCESS);
+    EXPECT_EQ(ReadSectionContent(ret.outputFile, CONTENT_TYPE_KALLSYMS), usedSymbols);
+    remove(ret.outputFile);
+
+    param.withKallsyms = false;
+    ret = TraceDumpExecutor::GetInstance().DumpTrace(param, TEST_OUTPUT_DIR);
+    EXPECT_EQ(ret.code, TraceErrorCode::SUCCESS);
+    EXPECT_TRUE(ReadSectionContent(ret.outputFile, CONTENT_TYPE_KALLSYMS).empty());
+    remove(ret.outputFile);
+
+    metadataCache.PrepareKallsyms();
+    remove(FAKE_KALLSYMS_FILE);
+    GTEST_LOG_(INFO) << "kallsyms: snapshot dump with the referenced symbols " << dumpMs << "ms.";
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <memory>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "common_define.h"
+#include "fake_tracefs_test_utils.h"
+#include "trace_context.h"
+#include "trace_dump_executor.h"
+#include "trace_metadata_cache.h"
+#include "trace_strategy_factory.h"
+
+using namespace testing::ext;
+using namespace std;
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+namespace {
+const char* const SAVED_EVENTS_FORMAT_FILE = "/data/local/tmp/hitrace_saved_events_format";
+constexpr int MALLOC_THREAD_COUNT = 4; // threads which keep the allocator locks busy while forking
+constexpr int FORK_ROUNDS = 50;
+constexpr int CHILD_ALLOC_COUNT = 64;
+constexpr size_t CHILD_ALLOC_SIZE = 4096;
+constexpr auto CHILD_EXIT_TIMEOUT = std::chrono::seconds(5); // a child stuck on an allocator lock never exits
+
+bool WaitChildExit(const pid_t pid, int& status)
+{
+    auto deadline = std::chrono::steady_clock::now() + CHILD_EXIT_TIMEOUT;
+    while (std::chrono::steady_clock::now() < deadline) {
+        pid_t ret = waitpid(pid, &status, WNOHANG);
+        if (ret == pid) {
+            return true;
+        }
+        if (ret < 0) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, &status, 0);
+    return false;
+}
+}
+
+class TraceMetadataCacheTest : public FakeTracefsTest {};
+
+/**
+ * @tc.name: TraceMetadataCacheTest001
+ * @tc.desc: Test the event formats prepared in the background are saved, reused and written as the events format
+ *           section of a dump, with the field layouts of every event.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceMetadataCacheTest, TraceMetadataCacheTest001, TestSize.Level2)
+{
+    FakeTracefsConfig config;
+    config.eventFormats = GetAllEventFormats();
+    if (config.eventFormats.empty()) {
+        config.eventFormats = { "events/sched/sched_switch/format", "events/sched/sched_wakeup/format",
+            "events/ftrace/print/format" };
+    }
+    ASSERT_TRUE(fakeTracefs_.Build(config));
+    std::string expectedContent;
+    for (const auto& eventFormat : config.eventFormats) {
+        std::ifstream formatFile(fakeTracefs_.GetRootPath() + eventFormat);
+        expectedContent.append(std::istreambuf_iterator<char>(formatFile), std::istreambuf_iterator<char>());
+    }
+    TraceMetadataCache& metadataCache = TraceMetadataCache::GetInstance();
+    auto start = std::chrono::steady_clock::now();
+    metadataCache.PrepareEventFormats(config.eventFormats, SAVED_EVENTS_FORMAT_FILE);
+    auto eventFormats = metadataCache.GetPreparedEventFormats();
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    ASSERT_NE(eventFormats, nullptr);
+    EXPECT_EQ(eventFormats->GetContent(), expectedContent);
+    std::ifstream savedFile(SAVED_EVENTS_FORMAT_FILE);
+    EXPECT_EQ(std::string(std::istreambuf_iterator<char>(savedFile), std::istreambuf_iterator<char>()),
+        expectedContent);
+    remove(SAVED_EVENTS_FORMAT_FILE);
+    EXPECT_EQ(metadataCache.GetEventFormats(config.eventFormats), eventFormats);
+
+    ASSERT_EQ(eventFormats->GetLayouts().size(), config.eventFormats.size());
+    const TraceEventLayout* layout = eventFormats->FindLayout(eventFormats->GetLayouts().back().id);
+    ASSERT_NE(layout, nullptr);
+    const TraceEventField* pidField = layout->FindField("common_pid");
+    ASSERT_NE(pidField, nullptr);
+    EXPECT_EQ(pidField->offset, 4);
+    EXPECT_EQ(pidField->size, sizeof(int32_t));
+    EXPECT_TRUE(pidField->isSigned);
+    const TraceEventField* bufField = layout->FindField("buf");
+    ASSERT_NE(bufField, nullptr);
+    EXPECT_EQ(bufField->size, 12);
+
+    TraceDumpParam param = { .type = TraceDumpType::TRACE_SNAPSHOT };
+    start = std::chrono::steady_clock::now();
+    TraceDumpRet ret = TraceDumpExecutor::GetInstance().DumpTrace(param, TEST_OUTPUT_DIR);
+    double dumpMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(ret.code, TraceErrorCode::SUCCESS);
+    EXPECT_EQ(ReadSectionContent(ret.outputFile, CONTENT_TYPE_EVENTS_FORMAT), expectedContent);
+    remove(ret.outputFile);
+    GTEST_LOG_(INFO) << config.eventFormats.size() << " event formats, " << expectedContent.size() <<
+        " bytes: prepared in " << buildMs << "ms, snapshot dump " << dumpMs << "ms.";
+}
+
+/**
+ * @tc.name: TraceMetadataCacheTest002
+ * @tc.desc: Test the header_page and printk_formats of the dumps come from the snapshot of the session, tracefs
+ *           is read again only when a new snapshot is prepared.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceMetadataCacheTest, TraceMetadataCacheTest002, TestSize.Level2)
+{
+    ASSERT_TRUE(fakeTracefs_.Build(FakeTracefsConfig()));
+    auto readFile = [this](const std::string& relativePath) {
+        std::ifstream file(fakeTracefs_.GetRootPath() + relativePath);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    };
+    const std::string headerPage = readFile("events/header_page");
+    const std::string printkFormats = readFile("printk_formats");
+    TraceMetadataCache& metadataCache = TraceMetadataCache::GetInstance();
+    metadataCache.PrepareStaticFiles();
+    auto staticFiles = metadataCache.GetPreparedStaticFiles();
+    ASSERT_NE(staticFiles, nullptr);
+    EXPECT_EQ(staticFiles->headerPage, headerPage);
+    EXPECT_EQ(staticFiles->printkFormats, printkFormats);
+
+    // a module loaded during the session, its formats are only dumped after the next snapshot.
+    const std::string modulePrintkFormat = "0xffffffc020000000 : \"fake module format %d\\n\"\n";
+    std::ofstream(fakeTracefs_.GetRootPath() + "printk_formats", std::ios::app) << modulePrintkFormat;
+    TraceDumpParam param = { .type = TraceDumpType::TRACE_SNAPSHOT };
+    TraceDumpRet ret = TraceDumpExecutor::GetInstance().DumpTrace(param, TEST_OUTPUT_DIR);
+    EXPECT_EQ(ret.code, TraceErrorCode::SUCCESS);
+    EXPECT_EQ(ReadSectionContent(ret.outputFile, CONTENT_TYPE_HEADER_PAGE), headerPage);
+    EXPECT_EQ(ReadSectionContent(ret.outputFile, CONTENT_TYPE_PRINTK_FORMATS), printkFormats);
+    remove(ret.outputFile);
+
+    metadataCache.PrepareStaticFiles();
+    ret = TraceDumpExecutor::GetInstance().DumpTrace(param, TEST_OUTPUT_DIR);
+    EXPECT_EQ(ret.code, TraceErrorCode::SUCCESS);
+    EXPECT_EQ(ReadSectionContent(ret.outputFile, CONTENT_TYPE_PRINTK_FORMATS), printkFormats + modulePrintkFormat);
+    remove(ret.outputFile);
+
+    // the fake tracefs of the other cases has no module formats.
+    std::ofstream(fakeTracefs_.GetRootPath() + "printk_formats", std::ios::trunc) << printkFormats;
+    metadataCache.PrepareStaticFiles();
+    EXPECT_EQ(metadataCache.GetPreparedStaticFiles()->printkFormats, printkFormats);
+}
+
+/**
+ * @tc.name: TraceMetadataCacheTest003
+ * @tc.desc: Test the state copied into a forked dump process is versioned, and the process forked while the locks
+ *           of the metadata cache and the strategy factory are held for fork can take them.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceMetadataCacheTest, TraceMetadataCacheTest003, TestSize.Level2)
+{
+    TraceMetadataCache& metadataCache = TraceMetadataCache::GetInstance();
+    uint64_t metadataGeneration = metadataCache.GetGeneration();
+    metadataCache.PrepareEventFormats({}, SAVED_EVENTS_FORMAT_FILE);
+    EXPECT_NE(metadataCache.GetGeneration(), metadataGeneration);
+    metadataGeneration = metadataCache.GetGeneration();
+    metadataCache.PrepareStaticFiles();
+    EXPECT_NE(metadataCache.GetGeneration(), metadataGeneration);
+    metadataGeneration = metadataCache.GetGeneration();
+    metadataCache.PrepareKallsyms();
+    EXPECT_NE(metadataCache.GetGeneration(), metadataGeneration);
+
+    TraceContextManager& contextManager = TraceContextManager::GetInstance();
+    uint64_t filterGeneration = contextManager.GetGeneration();
+    ASSERT_NE(contextManager.GetTraceFilterContext(true), nullptr);
+    EXPECT_NE(contextManager.GetGeneration(), filterGeneration);
+    filterGeneration = contextManager.GetGeneration();
+    contextManager.ReleaseContext();
+    EXPECT_NE(contextManager.GetGeneration(), filterGeneration);
+
+    metadataCache.LockForFork();
+    TraceStrategyFactory::GetInstance().LockForFork();
+    pid_t pid = fork();
+    TraceStrategyFactory::GetInstance().UnlockAfterFork();
+    metadataCache.UnlockAfterFork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        metadataCache.GetPreparedEventFormats();
+        metadataCache.GetPreparedStaticFiles();
+        metadataCache.GetKallsyms();
+        bool created = TraceStrategyFactory::GetInstance().Create(TraceDumpType::TRACE_SNAPSHOT) != nullptr;
+        _exit(created ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), EXIT_SUCCESS);
+    remove(SAVED_EVENTS_FORMAT_FILE);
+}
+
+/**
+ * @tc.name: TraceMetadataCacheTest004
+ * @tc.desc: Test the process forked while other threads allocate can allocate, libc resets the allocator locks in
+ *           the child, which the dump worker forked by StartSyncDumpWorker relies on.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceMetadataCacheTest, TraceMetadataCacheTest004, TestSize.Level2)
+{
+    std::atomic<bool> stop = false;
+    std::vector<std::thread> mallocThreads;
+    for (int i = 0; i < MALLOC_THREAD_COUNT; i++) {
+        mallocThreads.emplace_back([&stop]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                std::vector<std::unique_ptr<uint8_t[]>> blocks;
+                for (int j = 0; j < CHILD_ALLOC_COUNT; j++) {
+                    blocks.emplace_back(new uint8_t[CHILD_ALLOC_SIZE * (j % 4 + 1)]);
+                }
+            }
+        });
+    }
+    int exitedCount = 0;
+    for (int round = 0; round < FORK_ROUNDS; round++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            break;
+        }
+        if (pid == 0) {
+            std::vector<std::unique_ptr<uint8_t[]>> blocks;
+            for (int j = 0; j < CHILD_ALLOC_COUNT; j++) {
+                blocks.emplace_back(new uint8_t[CHILD_ALLOC_SIZE]);
+            }
+            blocks.clear();
+            _exit(EXIT_SUCCESS);
+        }
+        int status = 0;
+        if (!WaitChildExit(pid, status) || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            break;
+        }
+        exitedCount++;
+    }
+    stop = true;
+    for (auto& mallocThread : mallocThreads) {
+        mallocThread.join();
+    }
+    EXPECT_EQ(exitedCount, FORK_ROUNDS);
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <unistd.h>
+
+#include "common_define.h"
+#include "fake_tracefs_test_utils.h"
+#include "trace_dump_executor.h"
+#include "trace_file_utils.h"
+#include "trace_metadata_cache.h"
+#include "trace_metadata_sidecar.h"
+#include "trace_page_index.h"
+
+using namespace testing::ext;
+using namespace std;
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+namespace {
+const char* const SAVED_EVENTS_FORMAT_FILE = "/data/local/tmp/hitrace_saved_events_format";
+constexpr uint64_t USED_SIDECAR_HASH = 0x0123456789abcdef;
+constexpr uint64_t UNUSED_SIDECAR_HASH = 0xfedcba9876543210;
+
+// a trace file which holds nothing but the metadata ref of hash.
+bool WriteRefTraceFile(const std::string& path, const uint64_t hash)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    TraceFileHeader fileHeader;
+    TraceFileContentHeader contentHeader;
+    contentHeader.type = CONTENT_TYPE_METADATA_REF;
+    contentHeader.length = sizeof(TraceMetadataRef);
+    TraceMetadataRef ref;
+    ref.hash = hash;
+    out.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+    out.write(reinterpret_cast<const char*>(&contentHeader), sizeof(contentHeader));
+    out.write(reinterpret_cast<const char*>(&ref), sizeof(ref));
+    return out.good();
+}
+}
+
+class TraceMetadataSidecarTest : public FakeTracefsTest {};
+
+/**
+ * @tc.name: TraceMetadataSidecarTest001
+ * @tc.desc: Test the record slices of a series refer to a metadata sidecar instead of carrying the static sections,
+ *           and a slice is inlined back into a self contained file with a valid page index.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceMetadataSidecarTest, TraceMetadataSidecarTest001, TestSize.Level2)
+{
+    FakeTracefsConfig config;
+    config.eventFormats = { "events/sched/sched_switch/format", "events/sched/sched_wakeup/format",
+        "events/ftrace/print/format" };
+    ASSERT_TRUE(fakeTracefs_.Build(config));
+    TraceMetadataCache& metadataCache = TraceMetadataCache::GetInstance();
+    metadataCache.PrepareEventFormats(config.eventFormats, SAVED_EVENTS_FORMAT_FILE);
+    metadataCache.PrepareStaticFiles();
+    auto eventFormats = metadataCache.GetPreparedEventFormats();
+    auto staticFiles = metadataCache.GetPreparedStaticFiles();
+    ASSERT_NE(eventFormats, nullptr);
+    ASSERT_NE(staticFiles, nullptr);
+    remove(SAVED_EVENTS_FORMAT_FILE);
+
+    TraceDumpParam param = {
+        .type = TraceDumpType::TRACE_RECORDING,
+        .metadataSidecar = true
+    };
+    auto outputFiles = RunRecordLoop(param);
+    ASSERT_FALSE(outputFiles.empty());
+
+    const std::string& sliceFile = outputFiles[0];
+    EXPECT_TRUE(ReadSectionContent(sliceFile, CONTENT_TYPE_EVENTS_FORMAT).empty());
+    EXPECT_TRUE(ReadSectionContent(sliceFile, CONTENT_TYPE_HEADER_PAGE).empty());
+    std::string refContent = ReadSectionContent(sliceFile, CONTENT_TYPE_METADATA_REF);
+    ASSERT_EQ(refContent.size(), sizeof(TraceMetadataRef));
+    TraceMetadataRef ref;
+    std::copy(refContent.begin(), refContent.end(), reinterpret_cast<char*>(&ref));
+    std::string sidecarFile = TraceMetadataSidecar::GetFilePath(TEST_OUTPUT_DIR, ref.hash);
+    off_t sidecarSize = GetFileSize(sidecarFile);
+    EXPECT_GT(sidecarSize, 0);
+
+    off_t sliceSize = GetFileSize(sliceFile);
+    ASSERT_TRUE(InlineMetadataSidecar(sliceFile));
+    EXPECT_FALSE(InlineMetadataSidecar(sliceFile));
+    EXPECT_TRUE(ReadSectionContent(sliceFile, CONTENT_TYPE_METADATA_REF).empty());
+    EXPECT_EQ(ReadSectionContent(sliceFile, CONTENT_TYPE_EVENTS_FORMAT), eventFormats->GetContent());
+    EXPECT_EQ(ReadSectionContent(sliceFile, CONTENT_TYPE_HEADER_PAGE), staticFiles->headerPage);
+    EXPECT_EQ(ReadSectionContent(sliceFile, CONTENT_TYPE_PRINTK_FORMATS), staticFiles->printkFormats);
+    off_t inlinedSize = GetFileSize(sliceFile);
+    EXPECT_GT(inlinedSize, sliceSize);
+
+    std::string windowFile = std::string(TEST_OUTPUT_DIR) + "trace_window.sys";
+    uint64_t firstPageTime = 0;
+    uint64_t lastPageTime = 0;
+    EXPECT_TRUE(ExtractTraceWindow(sliceFile, windowFile, fakeTracefs_.GetFirstPageTime(),
+        fakeTracefs_.GetLastPageTime(), firstPageTime, lastPageTime));
+    EXPECT_EQ(firstPageTime, fakeTracefs_.GetFirstPageTime());
+    remove(windowFile.c_str());
+    remove(sidecarFile.c_str());
+    for (const auto& file : outputFiles) {
+        remove(file.c_str());
+    }
+    GTEST_LOG_(INFO) << "metadata sidecar: " << sidecarSize << " bytes shared, slice " << sliceSize <<
+        " bytes, inlined " << inlinedSize << " bytes.";
+}
+
+/**
+ * @tc.name: TraceMetadataSidecarTest002
+ * @tc.desc: Test a sidecar is kept while a trace file of its directory refers to it and removed with the last one.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceMetadataSidecarTest, TraceMetadataSidecarTest002, TestSize.Level2)
+{
+    std::string sliceFile = std::string(TEST_OUTPUT_DIR) + "record_trace_sidecar_ref.sys";
+    std::string usedSidecar = TraceMetadataSidecar::GetFilePath(TEST_OUTPUT_DIR, USED_SIDECAR_HASH);
+    std::string unusedSidecar = TraceMetadataSidecar::GetFilePath(TEST_OUTPUT_DIR, UNUSED_SIDECAR_HASH);
+    std::string savingSidecar = unusedSidecar + ".tmp";
+    ASSERT_TRUE(WriteRefTraceFile(sliceFile, USED_SIDECAR_HASH));
+    for (const auto& file : { usedSidecar, unusedSidecar, savingSidecar }) {
+        std::ofstream(file, std::ios::trunc) << "sidecar";
+    }
+
+    RemoveUnusedMetadataSidecars(TEST_OUTPUT_DIR);
+    EXPECT_EQ(access(usedSidecar.c_str(), F_OK), 0);
+    EXPECT_NE(access(unusedSidecar.c_str(), F_OK), 0);
+    EXPECT_EQ(access(savingSidecar.c_str(), F_OK), 0);
+
+    remove(sliceFile.c_str());
+    RemoveUnusedMetadataSidecars(TEST_OUTPUT_DIR);
+    EXPECT_NE(access(usedSidecar.c_str(), F_OK), 0);
+    remove(savingSidecar.c_str());
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
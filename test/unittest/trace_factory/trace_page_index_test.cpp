@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <limits>
+
+#include "common_define.h"
+#include "fake_tracefs_test_utils.h"
+#include "trace_dump_executor.h"
+#include "trace_file_utils.h"
+#include "trace_page_index.h"
+
+using namespace testing::ext;
+using namespace std;
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+class TracePageIndexTest : public FakeTracefsTest {};
+
+/**
+ * @tc.name: TracePageIndexTest001
+ * @tc.desc: Test a time window is cut out of a record file through its page index.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TracePageIndexTest, TracePageIndexTest001, TestSize.Level2)
+{
+    FakeTracefsConfig config;
+    config.pagesPerCpu = RECORD_PAGES_PER_CPU;
+    ASSERT_TRUE(fakeTracefs_.Build(config));
+    TraceDumpParam param = {
+        .type = TraceDumpType::TRACE_RECORDING
+    };
+    auto outputFiles = RunRecordLoop(param);
+    ASSERT_FALSE(outputFiles.empty());
+
+    uint64_t edge = GetWindowEdge();
+    uint64_t startTime = fakeTracefs_.GetFirstPageTime() + edge;
+    uint64_t endTime = fakeTracefs_.GetLastPageTime() - edge;
+    std::string windowFile = std::string(TEST_OUTPUT_DIR) + "trace_window.sys";
+    uint64_t firstPageTime = 0;
+    uint64_t lastPageTime = 0;
+    BenchmarkSample sample;
+    sample.inputBytes = static_cast<uint64_t>(GetFileSize(outputFiles[0]));
+    BenchmarkTimer timer;
+    ASSERT_TRUE(ExtractTraceWindow(outputFiles[0], windowFile, startTime, endTime, firstPageTime, lastPageTime));
+    timer.Stop(sample);
+    EXPECT_GE(firstPageTime, startTime);
+    EXPECT_LE(lastPageTime, endTime);
+    sample.outputBytes = static_cast<uint64_t>(GetFileSize(windowFile));
+    EXPECT_GT(sample.outputBytes, 0);
+    EXPECT_LT(sample.outputBytes, sample.inputBytes * 3 / WINDOW_EDGE_DIVISOR); // 3 : the middle half and some more
+    EXPECT_FALSE(ExtractTraceWindow(outputFiles[0], windowFile, fakeTracefs_.GetLastPageTime() + 1,
+        std::numeric_limits<uint64_t>::max(), firstPageTime, lastPageTime));
+    remove(windowFile.c_str());
+    for (const auto& file : outputFiles) {
+        remove(file.c_str());
+    }
+    ReportSample("window extraction", config, sample);
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <fstream>
+
+#include "common_define.h"
+#include "fake_tracefs_test_utils.h"
+#include "trace_context.h"
+#include "trace_process_table.h"
+
+using namespace testing::ext;
+using namespace std;
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+namespace {
+constexpr size_t FILTER_PAGE_COUNT = 2560;
+constexpr uint64_t FILTER_PAGE_INTERVAL = 200000000; // 200ms, the kept events of two pages need a time extend
+constexpr int SAVED_TASK_COUNT = 8192; // the size of saved_cmdlines raised for the filtered apps
+constexpr int FILTER_APP_PID = 5000;
+constexpr int FILTER_APP_THREADS = 64;
+constexpr int OTHER_TASK_PID = 10000;
+}
+
+class TracePidFilterTest : public FakeTracefsTest {};
+
+/**
+ * @tc.name: TracePidFilterTest001
+ * @tc.desc: Test the pid filter of the drain keeps the events of the filtered tasks at their original times in
+ *           dense pages, and passes the pages whose events are all kept through.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TracePidFilterTest, TracePidFilterTest001, TestSize.Level2)
+{
+    ASSERT_TRUE(fakeTracefs_.Build(FakeTracefsConfig()));
+    const std::vector<int> pids = { 1, 100, 1000 };
+    std::vector<uint8_t> input(FILTER_PAGE_COUNT * PAGE_SIZE);
+    for (size_t i = 0; i < FILTER_PAGE_COUNT; i++) {
+        FakeTracefs::FillRawPage(input.data() + i * PAGE_SIZE, (i + 1) * FILTER_PAGE_INTERVAL, pids, i);
+    }
+    auto eventPids = std::make_shared<TracePagePids>(fakeTracefs_.GetRootPath() + "events/header_page");
+    ASSERT_TRUE(eventPids->IsValid());
+    eventPids->Add(100); // 100 : one of the three tasks
+
+    std::vector<uint8_t> output;
+    TracePagePidFilter pidFilter(eventPids, [&output](const uint8_t* pages, const size_t size) {
+        output.insert(output.end(), pages, pages + size);
+    });
+    pidFilter.FilterPages(input.data(), input.size());
+    pidFilter.Flush();
+    GTEST_LOG_(INFO) << "pid filter: kept " << output.size() << " of " << input.size() << " bytes, " <<
+        pidFilter.GetDroppedEvents() << " events dropped in " << pidFilter.GetCostUs() << "us.";
+    ASSERT_EQ(output.size() % PAGE_SIZE, 0);
+    EXPECT_EQ(pidFilter.GetOutputBytes(), output.size());
+    EXPECT_LT(output.size(), input.size() / 2); // 2 : two of the three tasks are dropped
+    std::vector<std::pair<int, uint64_t>> expected;
+    for (const auto& event : ReadPageEvents(input.data(), input.size())) {
+        if (event.first == 100) { // 100 : the kept task
+            expected.push_back(event);
+        }
+    }
+    ASSERT_FALSE(expected.empty());
+    EXPECT_TRUE(ReadPageEvents(output.data(), output.size()) == expected);
+
+    eventPids->Add(1);
+    eventPids->Add(1000); // 1000 : all the tasks are kept
+    output.clear();
+    TracePagePidFilter passFilter(eventPids, [&output](const uint8_t* pages, const size_t size) {
+        output.insert(output.end(), pages, pages + size);
+    });
+    passFilter.FilterPages(input.data(), input.size());
+    passFilter.Flush();
+    EXPECT_TRUE(output == input);
+    EXPECT_EQ(passFilter.GetDroppedEvents(), 0);
+}
+
+/**
+ * @tc.name: TracePidFilterTest002
+ * @tc.desc: Test the filter context picks the threads of the filtered process out of a full saved_tgids, and
+ *           keeps the exited threads while dropping the reused tids when it is refreshed.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TracePidFilterTest, TracePidFilterTest002, TestSize.Level2)
+{
+    ASSERT_TRUE(fakeTracefs_.Build(FakeTracefsConfig()));
+    auto writeSavedTasks = [this](const int reusedTid, const int exitedTid) {
+        std::ofstream tgids(fakeTracefs_.GetRootPath() + "saved_tgids", std::ios::trunc);
+        std::ofstream cmdlines(fakeTracefs_.GetRootPath() + "saved_cmdlines", std::ios::trunc);
+        for (int tid = FILTER_APP_PID; tid < FILTER_APP_PID + FILTER_APP_THREADS; tid++) {
+            if (tid != exitedTid) {
+                tgids << tid << " " << (tid == reusedTid ? OTHER_TASK_PID : FILTER_APP_PID) << "\n";
+                cmdlines << tid << " app_thread_" << tid << "\n";
+            }
+        }
+        for (int tid = OTHER_TASK_PID; tid < OTHER_TASK_PID + SAVED_TASK_COUNT - FILTER_APP_THREADS; tid++) {
+            tgids << tid << " " << OTHER_TASK_PID << "\n";
+            cmdlines << tid << " other_task_" << tid << "\n";
+        }
+    };
+    auto filterContext = TraceContextManager::GetInstance().GetTraceFilterContext(true);
+    ASSERT_NE(filterContext, nullptr);
+    std::ofstream(fakeTracefs_.GetRootPath() + "set_event_pid", std::ios::trunc) << FILTER_APP_PID << "\n";
+    auto countTasks = [&filterContext](size_t& threads, size_t& cmdlines) {
+        threads = 0;
+        cmdlines = 0;
+        filterContext->TraverseTGidsContent([&threads](const std::pair<int, int>& tgid) {
+            threads += tgid.second == FILTER_APP_PID ? 1 : 0;
+        });
+        filterContext->TraverseSavedCmdLine([&cmdlines](const std::string& cmdline) {
+            cmdlines += cmdline.find("app_thread_") != std::string::npos ? 1 : 0;
+        });
+    };
+
+    writeSavedTasks(-1, -1);
+    auto start = std::chrono::steady_clock::now();
+    filterContext->FilterTraceContent();
+    double firstMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    size_t threads = 0;
+    size_t cmdlines = 0;
+    countTasks(threads, cmdlines);
+    EXPECT_EQ(threads, FILTER_APP_THREADS);
+    EXPECT_EQ(cmdlines, FILTER_APP_THREADS);
+    std::vector<int> filterPids;
+    filterContext->TraverseFilterPid([&filterPids](const int pid) { filterPids.push_back(pid); });
+    EXPECT_EQ(filterPids, std::vector<int>({ FILTER_APP_PID }));
+
+    // one thread is gone from saved_tgids, the tid of another one is reused by a process out of the filter.
+    writeSavedTasks(FILTER_APP_PID + 1, FILTER_APP_PID + 2);
+    start = std::chrono::steady_clock::now();
+    filterContext->FilterTraceContent();
+    double refreshMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    countTasks(threads, cmdlines);
+    EXPECT_EQ(threads, FILTER_APP_THREADS - 1);
+    EXPECT_EQ(cmdlines, FILTER_APP_THREADS - 1);
+    TraceContextManager::GetInstance().ReleaseContext();
+    GTEST_LOG_(INFO) << "filter " << SAVED_TASK_COUNT << " saved tasks: first " << firstMs << "ms, refresh " <<
+        refreshMs << "ms.";
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
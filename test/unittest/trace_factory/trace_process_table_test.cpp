@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "common_define.h"
+#include "fake_tracefs_test_utils.h"
+#include "trace_dump_executor.h"
+#include "trace_process_table.h"
+
+using namespace testing::ext;
+using namespace std;
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+namespace {
+const char* const FAKE_PROC_DIR = "/data/local/tmp/hitrace_fake_proc";
+}
+
+class TraceProcessTableTest : public FakeTracefsTest {};
+
+/**
+ * @tc.name: TraceProcessTableTest001
+ * @tc.desc: Test the process table lists the pid directories of /proc with their comm, sorted by pid.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceProcessTableTest, TraceProcessTableTest001, TestSize.Level2)
+{
+    const std::vector<std::pair<std::string, std::string>> fakeProcesses = {
+        { "1000", "fake_task_1000" }, { "1", "init" }, { "100", "fake_task_100" }
+    };
+    const std::string fakeProcDir = FAKE_PROC_DIR;
+    mkdir(fakeProcDir.c_str(), 0755); // 0755 : rwxr-xr-x
+    mkdir((fakeProcDir + "/self").c_str(), 0755); // 0755 : rwxr-xr-x
+    for (const auto& process : fakeProcesses) {
+        std::string processDir = fakeProcDir + "/" + process.first;
+        mkdir(processDir.c_str(), 0755); // 0755 : rwxr-xr-x
+        std::ofstream(processDir + "/comm") << process.second << "\n";
+    }
+    TraceProcessTable fakeTable(fakeProcDir);
+    const auto& processes = fakeTable.GetProcesses();
+    ASSERT_EQ(processes.size(), fakeProcesses.size());
+    EXPECT_EQ(processes[0].pid, 1);
+    EXPECT_EQ(processes[1].pid, 100);
+    EXPECT_EQ(processes[2].pid, 1000);
+    EXPECT_EQ(processes[0].name, "init");
+    EXPECT_EQ(fakeTable.GetProcessName("1000"), "fake_task_1000");
+    EXPECT_EQ(fakeTable.GetProcessName("2000"), "");
+    for (const auto& process : fakeProcesses) {
+        std::string processDir = fakeProcDir + "/" + process.first;
+        remove((processDir + "/comm").c_str());
+        remove(processDir.c_str());
+    }
+    remove((fakeProcDir + "/self").c_str());
+    remove(fakeProcDir.c_str());
+
+    BenchmarkSample sample;
+    BenchmarkTimer timer;
+    TraceProcessTable procTable;
+    size_t processCount = procTable.GetProcesses().size();
+    timer.Stop(sample);
+    EXPECT_GT(processCount, 0);
+    EXPECT_FALSE(procTable.GetProcessName(std::to_string(getpid())).empty());
+    GTEST_LOG_(INFO) << "process table: " << processCount << " processes in " << sample.wallMs << " ms";
+}
+
+/**
+ * @tc.name: TraceProcessTableTest002
+ * @tc.desc: Test the cmdlines and tgids sections only list the tasks of the dumped pages when seenPidsOnly is set,
+ *           the tasks missing from saved_cmdlines are named from /proc.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceProcessTableTest, TraceProcessTableTest002, TestSize.Level2)
+{
+    const std::string selfPid = std::to_string(getpid());
+    FakeTracefsConfig config;
+    config.pids = { 1, 100, getpid() };
+    ASSERT_TRUE(fakeTracefs_.Build(config));
+    // pid 2000 never appears in the pages, the test process is missing from saved_cmdlines.
+    std::ofstream(fakeTracefs_.GetRootPath() + "saved_cmdlines") << "1 init\n100 fake_task_100\n2000 fake_task_2000\n";
+    std::ofstream(fakeTracefs_.GetRootPath() + "saved_tgids") << "1 1\n100 1\n2000 2000\n" << selfPid << " " <<
+        selfPid << "\n";
+    TraceDumpParam param = {
+        .type = TraceDumpType::TRACE_SNAPSHOT,
+        .seenPidsOnly = true
+    };
+    TraceDumpRet ret = TraceDumpExecutor::GetInstance().DumpTrace(param, TEST_OUTPUT_DIR);
+    ASSERT_EQ(ret.code, TraceErrorCode::SUCCESS);
+    std::string cmdlines = ReadSectionContent(ret.outputFile, CONTENT_TYPE_CMDLINES);
+    std::string tgids = ReadSectionContent(ret.outputFile, CONTENT_TYPE_TGIDS);
+    remove(ret.outputFile);
+    GTEST_LOG_(INFO) << "cmdlines: " << cmdlines << "tgids: " << tgids;
+    EXPECT_NE(cmdlines.find("1 init\n"), std::string::npos);
+    EXPECT_NE(cmdlines.find("100 fake_task_100\n"), std::string::npos);
+    EXPECT_NE(cmdlines.find("\n" + selfPid + " "), std::string::npos);
+    EXPECT_EQ(cmdlines.find("2000"), std::string::npos);
+    EXPECT_EQ(tgids, "1 1\n100 1\n" + selfPid + " " + selfPid + "\n");
+
+    param.seenPidsOnly = false;
+    ret = TraceDumpExecutor::GetInstance().DumpTrace(param, TEST_OUTPUT_DIR);
+    ASSERT_EQ(ret.code, TraceErrorCode::SUCCESS);
+    EXPECT_NE(ReadSectionContent(ret.outputFile, CONTENT_TYPE_TGIDS).find("2000 2000\n"), std::string::npos);
+    remove(ret.outputFile);
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "common_define.h"
+#include "fake_tracefs_test_utils.h"
+#include "smart_fd.h"
+#include "trace_content.h"
+#include "trace_dump_executor.h"
+#include "trace_page_index.h"
+#include "trace_section_table.h"
+
+using namespace testing::ext;
+using namespace std;
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+class TraceSectionTableTest : public FakeTracefsTest {};
+
+/**
+ * @tc.name: TraceSectionTableTest001
+ * @tc.desc: Test record files and the windows cut out of them end with a section table which locates every section.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceSectionTableTest, TraceSectionTableTest001, TestSize.Level2)
+{
+    FakeTracefsConfig config;
+    config.pagesPerCpu = RECORD_PAGES_PER_CPU;
+    ASSERT_TRUE(fakeTracefs_.Build(config));
+    TraceDumpParam param = {
+        .type = TraceDumpType::TRACE_RECORDING
+    };
+    auto outputFiles = RunRecordLoop(param);
+    ASSERT_FALSE(outputFiles.empty());
+
+    SmartFd traceFd(open(outputFiles[0].c_str(), O_RDONLY));
+    ASSERT_TRUE(traceFd);
+    std::vector<TraceSectionTableEntry> entries;
+    ASSERT_TRUE(ReadSectionTable(traceFd.GetFd(), entries));
+    std::vector<TraceSectionTableEntry> walkEntries;
+    ASSERT_TRUE(BuildSectionTable(traceFd.GetFd(), entries.empty() ? 0 : entries.back().offset +
+        sizeof(TraceFileContentHeader) + entries.back().length, walkEntries));
+    ASSERT_EQ(entries.size(), walkEntries.size());
+    uint64_t pageCount = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        EXPECT_EQ(entries[i].offset, walkEntries[i].offset);
+        EXPECT_EQ(entries[i].type, walkEntries[i].type);
+        if (entries[i].type >= CONTENT_TYPE_CPU_RAW && entries[i].type < CONTENT_TYPE_HEADER_PAGE) {
+            EXPECT_LE(entries[i].firstTimestamp, entries[i].lastTimestamp);
+            EXPECT_GE(entries[i].firstTimestamp, fakeTracefs_.GetFirstPageTime());
+            EXPECT_LE(entries[i].lastTimestamp, fakeTracefs_.GetLastPageTime());
+            pageCount += entries[i].pageCount;
+        }
+    }
+    EXPECT_GT(pageCount, 0);
+
+    uint64_t edge = GetWindowEdge();
+    std::string windowFile = std::string(TEST_OUTPUT_DIR) + "trace_window.sys";
+    uint64_t firstPageTime = 0;
+    uint64_t lastPageTime = 0;
+    ASSERT_TRUE(ExtractTraceWindow(outputFiles[0], windowFile, fakeTracefs_.GetFirstPageTime() + edge,
+        fakeTracefs_.GetLastPageTime() - edge, firstPageTime, lastPageTime));
+    SmartFd windowFd(open(windowFile.c_str(), O_RDONLY));
+    std::vector<TraceSectionTableEntry> windowEntries;
+    ASSERT_TRUE(ReadSectionTable(windowFd.GetFd(), windowEntries));
+    for (const auto& entry : windowEntries) {
+        EXPECT_NE(entry.type, CONTENT_TYPE_PAGE_INDEX);
+        if (entry.type >= CONTENT_TYPE_CPU_RAW && entry.type < CONTENT_TYPE_HEADER_PAGE) {
+            EXPECT_GE(entry.firstTimestamp, firstPageTime);
+            EXPECT_LE(entry.lastTimestamp, lastPageTime);
+        }
+    }
+    remove(windowFile.c_str());
+    for (const auto& file : outputFiles) {
+        remove(file.c_str());
+    }
+}
+
+/**
+ * @tc.name: TraceSectionTableTest002
+ * @tc.desc: Test the page timestamps of the cpu raw sections are only read from the files of the linux kernel.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceSectionTableTest, TraceSectionTableTest002, TestSize.Level2)
+{
+    constexpr uint64_t rawPageCount = 2;
+    constexpr uint64_t firstPageTime = 1000;
+    constexpr uint64_t lastPageTime = 2000;
+    std::vector<uint8_t> pages(rawPageCount * PAGE_SIZE, 0);
+    *reinterpret_cast<uint64_t*>(pages.data()) = firstPageTime;
+    *reinterpret_cast<uint64_t*>(pages.data() + PAGE_SIZE) = lastPageTime;
+    std::string traceFile = std::string(TEST_OUTPUT_DIR) + "trace_section_table.sys";
+    for (uint8_t fileType : {FILE_RAW_TRACE, HM_FILE_RAW_TRACE}) {
+        SmartFd traceFd(open(traceFile.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644)); // 0644 : -rw-r--r--
+        ASSERT_TRUE(traceFd);
+        TraceFileHeader fileHeader;
+        fileHeader.fileType = fileType;
+        TraceFileContentHeader contentHeader;
+        contentHeader.type = CONTENT_TYPE_CPU_RAW;
+        contentHeader.length = static_cast<uint32_t>(pages.size());
+        ASSERT_EQ(write(traceFd.GetFd(), &fileHeader, sizeof(fileHeader)), sizeof(fileHeader));
+        ASSERT_EQ(write(traceFd.GetFd(), &contentHeader, sizeof(contentHeader)), sizeof(contentHeader));
+        ASSERT_EQ(write(traceFd.GetFd(), pages.data(), pages.size()), pages.size());
+
+        std::vector<TraceSectionTableEntry> entries;
+        ASSERT_TRUE(BuildSectionTable(traceFd.GetFd(), sizeof(fileHeader) + sizeof(contentHeader) + pages.size(),
+            entries));
+        ASSERT_EQ(entries.size(), 1);
+        EXPECT_EQ(entries[0].pageCount, rawPageCount);
+        EXPECT_EQ(entries[0].firstTimestamp, fileType == HM_FILE_RAW_TRACE ? 0 : firstPageTime);
+        EXPECT_EQ(entries[0].lastTimestamp, fileType == HM_FILE_RAW_TRACE ? 0 : lastPageTime);
+    }
+    remove(traceFile.c_str());
+}
+
+/**
+ * @tc.name: TraceSectionTableTest003
+ * @tc.desc: Test the section table is built through the fd of the trace file, not its path, which may be renamed.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceSectionTableTest, TraceSectionTableTest003, TestSize.Level2)
+{
+    std::string traceFile = std::string(TEST_OUTPUT_DIR) + "trace_section_table.sys";
+    std::string renamedFile = std::string(TEST_OUTPUT_DIR) + "trace_section_table_renamed.sys";
+    SmartFd traceFd(open(traceFile.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644)); // 0644 : -rw-r--r--
+    ASSERT_TRUE(traceFd);
+    std::vector<uint8_t> page(PAGE_SIZE, 0);
+    TraceFileHeader fileHeader;
+    TraceFileContentHeader contentHeader;
+    contentHeader.type = CONTENT_TYPE_CPU_RAW;
+    contentHeader.length = static_cast<uint32_t>(page.size());
+    ASSERT_EQ(write(traceFd.GetFd(), &fileHeader, sizeof(fileHeader)), sizeof(fileHeader));
+    ASSERT_EQ(write(traceFd.GetFd(), &contentHeader, sizeof(contentHeader)), sizeof(contentHeader));
+    ASSERT_EQ(write(traceFd.GetFd(), page.data(), page.size()), page.size());
+    ASSERT_EQ(rename(traceFile.c_str(), renamedFile.c_str()), 0);
+
+    TraceSectionTableContent sectionTable(traceFd.GetFd(), traceFile, false);
+    ASSERT_TRUE(sectionTable.WriteTraceContent());
+    std::vector<TraceSectionTableEntry> entries;
+    ASSERT_TRUE(ReadSectionTable(traceFd.GetFd(), entries));
+    ASSERT_EQ(entries.size(), 1);
+    EXPECT_EQ(entries[0].offset, sizeof(fileHeader));
+    EXPECT_EQ(entries[0].type, CONTENT_TYPE_CPU_RAW);
+    remove(renamedFile.c_str());
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
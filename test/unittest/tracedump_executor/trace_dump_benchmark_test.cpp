@@ -0,0 +1,410 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "common_define.h"
+#include "common_utils.h"
+#include "fake_tracefs_test_utils.h"
+#include "trace_buffer_waiter.h"
+#include "trace_content.h"
+#include "trace_dump_executor.h"
+#include "trace_file_utils.h"
+#include "trace_flight_recorder.h"
+#include "trace_io_uring.h"
+
+using namespace testing::ext;
+using namespace std;
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+namespace {
+constexpr int WAITER_MAX_LATENCY_MS = 200;
+constexpr int WAITER_MIN_INTERVAL_MS = 10;
+constexpr uint64_t OVERRUN_PER_CPU = 1000;
+constexpr int FLIGHT_RECORD_SECONDS = 2; // at least one drain of the flight recorder
+constexpr int FLIGHT_DRAIN_ROUNDS = 3;
+constexpr uint64_t CACHE_TOTAL_FILE_SIZE_LIMIT = 1024ULL * 1024 * 1024; // keep all the cache slices of a run
+constexpr size_t PAGES_PER_CPU[] = { 256, 2560 }; // 1M and 10M of raw data per cpu
+constexpr int HOST_THREAD_COUNT = 32; // worker threads of a host process which never dump
+constexpr long HOST_THREAD_MAX_RSS_KB = 256; // stack and bookkeeping of an idle thread
+constexpr size_t URING_READ_DEPTH = 32; // the linked reads of trace_pipe_raw in one batch
+constexpr size_t URING_READ_BATCHES = 2; // the batch being handled and the next one in flight
+constexpr size_t URING_END_PAGE = 5; // the page which ends the first batch of reads
+
+// the read/write loop, the default engine, is the baseline of splice and io_uring.
+std::string GetEngineScene(const std::string& scene, const TraceDumpEngine engine)
+{
+    switch (engine) {
+        case TraceDumpEngine::ENGINE_SPLICE:
+            return scene + "(splice)";
+        case TraceDumpEngine::ENGINE_IO_URING:
+            return scene + "(io_uring)";
+        default:
+            return scene + "(read/write)";
+    }
+}
+
+std::vector<FakeTracefsConfig> GetBenchmarkConfigs()
+{
+    std::vector<FakeTracefsConfig> configs;
+    std::set<int> cpuCounts = { 1, GetCpuProcessors() };
+    for (int cpuCount : cpuCounts) {
+        for (size_t pages : PAGES_PER_CPU) {
+            FakeTracefsConfig config;
+            config.cpuCount = cpuCount;
+            config.pagesPerCpu = pages;
+            config.eventFormats = GetAllEventFormats();
+            configs.push_back(config);
+        }
+    }
+    return configs;
+}
+
+long GetVmRssKb()
+{
+    const std::string rssKey = "VmRSS:";
+    std::ifstream statusFile("/proc/self/status");
+    std::string line;
+    while (std::getline(statusFile, line)) {
+        if (line.compare(0, rssKey.size(), rssKey) == 0) {
+            return std::strtol(line.c_str() + rssKey.size(), nullptr, 10); // 10 : decimal
+        }
+    }
+    return 0;
+}
+
+void RunLoopDump(const TraceDumpType type, BenchmarkSample& sample)
+{
+    TraceDumpExecutor& traceDumpExecutor = TraceDumpExecutor::GetInstance();
+    ASSERT_TRUE(traceDumpExecutor.PreCheckDumpTraceLoopStatus());
+    TraceDumpParam param = {
+        .type = type,
+        .cacheTotalFileSizeLmt = CACHE_TOTAL_FILE_SIZE_LIMIT,
+        .cacheSliceDuration = LOOP_DUMP_SECONDS
+    };
+    BenchmarkTimer timer;
+    std::thread loopThread([&traceDumpExecutor, &param]() {
+        if (param.type == TraceDumpType::TRACE_CACHE) {
+            traceDumpExecutor.StartCacheTraceLoop(param);
+        } else {
+            traceDumpExecutor.StartDumpTraceLoop(param, TEST_OUTPUT_DIR);
+        }
+    });
+    sleep(LOOP_DUMP_SECONDS);
+    std::vector<std::string> outputFiles;
+    if (type == TraceDumpType::TRACE_CACHE) {
+        traceDumpExecutor.StopCacheTraceLoop();
+    } else {
+        outputFiles = traceDumpExecutor.StopDumpTraceLoop();
+    }
+    loopThread.join();
+    timer.Stop(sample);
+    if (type == TraceDumpType::TRACE_CACHE) {
+        for (const auto& file : traceDumpExecutor.GetCacheTraceFiles()) {
+            outputFiles.push_back(file.filename);
+        }
+        traceDumpExecutor.ClearCacheTraceFiles();
+    }
+    for (const auto& file : outputFiles) {
+        sample.outputBytes += static_cast<uint64_t>(GetFileSize(file));
+        remove(file.c_str());
+    }
+}
+}
+
+class TraceDumpBenchmarkTest : public FakeTracefsTest {};
+
+/**
+ * @tc.name: TraceDumpBenchmarkTest001
+ * @tc.desc: Test snapshot dump throughput over the fake tracefs with the read/write loop, splice and io_uring
+ *           engines.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceDumpBenchmarkTest, TraceDumpBenchmarkTest001, TestSize.Level2)
+{
+    for (const auto& config : GetBenchmarkConfigs()) {
+        ASSERT_TRUE(fakeTracefs_.Build(config));
+        for (auto engine : { TraceDumpEngine::ENGINE_DEFAULT, TraceDumpEngine::ENGINE_SPLICE,
+            TraceDumpEngine::ENGINE_IO_URING }) {
+            TraceDumpParam param = {
+                .type = TraceDumpType::TRACE_SNAPSHOT,
+                .engine = engine
+            };
+            BenchmarkSample sample;
+            sample.inputBytes = fakeTracefs_.GetRawDataSize();
+            BenchmarkTimer timer;
+            TraceDumpRet ret = TraceDumpExecutor::GetInstance().DumpTrace(param, TEST_OUTPUT_DIR);
+            timer.Stop(sample);
+            EXPECT_EQ(ret.code, TraceErrorCode::SUCCESS);
+            EXPECT_EQ(ret.traceStartTime, fakeTracefs_.GetFirstPageTime());
+            sample.outputBytes = static_cast<uint64_t>(GetFileSize(ret.outputFile));
+            EXPECT_GE(sample.outputBytes, sample.inputBytes);
+            remove(ret.outputFile);
+            ReportSample(GetEngineScene("snapshot", engine), config, sample);
+        }
+    }
+}
+
+/**
+ * @tc.name: TraceDumpBenchmarkTest002
+ * @tc.desc: Test record dump throughput over the fake tracefs, every round drains a full ring buffer.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceDumpBenchmarkTest, TraceDumpBenchmarkTest002, TestSize.Level2)
+{
+    for (const auto& config : GetBenchmarkConfigs()) {
+        ASSERT_TRUE(fakeTracefs_.Build(config));
+        BenchmarkSample sample;
+        sample.inputBytes = fakeTracefs_.GetRawDataSize();
+        RunLoopDump(TraceDumpType::TRACE_RECORDING, sample);
+        EXPECT_GE(sample.outputBytes, fakeTracefs_.GetRawDataSize());
+        ReportSample("record", config, sample);
+    }
+}
+
+/**
+ * @tc.name: TraceDumpBenchmarkTest003
+ * @tc.desc: Test cache dump throughput over the fake tracefs, every round drains a full ring buffer.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceDumpBenchmarkTest, TraceDumpBenchmarkTest003, TestSize.Level2)
+{
+    for (const auto& config : GetBenchmarkConfigs()) {
+        ASSERT_TRUE(fakeTracefs_.Build(config));
+        BenchmarkSample sample;
+        sample.inputBytes = fakeTracefs_.GetRawDataSize();
+        RunLoopDump(TraceDumpType::TRACE_CACHE, sample);
+        ReportSample("cache", config, sample);
+    }
+}
+
+/**
+ * @tc.name: TraceDumpBenchmarkTest004
+ * @tc.desc: Test TraceBufferWaiter falls back to the max latency timer on a fake tracefs which can not be polled,
+ *           and sums the lost events of all the cpus.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceDumpBenchmarkTest, TraceDumpBenchmarkTest004, TestSize.Level2)
+{
+    FakeTracefsConfig config;
+    config.overrunPerCpu = OVERRUN_PER_CPU;
+    ASSERT_TRUE(fakeTracefs_.Build(config));
+    EXPECT_EQ(TraceBufferWaiter::GetLostEvents(), OVERRUN_PER_CPU * static_cast<uint64_t>(GetCpuProcessors()));
+
+    TraceBufferWaiter bufferWaiter(WAITER_MAX_LATENCY_MS, WAITER_MIN_INTERVAL_MS);
+    EXPECT_FALSE(bufferWaiter.IsPollable());
+    auto waitStart = std::chrono::steady_clock::now();
+    bufferWaiter.Wait();
+    auto waitTime = std::chrono::steady_clock::now() - waitStart;
+    EXPECT_GE(waitTime, std::chrono::milliseconds(WAITER_MAX_LATENCY_MS));
+}
+
+/**
+ * @tc.name: TraceDumpBenchmarkTest005
+ * @tc.desc: Test in-memory cache trace, only the requested time window is written to a file.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceDumpBenchmarkTest, TraceDumpBenchmarkTest005, TestSize.Level2)
+{
+    FakeTracefsConfig config;
+    ASSERT_TRUE(fakeTracefs_.Build(config));
+    TraceDumpExecutor& traceDumpExecutor = TraceDumpExecutor::GetInstance();
+    ASSERT_TRUE(traceDumpExecutor.PreCheckDumpTraceLoopStatus());
+    TraceDumpParam param = {
+        .type = TraceDumpType::TRACE_CACHE,
+        .cacheTotalFileSizeLmt = CACHE_TOTAL_FILE_SIZE_LIMIT,
+        .cacheInMemory = true
+    };
+    std::thread cacheThread([&traceDumpExecutor, &param]() {
+        traceDumpExecutor.StartCacheTraceLoop(param);
+    });
+    sleep(FLIGHT_RECORD_SECONDS);
+    EXPECT_TRUE(TraceFlightRecorder::GetInstance().IsRunning());
+    EXPECT_TRUE(traceDumpExecutor.GetCacheTraceFiles(fakeTracefs_.GetLastPageTime() + 1).empty());
+
+    BenchmarkSample sample;
+    sample.inputBytes = fakeTracefs_.GetRawDataSize();
+    BenchmarkTimer timer;
+    auto cacheFiles = traceDumpExecutor.GetCacheTraceFiles(fakeTracefs_.GetFirstPageTime(),
+        fakeTracefs_.GetLastPageTime());
+    timer.Stop(sample);
+    traceDumpExecutor.StopCacheTraceLoop();
+    cacheThread.join();
+    EXPECT_FALSE(TraceFlightRecorder::GetInstance().IsRunning());
+    ASSERT_EQ(cacheFiles.size(), 1);
+    sample.outputBytes = static_cast<uint64_t>(GetFileSize(cacheFiles[0].filename));
+    EXPECT_GE(sample.outputBytes, sample.inputBytes);
+    remove(cacheFiles[0].filename.c_str());
+    ReportSample("cache(memory) dump", config, sample);
+}
+
+/**
+ * @tc.name: TraceDumpBenchmarkTest006
+ * @tc.desc: Test the flight recorder evicts the oldest blocks to stay in its memory budget.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceDumpBenchmarkTest, TraceDumpBenchmarkTest006, TestSize.Level2)
+{
+    FakeTracefsConfig config;
+    ASSERT_TRUE(fakeTracefs_.Build(config));
+    auto& flightRecorder = TraceFlightRecorder::GetInstance();
+    flightRecorder.Start(0, 0); // 0 : the smallest budget, one block per cpu and one more
+    size_t maxTotalSz = static_cast<size_t>(GetCpuProcessors() + 1) * FLIGHT_BLOCK_SZ;
+    for (int i = 0; i < FLIGHT_DRAIN_ROUNDS; i++) {
+        ASSERT_TRUE(flightRecorder.DrainTracePipeRaw());
+        EXPECT_LE(flightRecorder.GetCurrentTotalSize(), maxTotalSz);
+    }
+    auto pageRuns = flightRecorder.GetPageRuns(0, fakeTracefs_.GetFirstPageTime(), fakeTracefs_.GetLastPageTime());
+    ASSERT_FALSE(pageRuns.empty());
+    EXPECT_EQ(pageRuns.back().lastTimestamp, fakeTracefs_.GetLastPageTime());
+    flightRecorder.Stop();
+    EXPECT_EQ(flightRecorder.GetCurrentTotalSize(), 0);
+    EXPECT_FALSE(flightRecorder.DrainTracePipeRaw());
+}
+
+/**
+ * @tc.name: TraceDumpBenchmarkTest007
+ * @tc.desc: Test the async read keeps the newest pages when the cached pages exceed the file size budget.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceDumpBenchmarkTest, TraceDumpBenchmarkTest007, TestSize.Level2)
+{
+    FakeTracefsConfig config;
+    config.pagesPerCpu = PAGES_PER_CPU[1];
+    ASSERT_TRUE(fakeTracefs_.Build(config));
+    constexpr uint64_t taskId = 1;
+    TraceDumpRequest request = {
+        .type = TraceDumpType::TRACE_ASYNC_READ,
+        .fileSize = static_cast<int>(fakeTracefs_.GetRawDataSize() / WINDOW_EDGE_DIVISOR),
+        .limitFileSz = true,
+        .taskId = taskId
+    };
+    TraceSourceLinuxFactory traceSourceFactory("");
+    auto cpuRawRead = traceSourceFactory.GetTraceCpuRawRead(request);
+    BenchmarkSample sample;
+    sample.inputBytes = fakeTracefs_.GetRawDataSize();
+    BenchmarkTimer timer;
+    ASSERT_TRUE(cpuRawRead->WriteTraceContent());
+    timer.Stop(sample);
+    sample.outputBytes = TraceBufferManager::GetInstance().GetTaskTotalUsedBytes(taskId);
+    EXPECT_TRUE(cpuRawRead->IsOverFlow());
+    EXPECT_LE(sample.outputBytes, static_cast<uint64_t>(request.fileSize));
+    EXPECT_GT(sample.outputBytes, static_cast<uint64_t>(request.fileSize) - PAGE_SIZE);
+    EXPECT_GT(cpuRawRead->GetFirstPageTimeStamp(), fakeTracefs_.GetFirstPageTime());
+    EXPECT_EQ(cpuRawRead->GetLastPageTimeStamp(), fakeTracefs_.GetLastPageTime());
+    uint64_t prevPageTime = 0;
+    for (const auto& block : TraceBufferManager::GetInstance().GetTaskBuffers(taskId)) {
+        for (size_t offset = 0; offset < block->usedBytes; offset += PAGE_SIZE) {
+            uint64_t pageTime = *reinterpret_cast<const uint64_t*>(block->data.data() + offset);
+            EXPECT_GE(pageTime, cpuRawRead->GetFirstPageTimeStamp());
+            EXPECT_GT(pageTime, prevPageTime);
+            prevPageTime = pageTime;
+        }
+    }
+    TraceBufferManager::GetInstance().ReleaseTaskBlocks(taskId);
+    ReportSample("async read(tail budget)", config, sample);
+}
+
+/**
+ * @tc.name: TraceDumpBenchmarkTest008
+ * @tc.desc: Test the threads of a host process do not pay for the content writer buffers, which are lent by the
+ *           buffer pool of a dump only while the dump runs.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceDumpBenchmarkTest, TraceDumpBenchmarkTest008, TestSize.Level2)
+{
+    auto bufferPool = std::make_shared<TraceDumpBufferPool>(CONTENT_BUFFER_SIZE, CONTENT_BUFFER_MAX_COUNT);
+    {
+        auto buffer = bufferPool->Acquire();
+        ASSERT_NE(buffer, nullptr);
+        EXPECT_EQ(buffer->size(), CONTENT_BUFFER_SIZE);
+        EXPECT_EQ(bufferPool->Acquire(), nullptr);
+    }
+    EXPECT_NE(bufferPool->Acquire(), nullptr);
+    EXPECT_EQ(bufferPool->GetMappedBufferCount(), CONTENT_BUFFER_MAX_COUNT);
+    bufferPool = nullptr;
+
+    long rssBefore = GetVmRssKb();
+    std::mutex mutex;
+    std::condition_variable cond;
+    int startedCnt = 0;
+    bool stop = false;
+    std::vector<std::thread> hostThreads;
+    for (int i = 0; i < HOST_THREAD_COUNT; i++) {
+        hostThreads.emplace_back([&mutex, &cond, &startedCnt, &stop]() {
+            std::unique_lock<std::mutex> lock(mutex);
+            startedCnt++;
+            cond.notify_all();
+            cond.wait(lock, [&stop]() { return stop; });
+        });
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&startedCnt]() { return startedCnt == HOST_THREAD_COUNT; });
+    }
+    long rssWithThreads = GetVmRssKb();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    cond.notify_all();
+    for (auto& hostThread : hostThreads) {
+        hostThread.join();
+    }
+    GTEST_LOG_(INFO) << "host threads: " << HOST_THREAD_COUNT << ", rss " << rssBefore << " KB -> " <<
+        rssWithThreads << " KB";
+    EXPECT_LT(rssWithThreads - rssBefore, HOST_THREAD_COUNT * HOST_THREAD_MAX_RSS_KB);
+}
+
+/**
+ * @tc.name: TraceDumpBenchmarkTest009
+ * @tc.desc: Test the io_uring engine writes the pages read ahead of the page which ends the dump, including the
+ *           next batch of reads already in flight, they are gone from trace_pipe_raw once read.
+ * @tc.type: FUNC
+ */
+HWTEST_F(TraceDumpBenchmarkTest, TraceDumpBenchmarkTest009, TestSize.Level2)
+{
+    if (!TraceIoUring::IsSupported()) {
+        GTEST_LOG_(INFO) << "io_uring is unavailable, skip.";
+        return;
+    }
+    FakeTracefsConfig config;
+    ASSERT_TRUE(fakeTracefs_.Build(config));
+    TraceDumpParam param = {
+        .type = TraceDumpType::TRACE_SNAPSHOT,
+        .traceEndTime = fakeTracefs_.GetFirstPageTime() + URING_END_PAGE * config.pageInterval - 1,
+        .engine = TraceDumpEngine::ENGINE_IO_URING
+    };
+    TraceDumpRet ret = TraceDumpExecutor::GetInstance().DumpTrace(param, TEST_OUTPUT_DIR);
+    EXPECT_EQ(ret.code, TraceErrorCode::SUCCESS);
+    EXPECT_EQ(ReadSectionContent(ret.outputFile, CONTENT_TYPE_CPU_RAW).size(),
+        URING_READ_BATCHES * URING_READ_DEPTH * PAGE_SIZE);
+    EXPECT_EQ(ret.traceEndTime, fakeTracefs_.GetFirstPageTime() + (URING_READ_BATCHES * URING_READ_DEPTH - 1) *
+        config.pageInterval);
+    remove(ret.outputFile);
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
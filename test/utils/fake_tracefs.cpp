@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fake_tracefs.h"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+namespace {
+constexpr size_t RAW_PAGE_SIZE = 4096;
+constexpr size_t RAW_PAGE_HEADER_SIZE = 16; // u64 time_stamp and local_t commit
+constexpr uint32_t EVENT_TYPE_LEN = 7; // 7 * 4 bytes of payload
+constexpr size_t EVENT_SIZE = sizeof(uint32_t) + EVENT_TYPE_LEN * sizeof(uint32_t);
+constexpr uint32_t EVENT_TIME_DELTA = 1000; // 1us between two events of a page
+constexpr uint32_t TYPE_LEN_BITS = 5;
+constexpr int MAX_OPEN_FDS = 16;
+constexpr uint64_t S_TO_NS = 1000000000;
+
+const char HEADER_PAGE[] =
+    "\tfield: u64 timestamp;\toffset:0;\tsize:8;\tsigned:0;\n"
+    "\tfield: local_t commit;\toffset:8;\tsize:8;\tsigned:1;\n"
+    "\tfield: int overwrite;\toffset:8;\tsize:1;\tsigned:1;\n"
+    "\tfield: char data;\toffset:16;\tsize:4080;\tsigned:1;\n";
+
+const char PRINTK_FORMATS[] =
+    "0xffffffc010000000 : \"fake printk format %d\\n\"\n"
+    "0xffffffc010000100 : \"fake printk format %s\\n\"\n";
+
+uint64_t GetBootTime()
+{
+    struct timespec bts = {0, 0};
+    clock_gettime(CLOCK_BOOTTIME, &bts);
+    return static_cast<uint64_t>(bts.tv_sec) * S_TO_NS + static_cast<uint64_t>(bts.tv_nsec);
+}
+
+bool MakeDirs(const std::string& path)
+{
+    for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+        std::string dir = path.substr(0, pos);
+        if (!dir.empty() && mkdir(dir.c_str(), S_IRWXU) != 0 && errno != EEXIST) {
+            return false;
+        }
+        if (pos == std::string::npos) {
+            return true;
+        }
+    }
+}
+
+int RemoveEntry(const char* path, const struct stat* statBuf, int typeFlag, struct FTW* ftwBuf)
+{
+    (void)statBuf;
+    (void)typeFlag;
+    (void)ftwBuf;
+    return remove(path);
+}
+
+std::string MakeEventFormat(const std::string& relativePath, const int id)
+{
+    // events/<system>/<name>/format
+    std::string name = relativePath;
+    size_t end = name.rfind('/');
+    if (end != std::string::npos) {
+        name = name.substr(0, end);
+    }
+    size_t begin = name.rfind('/');
+    if (begin != std::string::npos) {
+        name = name.substr(begin + 1);
+    }
+    return "name: " + name + "\nID: " + std::to_string(id) + "\nformat:\n"
+        "\tfield:unsigned short common_type;\toffset:0;\tsize:2;\tsigned:0;\n"
+        "\tfield:unsigned char common_flags;\toffset:2;\tsize:1;\tsigned:0;\n"
+        "\tfield:unsigned char common_preempt_count;\toffset:3;\tsize:1;\tsigned:0;\n"
+        "\tfield:int common_pid;\toffset:4;\tsize:4;\tsigned:1;\n\n"
+        "\tfield:unsigned long ip;\toffset:8;\tsize:8;\tsigned:0;\n"
+        "\tfield:char buf[12];\toffset:16;\tsize:12;\tsigned:0;\n\n"
+        "print fmt: \"%ps: %s\", (void *)REC->ip, REC->buf\n";
+}
+
+std::string MakeCpuStats(const FakeTracefsConfig& config)
+{
+    return "entries: " + std::to_string(config.pagesPerCpu) + "\noverrun: " + std::to_string(config.overrunPerCpu) +
+        "\ncommit overrun: 0\nbytes: 0\noldest event ts: 0.000000\nnow ts: 0.000000\n"
+        "dropped events: 0\nread events: 0\n";
+}
+}
+
+FakeTracefs::FakeTracefs(const std::string& rootDir) : rootPath_(rootDir)
+{
+    if (rootPath_.empty() || rootPath_.back() != '/') {
+        rootPath_ += "/";
+    }
+}
+
+FakeTracefs::~FakeTracefs()
+{
+    Remove();
+}
+
+void FakeTracefs::FillRawPage(uint8_t* page, const uint64_t timestamp, const std::vector<int>& pids,
+    const size_t seq)
+{
+    memset(page, 0, RAW_PAGE_SIZE);
+    const size_t eventCount = (RAW_PAGE_SIZE - RAW_PAGE_HEADER_SIZE) / EVENT_SIZE;
+    const uint64_t commit = eventCount * EVENT_SIZE;
+    memcpy(page, &timestamp, sizeof(timestamp));
+    memcpy(page + sizeof(timestamp), &commit, sizeof(commit));
+    uint8_t* event = page + RAW_PAGE_HEADER_SIZE;
+    for (size_t i = 0; i < eventCount; i++, event += EVENT_SIZE) {
+        uint32_t header = EVENT_TYPE_LEN | (EVENT_TIME_DELTA << TYPE_LEN_BITS);
+        int32_t pid = pids.empty() ? 0 : pids[(seq + i) % pids.size()];
+        uint64_t ip = 0xffffffc010000000 + i;
+        memcpy(event, &header, sizeof(header));
+        memcpy(event + 4, &FAKE_EVENT_ID, sizeof(FAKE_EVENT_ID)); // 4 : common_type
+        memcpy(event + 8, &pid, sizeof(pid)); // 8 : common_pid
+        memcpy(event + 12, &ip, sizeof(ip)); // 12 : ip
+        memcpy(event + 20, "fake_event", sizeof("fake_event")); // 20 : buf
+    }
+}
+
+bool FakeTracefs::WriteFile(const std::string& relativePath, const std::string& content)
+{
+    std::string path = rootPath_ + relativePath;
+    if (!MakeDirs(path.substr(0, path.rfind('/')))) {
+        return false;
+    }
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        return false;
+    }
+    bool ret = write(fd, content.data(), content.size()) == static_cast<ssize_t>(content.size());
+    close(fd);
+    return ret;
+}
+
+bool FakeTracefs::WriteRawData(const std::string& relativePath, const FakeTracefsConfig& config, const bool hasData)
+{
+    if (!WriteFile(relativePath, "")) {
+        return false;
+    }
+    if (!hasData) {
+        return true;
+    }
+    int fd = open((rootPath_ + relativePath).c_str(), O_WRONLY | O_APPEND);
+    if (fd < 0) {
+        return false;
+    }
+    std::vector<uint8_t> page(RAW_PAGE_SIZE);
+    bool ret = true;
+    for (size_t i = 0; i < config.pagesPerCpu && ret; i++) {
+        FillRawPage(page.data(), firstPageTime_ + i * config.pageInterval, config.pids, i);
+        ret = write(fd, page.data(), page.size()) == static_cast<ssize_t>(page.size());
+    }
+    close(fd);
+    rawDataSize_ += ret ? config.pagesPerCpu * RAW_PAGE_SIZE : 0;
+    return ret;
+}
+
+bool FakeTracefs::Build(const FakeTracefsConfig& config)
+{
+    Remove();
+    if (!MakeDirs(rootPath_.substr(0, rootPath_.size() - 1))) {
+        return false;
+    }
+    const uint64_t span = config.pagesPerCpu > 0 ? (config.pagesPerCpu - 1) * config.pageInterval : 0;
+    firstPageTime_ = config.firstPageTime != 0 ? config.firstPageTime : GetBootTime() - span;
+    lastPageTime_ = firstPageTime_ + span;
+    rawDataSize_ = 0;
+
+    std::string cmdlines;
+    std::string tgids;
+    for (auto pid : config.pids) {
+        cmdlines += std::to_string(pid) + " fake_task_" + std::to_string(pid) + "\n";
+        tgids += std::to_string(pid) + " " + std::to_string(pid) + "\n";
+    }
+    bool ret = WriteFile("trace_marker", "") && WriteFile("saved_cmdlines", cmdlines) &&
+        WriteFile("saved_tgids", tgids) && WriteFile("events/header_page", HEADER_PAGE) &&
+        WriteFile("printk_formats", PRINTK_FORMATS);
+    int eventId = FAKE_EVENT_ID;
+    for (size_t i = 0; i < config.eventFormats.size() && ret; i++) {
+        ret = WriteFile(config.eventFormats[i], MakeEventFormat(config.eventFormats[i], eventId++));
+    }
+    long cpuNums = sysconf(_SC_NPROCESSORS_CONF);
+    for (long cpu = 0; cpu < cpuNums && ret; cpu++) {
+        std::string cpuDir = "per_cpu/cpu" + std::to_string(cpu);
+        ret = WriteRawData(cpuDir + "/trace_pipe_raw", config, cpu < config.cpuCount) &&
+            WriteFile(cpuDir + "/stats", MakeCpuStats(config));
+    }
+    return ret;
+}
+
+void FakeTracefs::Remove()
+{
+    if (access(rootPath_.c_str(), F_OK) == 0) {
+        nftw(rootPath_.c_str(), RemoveEntry, MAX_OPEN_FDS, FTW_DEPTH | FTW_PHYS);
+    }
+}
+
+const std::string& FakeTracefs::GetRootPath() const
+{
+    return rootPath_;
+}
+
+uint64_t FakeTracefs::GetRawDataSize() const
+{
+    return rawDataSize_;
+}
+
+uint64_t FakeTracefs::GetFirstPageTime() const
+{
+    return firstPageTime_;
+}
+
+uint64_t FakeTracefs::GetLastPageTime() const
+{
+    return lastPageTime_;
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HITRACE_FAKE_TRACEFS_H
+#define HITRACE_FAKE_TRACEFS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+constexpr uint16_t FAKE_EVENT_ID = 1024;
+
+struct FakeTracefsConfig {
+    int cpuCount = 1; // cpus with trace data, trace_pipe_raw of the other cpus is left empty.
+    size_t pagesPerCpu = 256;
+    uint64_t firstPageTime = 0; // 0 : the pages of every cpu end at the current boot time.
+    uint64_t pageInterval = 1000000; // 1ms between two pages of a cpu.
+    std::vector<int> pids = { 1, 100, 1000 };
+    uint64_t overrunPerCpu = 0; // overrun of per_cpu/cpuN/stats.
+    std::vector<std::string> eventFormats = {}; // relative paths, such as "events/sched/sched_switch/format".
+};
+
+/**
+ * A tracefs look-alike tree in a plain directory, so that the dump pipeline can run without kernel ftrace.
+ * trace_pipe_raw of each cpu is a regular file of synthetic ring buffer pages, which is read again from the
+ * beginning on every open just as a refilled kernel ring buffer.
+ */
+class FakeTracefs {
+public:
+    explicit FakeTracefs(const std::string& rootDir);
+    ~FakeTracefs();
+
+    bool Build(const FakeTracefsConfig& config);
+    void Remove();
+    const std::string& GetRootPath() const;
+    uint64_t GetRawDataSize() const;
+    uint64_t GetFirstPageTime() const;
+    uint64_t GetLastPageTime() const;
+
+    static void FillRawPage(uint8_t* page, const uint64_t timestamp, const std::vector<int>& pids,
+        const size_t seq);
+
+private:
+    bool WriteFile(const std::string& relativePath, const std::string& content);
+    bool WriteRawData(const std::string& relativePath, const FakeTracefsConfig& config, const bool hasData);
+
+    std::string rootPath_;
+    uint64_t rawDataSize_ = 0;
+    uint64_t firstPageTime_ = 0;
+    uint64_t lastPageTime_ = 0;
+};
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
+#endif // HITRACE_FAKE_TRACEFS_H
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fake_tracefs_test_utils.h"
+
+#include <fcntl.h>
+#include <fstream>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+
+#include "common_define.h"
+#include "common_utils.h"
+#include "smart_fd.h"
+#include "trace_content.h"
+#include "trace_json_parser.h"
+#include "trace_section_table.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+namespace {
+constexpr double BYTE_PER_MB = 1024.0 * 1024.0;
+constexpr double MS_PER_S = 1000.0;
+constexpr double US_PER_MS = 1000.0;
+
+std::string g_fakeTraceRootPath;
+
+double GetCpuTimeMs()
+{
+    struct rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    auto toMs = [](const struct timeval& tv) {
+        return static_cast<double>(tv.tv_sec) * MS_PER_S + static_cast<double>(tv.tv_usec) / US_PER_MS;
+    };
+    return toMs(usage.ru_utime) + toMs(usage.ru_stime);
+}
+}
+
+// replaces the one of libhitrace_option, the dump pipeline of the test binary reads the fake tracefs only.
+const std::string& GetTraceRootPath()
+{
+    return g_fakeTraceRootPath;
+}
+
+BenchmarkTimer::BenchmarkTimer() : wallStart_(std::chrono::steady_clock::now()), cpuStart_(GetCpuTimeMs()) {}
+
+void BenchmarkTimer::Stop(BenchmarkSample& sample) const
+{
+    auto wallTime = std::chrono::steady_clock::now() - wallStart_;
+    sample.wallMs = std::chrono::duration<double, std::milli>(wallTime).count();
+    sample.cpuMs = GetCpuTimeMs() - cpuStart_;
+    struct rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    sample.peakRssKb = usage.ru_maxrss;
+}
+
+void ReportSample(const std::string& scene, const FakeTracefsConfig& config, const BenchmarkSample& sample)
+{
+    double outputMb = static_cast<double>(sample.outputBytes) / BYTE_PER_MB;
+    double throughput = sample.wallMs > 0 ? outputMb * MS_PER_S / sample.wallMs : 0;
+    double cpuMsPerMb = outputMb > 0 ? sample.cpuMs / outputMb : 0;
+    GTEST_LOG_(INFO) << scene << ": cpus " << config.cpuCount << ", raw " <<
+        static_cast<double>(sample.inputBytes) / BYTE_PER_MB << " MB per round, output " << outputMb << " MB, " <<
+        throughput << " MB/s, " << cpuMsPerMb << " cpu ms/MB, peak rss " << sample.peakRssKb << " KB";
+}
+
+std::vector<std::string> GetAllEventFormats()
+{
+    const TraceJsonParser& traceJsonParser = TraceJsonParser::Instance();
+    std::vector<std::string> eventFormats = traceJsonParser.GetBaseFmtPath();
+    for (const auto& tag : traceJsonParser.GetAllTagInfos()) {
+        eventFormats.insert(eventFormats.end(), tag.second.formatPath.begin(), tag.second.formatPath.end());
+    }
+    return eventFormats;
+}
+
+std::string ReadSectionContent(const std::string& file, const uint8_t type)
+{
+    SmartFd fd(open(file.c_str(), O_RDONLY));
+    std::vector<TraceSectionTableEntry> entries;
+    if (!fd || !ReadSectionTable(fd.GetFd(), entries)) {
+        return "";
+    }
+    for (const auto& entry : entries) {
+        if (entry.type != type) {
+            continue;
+        }
+        std::string content(entry.length, '\0');
+        if (pread(fd.GetFd(), content.data(), content.size(),
+            static_cast<off_t>(entry.offset + sizeof(TraceFileContentHeader))) != static_cast<ssize_t>(entry.length)) {
+            return "";
+        }
+        return content;
+    }
+    return "";
+}
+
+std::vector<std::pair<int, uint64_t>> ReadPageEvents(const uint8_t* pages, const size_t size)
+{
+    constexpr size_t dataOffset = 16;
+    constexpr uint32_t typeLenMask = 0x1f;
+    constexpr uint32_t typePadding = 29;
+    constexpr uint32_t typeTimeExtend = 30;
+    constexpr uint32_t timeDeltaShift = 5;
+    constexpr uint32_t timeExtendShift = 27;
+    std::vector<std::pair<int, uint64_t>> events;
+    for (size_t offset = 0; offset + PAGE_SIZE <= size; offset += PAGE_SIZE) {
+        const uint8_t* page = pages + offset;
+        uint64_t time = *reinterpret_cast<const uint64_t*>(page);
+        uint64_t commit = *reinterpret_cast<const uint64_t*>(page + sizeof(uint64_t)) & ((1ULL << 27) - 1);
+        for (size_t pos = dataOffset; pos < dataOffset + commit;) {
+            uint32_t header = *reinterpret_cast<const uint32_t*>(page + pos);
+            uint32_t typeLen = header & typeLenMask;
+            if (typeLen == typePadding || typeLen == 0) {
+                break;
+            }
+            time += header >> timeDeltaShift;
+            if (typeLen == typeTimeExtend) {
+                time += static_cast<uint64_t>(*reinterpret_cast<const uint32_t*>(page + pos + 4)) << timeExtendShift;
+                pos += 8; // 8 : a time extend
+                continue;
+            }
+            events.emplace_back(*reinterpret_cast<const int32_t*>(page + pos + 8), time); // 8 : common_pid
+            pos += sizeof(uint32_t) * (typeLen + 1);
+        }
+    }
+    return events;
+}
+
+uint16_t GetTraceFileVersion(const std::string& file)
+{
+    TraceFileHeader header;
+    std::ifstream fileStream(file, std::ios::binary);
+    fileStream.read(reinterpret_cast<char*>(&header), sizeof(header));
+    return fileStream ? header.versionNumber : 0;
+}
+
+std::vector<std::string> RunRecordLoop(const TraceDumpParam& param)
+{
+    TraceDumpExecutor& traceDumpExecutor = TraceDumpExecutor::GetInstance();
+    if (!traceDumpExecutor.PreCheckDumpTraceLoopStatus()) {
+        return {};
+    }
+    std::thread loopThread([&traceDumpExecutor, &param]() {
+        traceDumpExecutor.StartDumpTraceLoop(param, TEST_OUTPUT_DIR);
+    });
+    sleep(LOOP_DUMP_SECONDS);
+    auto outputFiles = traceDumpExecutor.StopDumpTraceLoop();
+    loopThread.join();
+    return outputFiles;
+}
+
+uint64_t FakeTracefsTest::GetWindowEdge() const
+{
+    return (fakeTracefs_.GetLastPageTime() - fakeTracefs_.GetFirstPageTime()) / WINDOW_EDGE_DIVISOR;
+}
+
+void FakeTracefsTest::SetUp()
+{
+    g_fakeTraceRootPath = fakeTracefs_.GetRootPath();
+}
+
+void FakeTracefsTest::TearDown()
+{
+    fakeTracefs_.Remove();
+}
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
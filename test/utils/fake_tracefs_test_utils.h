@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HITRACE_FAKE_TRACEFS_TEST_UTILS_H
+#define HITRACE_FAKE_TRACEFS_TEST_UTILS_H
+
+#include <chrono>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "fake_tracefs.h"
+#include "trace_dump_executor.h"
+
+namespace OHOS {
+namespace HiviewDFX {
+namespace Hitrace {
+const char* const FAKE_TRACEFS_DIR = "/data/local/tmp/hitrace_fake_tracefs";
+const char* const TEST_OUTPUT_DIR = "/data/local/tmp/";
+constexpr size_t RECORD_PAGES_PER_CPU = 2560; // 10M of raw data per cpu
+constexpr int LOOP_DUMP_SECONDS = 3;
+constexpr uint64_t WINDOW_EDGE_DIVISOR = 4; // cut the middle half of the pages of every round
+
+struct BenchmarkSample {
+    uint64_t inputBytes = 0;
+    uint64_t outputBytes = 0;
+    double wallMs = 0;
+    double cpuMs = 0;
+    long peakRssKb = 0;
+};
+
+class BenchmarkTimer {
+public:
+    BenchmarkTimer();
+    void Stop(BenchmarkSample& sample) const;
+
+private:
+    std::chrono::steady_clock::time_point wallStart_;
+    double cpuStart_;
+};
+
+void ReportSample(const std::string& scene, const FakeTracefsConfig& config, const BenchmarkSample& sample);
+
+// the event formats of all the tags of the device, as listed by the tag config.
+std::vector<std::string> GetAllEventFormats();
+
+// the content of the first section of the type in a trace file which ends with a section table.
+std::string ReadSectionContent(const std::string& file, const uint8_t type);
+
+// the (pid, time) of the events of the pages laid out as the header_page of the fake tracefs.
+std::vector<std::pair<int, uint64_t>> ReadPageEvents(const uint8_t* pages, const size_t size);
+
+uint16_t GetTraceFileVersion(const std::string& file);
+
+// runs the record loop of the param for LOOP_DUMP_SECONDS, returns the record files.
+std::vector<std::string> RunRecordLoop(const TraceDumpParam& param);
+
+/**
+ * The fixture of the cases which run the dump pipeline over a fake tracefs, GetTraceRootPath of the test binary
+ * points to the fake tracefs of the running case.
+ */
+class FakeTracefsTest : public testing::Test {
+public:
+    void SetUp() override;
+    void TearDown() override;
+
+protected:
+    // the time cut off each end of the pages of a round to get its middle half.
+    uint64_t GetWindowEdge() const;
+
+    FakeTracefs fakeTracefs_{FAKE_TRACEFS_DIR};
+};
+} // namespace Hitrace
+} // namespace HiviewDFX
+} // namespace OHOS
+#endif // HITRACE_FAKE_TRACEFS_TEST_UTILS_H
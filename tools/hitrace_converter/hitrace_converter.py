@@ -24,6 +24,7 @@ import re
 import stat
 import struct
 import sys
+import zlib
 
 import parse_functions
 
@@ -149,6 +150,9 @@ class FieldType(IntEnum):
     SEGMENT_HEADER_PAGE = 30
     SEGMENT_PRINTK_FORMATS = 31
     SEGMENT_KALLSYMS = 32
+    SEGMENT_RAW_TRACE_COMPRESSED = 35
+    SEGMENT_SECTION_TABLE = 36
+    SEGMENT_METADATA_REF = 37
     SEGMENT_UNSUPPORT = -1
     pass
 
@@ -505,6 +509,49 @@ class RawTraceSegment(SegmentOperator):
         return True
 
 
+class CompressedRawTraceSegment(SegmentOperator):
+    """
+    功能描述: 声明HiTrace文件压缩后的trace_pipe_raw内容的段格式, 段内是若干个zlib压缩的page块
+    """
+    # 段头: cpu核号、压缩算法、保留字段
+    HEADER_FORMAT = "<BBH"
+    # 块头: 压缩后大小、压缩前大小、page个数, 两个大小相等时块内容未压缩
+    CHUNK_FORMAT = "<III"
+    ALGORITHM_ZLIB = 1
+
+    def __init__(self) -> None:
+        super().__init__(FieldType.SEGMENT_RAW_TRACE_COMPRESSED)
+        self.raw_trace = RawTraceSegment()
+        pass
+
+    def accept(self, parser: TraceFileParserInterface, segment=None) -> bool:
+        segment = segment or b""
+        header_size = struct.calcsize(CompressedRawTraceSegment.HEADER_FORMAT)
+        chunk_header_size = struct.calcsize(CompressedRawTraceSegment.CHUNK_FORMAT)
+        if len(segment) < header_size:
+            return False
+        (_, algorithm, _) = struct.unpack_from(CompressedRawTraceSegment.HEADER_FORMAT, segment, 0)
+        if algorithm != CompressedRawTraceSegment.ALGORITHM_ZLIB:
+            print("unsupport compress algorithm %d, skipped" % algorithm)
+            return False
+        pages = []
+        cur_post = header_size
+        while cur_post + chunk_header_size <= len(segment):
+            (compressed_size, raw_size, _) = struct.unpack_from(
+                CompressedRawTraceSegment.CHUNK_FORMAT, segment, cur_post)
+            cur_post += chunk_header_size
+            if cur_post + compressed_size > len(segment):
+                return False
+            data = segment[cur_post: cur_post + compressed_size]
+            cur_post += compressed_size
+            if compressed_size != raw_size:
+                data = zlib.decompress(data)
+                if len(data) != raw_size:
+                    return False
+            pages.append(data)
+        return self.raw_trace.accept(parser, b"".join(pages))
+
+
 class EventFormatSegment(SegmentOperator):
     """
     功能描述: 声明HiTrace文件event/format内容的段格式
@@ -593,16 +640,83 @@ class HeaderPageSegment(SegmentOperator):
         return True
 
 
+class SectionTableSegment(SegmentOperator):
+    """
+    功能描述: 声明HiTrace文件段偏移表的段格式, 转换时按顺序解析所有段, 不需要该表, 直接跳过
+    """
+    def __init__(self) -> None:
+        super().__init__(FieldType.SEGMENT_SECTION_TABLE)
+        pass
+
+    def accept(self, parser: TraceFileParserInterface, segment=None) -> bool:
+        return True
+
+
+class MetadataRefSegment(SegmentOperator):
+    """
+    功能描述: 声明HiTrace文件metadata引用的段格式, 分片文件的event/format等静态段保存在
+             同目录的sidecar文件中, sidecar文件以相同的引用开头, 其后是各个静态段
+    """
+    # 引用: sidecar内容的hash、sidecar的段个数、magic
+    REF_FORMAT = "<QII"
+    SIDECAR_MAGIC = 0x4D445354
+    SIDECAR_FILE_PREFIX = "saved_metadata_"
+    # 段头与SegmentWrapper相同, 段类型只有1个字节，其后3个字节是对齐填充
+    SECTION_FORMAT = "<BxxxI"
+
+    def __init__(self, fields: List) -> None:
+        super().__init__(FieldType.SEGMENT_METADATA_REF)
+        self.fields = fields
+        pass
+
+    def accept(self, parser: TraceFileParserInterface, segment=None) -> bool:
+        segment = segment or b""
+        ref_size = struct.calcsize(MetadataRefSegment.REF_FORMAT)
+        if len(segment) != ref_size:
+            return False
+        ref = struct.unpack_from(MetadataRefSegment.REF_FORMAT, segment, 0)
+        (ref_hash, _, magic) = ref
+        if magic != MetadataRefSegment.SIDECAR_MAGIC:
+            return False
+        sidecar_file = os.path.join(os.path.dirname(parser.trace_file.name),
+                                    "%s%016x" % (MetadataRefSegment.SIDECAR_FILE_PREFIX, ref_hash))
+        if not os.path.isfile(sidecar_file):
+            print("metadata sidecar %s is missing, the events can not be formatted" % sidecar_file)
+            return False
+        with os.fdopen(os.open(sidecar_file, os.O_RDONLY | getattr(os, 'O_BINARY', 0), stat.S_IRUSR), 'rb') as f:
+            content = f.read()
+        if len(content) < ref_size or struct.unpack_from(MetadataRefSegment.REF_FORMAT, content, 0) != ref:
+            print("metadata sidecar %s does not match the trace file" % sidecar_file)
+            return False
+        section_header_size = struct.calcsize(MetadataRefSegment.SECTION_FORMAT)
+        cur_post = ref_size
+        while cur_post + section_header_size <= len(content):
+            (section_type, section_size) = struct.unpack_from(MetadataRefSegment.SECTION_FORMAT, content, cur_post)
+            cur_post += section_header_size
+            if cur_post + section_size > len(content):
+                return False
+            self.get_segment(section_type).accept(parser, content[cur_post: cur_post + section_size])
+            cur_post += section_size
+        return True
+
+    def get_segment(self, segment_type: int) -> FieldOperator:
+        for field in self.fields:
+            if field.field_type == segment_type:
+                return field
+        return UnSupportSegment(segment_type)
+
+
 class UnSupportSegment(FieldOperator):
     """
     功能描述: 声明HiTrace文件还不支持解析的段
     """
-    def __init__(self) -> None:
+    def __init__(self, segment_type: int = FieldType.SEGMENT_UNSUPPORT) -> None:
         super().__init__(FieldType.SEGMENT_UNSUPPORT, -1, "", [])
+        self.segment_type = segment_type
         pass
 
     def accept(self, parser: TraceFileParserInterface, segment=None) -> bool:
-        print("unsupport segment")
+        print("unsupport segment type %d, skipped" % self.segment_type)
         return True
 
 
@@ -610,8 +724,8 @@ class SegmentWrapper(FieldOperator):
     """
     功能描述: 声明HiTrace文件包含所有段的格式
     """
-    # 描述段的pack的格式
-    FORMAT = "II"
+    # 描述段的pack的格式，段类型只有1个字节，其后3个字节是对齐填充，内容不确定
+    FORMAT = "BxxxI"
 
     ITEM_SEGMENT_TYPE = 0
     ITEM_SEGMENT_SIZE = 1
@@ -654,8 +768,7 @@ class SegmentWrapper(FieldOperator):
                 for i, seg_info in enumerate(self.parsed_segments):
                     print(f"  [{i}] type={seg_info['type']:x}, size={seg_info['size']:x}, offset={seg_info['offset']:x}")
                 raise ValueError("Unsupported data file, please check the file content.")
-            conext = parser.get_context()
-            segment = self.get_segment(segment_type, conext.get_param(TraceParseContext.CONTEXT_CPU_NUM))
+            segment = self.get_segment(segment_type)
             segment_data = parser.get_segment_data(segment_size)
             try:
                 if not segment.accept(parser, segment_data):
@@ -669,18 +782,14 @@ class SegmentWrapper(FieldOperator):
             pass
         return True
 
-    def get_segment(self, segment_type: int, cpu_num: int) -> FieldOperator:
+    def get_segment(self, segment_type: int) -> FieldOperator:
+        # trace_pipe_raw的段类型是SEGMENT_RAW_TRACE加上CPU核号，其余未知类型的段(如page index)都跳过
+        if FieldType.SEGMENT_RAW_TRACE <= segment_type < FieldType.SEGMENT_HEADER_PAGE:
+            segment_type = FieldType.SEGMENT_RAW_TRACE
         for field in self.fields:
             if field.field_type == segment_type:
                 return field
-
-            if field.field_type < FieldType.SEGMENT_RAW_TRACE:
-                continue
-
-            if field.field_type > FieldType.SEGMENT_RAW_TRACE + cpu_num:
-                continue
-            return field
-        return UnSupportSegment()
+        return UnSupportSegment(segment_type)
 
 
 class TraceFile:
@@ -727,9 +836,16 @@ class TraceFileFormat(OperatorInterface):
                 TidGroupsSegment(),
                 EventFormatSegment(),
                 RawTraceSegment(),
+                CompressedRawTraceSegment(),
                 PrintkFormatSegment(),
                 KallSymsSegment(),
                 HeaderPageSegment(),
+                SectionTableSegment(),
+                MetadataRefSegment([
+                    EventFormatSegment(),
+                    PrintkFormatSegment(),
+                    HeaderPageSegment(),
+                ]),
             ])
         ]
         pass
@@ -274,6 +274,17 @@ bool RemoveFile(const std::string& fileName)
     return result;
 }
 
+bool IsFileUnlinked(const int fd)
+{
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0) {
+        HILOG_WARN(LOG_CORE, "IsFileUnlinked: fstat fd(%{public}d) failed, errno: %{public}d.", fd, errno);
+        return true;
+    }
+    // the open file stays writable after it is deleted, only the link count tells that it is gone.
+    return fileStat.st_nlink == 0;
+}
+
 bool IsWritable(const std::string& fileName)
 {
     constexpr auto length = sizeof(TRACE_WRITABLE_PATH) - 1u;